@@ -18,6 +18,7 @@ BENCHMARK_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 run_benchmark() {
     local name="$1"
     local file="$2"
+    local calls="$3"
     
     echo "Running: $name"
     echo "----------------------------------------"
@@ -33,6 +34,9 @@ run_benchmark() {
     
     echo "----------------------------------------"
     echo "Time: ${duration_s}.$(printf "%03d" $remaining_ms)s"
+    if [ -n "$calls" ] && [ "$duration_ms" -gt 0 ]; then
+        echo "Throughput: $((calls * 1000 / duration_ms)) calls/s"
+    fi
     echo ""
 }
 
@@ -42,6 +46,10 @@ run_benchmark "03. List Operations & Lambdas" "03_list_operations.akx"
 run_benchmark "04. Filesystem I/O" "04_filesystem_io.akx"
 run_benchmark "05. Forms System & Type Operations" "05_forms_system.akx"
 run_benchmark "06. Collatz Conjecture Stress Test" "06_collatz_stress.akx"
+run_benchmark "07. Quoted Literal in a Loop" "07_quoted_literal.akx"
+run_benchmark "08. Bignum Arithmetic" "08_bignum.akx"
+run_benchmark "09. Reading Large Bindings" "09_shared_binding.akx"
+run_benchmark "10. Tail-Call Throughput" "10_tail_calls.akx" 3000000
 
 echo "=========================================="
 echo "All benchmarks completed"
@@ -0,0 +1,62 @@
+#!/usr/bin/env bash
+
+set -e
+
+if ! command -v akx &> /dev/null; then
+    echo "Error: 'akx' command not found in PATH"
+    echo "Please ensure AKX is installed and available in your PATH"
+    exit 1
+fi
+
+FORMS="${FORMS:-20000}"
+RUNS="${RUNS:-5}"
+
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+MODULE="$WORK_DIR/startup_module.akx"
+DRIVER="$WORK_DIR/startup_driver.akx"
+
+echo "=========================================="
+echo "AKX Startup Benchmark (AST cache)"
+echo "=========================================="
+echo ""
+
+for ((i = 0; i < FORMS; i++)); do
+    echo "(let fn-$i (lambda [a b] (if (lt a b) (+ a $i) (- b 2.5))))"
+done > "$MODULE"
+echo "(io/putf \"Loaded %d forms\\n\" $FORMS)" >> "$MODULE"
+echo "(import \"$MODULE\")" > "$DRIVER"
+
+echo "Module: $FORMS forms, $(wc -c < "$MODULE") bytes"
+echo ""
+
+time_run() {
+    local start=$(date +%s%N)
+    "$@" akx "$DRIVER" > /dev/null
+    local end=$(date +%s%N)
+    echo $(((end - start) / 1000000))
+}
+
+best_of() {
+    local best=""
+    for ((r = 0; r < RUNS; r++)); do
+        local ms=$(time_run "$@")
+        if [ -z "$best" ] || [ "$ms" -lt "$best" ]; then
+            best=$ms
+        fi
+    done
+    echo "$best"
+}
+
+cold=$(best_of env AKX_NO_CACHE=1)
+
+akx "$DRIVER" > /dev/null
+warm=$(best_of env)
+
+echo "Cold (no cache): ${cold}ms"
+echo "Warm (cached):   ${warm}ms"
+echo ""
+echo "=========================================="
+echo "Startup benchmark completed"
+echo "=========================================="
@@ -3,35 +3,48 @@
 #include <ak24/list.h>
 #include <stdio.h>
 
+void akx_show_errors(akx_parse_error_t *err) {
+  while (err) {
+    akx_sv_show_location(&err->location, AKX_ERROR_LEVEL_ERROR, err->message);
+    err = err->next;
+  }
+}
+
 int akx_interpret_file(const char *filename, akx_core_t *core,
                        akx_runtime_ctx_t *runtime) {
   (void)core;
 
-  akx_parse_result_t result = akx_cell_parse_file(filename);
-
-  if (result.errors) {
-    akx_parse_error_t *err = result.errors;
-    while (err) {
-      akx_sv_show_location(&err->location, AKX_ERROR_LEVEL_ERROR, err->message);
-      err = err->next;
-    }
-    akx_parse_result_free(&result);
+  akx_cell_stream_t *stream = akx_cell_stream_open(filename);
+  if (!stream) {
     return 1;
   }
 
-  if (list_count(&result.cells) > 0) {
+  // Each top-level form is evaluated and dropped before the next is parsed
+  int status = 0;
+  akx_parse_result_t result;
+  int rc;
+  while ((rc = akx_cell_stream_next(stream, &result)) > 0) {
+    if (result.errors) {
+      akx_show_errors(result.errors);
+      akx_parse_result_free(&result);
+      status = 1;
+      break;
+    }
+
     if (akx_runtime_start(runtime, (akx_cell_list_t *)&result.cells) != 0) {
-      akx_parse_error_t *err = akx_runtime_get_errors(runtime);
-      while (err) {
-        akx_sv_show_location(&err->location, AKX_ERROR_LEVEL_ERROR,
-                             err->message);
-        err = err->next;
-      }
+      akx_show_errors(akx_runtime_get_errors(runtime));
       akx_parse_result_free(&result);
-      return 1;
+      status = 1;
+      break;
     }
+
+    akx_parse_result_free(&result);
+  }
+
+  if (rc < 0) {
+    status = 1;
   }
 
-  akx_parse_result_free(&result);
-  return 0;
+  akx_cell_stream_close(stream);
+  return status;
 }
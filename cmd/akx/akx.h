@@ -6,6 +6,9 @@
 #include "akx_rt.h"
 #include <ak24/application.h>
 
+// Prints each error with the source line it points at
+void akx_show_errors(akx_parse_error_t *err);
+
 int akx_interpret_file(const char *filename, akx_core_t *core,
                        akx_runtime_ctx_t *runtime);
 
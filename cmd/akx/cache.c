@@ -0,0 +1,48 @@
+#include "cache.h"
+#include "akx_cell_cache.h"
+#include <stdio.h>
+
+int akx_cache_stats(void) {
+  ak_buffer_t *dir = akx_cell_cache_dir();
+  if (!dir) {
+    printf("Error: Could not determine cache directory\n");
+    return 1;
+  }
+
+  akx_cell_cache_stats_t stats;
+  if (akx_cell_cache_stats(&stats) != 0) {
+    printf("Error: Failed to read cache directory\n");
+    ak_buffer_free(dir);
+    return 1;
+  }
+
+  printf("\nAST cache in %s:\n\n", (const char *)ak_buffer_data(dir));
+  printf("  Format version: %d\n", AKX_CELL_CACHE_VERSION);
+  printf("  Entries:        %zu\n", stats.entries);
+  printf("  Stale entries:  %zu\n", stats.stale_entries);
+  printf("  Total size:     %zu bytes\n\n", stats.total_bytes);
+
+  ak_buffer_free(dir);
+  return 0;
+}
+
+int akx_cache_clear(void) {
+  ak_buffer_t *dir = akx_cell_cache_dir();
+  if (!dir) {
+    printf("Error: Could not determine cache directory\n");
+    return 1;
+  }
+
+  int removed = akx_cell_cache_clear();
+  if (removed < 0) {
+    printf("Error: Failed to clear cache directory\n");
+    ak_buffer_free(dir);
+    return 1;
+  }
+
+  printf("Removed %d cache entries from %s\n", removed,
+         (const char *)ak_buffer_data(dir));
+
+  ak_buffer_free(dir);
+  return 0;
+}
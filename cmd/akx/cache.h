@@ -0,0 +1,8 @@
+#ifndef AKX_CACHE_H
+#define AKX_CACHE_H
+
+int akx_cache_stats(void);
+
+int akx_cache_clear(void);
+
+#endif
@@ -1,4 +1,6 @@
 #include "commands.h"
+#include "cache.h"
+#include "compile.h"
 #include "nucleus_info.h"
 #include "nucleus_list.h"
 #include <stdio.h>
@@ -29,9 +31,28 @@ int akx_dispatch_command(int argc, char **argv) {
       printf("Available subcommands: info, list\n");
       return 1;
     }
+  } else if (strcmp(command, "cache") == 0) {
+    if (argc < 3) {
+      printf("Usage: akx cache <stats|clear>\n");
+      return 1;
+    }
+
+    const char *subcommand = argv[2];
+
+    if (strcmp(subcommand, "stats") == 0) {
+      return akx_cache_stats();
+    } else if (strcmp(subcommand, "clear") == 0) {
+      return akx_cache_clear();
+    } else {
+      printf("Unknown cache subcommand: %s\n", subcommand);
+      printf("Available subcommands: stats, clear\n");
+      return 1;
+    }
+  } else if (strcmp(command, "compile") == 0) {
+    return akx_compile(argc, argv);
   } else {
     printf("Unknown command: %s\n", command);
-    printf("Available commands: nucleus\n");
+    printf("Available commands: nucleus, cache, compile\n");
     return 1;
   }
 }
@@ -0,0 +1,538 @@
+#include "compile.h"
+#include "akx.h"
+#include "builtin_metadata.h"
+#include <ak24/buffer.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Set by the build to what a program needs to compile and link against the
+// runtime akx itself was built from
+#ifndef AKX_AOT_CFLAGS
+#define AKX_AOT_CFLAGS ""
+#endif
+#ifndef AKX_AOT_LIBS
+#define AKX_AOT_LIBS ""
+#endif
+
+#define AKX_AOT_MAX_ARGS 256
+#define AKX_AOT_BYTES_PER_LINE 12
+
+static int is_list(akx_cell_t *cell) {
+  return cell->type == AKX_TYPE_LIST || cell->type == AKX_TYPE_LIST_SQUARE ||
+         cell->type == AKX_TYPE_LIST_CURLY ||
+         cell->type == AKX_TYPE_LIST_TEMPLE;
+}
+
+// A call of a compiled-in nucleus, lowered to a C function named after its
+// index in the plan
+typedef struct {
+  akx_cell_t *cell;
+  // Its number among the program's list cells; see akx_rt_aot_site_t
+  uint32_t number;
+  size_t nucleus;
+} lowered_call_t;
+
+typedef struct {
+  list_t(lowered_call_t) calls;
+  uint32_t lists;
+} lowering_plan_t;
+
+static const akx_nucleus_metadata_t *nucleus_at(size_t index) {
+  return &akx_nucleus_metadata[index];
+}
+
+static int find_nucleus(const char *symbol, size_t *index) {
+  for (size_t i = 0; i < akx_nucleus_metadata_count; i++) {
+    if (akx_nucleus_metadata[i].compiled_in &&
+        strcmp(akx_nucleus_metadata[i].symbol, symbol) == 0) {
+      *index = i;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Numbers list cells depth first, skipping quotes, as akx_rt_aot_main does,
+// and plans a C function for each call naming a compiled-in nucleus. A
+// lambda's body is copied when the lambda is made, so calls in it always
+// run on the interpreter and are numbered but not lowered.
+static int plan_calls(lowering_plan_t *plan, akx_cell_t *cell, int in_lambda) {
+  if (cell->type == AKX_TYPE_QUOTED) {
+    return 0;
+  }
+
+  akx_cell_t *head = is_list(cell) ? cell->value.list_head : NULL;
+  if (is_list(cell)) {
+    uint32_t number = plan->lists++;
+    lowered_call_t call = {cell, number, 0};
+    if (!in_lambda && head && head->type == AKX_TYPE_SYMBOL &&
+        find_nucleus(head->value.symbol, &call.nucleus) &&
+        list_push(&plan->calls, call) != 0) {
+      return -1;
+    }
+  }
+  if (head && head->type == AKX_TYPE_SYMBOL &&
+      strcmp(head->value.symbol, "lambda") == 0) {
+    in_lambda = 1;
+  }
+
+  akx_cell_t *children[2];
+  size_t count = akx_cell_children(cell, children);
+  for (size_t i = 0; i < count; i++) {
+    for (akx_cell_t *child = children[i]; child; child = child->next) {
+      if (plan_calls(plan, child, in_lambda) != 0) {
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+// The planned call made of cell; nested calls come after their parent
+static int find_call(lowering_plan_t *plan, size_t after, akx_cell_t *cell,
+                     size_t *index) {
+  for (size_t i = after + 1; i < list_count(&plan->calls); i++) {
+    lowered_call_t *call = list_get(&plan->calls, i);
+    if (call->cell == cell) {
+      *index = i;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void emit_string(FILE *out, const char *str) {
+  fputc('"', out);
+  for (const unsigned char *c = (const unsigned char *)str; *c; c++) {
+    if (*c == '"' || *c == '\\') {
+      fprintf(out, "\\%c", *c);
+    } else if (*c < 0x20 || *c >= 0x7f) {
+      fprintf(out, "\\%03o", *c);
+    } else {
+      fputc(*c, out);
+    }
+  }
+  fputc('"', out);
+}
+
+static void emit_bytes(FILE *out, const char *name, const uint8_t *data,
+                       size_t len) {
+  fprintf(out, "static const uint8_t %s[] = {", name);
+  for (size_t i = 0; i < len; i++) {
+    if (i % AKX_AOT_BYTES_PER_LINE == 0) {
+      fprintf(out, "\n   ");
+    }
+    fprintf(out, " 0x%02x,", data[i]);
+  }
+  fprintf(out, "%s};\n\n", len ? "\n" : "0");
+}
+
+// INT64_MIN has no C literal
+static int is_plain_int(akx_cell_t *cell) {
+  return cell->type == AKX_TYPE_INTEGER_LITERAL &&
+         !akx_rt_cell_is_bignum(cell) &&
+         cell->value.integer_literal != INT64_MIN;
+}
+
+// An argument of a lowered strict call: a nested lowered call runs its C
+// function unless a reloaded nucleus unbound it, and a literal int is made
+// directly; anything else is evaluated
+static void emit_arg(FILE *out, lowering_plan_t *plan, size_t parent,
+                     akx_cell_t *arg) {
+  size_t nested;
+  if (find_call(plan, parent, arg, &nested)) {
+    fprintf(out,
+            "akx_rt_native_bound(arg)\n"
+            "                            ? native_%zu(rt, arg, 0)\n"
+            "                            : akx_rt_eval(rt, arg)",
+            nested);
+  } else if (is_plain_int(arg)) {
+    fprintf(out, "akx_rt_make_int(rt, INT64_C(%" PRId64 "))",
+            arg->value.integer_literal);
+  } else {
+    fprintf(out, "akx_rt_eval(rt, arg)");
+  }
+}
+
+// One call as the interpreter would make it, minus the lookups
+static void emit_call(FILE *out, lowering_plan_t *plan, size_t index) {
+  lowered_call_t *call = list_get(&plan->calls, index);
+  const akx_nucleus_metadata_t *nucleus = nucleus_at(call->nucleus);
+  ak_source_loc_t loc = akx_cell_location(call->cell);
+  fprintf(out, "// %s at %zu:%zu\n", nucleus->symbol, (size_t)loc.line,
+          (size_t)loc.column);
+  fprintf(out,
+          "static akx_cell_t *native_%zu(akx_runtime_ctx_t *rt, "
+          "akx_cell_t *call,\n    int tail) {\n"
+          "  akx_rt_native_frame_t frame;\n",
+          index);
+
+  if (!nucleus->strict) {
+    fprintf(out,
+            "  akx_rt_native_enter(rt, &frame, call, tail);\n"
+            "  return akx_rt_native_leave(rt, &frame,\n"
+            "                             %s(rt, "
+            "call->value.list_head->next));\n}\n\n",
+            nucleus->c_function);
+    return;
+  }
+
+  // arg walks the call's arguments unless they are all literal ints
+  size_t argc = 0;
+  int walks = 0;
+  akx_cell_t *args = call->cell->value.list_head->next;
+  for (akx_cell_t *arg = args; arg; arg = arg->next) {
+    argc++;
+    walks |= !is_plain_int(arg);
+  }
+  fprintf(out,
+          "  akx_value_t argv[%zu];\n"
+          "  akx_value_t result = {0};\n",
+          argc ? argc : 1);
+  if (walks) {
+    fprintf(out, "  akx_cell_t *arg = call->value.list_head->next;\n");
+  }
+  fprintf(out,
+          "  if (akx_rt_native_enter_strict(rt, &frame, call, tail, %zu) != "
+          "0) {\n    return NULL;\n  }\n",
+          argc);
+  for (akx_cell_t *arg = args; arg; arg = arg->next) {
+    fprintf(out, "  if (akx_rt_native_arg(rt, &frame, argv,\n"
+                 "                        ");
+    emit_arg(out, plan, index, arg);
+    fprintf(out, ") != 0) {\n"
+                 "    return akx_rt_native_fail(rt, &frame, argv);\n  }\n");
+    if (walks && arg->next) {
+      fprintf(out, "  arg = arg->next;\n");
+    }
+  }
+  fprintf(out,
+          "  if (akx_rt_native_check(rt, &frame, argv) != 0) {\n"
+          "    return akx_rt_native_fail(rt, &frame, argv);\n  }\n"
+          "  return akx_rt_native_finish(rt, &frame, argv,\n"
+          "                              %s(rt, argv, %zu, &result), "
+          "&result);\n}\n\n",
+          nucleus->c_function, argc);
+}
+
+// The nuclei the plan calls, in table order; indices maps a nucleus to its
+// place in the table
+static size_t emit_nuclei(FILE *out, lowering_plan_t *plan, size_t *indices) {
+  for (size_t i = 0; i < akx_nucleus_metadata_count; i++) {
+    indices[i] = SIZE_MAX;
+  }
+  for (size_t i = 0; i < list_count(&plan->calls); i++) {
+    lowered_call_t *call = list_get(&plan->calls, i);
+    indices[call->nucleus] = 0;
+  }
+
+  size_t count = 0;
+  for (size_t i = 0; i < akx_nucleus_metadata_count; i++) {
+    if (indices[i] == SIZE_MAX) {
+      continue;
+    }
+    indices[i] = count++;
+    const akx_nucleus_metadata_t *nucleus = nucleus_at(i);
+    if (nucleus->strict) {
+      fprintf(out,
+              "extern int %s(akx_runtime_ctx_t *, akx_value_t *, size_t, "
+              "akx_value_t *);\n",
+              nucleus->c_function);
+    } else {
+      fprintf(out,
+              "extern akx_cell_t *%s(akx_runtime_ctx_t *, akx_cell_t *);\n",
+              nucleus->c_function);
+    }
+  }
+
+  fprintf(out, "\nstatic const akx_rt_aot_nucleus_t nuclei[] = {\n");
+  for (size_t i = 0; i < akx_nucleus_metadata_count; i++) {
+    if (indices[i] == SIZE_MAX) {
+      continue;
+    }
+    const akx_nucleus_metadata_t *nucleus = nucleus_at(i);
+    fprintf(out, "    {");
+    emit_string(out, nucleus->symbol);
+    if (nucleus->strict) {
+      fprintf(out, ", NULL, %s},\n", nucleus->c_function);
+    } else {
+      fprintf(out, ", %s, NULL},\n", nucleus->c_function);
+    }
+  }
+  fprintf(out, "    {NULL, NULL, NULL},\n};\n\n");
+  return count;
+}
+
+static int emit_program(FILE *out, const char *script, const char *binary,
+                        lowering_plan_t *plan, ak_buffer_t *source,
+                        ak_buffer_t *cells) {
+  size_t *indices =
+      AK24_ALLOC((akx_nucleus_metadata_count + 1) * sizeof(size_t));
+  if (!indices) {
+    return -1;
+  }
+
+  fprintf(out, "// Generated by akx compile from %s\n", script);
+  fprintf(out, "#include \"akx_rt_aot.h\"\n#include <ak24/kernel.h>\n\n");
+  size_t nucleus_count = emit_nuclei(out, plan, indices);
+
+  size_t call_count = list_count(&plan->calls);
+  for (size_t i = 0; i < call_count; i++) {
+    fprintf(out,
+            "static akx_cell_t *native_%zu(akx_runtime_ctx_t *, "
+            "akx_cell_t *, int);\n",
+            i);
+  }
+  fprintf(out, "\n");
+  for (size_t i = 0; i < call_count; i++) {
+    emit_call(out, plan, i);
+  }
+
+  fprintf(out, "static const akx_rt_aot_site_t sites[] = {\n");
+  for (size_t i = 0; i < call_count; i++) {
+    lowered_call_t *call = list_get(&plan->calls, i);
+    fprintf(out, "    {%" PRIu32 ", %zu, native_%zu},\n", call->number,
+            indices[call->nucleus], i);
+  }
+  fprintf(out, "    {0, 0, NULL},\n};\n\n");
+  AK24_FREE(indices);
+
+  emit_bytes(out, "source", ak_buffer_data(source), ak_buffer_count(source));
+  emit_bytes(out, "cells", ak_buffer_data(cells), ak_buffer_count(cells));
+
+  fprintf(out, "int main(int argc, char **argv) {\n");
+  fprintf(out, "  static const akx_rt_aot_program_t program = {\n");
+  fprintf(out, "      .filename = ");
+  emit_string(out, script);
+  fprintf(out, ",\n      .source = source,\n      .source_length = %zu,\n",
+          ak_buffer_count(source));
+  fprintf(out, "      .cells = cells,\n      .cells_length = %zu,\n",
+          ak_buffer_count(cells));
+  fprintf(out, "      .nuclei = nuclei,\n      .nucleus_count = %zu,\n",
+          nucleus_count);
+  fprintf(out, "      .sites = sites,\n      .site_count = %zu,\n",
+          call_count);
+  fprintf(out, "  };\n\n  ak_kernel_init(");
+  emit_string(out, binary);
+  fprintf(out, ");\n"
+               "  int status = akx_rt_aot_main(&program, argc, argv);\n"
+               "  ak_kernel_deinit();\n"
+               "  return status;\n}\n");
+
+  return ferror(out) ? -1 : 0;
+}
+
+// Splits words at spaces into argv, which keeps pointers into words
+static int split_args(char *words, char **argv, size_t *argc) {
+  for (char *word = strtok(words, " "); word; word = strtok(NULL, " ")) {
+    if (*argc + 1 >= AKX_AOT_MAX_ARGS) {
+      return -1;
+    }
+    argv[(*argc)++] = word;
+  }
+  return 0;
+}
+
+// Compiles c_path into binary with $CC (cc by default) at -O2
+static int run_compiler(const char *c_path, const char *binary) {
+  const char *cc = getenv("CC");
+  char *cc_words = strdup(cc && cc[0] ? cc : "cc");
+  char *cflags = strdup(AKX_AOT_CFLAGS);
+  char *libs = strdup(AKX_AOT_LIBS);
+  char *argv[AKX_AOT_MAX_ARGS];
+  size_t argc = 0;
+  int status = -1;
+
+  if (!cc_words || !cflags || !libs || split_args(cc_words, argv, &argc) != 0) {
+    goto done;
+  }
+  argv[argc++] = "-O2";
+  if (split_args(cflags, argv, &argc) != 0 ||
+      argc + 4 >= AKX_AOT_MAX_ARGS) {
+    goto done;
+  }
+  argv[argc++] = (char *)c_path;
+  argv[argc++] = "-o";
+  argv[argc++] = (char *)binary;
+  if (split_args(libs, argv, &argc) != 0) {
+    goto done;
+  }
+  argv[argc] = NULL;
+
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0) {
+    goto done;
+  }
+  if (pid == 0) {
+    execvp(argv[0], argv);
+    fprintf(stderr, "Error: Failed to run %s\n", argv[0]);
+    _exit(127);
+  }
+
+  int wait_status;
+  if (waitpid(pid, &wait_status, 0) == pid && WIFEXITED(wait_status)) {
+    status = WEXITSTATUS(wait_status);
+  }
+
+done:
+  free(cc_words);
+  free(cflags);
+  free(libs);
+  return status;
+}
+
+// Creates a private directory under $TMPDIR (/tmp by default) for the
+// generated C, so nothing is written beside the output
+static char *make_work_dir(void) {
+  const char *tmp = getenv("TMPDIR");
+  if (!tmp || !tmp[0]) {
+    tmp = "/tmp";
+  }
+  size_t len = strlen(tmp) + sizeof("/akx-compile-XXXXXX");
+  char *dir = AK24_ALLOC(len);
+  if (!dir) {
+    return NULL;
+  }
+  snprintf(dir, len, "%s/akx-compile-XXXXXX", tmp);
+  if (!mkdtemp(dir)) {
+    AK24_FREE(dir);
+    return NULL;
+  }
+  return dir;
+}
+
+// The script's file name without its directory and .akx
+static char *default_binary(const char *script) {
+  const char *base = strrchr(script, '/');
+  base = base ? base + 1 : script;
+  size_t len = strlen(base);
+  if (len > 4 && strcmp(base + len - 4, ".akx") == 0) {
+    len -= 4;
+  }
+  char *binary = AK24_ALLOC(len + 1);
+  if (binary) {
+    memcpy(binary, base, len);
+    binary[len] = '\0';
+  }
+  return binary;
+}
+
+int akx_compile(int argc, char **argv) {
+  const char *script = NULL;
+  const char *output = NULL;
+  int keep_c = 0;
+
+  for (int i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    } else if (strcmp(argv[i], "--keep-c") == 0) {
+      keep_c = 1;
+    } else if (!script && argv[i][0] != '-') {
+      script = argv[i];
+    } else {
+      script = NULL;
+      break;
+    }
+  }
+
+  if (!script) {
+    printf("Usage: akx compile <script.akx> [-o <binary>] [--keep-c]\n");
+    return 1;
+  }
+
+  ak_buffer_t *source = ak_buffer_from_file(script);
+  if (!source) {
+    printf("Error: Failed to read %s\n", script);
+    return 1;
+  }
+
+  akx_parse_result_t result = akx_cell_parse_buffer(source, script);
+  if (result.errors) {
+    akx_show_errors(result.errors);
+    akx_parse_result_free(&result);
+    ak_buffer_free(source);
+    return 1;
+  }
+
+  int status = 1;
+  char *binary = output ? NULL : default_binary(script);
+  const char *target = output ? output : binary;
+  ak_buffer_t *cells = ak_buffer_new(ak_buffer_count(source) + 64);
+  lowering_plan_t plan = {0};
+  list_init(&plan.calls);
+  char *work_dir = NULL;
+  char *c_path = NULL;
+  if (!cells || !target) {
+    printf("Error: Out of memory\n");
+    goto done;
+  }
+
+  if (akx_cell_serialize(&result, cells) != 0) {
+    printf("Error: Failed to serialize %s\n", script);
+    goto done;
+  }
+
+  list_iter_t iter = list_iter(&result.cells);
+  akx_cell_t **cell_ptr;
+  while ((cell_ptr = list_next(&result.cells, &iter))) {
+    if (plan_calls(&plan, *cell_ptr, 0) != 0) {
+      printf("Error: Out of memory\n");
+      goto done;
+    }
+  }
+
+  work_dir = make_work_dir();
+  if (!work_dir) {
+    printf("Error: Failed to create a temporary directory\n");
+    goto done;
+  }
+  size_t c_path_len = strlen(work_dir) + sizeof("/program.c");
+  c_path = AK24_ALLOC(c_path_len);
+  if (!c_path) {
+    printf("Error: Out of memory\n");
+    goto done;
+  }
+  snprintf(c_path, c_path_len, "%s/program.c", work_dir);
+  FILE *out = fopen(c_path, "wx");
+  if (!out) {
+    printf("Error: Failed to create %s\n", c_path);
+    goto done;
+  }
+  int emitted = emit_program(out, script, target, &plan, source, cells);
+  if (fclose(out) != 0 || emitted != 0) {
+    printf("Error: Failed to write %s\n", c_path);
+    goto done;
+  }
+
+  int rc = run_compiler(c_path, target);
+  if (rc != 0) {
+    printf("Error: C compiler failed (status %d)\n", rc);
+    goto done;
+  }
+  status = 0;
+
+done:
+  if (work_dir && keep_c) {
+    printf("Kept %s\n", c_path ? c_path : work_dir);
+  } else if (work_dir) {
+    if (c_path) {
+      unlink(c_path);
+    }
+    rmdir(work_dir);
+  }
+  AK24_FREE(c_path);
+  AK24_FREE(work_dir);
+  list_deinit(&plan.calls);
+  AK24_FREE(binary);
+  if (cells) {
+    ak_buffer_free(cells);
+  }
+  akx_parse_result_free(&result);
+  ak_buffer_free(source);
+  return status;
+}
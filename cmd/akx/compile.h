@@ -0,0 +1,7 @@
+#ifndef AKX_COMPILE_H
+#define AKX_COMPILE_H
+
+// akx compile <script.akx> [-o <binary>] [--keep-c]
+int akx_compile(int argc, char **argv);
+
+#endif
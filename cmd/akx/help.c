@@ -8,15 +8,35 @@ void akx_print_help(void) {
   printf("USAGE:\n");
   printf("  akx                     Start REPL mode\n");
   printf("  akx <file.akx>          Execute an AKX file\n");
+  printf("  akx -                   Execute a script read from stdin\n");
+  printf("  akx --engine=NAME ...   Use the tree, stack or vm evaluator\n");
   printf("  akx nucleus info        List compiled-in builtins\n");
   printf("  akx nucleus list        List available nuclei in ~/.akx/nucleus\n");
+  printf("  akx cache stats         Show parsed AST cache usage\n");
+  printf("  akx cache clear         Remove all cached ASTs\n");
+  printf("  akx compile F -o BIN    Build a native binary that runs F\n");
   printf("  akx -h, --help          Show this help message\n");
   printf("\n");
   printf("EXAMPLES:\n");
   printf("  akx script.akx          Run script.akx\n");
+  printf("  cat script.akx | akx    Run a script piped through stdin\n");
+  printf("  akx --engine=vm a.akx   Run a.akx on the bytecode VM\n");
+  printf("  akx compile a.akx -o a  Build ./a, which runs a.akx\n");
   printf("  akx nucleus info        Show all built-in functions\n");
   printf("  akx nucleus list        Show loadable nucleus files\n");
   printf("\n");
+  printf("ENVIRONMENT:\n");
+  printf("  AKX_ENGINE=NAME         Default for --engine\n");
+  printf("  AKX_GC=1                Reclaim cells with the tracing collector\n");
+  printf("  AKX_GC_STATS=1          Print collector statistics on exit\n");
+  printf("  AKX_JIT=1               Compile hot lambdas and loops natively\n");
+  printf("  AKX_JIT_STATS=1         Print JIT statistics on exit\n");
+  printf("  AKX_JIT_THRESHOLD=N     Calls or iterations before compiling\n");
+  printf("  AKX_QUICKEN=0           Leave builtin call sites unspecialized\n");
+  printf("  AKX_SLAB=1              Allocate cells from per-thread slabs\n");
+  printf("  AKX_SLAB_HUGEPAGES=1    Back cell slabs with huge pages\n");
+  printf("  AKX_SLAB_STATS=1        Print slab allocator statistics on exit\n");
+  printf("\n");
   printf("For more information, see the documentation.\n");
   printf("\n");
 }
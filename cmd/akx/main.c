@@ -3,6 +3,7 @@
 #include "help.h"
 #include "repl.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -44,12 +45,92 @@ APP_ON_SIGNAL(handle_sigabrt, SIGABRT) {
   _exit(134);
 }
 
+static int stats_requested(const char *name) {
+  const char *flag = getenv(name);
+  return flag && flag[0] && strcmp(flag, "0") != 0;
+}
+
+static void print_gc_stats(akx_runtime_ctx_t *runtime) {
+  if (!stats_requested("AKX_GC_STATS")) {
+    return;
+  }
+
+  akx_rt_gc_stats_t stats;
+  if (akx_rt_gc_get_stats(runtime, &stats) != 0) {
+    fprintf(stderr, "GC statistics need AKX_GC=1\n");
+    return;
+  }
+
+  fprintf(stderr, "\n=== GC Statistics ===\n");
+  fprintf(stderr, "Collections: %zu\n", stats.collections);
+  fprintf(stderr, "Heap cells: %zu (%zu bytes)\n", stats.heap_cells,
+          stats.heap_bytes);
+  fprintf(stderr, "Live after last collection: %zu\n", stats.live_cells);
+  fprintf(stderr, "Freed cells: %zu\n", stats.freed_cells);
+  fprintf(stderr, "Pause total/max/last: %.3f/%.3f/%.3f ms\n",
+          (double)stats.total_pause_ns / 1e6,
+          (double)stats.max_pause_ns / 1e6,
+          (double)stats.last_pause_ns / 1e6);
+  fprintf(stderr, "=====================\n");
+}
+
+static void print_slab_stats(akx_runtime_ctx_t *runtime) {
+  if (!stats_requested("AKX_SLAB_STATS")) {
+    return;
+  }
+
+  akx_rt_slab_stats_t stats;
+  if (akx_rt_slab_get_stats(runtime, &stats) != 0) {
+    fprintf(stderr, "Slab statistics need the slab allocator (AKX_SLAB=1)\n");
+    return;
+  }
+
+  fprintf(stderr, "\n=== Slab Statistics ===\n");
+  fprintf(stderr, "Slabs: %zu (peak %zu, %zu bytes)\n", stats.slabs,
+          stats.peak_slabs, stats.slab_bytes);
+  fprintf(stderr, "Live objects: %zu (peak %zu)\n", stats.live_objects,
+          stats.peak_objects);
+  fprintf(stderr, "Allocations: %zu\n", stats.allocations);
+  fprintf(stderr, "=======================\n");
+}
+
+static void print_jit_stats(akx_runtime_ctx_t *runtime) {
+  if (!stats_requested("AKX_JIT_STATS")) {
+    return;
+  }
+
+  akx_rt_jit_stats_t stats;
+  if (akx_rt_jit_get_stats(runtime, &stats) != 0) {
+    fprintf(stderr, "JIT statistics need AKX_JIT=1\n");
+    return;
+  }
+
+  fprintf(stderr, "\n=== JIT Statistics ===\n");
+  fprintf(stderr, "Tier-ups: %zu (rejected %zu, failed %zu)\n",
+          stats.tier_ups, stats.rejected, stats.failed);
+  fprintf(stderr, "Native calls: %zu\n", stats.native_calls);
+  fprintf(stderr, "Loop traces: %zu (side exits %zu)\n", stats.traces,
+          stats.side_exits);
+  fprintf(stderr, "Native loop iterations: %llu\n",
+          (unsigned long long)stats.native_iterations);
+  fprintf(stderr, "Deopts: %zu (invalidations %zu)\n", stats.deopts,
+          stats.invalidations);
+  fprintf(stderr, "Compile total/max/last: %.3f/%.3f/%.3f ms\n",
+          (double)stats.total_compile_ns / 1e6,
+          (double)stats.max_compile_ns / 1e6,
+          (double)stats.last_compile_ns / 1e6);
+  fprintf(stderr, "======================\n");
+}
+
 APP_ON_SHUTDOWN(on_shutdown) {
   time_t uptime = time(NULL) - ctx->shutdown_info->start_time;
   AK24_LOG_TRACE("Shutting down AKX runtime (uptime: %ld seconds)",
                  (long)uptime);
   AK24_LOG_TRACE("Deinitializing AKX core");
   if (g_runtime) {
+    print_gc_stats(g_runtime);
+    print_slab_stats(g_runtime);
+    print_jit_stats(g_runtime);
     akx_runtime_deinit(g_runtime);
     g_runtime = NULL;
   }
@@ -98,12 +179,6 @@ APP_MAIN(app_main) {
 
   size_t argc = list_count(&ctx->args);
 
-  if (argc == 1) {
-    akx_repl_signal_ctx_t signal_ctx = {.keep_running = &keep_running,
-                                        .signal_count = &signal_count};
-    return akx_repl_start(g_core, g_runtime, &signal_ctx);
-  }
-
   char **argv = AK24_ALLOC(sizeof(char *) * argc);
   if (!argv) {
     AK24_LOG_ERROR("Failed to allocate argv array");
@@ -117,13 +192,41 @@ APP_MAIN(app_main) {
     argv[i++] = *arg;
   }
 
+  // --engine=NAME picks the evaluator and is not passed on to the script
+  if (argc >= 2 && strncmp(argv[1], "--engine=", 9) == 0) {
+    const char *engine = argv[1] + 9;
+    if (akx_runtime_set_engine(g_runtime, engine) != 0) {
+      fprintf(stderr, "Unknown engine '%s' (expected tree, stack or vm)\n",
+              engine);
+      AK24_FREE(argv);
+      return 1;
+    }
+    memmove(argv + 1, argv + 2, sizeof(char *) * (argc - 2));
+    argc--;
+  }
+
+  if (argc == 1 && !isatty(STDIN_FILENO)) {
+    static char *stdin_argv[] = {"-"};
+    AK24_FREE(argv);
+    akx_runtime_set_script_args(g_runtime, 1, stdin_argv);
+    return akx_interpret_file("-", g_core, g_runtime);
+  }
+
+  if (argc == 1) {
+    akx_repl_signal_ctx_t signal_ctx = {.keep_running = &keep_running,
+                                        .signal_count = &signal_count};
+    AK24_FREE(argv);
+    return akx_repl_start(g_core, g_runtime, &signal_ctx);
+  }
+
   if (argc >= 2) {
     if (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
       akx_print_help();
       AK24_FREE(argv);
       return 0;
     }
-    if (strcmp(argv[1], "nucleus") != 0) {
+    if (strcmp(argv[1], "nucleus") != 0 && strcmp(argv[1], "cache") != 0 &&
+        strcmp(argv[1], "compile") != 0) {
       akx_runtime_set_script_args(g_runtime, (int)argc - 1, argv + 1);
       int result = akx_interpret_file(argv[1], g_core, g_runtime);
       AK24_FREE(argv);
@@ -74,10 +74,14 @@ akx_cell_t *exec_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
         break;
       }
       case AKX_TYPE_INTEGER_LITERAL: {
-        int val = akx_rt_cell_as_int(evaled_arg);
-        arg_str = AK24_ALLOC(32);
-        if (arg_str) {
-          snprintf(arg_str, 32, "%d", val);
+        ak_buffer_t *digits = akx_rt_int_to_buffer(evaled_arg);
+        if (digits) {
+          size_t len = ak_buffer_count(digits);
+          arg_str = AK24_ALLOC(len + 1);
+          if (arg_str) {
+            memcpy(arg_str, ak_buffer_data(digits), len + 1);
+          }
+          ak_buffer_free(digits);
         }
         break;
       }
@@ -145,7 +149,7 @@ akx_cell_t *exec_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     return NULL;
   }
 
-  akx_parse_result_t result = akx_cell_parse_file(expanded_path);
+  akx_parse_result_t result = akx_cell_cache_parse_file(expanded_path);
   AK24_FREE(expanded_path);
 
   if (result.errors) {
@@ -25,7 +25,7 @@ akx_cell_t *assert_ne_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
   } else {
     switch (akx_rt_cell_get_type(left)) {
     case AKX_TYPE_INTEGER_LITERAL:
-      equal = (left->value.integer_literal == right->value.integer_literal);
+      equal = (akx_rt_int_cmp(left, right) == 0);
       break;
     case AKX_TYPE_REAL_LITERAL:
       equal = (left->value.real_literal == right->value.real_literal);
@@ -82,7 +82,5 @@ akx_cell_t *assert_ne_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     akx_cell_free(right);
   }
 
-  akx_cell_t *ret = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
-  akx_rt_set_symbol(rt, ret, "t");
-  return ret;
+  return akx_rt_make_symbol(rt, "t");
 }
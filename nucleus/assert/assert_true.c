@@ -37,7 +37,5 @@ akx_cell_t *assert_true_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     raise(SIGABRT);
   }
 
-  akx_cell_t *ret = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
-  akx_rt_set_symbol(rt, ret, "t");
-  return ret;
+  return akx_rt_make_symbol(rt, "t");
 }
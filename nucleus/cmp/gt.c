@@ -1,55 +1,22 @@
-akx_cell_t *gt_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
-  if (akx_rt_list_length(args) != 2) {
-    akx_rt_error(rt, "gt requires exactly 2 arguments");
-    return NULL;
-  }
-
-  akx_cell_t *left_cell = akx_rt_list_nth(args, 0);
-  akx_cell_t *right_cell = akx_rt_list_nth(args, 1);
-
-  akx_cell_t *left = akx_rt_eval(rt, left_cell);
-  if (!left) {
-    return NULL;
-  }
-
-  akx_cell_t *right = akx_rt_eval(rt, right_cell);
-  if (!right) {
-    if (akx_rt_cell_get_type(left) != AKX_TYPE_LAMBDA) {
-      akx_rt_free_cell(rt, left);
-    }
-    return NULL;
-  }
-
-  akx_type_t left_type = akx_rt_cell_get_type(left);
-  akx_type_t right_type = akx_rt_cell_get_type(right);
-
-  int result = 0;
-  if (left_type != right_type) {
+const akx_builtin_signature_t gt_impl_signature = {
+    .name = "gt",
+    .min_args = 2,
+    .max_args = 2,
+    .accepts = AKX_ARG(AKX_TYPE_INTEGER_LITERAL) |
+               AKX_ARG(AKX_TYPE_REAL_LITERAL) | AKX_ARG_BIGNUM,
+};
+
+int gt_impl(akx_runtime_ctx_t *rt, akx_value_t *argv, size_t argc,
+            akx_value_t *result) {
+  (void)argc;
+  if (argv[0].type != argv[1].type) {
     akx_rt_error(rt, "gt: both operands must be the same type");
-  } else if (left_type == AKX_TYPE_INTEGER_LITERAL) {
-    result = (akx_rt_cell_as_int(left) > akx_rt_cell_as_int(right));
-  } else if (left_type == AKX_TYPE_REAL_LITERAL) {
-    result = (akx_rt_cell_as_real(left) > akx_rt_cell_as_real(right));
-  } else {
-    akx_rt_error(rt, "gt: operands must be integer or real");
-  }
-
-  int has_error = (result == 0 && (left_type != right_type ||
-                                   (left_type != AKX_TYPE_INTEGER_LITERAL &&
-                                    left_type != AKX_TYPE_REAL_LITERAL)));
-
-  if (akx_rt_cell_get_type(left) != AKX_TYPE_LAMBDA) {
-    akx_rt_free_cell(rt, left);
+    return -1;
   }
-  if (akx_rt_cell_get_type(right) != AKX_TYPE_LAMBDA) {
-    akx_rt_free_cell(rt, right);
-  }
-
-  if (has_error) {
-    return NULL;
+  if (argv[0].type == AKX_TYPE_INTEGER_LITERAL) {
+    *result = AKX_VALUE_INT(akx_rt_int_cmp(argv[0].cell, argv[1].cell) > 0);
+  } else {
+    *result = AKX_VALUE_INT(argv[0].as.real > argv[1].as.real);
   }
-
-  akx_cell_t *ret = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, ret, result);
-  return ret;
+  return 0;
 }
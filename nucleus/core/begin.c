@@ -1,8 +1,6 @@
 akx_cell_t *begin_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
   if (akx_rt_list_length(args) == 0) {
-    akx_cell_t *nil = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
-    akx_rt_set_symbol(rt, nil, "nil");
-    return nil;
+    return akx_rt_nil(rt);
   }
 
   akx_cell_t *result = NULL;
@@ -13,7 +11,11 @@ akx_cell_t *begin_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
       akx_rt_free_cell(rt, result);
     }
 
-    result = akx_rt_eval(rt, current);
+    if (akx_rt_cell_next(current)) {
+      result = akx_rt_eval(rt, current);
+    } else {
+      result = akx_rt_eval_in_tail(rt, current);
+    }
     if (!result) {
       return NULL;
     }
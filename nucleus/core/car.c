@@ -25,15 +25,13 @@ akx_cell_t *car_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     return NULL;
   }
 
-  akx_cell_t *result = akx_cell_clone(list_head);
+  akx_cell_t *result = akx_cell_promote(list_head);
   if (!result) {
     akx_rt_error(rt, "car: failed to clone first element");
     akx_rt_free_cell(rt, list);
     return NULL;
   }
 
-  result->next = NULL;
-
   akx_rt_free_cell(rt, list);
 
   return result;
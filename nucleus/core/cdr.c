@@ -20,21 +20,23 @@ akx_cell_t *cdr_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
 
   akx_cell_t *list_head = akx_rt_cell_as_list(list);
   if (!list_head) {
-    akx_cell_t *nil = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
-    akx_rt_set_symbol(rt, nil, "nil");
     akx_rt_free_cell(rt, list);
-    return nil;
+    return akx_rt_nil(rt);
   }
 
   akx_cell_t *rest = list_head->next;
   if (!rest) {
-    akx_cell_t *nil = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
-    akx_rt_set_symbol(rt, nil, "nil");
     akx_rt_free_cell(rt, list);
-    return nil;
+    return akx_rt_nil(rt);
   }
 
-  akx_cell_t *rest_clone = akx_cell_clone(rest);
+  // An unshared list gives up its tail instead of copying it
+  akx_cell_t *rest_clone = rest;
+  if (akx_cell_is_shared(list)) {
+    rest_clone = akx_cell_clone(rest);
+  } else {
+    list_head->next = NULL;
+  }
   if (!rest_clone) {
     akx_rt_error(rt, "cdr: failed to clone rest of list");
     akx_rt_free_cell(rt, list);
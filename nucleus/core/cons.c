@@ -1,68 +1,55 @@
-akx_cell_t *cons_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
-  if (akx_rt_list_length(args) != 2) {
-    akx_rt_error(rt, "cons requires exactly 2 arguments");
-    return NULL;
-  }
-
-  akx_cell_t *element_cell = akx_rt_list_nth(args, 0);
-  akx_cell_t *list_cell = akx_rt_list_nth(args, 1);
-
-  akx_cell_t *element = akx_rt_eval(rt, element_cell);
-  if (!element) {
-    return NULL;
-  }
-
-  akx_cell_t *list = akx_rt_eval(rt, list_cell);
-  if (!list) {
-    akx_rt_free_cell(rt, element);
-    return NULL;
-  }
-
-  akx_type_t list_type = akx_rt_cell_get_type(list);
+const akx_builtin_signature_t cons_impl_signature = {
+    .name = "cons",
+    .min_args = 2,
+    .max_args = 2,
+    .accepts = AKX_ARG_ANY,
+};
+
+int cons_impl(akx_runtime_ctx_t *rt, akx_value_t *argv, size_t argc,
+              akx_value_t *result) {
+  (void)argc;
+  akx_cell_t *list = argv[1].cell;
+
+  akx_type_t list_type = argv[1].type;
   if (list_type != AKX_TYPE_LIST && list_type != AKX_TYPE_LIST_SQUARE &&
       list_type != AKX_TYPE_LIST_CURLY && list_type != AKX_TYPE_LIST_TEMPLE) {
     akx_rt_error(rt, "cons: second argument must be a list");
-    akx_rt_free_cell(rt, element);
-    akx_rt_free_cell(rt, list);
-    return NULL;
+    return -1;
   }
 
   akx_cell_t *list_head = akx_rt_cell_as_list(list);
-  akx_cell_t *element_clone = akx_cell_clone(element);
+  akx_cell_t *element_clone = akx_cell_clone(argv[0].cell);
   if (!element_clone) {
     akx_rt_error(rt, "cons: failed to clone element");
-    akx_rt_free_cell(rt, element);
-    akx_rt_free_cell(rt, list);
-    return NULL;
+    return -1;
   }
 
   element_clone->next = NULL;
 
   if (list_head) {
-    akx_cell_t *list_head_clone = akx_cell_clone(list_head);
+    // An unshared list gives up its elements instead of copying them
+    akx_cell_t *list_head_clone = list_head;
+    if (akx_cell_is_shared(list)) {
+      list_head_clone = akx_cell_clone(list_head);
+    } else {
+      list->value.list_head = NULL;
+    }
     if (!list_head_clone) {
       akx_rt_error(rt, "cons: failed to clone list");
       akx_cell_free(element_clone);
-      akx_rt_free_cell(rt, element);
-      akx_rt_free_cell(rt, list);
-      return NULL;
+      return -1;
     }
     element_clone->next = list_head_clone;
   }
 
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_LIST);
-  if (!result) {
+  akx_cell_t *cell = akx_rt_alloc_cell(rt, AKX_TYPE_LIST);
+  if (!cell) {
     akx_rt_error(rt, "cons: failed to allocate result cell");
     akx_cell_free(element_clone);
-    akx_rt_free_cell(rt, element);
-    akx_rt_free_cell(rt, list);
-    return NULL;
+    return -1;
   }
 
-  akx_rt_set_list(rt, result, element_clone);
-
-  akx_rt_free_cell(rt, element);
-  akx_rt_free_cell(rt, list);
-
-  return result;
+  akx_rt_set_list(rt, cell, element_clone);
+  *result = AKX_VALUE_CELL(cell);
+  return 0;
 }
@@ -13,7 +13,5 @@ akx_cell_t *defined_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
   const char *sym = akx_rt_cell_as_symbol(symbol_cell);
   void *value = akx_rt_scope_get(rt, sym);
 
-  akx_cell_t *ret = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, ret, value ? 1 : 0);
-  return ret;
+  return akx_rt_make_int(rt, value ? 1 : 0);
 }
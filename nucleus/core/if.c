@@ -22,18 +22,17 @@ akx_cell_t *if_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
       akx_rt_cell_as_int(condition) == 1) {
     is_true = 1;
   }
+  akx_rt_jit_branch(rt, args, is_true);
 
   if (akx_rt_cell_get_type(condition) != AKX_TYPE_LAMBDA) {
     akx_rt_free_cell(rt, condition);
   }
 
   if (is_true) {
-    return akx_rt_eval(rt, then_branch);
+    return akx_rt_eval_in_tail(rt, then_branch);
   } else if (else_branch) {
-    return akx_rt_eval(rt, else_branch);
+    return akx_rt_eval_in_tail(rt, else_branch);
   } else {
-    akx_cell_t *nil = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
-    akx_rt_set_symbol(rt, nil, "nil");
-    return nil;
+    return akx_rt_nil(rt);
   }
 }
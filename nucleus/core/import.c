@@ -30,7 +30,7 @@ akx_cell_t *import_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     return NULL;
   }
 
-  akx_parse_result_t result = akx_cell_parse_file(expanded_path);
+  akx_parse_result_t result = akx_cell_cache_parse_file(expanded_path);
   AK24_FREE(expanded_path);
 
   if (result.errors) {
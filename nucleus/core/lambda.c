@@ -9,37 +9,29 @@ static void akx_lambda_context_free(void *ctx) {
   if (lambda_ctx->body) {
     akx_cell_free(lambda_ctx->body);
   }
-  AK24_FREE(lambda_ctx);
+  akx_rt_code_free(lambda_ctx->code);
+  akx_rt_jit_code_free(lambda_ctx->jit);
+  akx_rt_free_mem(lambda_ctx->rt, lambda_ctx, sizeof(akx_lambda_context_t));
 }
 
+// The runtime has already bound the parameters in the call's frame, so only
+// the body is left
 static void akx_lambda_invoke_impl(void *captured_ctx, void *invoke_args) {
+  (void)invoke_args;
   if (!captured_ctx) {
     return;
   }
 
   akx_lambda_context_t *lambda_ctx = (akx_lambda_context_t *)captured_ctx;
   akx_runtime_ctx_t *rt = lambda_ctx->rt;
-  akx_cell_t *args = (akx_cell_t *)invoke_args;
 
-  lambda_ctx->result = NULL;
-
-  size_t arg_count = akx_rt_list_length(args);
-  if (arg_count != lambda_ctx->param_count) {
-    akx_rt_error_fmt(rt, "lambda: expected %zu arguments, got %zu",
-                     lambda_ctx->param_count, arg_count);
+  // Native code from the JIT, once there is some, computes the whole body
+  akx_cell_t *result = akx_rt_jit_run(rt, lambda_ctx);
+  lambda_ctx->result = result;
+  if (result) {
     return;
   }
 
-  for (size_t i = 0; i < lambda_ctx->param_count; i++) {
-    akx_cell_t *arg = akx_rt_list_nth(args, i);
-    akx_cell_t *evaled = akx_rt_eval(rt, arg);
-    if (!evaled) {
-      return;
-    }
-    akx_rt_scope_set(rt, lambda_ctx->param_names[i], evaled);
-  }
-
-  akx_cell_t *result = NULL;
   akx_cell_t *current = lambda_ctx->body;
   while (current) {
     if (result) {
@@ -104,7 +96,7 @@ akx_cell_t *lambda_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
   akx_cell_t *body_tail = NULL;
   akx_cell_t *current = body;
   while (current) {
-    akx_cell_t *cloned = akx_cell_clone(current);
+    akx_cell_t *cloned = akx_cell_promote(current);
     if (!cloned) {
       if (param_names) {
         AK24_FREE(param_names);
@@ -115,7 +107,6 @@ akx_cell_t *lambda_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
       akx_rt_error(rt, "lambda: failed to clone body");
       return NULL;
     }
-    cloned->next = NULL;
     if (!body_clone) {
       body_clone = cloned;
       body_tail = cloned;
@@ -126,7 +117,8 @@ akx_cell_t *lambda_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     current = current->next;
   }
 
-  akx_lambda_context_t *lambda_ctx = AK24_ALLOC(sizeof(akx_lambda_context_t));
+  akx_lambda_context_t *lambda_ctx =
+      akx_rt_alloc_mem(rt, sizeof(akx_lambda_context_t));
   if (!lambda_ctx) {
     if (param_names) {
       AK24_FREE(param_names);
@@ -142,7 +134,12 @@ akx_cell_t *lambda_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
   lambda_ctx->param_names = param_names;
   lambda_ctx->param_count = param_count;
   lambda_ctx->body = body_clone;
+  lambda_ctx->local_count = param_count + akx_rt_count_lets(body_clone);
   lambda_ctx->result = NULL;
+  lambda_ctx->code = NULL;
+  lambda_ctx->calls = 0;
+  lambda_ctx->jit = NULL;
+  akx_rt_resolve_locals(rt, lambda_ctx, param_names, param_count, body_clone);
 
   ak_lambda_t *lambda = ak_lambda_new(akx_lambda_invoke_impl, lambda_ctx,
                                       akx_lambda_context_free);
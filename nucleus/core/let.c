@@ -7,8 +7,7 @@ akx_cell_t *let_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
 
   const char *symbol = akx_rt_cell_as_symbol(symbol_cell);
 
-  ak_context_t *scope = akx_rt_get_scope(rt);
-  if (ak_context_has_local(scope, symbol)) {
+  if (akx_rt_scope_has_local(rt, symbol)) {
     akx_rt_error_fmt(rt, "let: symbol '%s' already defined in current scope",
                      symbol);
     return NULL;
@@ -27,7 +26,7 @@ akx_cell_t *let_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
 
   akx_rt_scope_set(rt, symbol, evaled);
 
-  akx_cell_t *returned = akx_cell_clone(evaled);
+  akx_cell_t *returned = akx_rt_copy(rt, evaled);
   if (!returned) {
     akx_rt_error(rt, "let: failed to clone value for return");
     return NULL;
@@ -7,9 +7,31 @@ akx_cell_t *loop_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
   akx_cell_t *condition_cell = akx_rt_list_nth(args, 0);
   akx_cell_t *body = akx_rt_list_nth(args, 1);
 
+  size_t locals = akx_rt_count_lets(body);
   akx_cell_t *last_result = NULL;
+  akx_rt_jit_trace_t *trace = akx_rt_jit_loop_trace(rt, args);
 
   while (1) {
+    akx_rt_gc_safepoint(rt);
+
+    akx_cell_t *native = NULL;
+    int done = akx_rt_jit_loop_run(rt, trace, &native);
+    if (native) {
+      if (last_result && akx_rt_cell_get_type(last_result) != AKX_TYPE_LAMBDA) {
+        akx_rt_free_cell(rt, last_result);
+      }
+      last_result = native;
+    }
+    if (done < 0) {
+      if (last_result && akx_rt_cell_get_type(last_result) != AKX_TYPE_LAMBDA) {
+        akx_rt_free_cell(rt, last_result);
+      }
+      return NULL;
+    }
+    if (done) {
+      break;
+    }
+
     akx_cell_t *condition = akx_rt_eval(rt, condition_cell);
     if (!condition) {
       if (last_result && akx_rt_cell_get_type(last_result) != AKX_TYPE_LAMBDA) {
@@ -32,7 +54,7 @@ akx_cell_t *loop_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
       break;
     }
 
-    akx_rt_push_scope(rt);
+    akx_rt_push_scope_sized(rt, locals);
 
     if (last_result && akx_rt_cell_get_type(last_result) != AKX_TYPE_LAMBDA) {
       akx_rt_free_cell(rt, last_result);
@@ -49,11 +71,11 @@ akx_cell_t *loop_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     }
 
     akx_rt_pop_scope(rt);
+    akx_rt_jit_loop_step(rt, trace);
   }
 
   if (!last_result) {
-    last_result = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
-    akx_rt_set_symbol(rt, last_result, "nil");
+    last_result = akx_rt_nil(rt);
   }
 
   return last_result;
@@ -7,8 +7,8 @@ akx_cell_t *set_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
 
   const char *symbol = akx_rt_cell_as_symbol(symbol_cell);
 
-  ak_context_t *scope = akx_rt_get_scope(rt);
-  if (!ak_context_has(scope, symbol)) {
+  akx_rt_scope_t *containing = akx_rt_scope_find(rt, symbol_cell);
+  if (!containing) {
     akx_rt_error_fmt(rt, "set: symbol '%s' is not defined", symbol);
     return NULL;
   }
@@ -24,16 +24,13 @@ akx_cell_t *set_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     return NULL;
   }
 
-  ak_context_t *containing = ak_context_get_containing_context(scope, symbol);
-  if (containing) {
-    void *old_value = ak_context_get_local(containing, symbol);
-    if (old_value) {
-      akx_cell_free((akx_cell_t *)old_value);
-    }
-    ak_context_set(containing, symbol, evaled);
+  void *old_value = NULL;
+  akx_rt_scope_assign(rt, containing, symbol, evaled, &old_value);
+  if (old_value) {
+    akx_cell_free((akx_cell_t *)old_value);
   }
 
-  akx_cell_t *returned = akx_cell_clone(evaled);
+  akx_cell_t *returned = akx_rt_copy(rt, evaled);
   if (!returned) {
     akx_rt_error(rt, "set: failed to clone value for return");
     return NULL;
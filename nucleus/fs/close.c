@@ -35,8 +35,8 @@ akx_cell_t *close_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
                                  "fs/close: fid must be an integer");
       if (!fid_cell)
         return NULL;
-      fid = akx_rt_cell_as_int(fid_cell);
-      akx_rt_free_cell(rt, fid_cell);
+      if (fs_int_arg(rt, fid_cell, "fs/close: fid", &fid) != 0)
+        return NULL;
     } else {
       akx_rt_error_fmt(rt, "fs/close: unknown keyword: %s", keyword);
       return NULL;
@@ -66,7 +66,5 @@ akx_cell_t *close_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
 
   akx_rt_scope_set(rt, fid_to_key(fid), NULL);
 
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, result, 1);
-  return result;
+  return akx_rt_make_int(rt, 1);
 }
@@ -29,7 +29,5 @@ akx_cell_t *exists_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
 
   akx_rt_free_cell(rt, path_cell);
 
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, result, exists ? 1 : 0);
-  return result;
+  return akx_rt_make_int(rt, exists ? 1 : 0);
 }
@@ -1,6 +1,8 @@
 #ifndef FS_HANDLES_INTERNAL_H
 #define FS_HANDLES_INTERNAL_H
 
+#include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 
 typedef struct {
@@ -18,4 +20,21 @@ static inline char *fid_to_key(int fid) {
   return key;
 }
 
+// Reads an evaluated integer argument that must fit an int and frees its
+// cell; an integer out of range is a runtime error
+static inline int fs_int_arg(akx_runtime_ctx_t *rt, akx_cell_t *cell,
+                             const char *what, int *out) {
+  int64_t value = 0;
+  int status = akx_rt_cell_to_int(rt, cell, &value);
+  if (status == 0 && (value < INT_MIN || value > INT_MAX)) {
+    akx_rt_error_fmt(rt, "%s is out of range", what);
+    status = -1;
+  }
+  akx_rt_free_cell(rt, cell);
+  if (status == 0) {
+    *out = (int)value;
+  }
+  return status;
+}
+
 #endif
@@ -28,7 +28,5 @@ akx_cell_t *is_file_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     free(expanded_path);
   akx_rt_free_cell(rt, path_cell);
 
-  akx_cell_t *result_cell = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, result_cell, is_file ? 1 : 0);
-  return result_cell;
+  return akx_rt_make_int(rt, is_file ? 1 : 0);
 }
@@ -93,9 +93,7 @@ akx_cell_t *open_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
   if (mode_copy)
     free(mode_copy);
 
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, result, fid);
-  return result;
+  return akx_rt_make_int(rt, fid);
 
 cleanup_error:
   if (expanded_path)
@@ -43,48 +43,48 @@ akx_cell_t *file_read_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
                                  "fs/read: fid must be an integer");
       if (!fid_cell)
         return NULL;
-      fid = akx_rt_cell_as_int(fid_cell);
-      akx_rt_free_cell(rt, fid_cell);
+      if (fs_int_arg(rt, fid_cell, "fs/read: fid", &fid) != 0)
+        return NULL;
     } else if (strcmp(keyword, ":bytes") == 0) {
       akx_cell_t *bytes_cell =
           akx_rt_eval_and_assert(rt, current, AKX_TYPE_INTEGER_LITERAL,
                                  "fs/read: bytes must be an integer");
       if (!bytes_cell)
         return NULL;
-      bytes = akx_rt_cell_as_int(bytes_cell);
-      akx_rt_free_cell(rt, bytes_cell);
+      if (fs_int_arg(rt, bytes_cell, "fs/read: bytes", &bytes) != 0)
+        return NULL;
     } else if (strcmp(keyword, ":lines") == 0) {
       akx_cell_t *lines_cell =
           akx_rt_eval_and_assert(rt, current, AKX_TYPE_INTEGER_LITERAL,
                                  "fs/read: lines must be an integer");
       if (!lines_cell)
         return NULL;
-      lines = akx_rt_cell_as_int(lines_cell);
-      akx_rt_free_cell(rt, lines_cell);
+      if (fs_int_arg(rt, lines_cell, "fs/read: lines", &lines) != 0)
+        return NULL;
     } else if (strcmp(keyword, ":offset") == 0) {
       akx_cell_t *offset_cell =
           akx_rt_eval_and_assert(rt, current, AKX_TYPE_INTEGER_LITERAL,
                                  "fs/read: offset must be an integer");
       if (!offset_cell)
         return NULL;
-      offset = akx_rt_cell_as_int(offset_cell);
-      akx_rt_free_cell(rt, offset_cell);
+      if (fs_int_arg(rt, offset_cell, "fs/read: offset", &offset) != 0)
+        return NULL;
     } else if (strcmp(keyword, ":line-start") == 0) {
       akx_cell_t *ls_cell =
           akx_rt_eval_and_assert(rt, current, AKX_TYPE_INTEGER_LITERAL,
                                  "fs/read: line-start must be an integer");
       if (!ls_cell)
         return NULL;
-      line_start = akx_rt_cell_as_int(ls_cell);
-      akx_rt_free_cell(rt, ls_cell);
+      if (fs_int_arg(rt, ls_cell, "fs/read: line-start", &line_start) != 0)
+        return NULL;
     } else if (strcmp(keyword, ":line-end") == 0) {
       akx_cell_t *le_cell =
           akx_rt_eval_and_assert(rt, current, AKX_TYPE_INTEGER_LITERAL,
                                  "fs/read: line-end must be an integer");
       if (!le_cell)
         return NULL;
-      line_end = akx_rt_cell_as_int(le_cell);
-      akx_rt_free_cell(rt, le_cell);
+      if (fs_int_arg(rt, le_cell, "fs/read: line-end", &line_end) != 0)
+        return NULL;
     } else {
       akx_rt_error_fmt(rt, "fs/read: unknown keyword: %s", keyword);
       return NULL;
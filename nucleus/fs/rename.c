@@ -51,7 +51,5 @@ akx_cell_t *rename_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
   akx_rt_free_cell(rt, old_path_cell);
   akx_rt_free_cell(rt, new_path_cell);
 
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, result, (result_code == 0) ? 1 : 0);
-  return result;
+  return akx_rt_make_int(rt, (result_code == 0) ? 1 : 0);
 }
@@ -26,7 +26,5 @@ akx_cell_t *rmdir_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     free(expanded_path);
   akx_rt_free_cell(rt, path_cell);
 
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, result, (result_code == 0) ? 1 : 0);
-  return result;
+  return akx_rt_make_int(rt, (result_code == 0) ? 1 : 0);
 }
@@ -38,16 +38,16 @@ akx_cell_t *seek_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
                                  "fs/seek: fid must be an integer");
       if (!fid_cell)
         return NULL;
-      fid = akx_rt_cell_as_int(fid_cell);
-      akx_rt_free_cell(rt, fid_cell);
+      if (fs_int_arg(rt, fid_cell, "fs/seek: fid", &fid) != 0)
+        return NULL;
     } else if (strcmp(keyword, ":offset") == 0) {
       akx_cell_t *offset_cell =
           akx_rt_eval_and_assert(rt, current, AKX_TYPE_INTEGER_LITERAL,
                                  "fs/seek: offset must be an integer");
       if (!offset_cell)
         return NULL;
-      offset = akx_rt_cell_as_int(offset_cell);
-      akx_rt_free_cell(rt, offset_cell);
+      if (fs_int_arg(rt, offset_cell, "fs/seek: offset", &offset) != 0)
+        return NULL;
     } else if (strcmp(keyword, ":whence") == 0) {
       // Don't evaluate - args are passed unevaluated
       if (current->type != AKX_TYPE_SYMBOL) {
@@ -95,7 +95,5 @@ akx_cell_t *seek_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
   long new_pos = ftell(handle->fp);
   handle->position = new_pos;
 
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, result, (int)new_pos);
-  return result;
+  return akx_rt_make_int(rt, (int)new_pos);
 }
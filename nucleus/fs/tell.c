@@ -36,8 +36,8 @@ akx_cell_t *tell_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
                                  "fs/tell: fid must be an integer");
       if (!fid_cell)
         return NULL;
-      fid = akx_rt_cell_as_int(fid_cell);
-      akx_rt_free_cell(rt, fid_cell);
+      if (fs_int_arg(rt, fid_cell, "fs/tell: fid", &fid) != 0)
+        return NULL;
     } else {
       akx_rt_error_fmt(rt, "fs/tell: unknown keyword: %s", keyword);
       return NULL;
@@ -65,7 +65,5 @@ akx_cell_t *tell_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
 
   handle->position = pos;
 
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, result, (int)pos);
-  return result;
+  return akx_rt_make_int(rt, (int)pos);
 }
@@ -48,8 +48,11 @@ akx_cell_t *file_write_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
           free(content);
         return NULL;
       }
-      fid = akx_rt_cell_as_int(fid_cell);
-      akx_rt_free_cell(rt, fid_cell);
+      if (fs_int_arg(rt, fid_cell, "fs/write: fid", &fid) != 0) {
+        if (content)
+          free(content);
+        return NULL;
+      }
     } else if (strcmp(keyword, ":content") == 0) {
       akx_cell_t *content_cell =
           akx_rt_eval_and_assert(rt, current, AKX_TYPE_STRING_LITERAL,
@@ -70,8 +73,11 @@ akx_cell_t *file_write_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
           free(content);
         return NULL;
       }
-      offset = akx_rt_cell_as_int(offset_cell);
-      akx_rt_free_cell(rt, offset_cell);
+      if (fs_int_arg(rt, offset_cell, "fs/write: offset", &offset) != 0) {
+        if (content)
+          free(content);
+        return NULL;
+      }
     } else if (strcmp(keyword, ":append") == 0) {
       akx_cell_t *append_cell = akx_rt_eval(rt, current);
       if (!append_cell) {
@@ -81,7 +87,8 @@ akx_cell_t *file_write_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
       }
       // Check for truthy values: 1, "true", or non-zero integers
       if (append_cell->type == AKX_TYPE_INTEGER_LITERAL) {
-        append = (akx_rt_cell_as_int(append_cell) != 0);
+        append = akx_rt_cell_is_bignum(append_cell) ||
+               akx_rt_cell_as_int(append_cell) != 0;
       } else if (append_cell->type == AKX_TYPE_SYMBOL) {
         const char *sym = akx_rt_cell_as_symbol(append_cell);
         append = (strcmp(sym, "true") == 0);
@@ -132,7 +139,5 @@ akx_cell_t *file_write_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
 
   free(content);
 
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, result, (int)written);
-  return result;
+  return akx_rt_make_int(rt, (int)written);
 }
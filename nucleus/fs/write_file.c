@@ -61,7 +61,5 @@ akx_cell_t *write_file_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     return NULL;
   }
 
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, result, (int)written);
-  return result;
+  return akx_rt_make_int(rt, (int)written);
 }
@@ -63,11 +63,12 @@ akx_cell_t *putf_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
 
       if (*p == 'd') {
         if (arg_type == AKX_TYPE_INTEGER_LITERAL) {
-          int val = akx_rt_cell_as_int(arg);
-          char buf[32];
-          int len = snprintf(buf, sizeof(buf), "%d", val);
-          printf("%s", buf);
-          char_count += len;
+          ak_buffer_t *digits = akx_rt_int_to_buffer(arg);
+          if (digits) {
+            printf("%s", (const char *)ak_buffer_data(digits));
+            char_count += ak_buffer_count(digits);
+            ak_buffer_free(digits);
+          }
         } else {
           akx_rt_error(rt, "io/putf: %d expects integer");
           akx_rt_free_cell(rt, arg);
@@ -195,11 +196,12 @@ akx_cell_t *putf_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
           break;
         }
         case AKX_TYPE_INTEGER_LITERAL: {
-          int val = akx_rt_cell_as_int(arg);
-          char buf[32];
-          int len = snprintf(buf, sizeof(buf), "%d", val);
-          printf("%s", buf);
-          char_count += len;
+          ak_buffer_t *digits = akx_rt_int_to_buffer(arg);
+          if (digits) {
+            printf("%s", (const char *)ak_buffer_data(digits));
+            char_count += ak_buffer_count(digits);
+            ak_buffer_free(digits);
+          }
           break;
         }
         case AKX_TYPE_REAL_LITERAL: {
@@ -253,7 +255,5 @@ akx_cell_t *putf_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
 
   akx_rt_free_cell(rt, format_cell);
 
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, result, char_count);
-  return result;
+  return akx_rt_make_int(rt, char_count);
 }
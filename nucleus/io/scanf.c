@@ -35,8 +35,8 @@ akx_cell_t *scanf_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
       akx_cell_t *value = NULL;
 
       if (*p == 'd') {
-        int val;
-        if (scanf("%d", &val) != 1) {
+        long long val;
+        if (scanf("%lld", &val) != 1) {
           akx_rt_error(rt, "io/scanf: failed to read integer");
           akx_rt_free_cell(rt, format_cell);
           if (result_list)
@@ -29,6 +29,7 @@ static akx_cell_t *iter_list(akx_runtime_ctx_t *rt, akx_cell_t *list,
     if (item_clone) {
       akx_cell_free(item_clone);
     }
+    transformed = akx_rt_unshare(rt, transformed);
 
     if (!transformed) {
       if (result_head) {
@@ -49,9 +50,7 @@ static akx_cell_t *iter_list(akx_runtime_ctx_t *rt, akx_cell_t *list,
   }
 
   if (!result_head) {
-    result_head = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
-    akx_rt_set_symbol(rt, result_head, "nil");
-    return result_head;
+    return akx_rt_nil(rt);
   }
 
   // Wrap the result list in a LIST cell
@@ -133,12 +132,13 @@ static akx_cell_t *iter_string(akx_runtime_ctx_t *rt, const char *str,
   return result;
 }
 
-static akx_cell_t *iter_integer(akx_runtime_ctx_t *rt, int value,
+static akx_cell_t *iter_integer(akx_runtime_ctx_t *rt, int64_t value,
                                 akx_cell_t *lambda_cell) {
-  int result = 0;
+  uint64_t bits = (uint64_t)value;
+  uint64_t result = 0;
 
-  for (int bit_pos = 0; bit_pos < 32; bit_pos++) {
-    int bit_value = (value >> bit_pos) & 1;
+  for (int bit_pos = 0; bit_pos < 64; bit_pos++) {
+    int bit_value = (bits >> bit_pos) & 1;
 
     akx_cell_t *bit_cell = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
     akx_rt_set_int(rt, bit_cell, bit_value);
@@ -152,17 +152,16 @@ static akx_cell_t *iter_integer(akx_runtime_ctx_t *rt, int value,
     }
 
     if (akx_rt_cell_get_type(transformed) == AKX_TYPE_INTEGER_LITERAL) {
-      int new_bit = akx_rt_cell_as_int(transformed) ? 1 : 0;
-      result = (result & ~(1 << bit_pos)) | (new_bit << bit_pos);
+      uint64_t new_bit = akx_rt_cell_is_bignum(transformed) ||
+                         akx_rt_cell_as_int(transformed) != 0;
+      result = (result & ~(1ULL << bit_pos)) | (new_bit << bit_pos);
     }
 
     akx_cell_free(bit_cell);
     akx_rt_free_cell(rt, transformed);
   }
 
-  akx_cell_t *result_cell = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, result_cell, result);
-  return result_cell;
+  return akx_rt_make_int(rt, (int64_t)result);
 }
 
 static akx_cell_t *iter_real(akx_runtime_ctx_t *rt, double value,
@@ -191,7 +190,8 @@ static akx_cell_t *iter_real(akx_runtime_ctx_t *rt, double value,
     }
 
     if (akx_rt_cell_get_type(transformed) == AKX_TYPE_INTEGER_LITERAL) {
-      uint64_t new_bit = akx_rt_cell_as_int(transformed) ? 1ULL : 0ULL;
+      uint64_t new_bit = akx_rt_cell_is_bignum(transformed) ||
+                         akx_rt_cell_as_int(transformed) != 0;
       result = (result & ~(1ULL << bit_pos)) | (new_bit << bit_pos);
     }
 
@@ -273,8 +273,10 @@ akx_cell_t *iter_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
   }
 
   case AKX_TYPE_INTEGER_LITERAL: {
-    int value = akx_rt_cell_as_int(evaled_value);
-    result = iter_integer(rt, value, lambda_cell);
+    int64_t value = 0;
+    if (akx_rt_cell_to_int(rt, evaled_value, &value) == 0) {
+      result = iter_integer(rt, value, lambda_cell);
+    }
     break;
   }
 
@@ -20,7 +20,5 @@ akx_cell_t *not_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     akx_rt_free_cell(rt, evaled);
   }
 
-  akx_cell_t *ret = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, ret, is_true ? 0 : 1);
-  return ret;
+  return akx_rt_make_int(rt, is_true ? 0 : 1);
 }
@@ -22,15 +22,11 @@ akx_cell_t *real_or_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     akx_rt_free_cell(rt, evaled);
 
     if (is_true) {
-      akx_cell_t *ret = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-      akx_rt_set_int(rt, ret, 1);
-      return ret;
+      return akx_rt_make_int(rt, 1);
     }
 
     current = akx_rt_cell_next(current);
   }
 
-  akx_cell_t *ret = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, ret, 0);
-  return ret;
+  return akx_rt_make_int(rt, 0);
 }
@@ -1,46 +1,33 @@
-akx_cell_t *akx_eq(akx_runtime_ctx_t *rt, akx_cell_t *args) {
-  if (akx_rt_list_length(args) != 2) {
-    akx_rt_error(rt, "= requires exactly 2 arguments");
-    return NULL;
-  }
-
-  akx_cell_t *left_cell = akx_rt_list_nth(args, 0);
-  akx_cell_t *right_cell = akx_rt_list_nth(args, 1);
+#include <string.h>
 
-  akx_cell_t *left = akx_rt_eval(rt, left_cell);
-  if (!left) {
-    return NULL;
-  }
-
-  akx_cell_t *right = akx_rt_eval(rt, right_cell);
-  if (!right) {
-    akx_rt_free_cell(rt, left);
-    return NULL;
-  }
+const akx_builtin_signature_t akx_eq_signature = {
+    .name = "=",
+    .min_args = 2,
+    .max_args = 2,
+    .accepts = AKX_ARG_ANY,
+};
 
+int akx_eq(akx_runtime_ctx_t *rt, akx_value_t *argv, size_t argc,
+           akx_value_t *result) {
+  (void)rt;
+  (void)argc;
   int equal = 0;
-  akx_type_t left_type = akx_rt_cell_get_type(left);
-  akx_type_t right_type = akx_rt_cell_get_type(right);
-  if (left_type == right_type) {
-    if (left_type == AKX_TYPE_INTEGER_LITERAL) {
-      equal = (akx_rt_cell_as_int(left) == akx_rt_cell_as_int(right));
-    } else if (left_type == AKX_TYPE_REAL_LITERAL) {
-      equal = (akx_rt_cell_as_real(left) == akx_rt_cell_as_real(right));
-    } else if (left_type == AKX_TYPE_STRING_LITERAL) {
-      const char *ls = akx_rt_cell_as_string(left);
-      const char *rs = akx_rt_cell_as_string(right);
-      equal = (strcmp(ls, rs) == 0);
-    } else if (left_type == AKX_TYPE_SYMBOL) {
-      const char *ls = akx_rt_cell_as_symbol(left);
-      const char *rs = akx_rt_cell_as_symbol(right);
-      equal = (strcmp(ls, rs) == 0);
+  if (argv[0].type == argv[1].type) {
+    switch (argv[0].type) {
+    case AKX_TYPE_INTEGER_LITERAL:
+      equal = (akx_rt_int_cmp(argv[0].cell, argv[1].cell) == 0);
+      break;
+    case AKX_TYPE_REAL_LITERAL:
+      equal = (argv[0].as.real == argv[1].as.real);
+      break;
+    case AKX_TYPE_STRING_LITERAL:
+    case AKX_TYPE_SYMBOL:
+      equal = (strcmp(argv[0].as.text, argv[1].as.text) == 0);
+      break;
+    default:
+      break;
     }
   }
-
-  akx_rt_free_cell(rt, left);
-  akx_rt_free_cell(rt, right);
-
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
-  akx_rt_set_symbol(rt, result, equal ? "true" : "false");
-  return result;
+  *result = AKX_VALUE_SYMBOL(equal ? "true" : "false");
+  return 0;
 }
@@ -1,25 +1,21 @@
-akx_cell_t *mul(akx_runtime_ctx_t *rt, akx_cell_t *args) {
-  if (akx_rt_list_length(args) < 2) {
-    akx_rt_error(rt, "* requires at least 2 arguments");
-    return NULL;
-  }
-
-  int product = 1;
-  akx_cell_t *current = args;
-
-  while (current) {
-    akx_cell_t *evaled = akx_rt_eval_and_assert(
-        rt, current, AKX_TYPE_INTEGER_LITERAL, "* requires integer arguments");
-    if (!evaled) {
-      return NULL;
-    }
+const akx_builtin_signature_t mul_signature = {
+    .name = "*",
+    .min_args = 2,
+    .max_args = AKX_ARGS_VARIADIC,
+    .accepts = AKX_ARG(AKX_TYPE_INTEGER_LITERAL) | AKX_ARG_BIGNUM,
+};
 
-    product *= akx_rt_cell_as_int(evaled);
-    akx_rt_free_cell(rt, evaled);
-    current = akx_rt_cell_next(current);
+int mul(akx_runtime_ctx_t *rt, akx_value_t *argv, size_t argc,
+        akx_value_t *result) {
+  akx_cell_t *product = akx_rt_int_mul(rt, argv[0].cell, argv[1].cell);
+  for (size_t i = 2; product && i < argc; i++) {
+    akx_cell_t *next = akx_rt_int_mul(rt, product, argv[i].cell);
+    akx_rt_free_cell(rt, product);
+    product = next;
   }
-
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, result, product);
-  return result;
+  if (!product) {
+    return -1;
+  }
+  *result = AKX_VALUE_CELL(product);
+  return 0;
 }
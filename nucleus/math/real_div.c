@@ -1,42 +1,22 @@
 #include <math.h>
 
-akx_cell_t *real_div(akx_runtime_ctx_t *rt, akx_cell_t *args) {
-  if (akx_rt_list_length(args) < 2) {
-    akx_rt_error(rt, "real// requires at least 2 arguments");
-    return NULL;
-  }
-
-  akx_cell_t *first_arg = akx_rt_list_nth(args, 0);
-  akx_cell_t *evaled_first = akx_rt_eval_and_assert(
-      rt, first_arg, AKX_TYPE_REAL_LITERAL, "real// requires real arguments");
-  if (!evaled_first) {
-    return NULL;
-  }
-
-  double result_val = akx_rt_cell_as_real(evaled_first);
-  akx_rt_free_cell(rt, evaled_first);
+const akx_builtin_signature_t real_div_signature = {
+    .name = "real//",
+    .min_args = 2,
+    .max_args = AKX_ARGS_VARIADIC,
+    .accepts = AKX_ARG(AKX_TYPE_REAL_LITERAL),
+};
 
-  akx_cell_t *current = akx_rt_cell_next(args);
-  while (current) {
-    akx_cell_t *evaled = akx_rt_eval_and_assert(
-        rt, current, AKX_TYPE_REAL_LITERAL, "real// requires real arguments");
-    if (!evaled) {
-      return NULL;
-    }
-
-    double divisor = akx_rt_cell_as_real(evaled);
-    if (fabs(divisor) < 1e-10) {
-      akx_rt_free_cell(rt, evaled);
+int real_div(akx_runtime_ctx_t *rt, akx_value_t *argv, size_t argc,
+             akx_value_t *result) {
+  double quotient = argv[0].as.real;
+  for (size_t i = 1; i < argc; i++) {
+    if (fabs(argv[i].as.real) < 1e-10) {
       akx_rt_error(rt, "real//: division by zero");
-      return NULL;
+      return -1;
     }
-
-    result_val /= divisor;
-    akx_rt_free_cell(rt, evaled);
-    current = akx_rt_cell_next(current);
+    quotient /= argv[i].as.real;
   }
-
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_REAL_LITERAL);
-  akx_rt_set_real(rt, result, result_val);
-  return result;
+  *result = AKX_VALUE_REAL(quotient);
+  return 0;
 }
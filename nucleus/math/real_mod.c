@@ -1,42 +1,19 @@
 #include <math.h>
 
-akx_cell_t *real_mod(akx_runtime_ctx_t *rt, akx_cell_t *args) {
-  if (akx_rt_list_length(args) != 2) {
-    akx_rt_error(rt, "real/% requires exactly 2 arguments");
-    return NULL;
-  }
-
-  akx_cell_t *first_arg = akx_rt_list_nth(args, 0);
-  akx_cell_t *evaled_first = akx_rt_eval_and_assert(
-      rt, first_arg, AKX_TYPE_REAL_LITERAL, "real/% requires real arguments");
-  if (!evaled_first) {
-    return NULL;
-  }
-
-  akx_cell_t *second_arg = akx_rt_list_nth(args, 1);
-  akx_cell_t *evaled_second = akx_rt_eval_and_assert(
-      rt, second_arg, AKX_TYPE_REAL_LITERAL, "real/% requires real arguments");
-  if (!evaled_second) {
-    akx_rt_free_cell(rt, evaled_first);
-    return NULL;
-  }
-
-  double dividend = akx_rt_cell_as_real(evaled_first);
-  double divisor = akx_rt_cell_as_real(evaled_second);
-
-  if (fabs(divisor) < 1e-10) {
-    akx_rt_free_cell(rt, evaled_first);
-    akx_rt_free_cell(rt, evaled_second);
+const akx_builtin_signature_t real_mod_signature = {
+    .name = "real/%",
+    .min_args = 2,
+    .max_args = 2,
+    .accepts = AKX_ARG(AKX_TYPE_REAL_LITERAL),
+};
+
+int real_mod(akx_runtime_ctx_t *rt, akx_value_t *argv, size_t argc,
+             akx_value_t *result) {
+  (void)argc;
+  if (fabs(argv[1].as.real) < 1e-10) {
     akx_rt_error(rt, "real/%: modulo by zero");
-    return NULL;
+    return -1;
   }
-
-  double result_val = fmod(dividend, divisor);
-
-  akx_rt_free_cell(rt, evaled_first);
-  akx_rt_free_cell(rt, evaled_second);
-
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_REAL_LITERAL);
-  akx_rt_set_real(rt, result, result_val);
-  return result;
+  *result = AKX_VALUE_REAL(fmod(argv[0].as.real, argv[1].as.real));
+  return 0;
 }
@@ -1,25 +1,17 @@
-akx_cell_t *real_mul(akx_runtime_ctx_t *rt, akx_cell_t *args) {
-  if (akx_rt_list_length(args) < 2) {
-    akx_rt_error(rt, "real/* requires at least 2 arguments");
-    return NULL;
-  }
-
-  double product = 1.0;
-  akx_cell_t *current = args;
+const akx_builtin_signature_t real_mul_signature = {
+    .name = "real/*",
+    .min_args = 2,
+    .max_args = AKX_ARGS_VARIADIC,
+    .accepts = AKX_ARG(AKX_TYPE_REAL_LITERAL),
+};
 
-  while (current) {
-    akx_cell_t *evaled = akx_rt_eval_and_assert(
-        rt, current, AKX_TYPE_REAL_LITERAL, "real/* requires real arguments");
-    if (!evaled) {
-      return NULL;
-    }
-
-    product *= akx_rt_cell_as_real(evaled);
-    akx_rt_free_cell(rt, evaled);
-    current = akx_rt_cell_next(current);
+int real_mul(akx_runtime_ctx_t *rt, akx_value_t *argv, size_t argc,
+             akx_value_t *result) {
+  (void)rt;
+  double product = argv[0].as.real;
+  for (size_t i = 1; i < argc; i++) {
+    product *= argv[i].as.real;
   }
-
-  akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_REAL_LITERAL);
-  akx_rt_set_real(rt, result, product);
-  return result;
+  *result = AKX_VALUE_REAL(product);
+  return 0;
 }
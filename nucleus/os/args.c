@@ -5,9 +5,7 @@ akx_cell_t *os_args_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
   char **script_argv = akx_rt_get_script_argv(rt);
 
   if (script_argc <= 0 || !script_argv) {
-    akx_cell_t *nil = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
-    akx_rt_set_symbol(rt, nil, "nil");
-    return nil;
+    return akx_rt_nil(rt);
   }
 
   akx_cell_t *result = NULL;
@@ -40,9 +40,7 @@ akx_cell_t *os_env_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
       akx_rt_free_cell(rt, var_cell);
 
       if (!var_value) {
-        akx_cell_t *nil = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
-        akx_rt_set_symbol(rt, nil, "nil");
-        return nil;
+        return akx_rt_nil(rt);
       }
 
       akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_STRING_LITERAL);
@@ -80,9 +78,7 @@ akx_cell_t *os_env_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
       akx_rt_free_cell(rt, var_cell);
       akx_rt_free_cell(rt, value_cell);
 
-      akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-      akx_rt_set_int(rt, result, (result_code == 0) ? 1 : 0);
-      return result;
+      return akx_rt_make_int(rt, (result_code == 0) ? 1 : 0);
 
     } else {
       akx_rt_error_fmt(rt, "os/env: unknown keyword: %s", keyword);
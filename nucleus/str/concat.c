@@ -14,6 +14,8 @@ akx_cell_t *str_concat_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     akx_rt_error(rt, "str/+: memory allocation failed");
     return NULL;
   }
+  memset(evaled_args, 0, sizeof(akx_cell_t *) * arg_count);
+  akx_rt_gc_push_roots(rt, evaled_args, arg_count);
 
   for (size_t i = 0; i < arg_count; i++) {
     akx_cell_t *arg = akx_rt_list_nth(args, i);
@@ -23,6 +25,7 @@ akx_cell_t *str_concat_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
       for (size_t j = 0; j < i; j++) {
         akx_rt_free_cell(rt, evaled_args[j]);
       }
+      akx_rt_gc_pop_roots(rt, evaled_args);
       AK24_FREE(evaled_args);
       return NULL;
     }
@@ -38,6 +41,7 @@ akx_cell_t *str_concat_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     for (size_t i = 0; i < arg_count; i++) {
       akx_rt_free_cell(rt, evaled_args[i]);
     }
+    akx_rt_gc_pop_roots(rt, evaled_args);
     AK24_FREE(evaled_args);
     akx_rt_error(rt, "str/+: memory allocation failed");
     return NULL;
@@ -51,6 +55,7 @@ akx_cell_t *str_concat_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     }
     akx_rt_free_cell(rt, evaled_args[i]);
   }
+  akx_rt_gc_pop_roots(rt, evaled_args);
   AK24_FREE(evaled_args);
 
   akx_cell_t *result = akx_rt_alloc_cell(rt, AKX_TYPE_STRING_LITERAL);
@@ -50,7 +50,12 @@ akx_cell_t *str_split_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
       return NULL;
     }
 
-    int split_idx = akx_rt_cell_as_int(evaled_idx);
+    int64_t split_idx = 0;
+    if (akx_rt_cell_to_int(rt, evaled_idx, &split_idx) != 0) {
+      akx_rt_free_cell(rt, evaled_str);
+      akx_rt_free_cell(rt, evaled_idx);
+      return NULL;
+    }
     size_t str_len = strlen(input_str);
 
     if (split_idx < 0 || (size_t)split_idx > str_len) {
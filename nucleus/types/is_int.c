@@ -16,7 +16,5 @@ akx_cell_t *is_int_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     akx_rt_free_cell(rt, evaled);
   }
 
-  akx_cell_t *ret = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, ret, result);
-  return ret;
+  return akx_rt_make_int(rt, result);
 }
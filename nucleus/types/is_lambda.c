@@ -12,7 +12,5 @@ akx_cell_t *is_lambda_impl(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     result = (akx_rt_cell_get_type(evaled) == AKX_TYPE_LAMBDA);
   }
 
-  akx_cell_t *ret = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
-  akx_rt_set_int(rt, ret, result);
-  return ret;
+  return akx_rt_make_int(rt, result);
 }
@@ -1,12 +1,275 @@
 #include "akx_cell.h"
+#include "akx_cell_lex.h"
 #include <ctype.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
+
+#define AKX_CELL_ARENA_CHUNK_SIZE (64 * 1024)
+#define AKX_CELL_ARENA_FIRST_CHUNK_SIZE (1024)
+#define AKX_CELL_ARENA_ALIGN _Alignof(akx_cell_t)
+#define AKX_CELL_STREAM_CHUNK_SIZE (64 * 1024)
+#define AKX_CELL_STREAM_BATCH_SIZE (64 * 1024)
+#define AKX_CELL_STREAM_NEED_INPUT 2
+#define AKX_CELL_WORK_LOCAL_SIZE 32
+#define AKX_CELL_ENCODE_SPAN (1u << 0)
+#define AKX_CELL_ENCODE_BIGNUM (1u << 1)
+
+typedef struct akx_cell_span_t {
+  uint32_t start;
+  uint32_t end;
+} akx_cell_span_t;
+
+typedef struct source_entry_t {
+  ak_source_file_t *file;
+  ak_buffer_t *text;
+  const char *name;
+  uint32_t line_base;
+  size_t refs;
+  uint32_t next_free;
+} source_entry_t;
+
+// Shared by every thread that parses, clones or frees cells, such as the JIT
+// worker; g_sources_lock guards the table and every entry in it
+static pthread_mutex_t g_sources_lock = PTHREAD_MUTEX_INITIALIZER;
+static source_entry_t *g_sources = NULL;
+static uint32_t g_sources_count = 0;
+static uint32_t g_sources_capacity = 0;
+static uint32_t g_sources_free = 0;
+
+static akx_cell_heap_t g_heap;
+static int g_heap_set = 0;
+// Pools are per thread, so each thread's cells come from its own free lists
+static _Thread_local akx_cell_pool_t g_pool;
+static _Thread_local int g_pool_set = 0;
+
+typedef struct akx_cell_arena_chunk_t {
+  struct akx_cell_arena_chunk_t *next;
+  uint8_t *data;
+  size_t used;
+  size_t capacity;
+} akx_cell_arena_chunk_t;
+
+struct akx_cell_arena_t {
+  akx_cell_arena_chunk_t *chunks;
+  list_t(ak_buffer_t *) buffers;
+  // Quoted cells, whose shared views are freed with the arena
+  list_t(akx_cell_t *) quotes;
+  uint32_t source;
+};
+
+struct akx_cell_stream_t {
+  FILE *input;
+  const char *name;
+  ak_buffer_t *pending;
+  ak_buffer_t *opens;
+  ak_scanner_t *scanner;
+  size_t position;
+  size_t line_start;
+  size_t line_scan;
+  size_t retry_at;
+  size_t batch_size;
+  uint32_t line_base;
+  uint8_t *chunk;
+  uint8_t prev;
+  uint8_t in_string;
+  uint8_t in_escape;
+  uint8_t in_comment;
+  int eof;
+  int done;
+};
 
 typedef struct parse_context_t {
   akx_parse_error_t *errors;
   akx_parse_error_t *errors_tail;
+  uint8_t close_delim;
+  size_t depth;
+  akx_cell_arena_t *arena;
 } parse_context_t;
 
+static uint32_t source_register(ak_source_file_t *file) {
+  pthread_mutex_lock(&g_sources_lock);
+  uint32_t id = g_sources_free;
+
+  if (id) {
+    g_sources_free = g_sources[id - 1].next_free;
+  } else {
+    if (g_sources_count == g_sources_capacity) {
+      uint32_t capacity = g_sources_capacity ? g_sources_capacity * 2 : 16;
+      source_entry_t *grown = AK24_ALLOC(sizeof(source_entry_t) * capacity);
+      if (!grown) {
+        pthread_mutex_unlock(&g_sources_lock);
+        return 0;
+      }
+      if (g_sources) {
+        memcpy(grown, g_sources, sizeof(source_entry_t) * g_sources_count);
+        AK24_FREE(g_sources);
+      }
+      g_sources = grown;
+      g_sources_capacity = capacity;
+    }
+    id = ++g_sources_count;
+  }
+
+  g_sources[id - 1].file = file;
+  g_sources[id - 1].text = NULL;
+  g_sources[id - 1].name = NULL;
+  g_sources[id - 1].line_base = 0;
+  g_sources[id - 1].refs = 1;
+  g_sources[id - 1].next_free = 0;
+  pthread_mutex_unlock(&g_sources_lock);
+  return id;
+}
+
+static void source_retain(uint32_t id) {
+  if (id) {
+    pthread_mutex_lock(&g_sources_lock);
+    g_sources[id - 1].refs++;
+    pthread_mutex_unlock(&g_sources_lock);
+  }
+}
+
+static void source_release(uint32_t id) {
+  if (!id) {
+    return;
+  }
+
+  pthread_mutex_lock(&g_sources_lock);
+  source_entry_t *entry = &g_sources[id - 1];
+  if (--entry->refs > 0) {
+    pthread_mutex_unlock(&g_sources_lock);
+    return;
+  }
+
+  if (entry->file) {
+    ak_source_file_release(entry->file);
+  }
+  if (entry->text) {
+    ak_buffer_free(entry->text);
+  }
+  entry->file = NULL;
+  entry->text = NULL;
+  entry->next_free = g_sources_free;
+  g_sources_free = id;
+  pthread_mutex_unlock(&g_sources_lock);
+}
+
+static ak_source_file_t *source_file_of(uint32_t id) {
+  if (!id) {
+    return NULL;
+  }
+
+  pthread_mutex_lock(&g_sources_lock);
+  source_entry_t *entry = &g_sources[id - 1];
+  if (entry->file || !entry->text) {
+    ak_source_file_t *file = entry->file;
+    pthread_mutex_unlock(&g_sources_lock);
+    return file;
+  }
+
+  // Streamed forms keep only their own lines; leading newlines put them back
+  // on their original line numbers.
+  size_t text_len = ak_buffer_count(entry->text);
+  size_t len = entry->line_base + text_len;
+  char *padded = AK24_ALLOC(len + 1);
+  if (!padded) {
+    pthread_mutex_unlock(&g_sources_lock);
+    return NULL;
+  }
+  memset(padded, '\n', entry->line_base);
+  memcpy(padded + entry->line_base, ak_buffer_data(entry->text), text_len);
+  padded[len] = '\0';
+
+  entry->file = ak_source_file_new(entry->name, padded, len);
+  AK24_FREE(padded);
+
+  if (entry->file) {
+    ak_buffer_free(entry->text);
+    entry->text = NULL;
+  }
+  ak_source_file_t *file = entry->file;
+  pthread_mutex_unlock(&g_sources_lock);
+  return file;
+}
+
+static akx_cell_arena_t *arena_new(void) {
+  akx_cell_arena_t *arena = AK24_ALLOC(sizeof(akx_cell_arena_t));
+  if (!arena) {
+    return NULL;
+  }
+
+  arena->chunks = NULL;
+  list_init(&arena->buffers);
+  list_init(&arena->quotes);
+  arena->source = 0;
+  return arena;
+}
+
+static akx_cell_arena_chunk_t *arena_add_chunk(akx_cell_arena_t *arena,
+                                               size_t min_size) {
+  // Start small so a single streamed form doesn't pay for a full chunk
+  size_t capacity = AKX_CELL_ARENA_FIRST_CHUNK_SIZE;
+  if (arena->chunks && arena->chunks->capacity < AKX_CELL_ARENA_CHUNK_SIZE) {
+    capacity = arena->chunks->capacity * 2;
+  } else if (arena->chunks) {
+    capacity = AKX_CELL_ARENA_CHUNK_SIZE;
+  }
+  if (min_size + AKX_CELL_ARENA_ALIGN > capacity) {
+    capacity = min_size + AKX_CELL_ARENA_ALIGN;
+  }
+
+  akx_cell_arena_chunk_t *chunk =
+      AK24_ALLOC(sizeof(akx_cell_arena_chunk_t) + capacity);
+  if (!chunk) {
+    return NULL;
+  }
+
+  chunk->data = (uint8_t *)(chunk + 1);
+  chunk->used = 0;
+  chunk->capacity = capacity;
+  chunk->next = arena->chunks;
+  arena->chunks = chunk;
+  return chunk;
+}
+
+static void *arena_alloc(akx_cell_arena_t *arena, size_t size) {
+  akx_cell_arena_chunk_t *chunk = arena->chunks;
+
+  if (chunk) {
+    uintptr_t base = (uintptr_t)chunk->data;
+    uintptr_t aligned = (base + chunk->used + AKX_CELL_ARENA_ALIGN - 1) &
+                        ~(uintptr_t)(AKX_CELL_ARENA_ALIGN - 1);
+    size_t offset = (size_t)(aligned - base);
+    if (offset + size <= chunk->capacity) {
+      chunk->used = offset + size;
+      return chunk->data + offset;
+    }
+  }
+
+  chunk = arena_add_chunk(arena, size);
+  if (!chunk) {
+    return NULL;
+  }
+
+  return arena_alloc(arena, size);
+}
+
+static ak_buffer_t *arena_buffer_new(akx_cell_arena_t *arena, size_t size) {
+  ak_buffer_t *buf = ak_buffer_new(size);
+  if (!buf || !arena) {
+    return buf;
+  }
+
+  if (list_push(&arena->buffers, buf) != 0) {
+    ak_buffer_free(buf);
+    return NULL;
+  }
+
+  return buf;
+}
+
 static void add_parse_error(parse_context_t *ctx, ak_source_loc_t *loc,
                             const char *message) {
   for (akx_parse_error_t *err = ctx->errors; err; err = err->next) {
@@ -34,62 +297,340 @@ static void add_parse_error(parse_context_t *ctx, ak_source_loc_t *loc,
   }
 }
 
-static akx_cell_t *create_cell(akx_type_t type, ak_source_range_t *range) {
-  akx_cell_t *cell = AK24_ALLOC(sizeof(akx_cell_t));
+static ak_source_loc_t parse_error_loc(ak_source_file_t *source_file,
+                                       size_t offset) {
+  if (source_file) {
+    return ak_source_loc_from_offset(source_file, offset);
+  }
+
+  // Streamed parses resolve the location once the form is known to be final
+  ak_source_loc_t loc;
+  memset(&loc, 0, sizeof(loc));
+  loc.offset = (uint32_t)offset;
+  return loc;
+}
+
+static int is_list_type(uint8_t type) {
+  return type == AKX_TYPE_LIST || type == AKX_TYPE_LIST_SQUARE ||
+         type == AKX_TYPE_LIST_CURLY || type == AKX_TYPE_LIST_TEMPLE;
+}
+
+static akx_cell_span_t *cell_span(akx_cell_t *cell) {
+  return (akx_cell_span_t *)(cell + 1);
+}
+
+static akx_cell_t **cell_quoted_expr(akx_cell_t *cell) {
+  uint8_t *slot = (uint8_t *)(cell + 1);
+  if (cell->flags & AKX_CELL_FLAG_SPAN) {
+    slot += sizeof(akx_cell_span_t);
+  }
+  return (akx_cell_t **)slot;
+}
+
+// A parsed quote's heap copy of its expression, made on first use
+static akx_cell_t **cell_quoted_view(akx_cell_t *cell) {
+  return cell_quoted_expr(cell) + 1;
+}
+
+static void arena_free(akx_cell_arena_t *arena) {
+  if (!arena) {
+    return;
+  }
+
+  list_iter_t quote_iter = list_iter(&arena->quotes);
+  akx_cell_t **quote_ptr;
+  while ((quote_ptr = list_next(&arena->quotes, &quote_iter))) {
+    akx_cell_free(*cell_quoted_view(*quote_ptr));
+  }
+  list_deinit(&arena->quotes);
+
+  list_iter_t iter = list_iter(&arena->buffers);
+  ak_buffer_t **buf_ptr;
+  while ((buf_ptr = list_next(&arena->buffers, &iter))) {
+    ak_buffer_free(*buf_ptr);
+  }
+  list_deinit(&arena->buffers);
+
+  akx_cell_arena_chunk_t *chunk = arena->chunks;
+  while (chunk) {
+    akx_cell_arena_chunk_t *next = chunk->next;
+    AK24_FREE(chunk);
+    chunk = next;
+  }
+
+  source_release(arena->source);
+  AK24_FREE(arena);
+}
+
+static akx_cell_site_t *cell_site(akx_cell_t *cell) {
+  uint8_t *slot = (uint8_t *)(cell + 1);
+  if (cell->flags & AKX_CELL_FLAG_SPAN) {
+    slot += sizeof(akx_cell_span_t);
+  }
+  return (akx_cell_site_t *)slot;
+}
+
+static size_t cell_size(int has_span, int has_quoted_expr, int has_site) {
+  size_t size = sizeof(akx_cell_t);
+  if (has_span) {
+    size += sizeof(akx_cell_span_t);
+  }
+  if (has_quoted_expr) {
+    size += 2 * sizeof(akx_cell_t *);
+  }
+  if (has_site) {
+    size += sizeof(akx_cell_site_t);
+  }
+  return size;
+}
+
+// The flags record what was allocated after the cell
+static size_t cell_alloc_size(const akx_cell_t *cell) {
+  return cell_size(cell->flags & AKX_CELL_FLAG_SPAN,
+                   cell->flags & AKX_CELL_FLAG_QUOTED_EXPR,
+                   cell->flags & AKX_CELL_FLAG_SITE);
+}
+
+static akx_cell_t *create_cell_with(akx_cell_arena_t *arena, int plain,
+                                    akx_type_t type, uint32_t source,
+                                    const akx_cell_span_t *span) {
+  // Only parsed lists and symbols can be code, so only they get a site
+  int has_span = source && span;
+  int has_site = has_span && (is_list_type(type) || type == AKX_TYPE_SYMBOL);
+  size_t size = cell_size(has_span, type == AKX_TYPE_QUOTED, has_site);
+
+  akx_cell_t *cell;
+  if (arena) {
+    cell = arena_alloc(arena, size);
+  } else if (plain) {
+    cell = AK24_ALLOC(size);
+  } else if (g_heap_set) {
+    cell = g_heap.alloc(g_heap.user, size);
+  } else if (g_pool_set) {
+    cell = g_pool.alloc(g_pool.user, size);
+  } else {
+    cell = AK24_ALLOC(size);
+  }
   if (!cell) {
     return NULL;
   }
 
   memset(cell, 0, sizeof(akx_cell_t));
-  cell->type = type;
+  cell->type = (uint8_t)type;
+  if (arena) {
+    cell->flags = AKX_CELL_FLAG_ARENA;
+  } else if (plain) {
+    cell->flags = 0;
+  } else if (g_heap_set) {
+    cell->flags = AKX_CELL_FLAG_TRACKED;
+  } else if (g_pool_set) {
+    cell->flags = AKX_CELL_FLAG_POOLED;
+  }
   cell->next = NULL;
 
-  if (range) {
-    cell->sourceloc = AK24_ALLOC(sizeof(ak_source_range_t));
-    if (cell->sourceloc) {
-      memcpy(cell->sourceloc, range, sizeof(ak_source_range_t));
+  // The span lives directly after the cell; line/column are resolved on demand
+  if (has_span) {
+    cell->flags |= AKX_CELL_FLAG_SPAN;
+    cell->source = source;
+    *cell_span(cell) = *span;
+    if (!arena) {
+      source_retain(source);
+    }
+  }
+
+  // Quoted cells keep their parsed expression after the span
+  if (type == AKX_TYPE_QUOTED) {
+    cell->flags |= AKX_CELL_FLAG_QUOTED_EXPR;
+    *cell_quoted_expr(cell) = NULL;
+    *cell_quoted_view(cell) = NULL;
+    if (arena && list_push(&arena->quotes, cell) != 0) {
+      return NULL;
     }
-  } else {
-    cell->sourceloc = NULL;
+  }
+
+  if (has_site) {
+    cell->flags |= AKX_CELL_FLAG_SITE;
+    memset(cell_site(cell), 0, sizeof(akx_cell_site_t));
   }
 
   return cell;
 }
 
+static akx_cell_t *create_cell(akx_cell_arena_t *arena, akx_type_t type,
+                               uint32_t source, const akx_cell_span_t *span) {
+  return create_cell_with(arena, 0, type, source, span);
+}
+
+// Pending work for the tree walks in akx_cell_free and akx_cell_clone. The
+// walks descend into children in a loop and park the rest of the sibling
+// chain here, so C stack use stays constant and this stack only grows with
+// nesting depth.
+typedef struct cell_work_t {
+  akx_cell_t *cell;
+  akx_cell_t **slot;
+  int siblings;
+} cell_work_t;
+
+typedef struct cell_work_stack_t {
+  cell_work_t *items;
+  size_t count;
+  size_t capacity;
+  cell_work_t local[AKX_CELL_WORK_LOCAL_SIZE];
+} cell_work_stack_t;
+
+static void work_init(cell_work_stack_t *work) {
+  work->items = work->local;
+  work->count = 0;
+  work->capacity = AKX_CELL_WORK_LOCAL_SIZE;
+}
+
+static void work_deinit(cell_work_stack_t *work) {
+  if (work->items != work->local) {
+    AK24_FREE(work->items);
+  }
+}
+
+static int work_push(cell_work_stack_t *work, akx_cell_t *cell,
+                     akx_cell_t **slot, int siblings) {
+  if (work->count == work->capacity) {
+    size_t capacity = work->capacity * 2;
+    cell_work_t *grown = AK24_ALLOC(sizeof(cell_work_t) * capacity);
+    if (!grown) {
+      return -1;
+    }
+    memcpy(grown, work->items, sizeof(cell_work_t) * work->count);
+    work_deinit(work);
+    work->items = grown;
+    work->capacity = capacity;
+  }
+
+  cell_work_t *item = &work->items[work->count++];
+  item->cell = cell;
+  item->slot = slot;
+  item->siblings = siblings;
+  return 0;
+}
+
+static int work_pop(cell_work_stack_t *work, cell_work_t *out) {
+  if (work->count == 0) {
+    return 0;
+  }
+  *out = work->items[--work->count];
+  return 1;
+}
+
+// Parks a chain to free later; if the stack can't grow, free it right away
+static void free_later(cell_work_stack_t *work, akx_cell_t *chain) {
+  if (chain && work_push(work, chain, NULL, 1) != 0) {
+    akx_cell_free(chain);
+  }
+}
+
+// A pooled cell freed on a thread with no pool has nowhere to go; it is
+// reported and leaked rather than handed to a missing allocator
+static void pool_release(void *ptr, size_t size) {
+  if (!g_pool_set) {
+    AK24_LOG_ERROR("Pooled cell freed on a thread without a cell pool");
+    return;
+  }
+  g_pool.free(g_pool.user, ptr, size);
+}
+
+// Frees what a heap cell owns apart from other cells, then the cell itself
+static void release_cell(akx_cell_t *cell) {
+  if (cell->type == AKX_TYPE_STRING_LITERAL && cell->value.string_literal) {
+    ak_buffer_free(cell->value.string_literal);
+  } else if (cell->flags & AKX_CELL_FLAG_BIGNUM) {
+    akx_bignum_free(cell->value.bignum);
+  } else if (cell->type == AKX_TYPE_QUOTED && cell->value.quoted_literal) {
+    ak_buffer_free(cell->value.quoted_literal);
+  } else if (cell->type == AKX_TYPE_LAMBDA && cell->value.lambda) {
+    ak_lambda_free(cell->value.lambda);
+  } else if (cell->type == AKX_TYPE_CONTINUATION &&
+             cell->value.continuation) {
+    if (cell->flags & AKX_CELL_FLAG_POOLED) {
+      pool_release(cell->value.continuation, sizeof(akx_continuation_t));
+    } else {
+      AK24_FREE(cell->value.continuation);
+    }
+  }
+
+  if (cell->flags & AKX_CELL_FLAG_SPAN) {
+    source_release(cell->source);
+  }
+
+  if (cell->flags & AKX_CELL_FLAG_POOLED) {
+    pool_release(cell, cell_alloc_size(cell));
+  } else if (!(cell->flags & AKX_CELL_FLAG_TRACKED)) {
+    // The memory of a tracked cell belongs to its collector
+    AK24_FREE(cell);
+  }
+}
+
 void akx_cell_free(akx_cell_t *cell) {
-  while (cell) {
-    akx_cell_t *next = cell->next;
-
-    if (cell->type == AKX_TYPE_STRING_LITERAL && cell->value.string_literal) {
-      ak_buffer_free(cell->value.string_literal);
-    } else if ((cell->type == AKX_TYPE_LIST ||
-                cell->type == AKX_TYPE_LIST_SQUARE ||
-                cell->type == AKX_TYPE_LIST_CURLY ||
-                cell->type == AKX_TYPE_LIST_TEMPLE) &&
-               cell->value.list_head) {
-      akx_cell_free(cell->value.list_head);
-    } else if (cell->type == AKX_TYPE_QUOTED && cell->value.quoted_literal) {
-      ak_buffer_free(cell->value.quoted_literal);
-    } else if (cell->type == AKX_TYPE_LAMBDA && cell->value.lambda) {
-      ak_lambda_free(cell->value.lambda);
-    } else if (cell->type == AKX_TYPE_CONTINUATION &&
-               cell->value.continuation) {
-      if (cell->value.continuation->lambda_cell) {
-        akx_cell_free(cell->value.continuation->lambda_cell);
+  cell_work_stack_t work;
+  work_init(&work);
+
+  for (;;) {
+    while (cell) {
+      akx_cell_t *next = cell->next;
+
+      // Arena cells are released with their parse result, so freeing one
+      // means its caller never owned it; it is reported and left alone
+      if (cell->flags & AKX_CELL_FLAG_ARENA) {
+        AK24_LOG_ERROR("akx_cell_free: cell belongs to a parse arena");
+        cell = next;
+        continue;
       }
-      if (cell->value.continuation->args) {
-        akx_cell_free(cell->value.continuation->args);
+      if (cell->flags & AKX_CELL_FLAG_IMMEDIATE) {
+        cell = next;
+        continue;
       }
-      AK24_FREE(cell->value.continuation);
-    }
 
-    if (cell->sourceloc) {
-      AK24_FREE(cell->sourceloc);
+      // A shared cell only loses this owner
+      if (cell->refs) {
+        cell->refs--;
+        cell = next;
+        continue;
+      }
+
+      // Tracked cells are left for their collector, children included
+      if (cell->flags & AKX_CELL_FLAG_TRACKED) {
+        cell = next;
+        continue;
+      }
+
+      akx_cell_t *child = NULL;
+
+      if (is_list_type(cell->type)) {
+        child = cell->value.list_head;
+      } else if (cell->type == AKX_TYPE_QUOTED &&
+                 (cell->flags & AKX_CELL_FLAG_QUOTED_EXPR)) {
+        child = *cell_quoted_expr(cell);
+      } else if (cell->type == AKX_TYPE_CONTINUATION &&
+                 cell->value.continuation) {
+        free_later(&work, cell->value.continuation->args);
+        child = cell->value.continuation->lambda_cell;
+      }
+
+      release_cell(cell);
+
+      if (child) {
+        free_later(&work, next);
+        cell = child;
+      } else {
+        cell = next;
+      }
     }
 
-    AK24_FREE(cell);
-    cell = next;
+    cell_work_t item;
+    if (!work_pop(&work, &item)) {
+      break;
+    }
+    cell = item.cell;
   }
+
+  work_deinit(&work);
 }
 
 static akx_cell_t *parse_argument(ak_scanner_t *scanner,
@@ -105,63 +646,131 @@ static akx_cell_t *parse_quoted(ak_scanner_t *scanner,
                                 ak_source_file_t *source_file,
                                 parse_context_t *ctx);
 
+static void skip_blank(ak_scanner_t *scanner) {
+  scanner->position = akx_cell_lex_skip_blank(ak_buffer_data(scanner->buffer),
+                                              scanner->position,
+                                              ak_buffer_count(scanner->buffer));
+}
+
+static int is_close_delim(uint8_t c, uint8_t close_delim) {
+  return c == close_delim || c == ')' || c == ']' || c == '}';
+}
+
+static akx_type_t classify_atom(const uint8_t *data, size_t len) {
+  size_t i = 0;
+  if (data[i] == '-' || data[i] == '+') {
+    i++;
+  }
+
+  size_t digits = 0;
+  size_t dots = 0;
+  for (; i < len; i++) {
+    if (isdigit(data[i])) {
+      digits++;
+    } else if (data[i] == '.') {
+      dots++;
+    } else {
+      return AKX_TYPE_SYMBOL;
+    }
+  }
+
+  if (digits == 0 || dots > 1) {
+    return AKX_TYPE_SYMBOL;
+  }
+  return dots ? AKX_TYPE_REAL_LITERAL : AKX_TYPE_INTEGER_LITERAL;
+}
+
+// Reads a classified integer atom. Values that don't fit in 64 bits become
+// bignums copied into the arena.
+static int parse_integer(akx_cell_arena_t *arena, akx_cell_t *cell,
+                         const uint8_t *atom, size_t len) {
+  size_t i = 0;
+  int negative = atom[0] == '-';
+  if (atom[0] == '-' || atom[0] == '+') {
+    i++;
+  }
+
+  uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+  uint64_t mag = 0;
+  for (; i < len; i++) {
+    uint64_t digit = (uint64_t)(atom[i] - '0');
+    if (mag > (limit - digit) / 10) {
+      break;
+    }
+    mag = mag * 10 + digit;
+  }
+
+  if (i == len) {
+    if (!negative) {
+      cell->value.integer_literal = (int64_t)mag;
+    } else if (mag == (uint64_t)INT64_MAX + 1) {
+      cell->value.integer_literal = INT64_MIN;
+    } else {
+      cell->value.integer_literal = -(int64_t)mag;
+    }
+    return 0;
+  }
+
+  akx_bignum_t *num = akx_bignum_from_string((const char *)atom, len);
+  if (!num) {
+    return -1;
+  }
+  akx_bignum_t *stored = arena_alloc(arena, akx_bignum_size(num));
+  if (stored) {
+    memcpy(stored, num, akx_bignum_size(num));
+    cell->value.bignum = stored;
+    cell->flags |= AKX_CELL_FLAG_BIGNUM;
+  }
+  akx_bignum_free(num);
+  return stored ? 0 : -1;
+}
+
 static akx_cell_t *parse_static_type(ak_scanner_t *scanner,
-                                     ak_source_file_t *source_file,
                                      parse_context_t *ctx) {
-  (void)ctx;
   size_t start_pos = scanner->position;
+  uint8_t *buf_data = ak_buffer_data(scanner->buffer);
+  size_t buf_len = ak_buffer_count(scanner->buffer);
 
-  ak_scanner_static_type_result_t result =
-      ak_scanner_read_static_base_type(scanner, NULL);
+  size_t end_pos =
+      akx_cell_lex_atom_end(buf_data, start_pos, buf_len, ctx->close_delim);
 
-  if (!result.success) {
+  if (end_pos == start_pos) {
     return NULL;
   }
 
+  scanner->position = end_pos;
+
   size_t origin_offset = scanner->buffer->origin_offset;
-  ak_source_loc_t start_loc =
-      ak_source_loc_from_offset(source_file, start_pos + origin_offset);
-  ak_source_loc_t end_loc =
-      ak_source_loc_from_offset(source_file, scanner->position + origin_offset);
-  ak_source_range_t range = ak_source_range_new(start_loc, end_loc);
-
-  akx_cell_t *cell = NULL;
-
-  switch (result.data.base) {
-  case AK24_STATIC_BASE_INTEGER: {
-    cell = create_cell(AKX_TYPE_INTEGER_LITERAL, &range);
-    if (cell) {
-      char temp[32];
-      size_t len = result.data.byte_length < 31 ? result.data.byte_length : 31;
-      memcpy(temp, result.data.data, len);
-      temp[len] = '\0';
-      cell->value.integer_literal = atoi(temp);
-    }
-    break;
+  akx_cell_span_t span = {(uint32_t)(start_pos + origin_offset),
+                          (uint32_t)(end_pos + origin_offset)};
+
+  const uint8_t *atom = buf_data + start_pos;
+  size_t atom_len = end_pos - start_pos;
+  akx_type_t type = classify_atom(atom, atom_len);
+
+  akx_cell_t *cell = create_cell(ctx->arena, type, ctx->arena->source, &span);
+  if (!cell) {
+    return NULL;
   }
 
-  case AK24_STATIC_BASE_REAL: {
-    cell = create_cell(AKX_TYPE_REAL_LITERAL, &range);
-    if (cell) {
-      char temp[64];
-      size_t len = result.data.byte_length < 63 ? result.data.byte_length : 63;
-      memcpy(temp, result.data.data, len);
-      temp[len] = '\0';
-      cell->value.real_literal = atof(temp);
+  switch (type) {
+  case AKX_TYPE_INTEGER_LITERAL:
+    if (parse_integer(ctx->arena, cell, atom, atom_len) != 0) {
+      return NULL;
     }
     break;
-  }
 
-  case AK24_STATIC_BASE_SYMBOL: {
-    cell = create_cell(AKX_TYPE_SYMBOL, &range);
-    if (cell) {
-      cell->value.symbol =
-          ak_intern_n((const char *)result.data.data, result.data.byte_length);
-    }
+  case AKX_TYPE_REAL_LITERAL: {
+    char temp[64];
+    size_t len = atom_len < 63 ? atom_len : 63;
+    memcpy(temp, atom, len);
+    temp[len] = '\0';
+    cell->value.real_literal = atof(temp);
     break;
   }
 
   default:
+    cell->value.symbol = ak_intern_n((const char *)atom, atom_len);
     break;
   }
 
@@ -174,6 +783,15 @@ static size_t process_escape_sequences(const uint8_t *src, size_t src_len,
   size_t i = 0;
 
   while (i < src_len) {
+    // Copy everything up to the next backslash in one go
+    size_t run_end = akx_cell_lex_find_quote(src, i, src_len);
+    memcpy(dst + dst_pos, src + i, run_end - i);
+    dst_pos += run_end - i;
+    i = run_end;
+    if (i >= src_len) {
+      break;
+    }
+
     if (src[i] == '\\' && i + 1 < src_len) {
       i++; // Skip the backslash
       switch (src[i]) {
@@ -214,46 +832,58 @@ static akx_cell_t *parse_string_literal(ak_scanner_t *scanner,
                                         ak_source_file_t *source_file,
                                         parse_context_t *ctx) {
   size_t start_pos = scanner->position;
+  uint8_t *buf_data = ak_buffer_data(scanner->buffer);
+  size_t buf_len = ak_buffer_count(scanner->buffer);
 
-  uint8_t escape = '\\';
-  ak_scanner_find_group_result_t result =
-      ak_scanner_find_group(scanner, '"', '"', &escape, false);
+  size_t close_pos = start_pos + 1;
+  int escaped = 0;
+  for (;;) {
+    close_pos = akx_cell_lex_find_quote(buf_data, close_pos, buf_len);
+    if (close_pos >= buf_len || buf_data[close_pos] == '"') {
+      break;
+    }
+    escaped = 1;
+    close_pos += 2;
+  }
 
-  if (!result.success) {
-    ak_source_loc_t error_loc = ak_source_loc_from_offset(
+  if (close_pos >= buf_len) {
+    ak_source_loc_t error_loc = parse_error_loc(
         source_file, start_pos + scanner->buffer->origin_offset);
     add_parse_error(ctx, &error_loc, "unterminated string literal");
     return NULL;
   }
 
   size_t origin_offset = scanner->buffer->origin_offset;
-  ak_source_loc_t start_loc =
-      ak_source_loc_from_offset(source_file, start_pos + origin_offset);
-  ak_source_loc_t end_loc = ak_source_loc_from_offset(
-      source_file, result.index_of_closing_symbol + 1 + origin_offset);
-  ak_source_range_t range = ak_source_range_new(start_loc, end_loc);
+  akx_cell_span_t span = {
+      (uint32_t)(start_pos + origin_offset),
+      (uint32_t)(close_pos + 1 + origin_offset)};
 
-  akx_cell_t *cell = create_cell(AKX_TYPE_STRING_LITERAL, &range);
+  akx_cell_t *cell = create_cell(ctx->arena, AKX_TYPE_STRING_LITERAL,
+                                 ctx->arena->source, &span);
   if (!cell) {
     return NULL;
   }
 
-  size_t content_start = result.index_of_start_symbol + 1;
-  size_t content_len = result.index_of_closing_symbol - content_start;
+  size_t content_start = start_pos + 1;
+  size_t content_len = close_pos - content_start;
 
   // Allocate buffer for the processed string (worst case: same size as input)
-  cell->value.string_literal = ak_buffer_new(content_len + 1);
+  cell->value.string_literal =
+      arena_buffer_new(ctx->arena, content_len + 1);
   if (!cell->value.string_literal) {
-    akx_cell_free(cell);
     return NULL;
   }
 
-  uint8_t *buf_data = ak_buffer_data(scanner->buffer);
   uint8_t *dst_data = ak_buffer_data(cell->value.string_literal);
 
   // Process escape sequences
-  size_t processed_len =
-      process_escape_sequences(buf_data + content_start, content_len, dst_data);
+  size_t processed_len = content_len;
+  if (escaped) {
+    processed_len = process_escape_sequences(buf_data + content_start,
+                                             content_len, dst_data);
+  } else {
+    memcpy(dst_data, buf_data + content_start, content_len);
+  }
 
   // Null-terminate
   dst_data[processed_len] = '\0';
@@ -261,117 +891,139 @@ static akx_cell_t *parse_string_literal(ak_scanner_t *scanner,
   // Update buffer count to reflect actual processed length
   cell->value.string_literal->count = processed_len;
 
-  scanner->position = result.index_of_closing_symbol + 1;
+  scanner->position = close_pos + 1;
 
   return cell;
 }
 
-static akx_cell_t *parse_explicit_list_generic(
-    ak_scanner_t *scanner, ak_source_file_t *source_file, uint8_t open_delim,
-    uint8_t close_delim, akx_type_t list_type, parse_context_t *ctx) {
-  size_t start_pos = scanner->position;
-  size_t origin_offset = scanner->buffer->origin_offset;
+static void report_unterminated_list(ak_scanner_t *scanner,
+                                     ak_source_file_t *source_file,
+                                     size_t start_pos, size_t stop_pos,
+                                     uint8_t open_delim, uint8_t close_delim,
+                                     parse_context_t *ctx) {
+  uint8_t *buf_data = ak_buffer_data(scanner->buffer);
+  size_t last_open_pos = start_pos;
 
-  ak_scanner_find_group_result_t result =
-      ak_scanner_find_group(scanner, open_delim, close_delim, NULL, true);
-
-  if (!result.success) {
-    size_t scan_pos = scanner->position + 1;
-    uint8_t *buf_data = ak_buffer_data(scanner->buffer);
-    size_t buf_len = ak_buffer_count(scanner->buffer);
-    size_t last_open_pos = start_pos;
-    int depth = 0;
-
-    for (size_t i = scan_pos; i < buf_len; i++) {
-      uint8_t c = buf_data[i];
-      if (c == open_delim) {
-        last_open_pos = i;
-        depth++;
-      } else if (c == close_delim) {
-        if (depth > 0) {
-          depth--;
-        }
-      }
+  for (size_t i = start_pos + 1; i < stop_pos; i++) {
+    if (buf_data[i] == open_delim) {
+      last_open_pos = i;
     }
-
-    ak_source_loc_t error_loc =
-        ak_source_loc_from_offset(source_file, last_open_pos + origin_offset);
-    char error_msg[AKX_CELL_MAX_ERROR_MESSAGE_SIZE_MAX];
-    snprintf(error_msg, sizeof(error_msg),
-             "unterminated list - missing closing '%c'", close_delim);
-    add_parse_error(ctx, &error_loc, error_msg);
-    return NULL;
   }
 
-  ak_source_loc_t start_loc =
-      ak_source_loc_from_offset(source_file, start_pos + origin_offset);
-  ak_source_loc_t end_loc = ak_source_loc_from_offset(
-      source_file, result.index_of_closing_symbol + 1 + origin_offset);
-  ak_source_range_t range = ak_source_range_new(start_loc, end_loc);
+  ak_source_loc_t error_loc = parse_error_loc(
+      source_file, last_open_pos + scanner->buffer->origin_offset);
+  char error_msg[AKX_CELL_MAX_ERROR_MESSAGE_SIZE_MAX];
+  snprintf(error_msg, sizeof(error_msg),
+           "unterminated list - missing closing '%c'", close_delim);
+  add_parse_error(ctx, &error_loc, error_msg);
+}
 
-  akx_cell_t *list_cell = create_cell(list_type, &range);
-  if (!list_cell) {
-    return NULL;
+static int skip_to_close_delim(ak_scanner_t *scanner, uint8_t open_delim,
+                               uint8_t close_delim) {
+  uint8_t *buf_data = ak_buffer_data(scanner->buffer);
+  size_t buf_len = ak_buffer_count(scanner->buffer);
+  int depth = 0;
+
+  for (size_t i = scanner->position; i < buf_len; i++) {
+    if (buf_data[i] == open_delim) {
+      depth++;
+    } else if (buf_data[i] == close_delim) {
+      if (depth == 0) {
+        scanner->position = i;
+        return 1;
+      }
+      depth--;
+    }
   }
 
-  size_t content_start = result.index_of_start_symbol + 1;
-  size_t content_len = result.index_of_closing_symbol - content_start;
-
-  if (content_len > 0) {
-    int bytes_copied = 0;
-    ak_buffer_t *sub_buf = ak_buffer_sub_buffer(scanner->buffer, content_start,
-                                                content_len, &bytes_copied);
+  scanner->position = buf_len;
+  return 0;
+}
 
-    if (sub_buf && bytes_copied > 0) {
-      ak_scanner_t *sub_scanner = ak_scanner_new(sub_buf, 0);
-      if (sub_scanner) {
-        akx_cell_t *head = NULL;
-        akx_cell_t *tail = NULL;
+static akx_cell_t *parse_explicit_list_generic(
+    ak_scanner_t *scanner, ak_source_file_t *source_file, uint8_t open_delim,
+    uint8_t close_delim, akx_type_t list_type, parse_context_t *ctx) {
+  size_t start_pos = scanner->position;
+  size_t origin_offset = scanner->buffer->origin_offset;
+  uint8_t *buf_data = ak_buffer_data(scanner->buffer);
+  size_t buf_len = ak_buffer_count(scanner->buffer);
 
-        while (sub_scanner->position < ak_buffer_count(sub_buf)) {
-          if (!ak_scanner_skip_whitespace_and_comments(sub_scanner)) {
-            break;
-          }
+  uint8_t enclosing_close_delim = ctx->close_delim;
+  ctx->close_delim = close_delim;
+  ctx->depth++;
 
-          if (sub_scanner->position >= ak_buffer_count(sub_buf)) {
-            break;
-          }
+  scanner->position++;
 
-          akx_cell_t *arg = parse_argument(sub_scanner, source_file, ctx);
-          if (!arg) {
-            break;
-          }
+  akx_cell_t *head = NULL;
+  akx_cell_t *tail = NULL;
 
-          if (!head) {
-            head = arg;
-            tail = arg;
-          } else {
-            tail->next = arg;
-            tail = arg;
-          }
+  while (scanner->position < buf_len) {
+    skip_blank(scanner);
 
-          while (tail->next) {
-            tail = tail->next;
-          }
-        }
+    if (scanner->position >= buf_len ||
+        is_close_delim(buf_data[scanner->position], close_delim)) {
+      break;
+    }
 
-        list_cell->value.list_head = head;
-        ak_scanner_free(sub_scanner);
+    akx_cell_t *arg = parse_argument(scanner, source_file, ctx);
+    if (!arg) {
+      // A malformed element drops the rest of this list, as long as the
+      // list itself is closed somewhere further on.
+      if (scanner->position < buf_len &&
+          !is_close_delim(buf_data[scanner->position], close_delim)) {
+        skip_to_close_delim(scanner, open_delim, close_delim);
       }
-      ak_buffer_free(sub_buf);
+      break;
+    }
+
+    if (!head) {
+      head = arg;
+      tail = arg;
+    } else {
+      tail->next = arg;
+      tail = arg;
+    }
+
+    while (tail->next) {
+      tail = tail->next;
     }
-  } else {
-    list_cell->value.list_head = NULL;
   }
 
-  scanner->position = result.index_of_closing_symbol + 1;
+  ctx->depth--;
+  ctx->close_delim = enclosing_close_delim;
+
+  if (scanner->position >= buf_len ||
+      buf_data[scanner->position] != close_delim) {
+    // Only the outermost open list reports running off the end of the
+    // buffer; a stray closer is reported by the list it interrupts.
+    if (scanner->position < buf_len || ctx->depth == 0) {
+      report_unterminated_list(scanner, source_file, start_pos,
+                               scanner->position, open_delim, close_delim,
+                               ctx);
+    }
+    scanner->position = start_pos;
+    return NULL;
+  }
 
-  return list_cell;
-}
+  scanner->position++;
 
-static akx_cell_t *parse_explicit_list(ak_scanner_t *scanner,
-                                       ak_source_file_t *source_file,
-                                       parse_context_t *ctx) {
+  akx_cell_span_t span = {(uint32_t)(start_pos + origin_offset),
+                          (uint32_t)(scanner->position + origin_offset)};
+
+  akx_cell_t *list_cell =
+      create_cell(ctx->arena, list_type, ctx->arena->source, &span);
+  if (!list_cell) {
+    return NULL;
+  }
+
+  list_cell->value.list_head = head;
+
+  return list_cell;
+}
+
+static akx_cell_t *parse_explicit_list(ak_scanner_t *scanner,
+                                       ak_source_file_t *source_file,
+                                       parse_context_t *ctx) {
   return parse_explicit_list_generic(scanner, source_file, '(', ')',
                                      AKX_TYPE_LIST, ctx);
 }
@@ -397,48 +1049,28 @@ static akx_cell_t *parse_explicit_list_temple(ak_scanner_t *scanner,
                                      AKX_TYPE_LIST_TEMPLE, ctx);
 }
 
-static int is_newline(uint8_t c) { return c == '\n' || c == '\r'; }
-
 static akx_cell_t *parse_virtual_list(ak_scanner_t *scanner,
                                       ak_source_file_t *source_file,
                                       parse_context_t *ctx) {
   size_t start_pos = scanner->position;
 
-  akx_cell_t *first_symbol = parse_static_type(scanner, source_file, ctx);
+  akx_cell_t *first_symbol = parse_static_type(scanner, ctx);
   if (!first_symbol || first_symbol->type != AKX_TYPE_SYMBOL) {
-    if (first_symbol) {
-      akx_cell_free(first_symbol);
-    }
     return NULL;
   }
 
   akx_cell_t *head = first_symbol;
   akx_cell_t *tail = first_symbol;
 
-  while (scanner->position < ak_buffer_count(scanner->buffer)) {
-    size_t pos_before_ws = scanner->position;
-
-    if (!ak_scanner_goto_next_non_white(scanner)) {
-      break;
-    }
-
-    uint8_t *buf_data = ak_buffer_data(scanner->buffer);
-    for (size_t i = pos_before_ws;
-         i < scanner->position && i < ak_buffer_count(scanner->buffer); i++) {
-      if (is_newline(buf_data[i])) {
-        goto end_virtual_list;
-      }
-    }
-
-    if (scanner->position >= ak_buffer_count(scanner->buffer)) {
-      break;
-    }
-
-    if (buf_data[scanner->position] == ';') {
-      break;
-    }
-
-    if (is_newline(buf_data[scanner->position])) {
+  uint8_t *buf_data = ak_buffer_data(scanner->buffer);
+  size_t buf_len = ak_buffer_count(scanner->buffer);
+
+  while (scanner->position < buf_len) {
+    int newline = 0;
+    scanner->position = akx_cell_lex_skip_space(buf_data, scanner->position,
+                                                buf_len, &newline);
+    if (newline || scanner->position >= buf_len ||
+        buf_data[scanner->position] == ';') {
       break;
     }
 
@@ -455,18 +1087,13 @@ static akx_cell_t *parse_virtual_list(ak_scanner_t *scanner,
     }
   }
 
-end_virtual_list:;
-
   size_t origin_offset = scanner->buffer->origin_offset;
-  ak_source_loc_t start_loc =
-      ak_source_loc_from_offset(source_file, start_pos + origin_offset);
-  ak_source_loc_t end_loc =
-      ak_source_loc_from_offset(source_file, scanner->position + origin_offset);
-  ak_source_range_t range = ak_source_range_new(start_loc, end_loc);
+  akx_cell_span_t span = {(uint32_t)(start_pos + origin_offset),
+                          (uint32_t)(scanner->position + origin_offset)};
 
-  akx_cell_t *list_cell = create_cell(AKX_TYPE_LIST, &range);
+  akx_cell_t *list_cell =
+      create_cell(ctx->arena, AKX_TYPE_LIST, ctx->arena->source, &span);
   if (!list_cell) {
-    akx_cell_free(head);
     return NULL;
   }
 
@@ -484,7 +1111,7 @@ static akx_cell_t *parse_quoted(ak_scanner_t *scanner,
 
   akx_cell_t *inner = parse_argument(scanner, source_file, ctx);
   if (!inner) {
-    ak_source_loc_t error_loc = ak_source_loc_from_offset(
+    ak_source_loc_t error_loc = parse_error_loc(
         source_file, start_pos + scanner->buffer->origin_offset);
     add_parse_error(ctx, &error_loc, "invalid expression after quote");
     return NULL;
@@ -493,31 +1120,41 @@ static akx_cell_t *parse_quoted(ak_scanner_t *scanner,
   size_t content_start = start_pos + 1;
   size_t content_end = scanner->position;
 
-  ak_source_loc_t start_loc = ak_source_loc_from_offset(
-      source_file, start_pos + scanner->buffer->origin_offset);
-  ak_source_loc_t end_loc = ak_source_loc_from_offset(
-      source_file, content_end + scanner->buffer->origin_offset);
-  ak_source_range_t range = ak_source_range_new(start_loc, end_loc);
+  akx_cell_span_t span = {
+      (uint32_t)(start_pos + scanner->buffer->origin_offset),
+      (uint32_t)(content_end + scanner->buffer->origin_offset)};
 
-  akx_cell_t *quoted_cell = create_cell(AKX_TYPE_QUOTED, &range);
+  akx_cell_t *quoted_cell =
+      create_cell(ctx->arena, AKX_TYPE_QUOTED, ctx->arena->source, &span);
   if (!quoted_cell) {
-    akx_cell_free(inner);
     return NULL;
   }
 
   uint8_t *buf_data = ak_buffer_data(scanner->buffer);
   size_t content_len = content_end - content_start;
-  quoted_cell->value.quoted_literal = ak_buffer_new(content_len + 1);
+  quoted_cell->value.quoted_literal =
+      arena_buffer_new(ctx->arena, content_len + 1);
   if (!quoted_cell->value.quoted_literal) {
-    akx_cell_free(quoted_cell);
-    akx_cell_free(inner);
     return NULL;
   }
 
   ak_buffer_copy_to(quoted_cell->value.quoted_literal, buf_data + content_start,
                     content_len);
 
-  akx_cell_free(inner);
+  // Keep the tree that reparsing the text on its own would give: a bare
+  // symbol reads as a one-element list and other atoms do not form a list
+  if (inner->type == AKX_TYPE_SYMBOL) {
+    akx_cell_span_t inner_span = {
+        (uint32_t)(content_start + scanner->buffer->origin_offset), span.end};
+    akx_cell_t *list_cell =
+        create_cell(ctx->arena, AKX_TYPE_LIST, ctx->arena->source, &inner_span);
+    if (list_cell) {
+      list_cell->value.list_head = inner;
+    }
+    *cell_quoted_expr(quoted_cell) = list_cell;
+  } else {
+    *cell_quoted_expr(quoted_cell) = inner;
+  }
 
   return quoted_cell;
 }
@@ -525,9 +1162,7 @@ static akx_cell_t *parse_quoted(ak_scanner_t *scanner,
 static akx_cell_t *parse_argument(ak_scanner_t *scanner,
                                   ak_source_file_t *source_file,
                                   parse_context_t *ctx) {
-  if (!ak_scanner_skip_whitespace_and_comments(scanner)) {
-    return NULL;
-  }
+  skip_blank(scanner);
 
   if (scanner->position >= ak_buffer_count(scanner->buffer)) {
     return NULL;
@@ -550,7 +1185,37 @@ static akx_cell_t *parse_argument(ak_scanner_t *scanner,
   case '\'':
     return parse_quoted(scanner, source_file, ctx);
   default:
-    return parse_static_type(scanner, source_file, ctx);
+    return parse_static_type(scanner, ctx);
+  }
+}
+
+static akx_cell_t *parse_top_level(ak_scanner_t *scanner,
+                                   ak_source_file_t *source_file,
+                                   parse_context_t *ctx) {
+  uint8_t *buf_data = ak_buffer_data(scanner->buffer);
+
+  switch (buf_data[scanner->position]) {
+  case '(':
+    return parse_explicit_list(scanner, source_file, ctx);
+  case '[':
+    return parse_explicit_list_square(scanner, source_file, ctx);
+  case '{':
+    return parse_explicit_list_curly(scanner, source_file, ctx);
+  case '<':
+    return parse_explicit_list_temple(scanner, source_file, ctx);
+  case '\'':
+    return parse_quoted(scanner, source_file, ctx);
+  default:
+    return parse_virtual_list(scanner, source_file, ctx);
+  }
+}
+
+static void push_top_level(akx_parse_result_t *result, akx_cell_t *expr) {
+  while (expr) {
+    akx_cell_t *next = expr->next;
+    expr->next = NULL;
+    list_push(&result->cells, expr);
+    expr = next;
   }
 }
 
@@ -560,79 +1225,63 @@ akx_parse_result_t akx_cell_parse_buffer(ak_buffer_t *buf,
   list_init(&result.cells);
   result.errors = NULL;
   result.source_file = NULL;
+  result.arena = NULL;
 
   if (!buf || !filename) {
     return result;
   }
 
-  parse_context_t ctx = {NULL, NULL};
+  akx_cell_arena_t *arena = arena_new();
+  if (!arena) {
+    AK24_LOG_ERROR("Failed to create cell arena for %s", filename);
+    return result;
+  }
+
+  parse_context_t ctx = {NULL, NULL, 0, 0, arena};
 
   ak_source_file_t *source_file = ak_source_file_new(
       filename, (const char *)ak_buffer_data(buf), ak_buffer_count(buf));
   if (!source_file) {
     AK24_LOG_ERROR("Failed to create source file for %s", filename);
+    arena_free(arena);
+    return result;
+  }
+
+  arena->source = source_register(source_file);
+  if (!arena->source) {
+    AK24_LOG_ERROR("Failed to register source file for %s", filename);
+    ak_source_file_release(source_file);
+    arena_free(arena);
     return result;
   }
 
   ak_scanner_t *scanner = ak_scanner_new(buf, 0);
   if (!scanner) {
     AK24_LOG_ERROR("Failed to create scanner");
-    ak_source_file_release(source_file);
+    arena_free(arena);
     return result;
   }
 
   while (scanner->position < ak_buffer_count(buf)) {
-    if (!ak_scanner_skip_whitespace_and_comments(scanner)) {
-      break;
-    }
+    skip_blank(scanner);
 
     if (scanner->position >= ak_buffer_count(buf)) {
       break;
     }
 
-    uint8_t *buf_data = ak_buffer_data(buf);
-    uint8_t current = buf_data[scanner->position];
-
-    akx_cell_t *expr = NULL;
-
-    switch (current) {
-    case '(':
-      expr = parse_explicit_list(scanner, source_file, &ctx);
-      break;
-    case '[':
-      expr = parse_explicit_list_square(scanner, source_file, &ctx);
-      break;
-    case '{':
-      expr = parse_explicit_list_curly(scanner, source_file, &ctx);
-      break;
-    case '<':
-      expr = parse_explicit_list_temple(scanner, source_file, &ctx);
-      break;
-    case '\'':
-      expr = parse_quoted(scanner, source_file, &ctx);
-      break;
-    default:
-      expr = parse_virtual_list(scanner, source_file, &ctx);
-      break;
-    }
-
+    akx_cell_t *expr = parse_top_level(scanner, source_file, &ctx);
     if (!expr) {
       break;
     }
 
-    akx_cell_t *cell_iter = expr;
-    while (cell_iter) {
-      akx_cell_t *next = cell_iter->next;
-      cell_iter->next = NULL;
-      list_push(&result.cells, cell_iter);
-      cell_iter = next;
-    }
+    push_top_level(&result, expr);
   }
 
   ak_scanner_free(scanner);
 
   result.errors = ctx.errors;
   result.source_file = source_file;
+  result.arena = arena;
   return result;
 }
 
@@ -641,6 +1290,7 @@ akx_parse_result_t akx_cell_parse_file(const char *path) {
   list_init(&result.cells);
   result.errors = NULL;
   result.source_file = NULL;
+  result.arena = NULL;
 
   if (!path) {
     return result;
@@ -658,59 +1308,362 @@ akx_parse_result_t akx_cell_parse_file(const char *path) {
   return result;
 }
 
-void akx_parse_result_free(akx_parse_result_t *result) {
-  if (!result) {
+static int stream_is_regular(FILE *input) {
+#ifdef AK24_PLATFORM_WINDOWS
+  struct _stat st;
+  return _fstat(_fileno(input), &st) == 0 && (st.st_mode & _S_IFREG);
+#else
+  struct stat st;
+  return fstat(fileno(input), &st) == 0 && S_ISREG(st.st_mode);
+#endif
+}
+
+akx_cell_stream_t *akx_cell_stream_open(const char *path) {
+  if (!path) {
+    return NULL;
+  }
+
+  akx_cell_stream_t *stream = AK24_ALLOC(sizeof(akx_cell_stream_t));
+  if (!stream) {
+    return NULL;
+  }
+  memset(stream, 0, sizeof(akx_cell_stream_t));
+
+  if (strcmp(path, "-") == 0) {
+    stream->input = stdin;
+    stream->name = ak_intern("<stdin>");
+  } else {
+    stream->input = fopen(path, "rb");
+    stream->name = ak_intern(path);
+  }
+
+  stream->pending = ak_buffer_new(AKX_CELL_STREAM_CHUNK_SIZE);
+  stream->opens = ak_buffer_new(64);
+  stream->scanner = stream->pending ? ak_scanner_new(stream->pending, 0) : NULL;
+  stream->chunk = AK24_ALLOC(AKX_CELL_STREAM_CHUNK_SIZE);
+  if (!stream->input || !stream->opens || !stream->scanner || !stream->chunk) {
+    AK24_LOG_ERROR("Failed to open input: %s", path);
+    akx_cell_stream_close(stream);
+    return NULL;
+  }
+
+  // Files are parsed in batches; pipes and terminals hand out every form as
+  // soon as its last line arrives
+  if (stream_is_regular(stream->input)) {
+    stream->batch_size = AKX_CELL_STREAM_BATCH_SIZE;
+  }
+
+  return stream;
+}
+
+void akx_cell_stream_close(akx_cell_stream_t *stream) {
+  if (!stream) {
     return;
   }
 
-  list_iter_t iter = list_iter(&result->cells);
-  akx_cell_t **cell_ptr;
-  while ((cell_ptr = list_next(&result->cells, &iter))) {
-    akx_cell_free(*cell_ptr);
+  if (stream->input && stream->input != stdin) {
+    fclose(stream->input);
   }
-  list_deinit(&result->cells);
+  if (stream->scanner) {
+    ak_scanner_free(stream->scanner);
+  }
+  if (stream->pending) {
+    ak_buffer_free(stream->pending);
+  }
+  if (stream->opens) {
+    ak_buffer_free(stream->opens);
+  }
+  if (stream->chunk) {
+    AK24_FREE(stream->chunk);
+  }
+  AK24_FREE(stream);
+}
+
+static void stream_track(akx_cell_stream_t *stream, const uint8_t *data,
+                         size_t len) {
+  ak_buffer_t *opens = stream->opens;
+
+  for (size_t i = 0; i < len; i++) {
+    uint8_t c = data[i];
+    uint8_t prev = stream->prev;
+    stream->prev = c;
+
+    if (stream->in_comment) {
+      stream->in_comment = c != '\n';
+      continue;
+    }
+
+    if (stream->in_string) {
+      if (stream->in_escape) {
+        stream->in_escape = 0;
+      } else if (c == '\\') {
+        stream->in_escape = 1;
+      } else if (c == '"') {
+        stream->in_string = 0;
+      }
+      continue;
+    }
+
+    switch (c) {
+    case '"':
+      stream->in_string = 1;
+      break;
+    case ';':
+      stream->in_comment = 1;
+      break;
+    case '<':
+      // Only opens a list where an element starts, as in parse_argument
+      if (prev && !isspace(prev) && prev != '(' && prev != '[' &&
+          prev != '{' && prev != '<' && prev != '\'') {
+        break;
+      }
+      ak_buffer_copy_to(opens, &c, 1);
+      break;
+    case '(':
+    case '[':
+    case '{':
+      ak_buffer_copy_to(opens, &c, 1);
+      break;
+    case '>':
+      if (opens->count && ak_buffer_data(opens)[opens->count - 1] == '<') {
+        opens->count--;
+      }
+      break;
+    case ')':
+    case ']':
+    case '}':
+      if (opens->count) {
+        opens->count--;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+static int stream_read_line(akx_cell_stream_t *stream) {
+  ak_buffer_t *buf = stream->pending;
+
+  // Drop lines already handed out once they make up half the window
+  if (stream->line_start > 0 &&
+      stream->line_start >= ak_buffer_count(buf) / 2) {
+    uint8_t *data = ak_buffer_data(buf);
+    size_t count = ak_buffer_count(buf);
+    memmove(data, data + stream->line_start, count - stream->line_start);
+    buf->count = count - stream->line_start;
+    stream->position -= stream->line_start;
+    stream->line_scan -= stream->line_start;
+    stream->retry_at -= stream->retry_at > stream->line_start
+                            ? stream->line_start
+                            : stream->retry_at;
+    stream->line_start = 0;
+  }
+
+  for (;;) {
+    char *line = (char *)stream->chunk;
+    if (!fgets(line, AKX_CELL_STREAM_CHUNK_SIZE, stream->input)) {
+      if (ferror(stream->input)) {
+        AK24_LOG_ERROR("Failed to read input: %s", stream->name);
+        return -1;
+      }
+      stream->eof = 1;
+      return 0;
+    }
+
+    size_t n = strlen(line);
+    size_t start = ak_buffer_count(buf);
+    ak_buffer_copy_to(buf, stream->chunk, n);
+    stream_track(stream, ak_buffer_data(buf) + start, n);
+
+    if (n > 0 && line[n - 1] == '\n') {
+      return 1;
+    }
+  }
+}
+
+static int stream_ready(akx_cell_stream_t *stream) {
+  size_t count = ak_buffer_count(stream->pending);
+
+  if (stream->eof) {
+    return 1;
+  }
+
+  return ak_buffer_count(stream->opens) == 0 && !stream->in_string &&
+         count - stream->position >= stream->batch_size &&
+         count >= stream->retry_at;
+}
+
+static void stream_seek_line(akx_cell_stream_t *stream, size_t position) {
+  uint8_t *data = ak_buffer_data(stream->pending);
 
-  akx_parse_error_t *err = result->errors;
+  for (size_t i = stream->line_scan; i < position; i++) {
+    if (data[i] == '\n') {
+      stream->line_base++;
+      stream->line_start = i + 1;
+    }
+  }
+  stream->line_scan = position;
+}
+
+static void free_parse_errors(akx_parse_error_t *err) {
   while (err) {
     akx_parse_error_t *next = err->next;
     AK24_FREE(err);
     err = next;
   }
-  result->errors = NULL;
+}
 
-  if (result->source_file) {
-    ak_source_file_release(result->source_file);
-    result->source_file = NULL;
+static int stream_parse(akx_cell_stream_t *stream,
+                        akx_parse_result_t *result) {
+  ak_buffer_t *buf = stream->pending;
+  size_t count = ak_buffer_count(buf);
+  ak_scanner_t *scanner = stream->scanner;
+
+  scanner->position = stream->position;
+  skip_blank(scanner);
+  stream->position = scanner->position;
+  if (stream->position >= count) {
+    return stream->eof ? 0 : AKX_CELL_STREAM_NEED_INPUT;
   }
-}
 
-akx_cell_t *akx_cell_unwrap_quoted(akx_cell_t *quoted_cell) {
-  if (!quoted_cell || quoted_cell->type != AKX_TYPE_QUOTED) {
-    return NULL;
+  // Only the lines of the forms handed out are kept for diagnostics
+  stream_seek_line(stream, stream->position);
+
+  akx_cell_arena_t *arena = arena_new();
+  if (!arena) {
+    return -1;
   }
 
-  if (!quoted_cell->value.quoted_literal) {
-    return NULL;
+  arena->source = source_register(NULL);
+  if (!arena->source) {
+    arena_free(arena);
+    return -1;
   }
 
-  const char *filename = "<quoted>";
-  if (quoted_cell->sourceloc && quoted_cell->sourceloc->start.file) {
-    filename = ak_source_file_name(quoted_cell->sourceloc->start.file);
+  // Offsets are relative to the first line handed out, preceded by one
+  // newline per earlier line (see source_file_of); unsigned wrap-around
+  // keeps this exact
+  buf->origin_offset = (size_t)stream->line_base - stream->line_start;
+
+  parse_context_t ctx = {NULL, NULL, 0, 0, arena};
+  size_t end = stream->position;
+
+  while (scanner->position < count) {
+    skip_blank(scanner);
+    if (scanner->position >= count) {
+      break;
+    }
+
+    akx_cell_t *expr = parse_top_level(scanner, NULL, &ctx);
+    if (ctx.errors) {
+      break;
+    }
+    if (!expr) {
+      stream->done = 1;
+      break;
+    }
+
+    push_top_level(result, expr);
+    end = scanner->position;
   }
 
-  akx_parse_result_t result =
-      akx_cell_parse_buffer(quoted_cell->value.quoted_literal, filename);
+  if (list_count(&result->cells) > 0) {
+    // Forms ahead of a bad one still run; the error is reported next time
+    free_parse_errors(ctx.errors);
+    ctx.errors = NULL;
+  } else if (!ctx.errors) {
+    arena_free(arena);
+    return 0;
+  } else if (!stream->eof) {
+    // Input cut short at the end of a line can look like an error
+    free_parse_errors(ctx.errors);
+    arena_free(arena);
+    stream->retry_at = stream->batch_size ? count * 2 : count + 1;
+    return AKX_CELL_STREAM_NEED_INPUT;
+  } else {
+    end = count;
+    stream->done = 1;
+  }
 
-  akx_cell_t *first = list_count(&result.cells) > 0
-                          ? *((akx_cell_t **)list_get(&result.cells, 0))
-                          : NULL;
+  uint8_t *data = ak_buffer_data(buf);
+  size_t line_end = end;
+  while (line_end < count && data[line_end] != '\n') {
+    line_end++;
+  }
+
+  size_t text_len = line_end - stream->line_start;
+  pthread_mutex_lock(&g_sources_lock);
+  source_entry_t *entry = &g_sources[arena->source - 1];
+  entry->name = stream->name;
+  entry->line_base = stream->line_base;
+  entry->text = ak_buffer_new(text_len + 1);
+  if (entry->text) {
+    ak_buffer_copy_to(entry->text, data + stream->line_start, text_len);
+  }
+  pthread_mutex_unlock(&g_sources_lock);
 
-  list_deinit(&result.cells);
-  if (result.source_file) {
-    ak_source_file_release(result.source_file);
+  if (ctx.errors) {
+    ak_source_file_t *file = source_file_of(arena->source);
+    for (akx_parse_error_t *err = ctx.errors; err; err = err->next) {
+      err->location = ak_source_loc_from_offset(file, err->location.offset);
+    }
   }
 
-  return first;
+  result->errors = ctx.errors;
+  result->arena = arena;
+  stream->position = end;
+  stream->retry_at = 0;
+  return 1;
+}
+
+int akx_cell_stream_next(akx_cell_stream_t *stream,
+                         akx_parse_result_t *result) {
+  if (!result) {
+    return -1;
+  }
+
+  list_init(&result->cells);
+  result->errors = NULL;
+  result->source_file = NULL;
+  result->arena = NULL;
+
+  if (!stream) {
+    return -1;
+  }
+
+  while (!stream->done) {
+    if (stream_ready(stream)) {
+      int rc = stream_parse(stream, result);
+      if (rc != AKX_CELL_STREAM_NEED_INPUT) {
+        return rc;
+      }
+    }
+
+    if (stream->eof) {
+      break;
+    }
+    if (stream_read_line(stream) < 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+void akx_parse_result_free(akx_parse_result_t *result) {
+  if (!result) {
+    return;
+  }
+
+  list_deinit(&result->cells);
+
+  arena_free(result->arena);
+  result->arena = NULL;
+  result->source_file = NULL;
+
+  free_parse_errors(result->errors);
+  result->errors = NULL;
 }
 
 static ak_buffer_t *clone_buffer(ak_buffer_t *buf) {
@@ -730,12 +1683,12 @@ static ak_buffer_t *clone_buffer(ak_buffer_t *buf) {
   return cloned;
 }
 
-akx_cell_t *akx_cell_clone(akx_cell_t *cell) {
-  if (!cell) {
-    return NULL;
-  }
-
-  akx_cell_t *cloned = create_cell(cell->type, cell->sourceloc);
+// Copies one cell without its children or siblings; those are filled in by
+// clone_tree. Plain copies bypass any collector or pool.
+static akx_cell_t *copy_cell(akx_cell_t *cell, int plain) {
+  akx_cell_t *cloned = create_cell_with(
+      NULL, plain, cell->type, cell->source,
+      (cell->flags & AKX_CELL_FLAG_SPAN) ? cell_span(cell) : NULL);
   if (!cloned) {
     return NULL;
   }
@@ -746,7 +1699,16 @@ akx_cell_t *akx_cell_clone(akx_cell_t *cell) {
     break;
 
   case AKX_TYPE_INTEGER_LITERAL:
-    cloned->value.integer_literal = cell->value.integer_literal;
+    if (cell->flags & AKX_CELL_FLAG_BIGNUM) {
+      cloned->value.bignum = akx_bignum_clone(cell->value.bignum);
+      if (!cloned->value.bignum) {
+        akx_cell_free(cloned);
+        return NULL;
+      }
+      cloned->flags |= AKX_CELL_FLAG_BIGNUM;
+    } else {
+      cloned->value.integer_literal = cell->value.integer_literal;
+    }
     break;
 
   case AKX_TYPE_REAL_LITERAL:
@@ -761,13 +1723,6 @@ akx_cell_t *akx_cell_clone(akx_cell_t *cell) {
     }
     break;
 
-  case AKX_TYPE_LIST:
-  case AKX_TYPE_LIST_SQUARE:
-  case AKX_TYPE_LIST_CURLY:
-  case AKX_TYPE_LIST_TEMPLE:
-    cloned->value.list_head = akx_cell_clone(cell->value.list_head);
-    break;
-
   case AKX_TYPE_QUOTED:
     cloned->value.quoted_literal = clone_buffer(cell->value.quoted_literal);
     if (!cloned->value.quoted_literal && cell->value.quoted_literal) {
@@ -785,21 +1740,617 @@ akx_cell_t *akx_cell_clone(akx_cell_t *cell) {
     break;
 
   case AKX_TYPE_CONTINUATION:
-    if (cell->value.continuation) {
-      cloned->value.continuation = AK24_ALLOC(sizeof(akx_continuation_t));
-      if (!cloned->value.continuation) {
-        akx_cell_free(cloned);
+    if (cell->value.continuation &&
+        !akx_cell_alloc_continuation(cloned)) {
+      akx_cell_free(cloned);
+      return NULL;
+    }
+    break;
+  }
+
+  return cloned;
+}
+
+// Deep copies cell (and its siblings when asked) without recursing. Every
+// copy is linked in as soon as it is made, so on failure the partial tree is
+// well formed and can simply be freed.
+static akx_cell_t *clone_tree(akx_cell_t *cell, int siblings, int plain) {
+  akx_cell_t *result = NULL;
+  akx_cell_t **slot = &result;
+  int failed = 0;
+
+  cell_work_stack_t work;
+  work_init(&work);
+
+  for (;;) {
+    while (cell) {
+      akx_cell_t *copy = copy_cell(cell, plain);
+      if (!copy) {
+        failed = 1;
+        break;
+      }
+
+      *slot = copy;
+      slot = &copy->next;
+
+      akx_cell_t *rest = siblings ? cell->next : NULL;
+      akx_cell_t *child = NULL;
+      akx_cell_t **child_slot = NULL;
+      int child_siblings = 1;
+
+      if (is_list_type(cell->type)) {
+        child = cell->value.list_head;
+        child_slot = &copy->value.list_head;
+      } else if (cell->type == AKX_TYPE_QUOTED &&
+                 (cell->flags & AKX_CELL_FLAG_QUOTED_EXPR)) {
+        child = *cell_quoted_expr(cell);
+        child_slot = cell_quoted_expr(copy);
+        child_siblings = 0;
+      } else if (cell->type == AKX_TYPE_CONTINUATION &&
+                 cell->value.continuation) {
+        akx_continuation_t *src = cell->value.continuation;
+        akx_continuation_t *dst = copy->value.continuation;
+        if (src->args && work_push(&work, src->args, &dst->args, 1) != 0) {
+          failed = 1;
+          break;
+        }
+        child = src->lambda_cell;
+        child_slot = &dst->lambda_cell;
+      }
+
+      if (!child) {
+        cell = rest;
+        continue;
+      }
+
+      if (rest && work_push(&work, rest, slot, siblings) != 0) {
+        failed = 1;
+        break;
+      }
+
+      cell = child;
+      slot = child_slot;
+      siblings = child_siblings;
+    }
+
+    cell_work_t item;
+    if (failed || !work_pop(&work, &item)) {
+      break;
+    }
+    cell = item.cell;
+    slot = item.slot;
+    siblings = item.siblings;
+  }
+
+  work_deinit(&work);
+
+  if (failed) {
+    akx_cell_free(result);
+    return NULL;
+  }
+
+  return result;
+}
+
+akx_cell_t *akx_cell_promote(akx_cell_t *cell) {
+  return clone_tree(cell, 0, 0);
+}
+
+akx_cell_t *akx_cell_clone(akx_cell_t *cell) { return clone_tree(cell, 1, 0); }
+
+// Arena cells cannot be shared, so a parsed quote keeps one heap copy of its
+// tree and shares that. The copy is plain AK24_ALLOC memory: a collector
+// would not see it from the arena and a pool may go before the arena does.
+// With a collector installed, callers drop values without releasing them,
+// so every evaluation gets its own copy instead.
+static akx_cell_t *share_quoted_view(akx_cell_t *quoted_cell,
+                                     akx_cell_t *expr) {
+  if (g_heap_set) {
+    return akx_cell_promote(expr);
+  }
+  akx_cell_t **view = cell_quoted_view(quoted_cell);
+  if (!*view) {
+    *view = clone_tree(expr, 0, 1);
+    if (!*view) {
+      return NULL;
+    }
+  }
+  return akx_cell_retain(*view);
+}
+
+akx_cell_t *akx_cell_unwrap_quoted(akx_cell_t *quoted_cell) {
+  if (!quoted_cell || quoted_cell->type != AKX_TYPE_QUOTED) {
+    return NULL;
+  }
+
+  // Quotes that kept their tree hand out a shared reference to it; the text
+  // is only reparsed for quoted cells built at runtime
+  akx_cell_t *expr = (quoted_cell->flags & AKX_CELL_FLAG_QUOTED_EXPR)
+                         ? *cell_quoted_expr(quoted_cell)
+                         : NULL;
+  if (expr && !(quoted_cell->flags & AKX_CELL_FLAG_ARENA)) {
+    return akx_cell_retain(expr);
+  }
+  if (expr) {
+    return share_quoted_view(quoted_cell, expr);
+  }
+
+  if (!quoted_cell->value.quoted_literal) {
+    return NULL;
+  }
+
+  const char *filename = "<quoted>";
+  if (akx_cell_has_location(quoted_cell)) {
+    filename = ak_source_file_name(akx_cell_source_file(quoted_cell));
+  }
+
+  akx_parse_result_t result =
+      akx_cell_parse_buffer(quoted_cell->value.quoted_literal, filename);
+
+  akx_cell_t *first = list_count(&result.cells) > 0
+                          ? *((akx_cell_t **)list_get(&result.cells, 0))
+                          : NULL;
+
+  akx_cell_t *promoted = akx_cell_promote(first);
+
+  akx_parse_result_free(&result);
+
+  return promoted;
+}
+
+static akx_cell_t small_ints[AKX_CELL_SMALL_INT_MAX - AKX_CELL_SMALL_INT_MIN +
+                             1];
+
+void akx_cell_init_immediate(akx_cell_t *cell, akx_type_t type) {
+  memset(cell, 0, sizeof(*cell));
+  cell->type = (uint8_t)type;
+  cell->flags = AKX_CELL_FLAG_IMMEDIATE;
+}
+
+akx_cell_t *akx_cell_small_int(int64_t value) {
+  if (value < AKX_CELL_SMALL_INT_MIN || value > AKX_CELL_SMALL_INT_MAX) {
+    return NULL;
+  }
+  akx_cell_t *cell = &small_ints[value - AKX_CELL_SMALL_INT_MIN];
+  if (!(cell->flags & AKX_CELL_FLAG_IMMEDIATE)) {
+    akx_cell_init_immediate(cell, AKX_TYPE_INTEGER_LITERAL);
+    cell->value.integer_literal = value;
+  }
+  return cell;
+}
+
+akx_cell_t *akx_cell_retain(akx_cell_t *cell) {
+  if (!cell || (cell->flags & AKX_CELL_FLAG_IMMEDIATE)) {
+    return cell;
+  }
+  if ((cell->flags & AKX_CELL_FLAG_ARENA) || cell->next ||
+      cell->refs == UINT16_MAX) {
+    return akx_cell_promote(cell);
+  }
+  cell->refs++;
+  return cell;
+}
+
+int akx_cell_is_shared(const akx_cell_t *cell) {
+  if (!cell) {
+    return 0;
+  }
+  return cell->refs || (cell->flags & AKX_CELL_FLAG_IMMEDIATE) ? 1 : 0;
+}
+
+void akx_cell_set_heap(const akx_cell_heap_t *heap) {
+  if (heap) {
+    g_heap = *heap;
+    g_heap_set = 1;
+  } else {
+    memset(&g_heap, 0, sizeof(g_heap));
+    g_heap_set = 0;
+  }
+}
+
+void akx_cell_set_pool(const akx_cell_pool_t *pool) {
+  if (pool) {
+    g_pool = *pool;
+    g_pool_set = 1;
+  } else {
+    memset(&g_pool, 0, sizeof(g_pool));
+    g_pool_set = 0;
+  }
+}
+
+akx_cell_t *akx_cell_new(akx_type_t type) {
+  return create_cell(NULL, type, 0, NULL);
+}
+
+akx_continuation_t *akx_cell_alloc_continuation(akx_cell_t *cell) {
+  if ((cell->flags & AKX_CELL_FLAG_POOLED) && !g_pool_set) {
+    AK24_LOG_ERROR("Pooled cell used on a thread without a cell pool");
+    return NULL;
+  }
+  akx_continuation_t *cont =
+      (cell->flags & AKX_CELL_FLAG_POOLED)
+          ? g_pool.alloc(g_pool.user, sizeof(akx_continuation_t))
+          : AK24_ALLOC(sizeof(akx_continuation_t));
+  if (!cont) {
+    return NULL;
+  }
+  memset(cont, 0, sizeof(akx_continuation_t));
+  cell->value.continuation = cont;
+  return cont;
+}
+
+void akx_cell_destroy(akx_cell_t *cell) {
+  if (!cell || (cell->flags & (AKX_CELL_FLAG_ARENA | AKX_CELL_FLAG_IMMEDIATE))) {
+    return;
+  }
+  release_cell(cell);
+}
+
+size_t akx_cell_children(akx_cell_t *cell, akx_cell_t *out[2]) {
+  size_t count = 0;
+  if (is_list_type(cell->type)) {
+    out[count++] = cell->value.list_head;
+  } else if (cell->type == AKX_TYPE_QUOTED &&
+             (cell->flags & AKX_CELL_FLAG_QUOTED_EXPR)) {
+    out[count++] = *cell_quoted_expr(cell);
+  } else if (cell->type == AKX_TYPE_CONTINUATION &&
+             cell->value.continuation) {
+    out[count++] = cell->value.continuation->lambda_cell;
+    out[count++] = cell->value.continuation->args;
+  }
+  return count;
+}
+
+akx_cell_site_t *akx_cell_site(akx_cell_t *cell) {
+  return cell && (cell->flags & AKX_CELL_FLAG_SITE) ? cell_site(cell) : NULL;
+}
+
+int akx_cell_has_location(akx_cell_t *cell) {
+  return cell && (cell->flags & AKX_CELL_FLAG_SPAN) ? 1 : 0;
+}
+
+ak_source_file_t *akx_cell_source_file(akx_cell_t *cell) {
+  if (!akx_cell_has_location(cell)) {
+    return NULL;
+  }
+
+  return source_file_of(cell->source);
+}
+
+ak_source_loc_t akx_cell_location(akx_cell_t *cell) {
+  ak_source_loc_t loc;
+  memset(&loc, 0, sizeof(loc));
+
+  if (!akx_cell_has_location(cell)) {
+    return loc;
+  }
+
+  return ak_source_loc_from_offset(akx_cell_source_file(cell),
+                                   cell_span(cell)->start);
+}
+
+ak_source_range_t akx_cell_range(akx_cell_t *cell) {
+  ak_source_range_t range;
+  memset(&range, 0, sizeof(range));
+
+  if (!akx_cell_has_location(cell)) {
+    return range;
+  }
+
+  ak_source_file_t *file = akx_cell_source_file(cell);
+  akx_cell_span_t *span = cell_span(cell);
+  return ak_source_range_new(ak_source_loc_from_offset(file, span->start),
+                             ak_source_loc_from_offset(file, span->end));
+}
+
+static void encode_bytes(ak_buffer_t *out, const void *data, size_t len) {
+  ak_buffer_copy_to(out, (uint8_t *)data, len);
+}
+
+static void encode_u32(ak_buffer_t *out, uint32_t value) {
+  encode_bytes(out, &value, sizeof(value));
+}
+
+static void encode_buffer(ak_buffer_t *out, ak_buffer_t *buf) {
+  uint32_t len = buf ? (uint32_t)ak_buffer_count(buf) : 0;
+  encode_u32(out, len);
+  if (len > 0) {
+    encode_bytes(out, ak_buffer_data(buf), len);
+  }
+}
+
+static int encode_cell(ak_buffer_t *out, akx_cell_t *cell) {
+  uint8_t header[2] = {cell->type, 0};
+  if (cell->flags & AKX_CELL_FLAG_SPAN) {
+    header[1] |= AKX_CELL_ENCODE_SPAN;
+  }
+  if (cell->flags & AKX_CELL_FLAG_BIGNUM) {
+    header[1] |= AKX_CELL_ENCODE_BIGNUM;
+  }
+  encode_bytes(out, header, sizeof(header));
+  if (header[1] & AKX_CELL_ENCODE_SPAN) {
+    encode_bytes(out, cell_span(cell), sizeof(akx_cell_span_t));
+  }
+
+  switch (cell->type) {
+  case AKX_TYPE_SYMBOL: {
+    uint32_t len = (uint32_t)strlen(cell->value.symbol);
+    encode_u32(out, len);
+    encode_bytes(out, cell->value.symbol, len);
+    return 0;
+  }
+
+  case AKX_TYPE_INTEGER_LITERAL:
+    if (cell->flags & AKX_CELL_FLAG_BIGNUM) {
+      encode_bytes(out, cell->value.bignum, akx_bignum_size(cell->value.bignum));
+    } else {
+      encode_bytes(out, &cell->value.integer_literal, sizeof(int64_t));
+    }
+    return 0;
+
+  case AKX_TYPE_REAL_LITERAL:
+    encode_bytes(out, &cell->value.real_literal, sizeof(double));
+    return 0;
+
+  case AKX_TYPE_STRING_LITERAL:
+    encode_buffer(out, cell->value.string_literal);
+    return 0;
+
+  case AKX_TYPE_QUOTED: {
+    encode_buffer(out, cell->value.quoted_literal);
+    akx_cell_t *expr = (cell->flags & AKX_CELL_FLAG_QUOTED_EXPR)
+                           ? *cell_quoted_expr(cell)
+                           : NULL;
+    uint8_t has_expr = expr ? 1 : 0;
+    encode_bytes(out, &has_expr, sizeof(has_expr));
+    return expr ? encode_cell(out, expr) : 0;
+  }
+
+  case AKX_TYPE_LIST:
+  case AKX_TYPE_LIST_SQUARE:
+  case AKX_TYPE_LIST_CURLY:
+  case AKX_TYPE_LIST_TEMPLE: {
+    uint32_t count = 0;
+    for (akx_cell_t *child = cell->value.list_head; child;
+         child = child->next) {
+      count++;
+    }
+    encode_u32(out, count);
+    for (akx_cell_t *child = cell->value.list_head; child;
+         child = child->next) {
+      if (encode_cell(out, child) != 0) {
+        return -1;
+      }
+    }
+    return 0;
+  }
+
+  default:
+    return -1;
+  }
+}
+
+int akx_cell_serialize(akx_parse_result_t *result, ak_buffer_t *out) {
+  if (!result || !out || result->errors) {
+    return -1;
+  }
+
+  encode_u32(out, (uint32_t)list_count(&result->cells));
+
+  list_iter_t iter = list_iter(&result->cells);
+  akx_cell_t **cell_ptr;
+  while ((cell_ptr = list_next(&result->cells, &iter))) {
+    if (encode_cell(out, *cell_ptr) != 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+typedef struct decode_reader_t {
+  const uint8_t *data;
+  size_t len;
+  size_t pos;
+  size_t source_len;
+} decode_reader_t;
+
+static int decode_bytes(decode_reader_t *reader, void *dst, size_t len) {
+  if (reader->len - reader->pos < len) {
+    return -1;
+  }
+
+  memcpy(dst, reader->data + reader->pos, len);
+  reader->pos += len;
+  return 0;
+}
+
+static ak_buffer_t *decode_buffer(decode_reader_t *reader,
+                                  akx_cell_arena_t *arena) {
+  uint32_t len;
+  if (decode_bytes(reader, &len, sizeof(len)) != 0 ||
+      reader->len - reader->pos < len) {
+    return NULL;
+  }
+
+  ak_buffer_t *buf = arena_buffer_new(arena, (size_t)len + 1);
+  if (!buf) {
+    return NULL;
+  }
+
+  ak_buffer_copy_to(buf, (uint8_t *)(reader->data + reader->pos), len);
+  reader->pos += len;
+  return buf;
+}
+
+static akx_cell_t *decode_cell(decode_reader_t *reader,
+                               akx_cell_arena_t *arena) {
+  uint8_t header[2];
+  akx_cell_span_t span;
+
+  if (decode_bytes(reader, header, sizeof(header)) != 0) {
+    return NULL;
+  }
+  if ((header[1] & AKX_CELL_ENCODE_SPAN) &&
+      (decode_bytes(reader, &span, sizeof(span)) != 0 ||
+       span.start > span.end || span.end > reader->source_len)) {
+    return NULL;
+  }
+  if (header[0] > AKX_TYPE_QUOTED) {
+    return NULL;
+  }
+
+  akx_cell_t *cell =
+      create_cell(arena, (akx_type_t)header[0], arena->source,
+                  (header[1] & AKX_CELL_ENCODE_SPAN) ? &span : NULL);
+  if (!cell) {
+    return NULL;
+  }
+
+  switch (cell->type) {
+  case AKX_TYPE_SYMBOL: {
+    uint32_t len;
+    if (decode_bytes(reader, &len, sizeof(len)) != 0 ||
+        reader->len - reader->pos < len) {
+      return NULL;
+    }
+    cell->value.symbol =
+        ak_intern_n((const char *)(reader->data + reader->pos), len);
+    reader->pos += len;
+    return cell->value.symbol ? cell : NULL;
+  }
+
+  case AKX_TYPE_INTEGER_LITERAL: {
+    if (!(header[1] & AKX_CELL_ENCODE_BIGNUM)) {
+      if (decode_bytes(reader, &cell->value.integer_literal,
+                       sizeof(int64_t)) != 0) {
         return NULL;
       }
-      cloned->value.continuation->lambda_cell =
-          akx_cell_clone(cell->value.continuation->lambda_cell);
-      cloned->value.continuation->args =
-          akx_cell_clone(cell->value.continuation->args);
+      return cell;
     }
-    break;
+
+    akx_bignum_t head;
+    if (decode_bytes(reader, &head, sizeof(head)) != 0 ||
+        (reader->len - reader->pos) / sizeof(uint32_t) < head.count) {
+      return NULL;
+    }
+    akx_bignum_t *num = arena_alloc(arena, akx_bignum_size(&head));
+    if (!num) {
+      return NULL;
+    }
+    *num = head;
+    if (decode_bytes(reader, num->limbs, sizeof(uint32_t) * head.count) != 0) {
+      return NULL;
+    }
+    cell->value.bignum = num;
+    cell->flags |= AKX_CELL_FLAG_BIGNUM;
+    return cell;
   }
 
-  cloned->next = akx_cell_clone(cell->next);
+  case AKX_TYPE_REAL_LITERAL:
+    if (decode_bytes(reader, &cell->value.real_literal, sizeof(double)) != 0) {
+      return NULL;
+    }
+    return cell;
 
-  return cloned;
+  case AKX_TYPE_STRING_LITERAL:
+    cell->value.string_literal = decode_buffer(reader, arena);
+    return cell->value.string_literal ? cell : NULL;
+
+  case AKX_TYPE_QUOTED: {
+    uint8_t has_expr;
+    cell->value.quoted_literal = decode_buffer(reader, arena);
+    if (!cell->value.quoted_literal ||
+        decode_bytes(reader, &has_expr, sizeof(has_expr)) != 0) {
+      return NULL;
+    }
+    if (has_expr) {
+      *cell_quoted_expr(cell) = decode_cell(reader, arena);
+      if (!*cell_quoted_expr(cell)) {
+        return NULL;
+      }
+    }
+    return cell;
+  }
+
+  default: {
+    uint32_t count;
+    if (decode_bytes(reader, &count, sizeof(count)) != 0) {
+      return NULL;
+    }
+
+    akx_cell_t *tail = NULL;
+    for (uint32_t i = 0; i < count; i++) {
+      akx_cell_t *child = decode_cell(reader, arena);
+      if (!child) {
+        return NULL;
+      }
+      if (!tail) {
+        cell->value.list_head = child;
+      } else {
+        tail->next = child;
+      }
+      tail = child;
+    }
+    return cell;
+  }
+  }
+}
+
+int akx_cell_deserialize(const uint8_t *data, size_t len, ak_buffer_t *source,
+                         const char *filename, akx_parse_result_t *result) {
+  if (!data || !source || !filename || !result) {
+    return -1;
+  }
+
+  list_init(&result->cells);
+  result->errors = NULL;
+  result->source_file = NULL;
+  result->arena = NULL;
+
+  akx_cell_arena_t *arena = arena_new();
+  if (!arena) {
+    return -1;
+  }
+
+  ak_source_file_t *source_file =
+      ak_source_file_new(filename, (const char *)ak_buffer_data(source),
+                         ak_buffer_count(source));
+  if (!source_file) {
+    arena_free(arena);
+    return -1;
+  }
+
+  arena->source = source_register(source_file);
+  if (!arena->source) {
+    ak_source_file_release(source_file);
+    arena_free(arena);
+    return -1;
+  }
+
+  result->source_file = source_file;
+  result->arena = arena;
+
+  decode_reader_t reader = {data, len, 0, ak_buffer_count(source)};
+  uint32_t count;
+  if (decode_bytes(&reader, &count, sizeof(count)) != 0) {
+    akx_parse_result_free(result);
+    return -1;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    akx_cell_t *cell = decode_cell(&reader, arena);
+    if (!cell) {
+      akx_parse_result_free(result);
+      return -1;
+    }
+    list_push(&result->cells, cell);
+  }
+
+  if (reader.pos != reader.len) {
+    akx_parse_result_free(result);
+    return -1;
+  }
+
+  return 0;
 }
@@ -1,6 +1,7 @@
 #ifndef AKX_CELL_H
 #define AKX_CELL_H
 
+#include "akx_cell_bignum.h"
 #include <ak24/buffer.h>
 #include <ak24/intern.h>
 #include <ak24/kernel.h>
@@ -11,6 +12,19 @@
 
 #define AKX_CELL_MAX_ERROR_MESSAGE_SIZE_MAX 256
 
+#define AKX_CELL_FLAG_ARENA (1u << 0)
+#define AKX_CELL_FLAG_SPAN (1u << 1)
+#define AKX_CELL_FLAG_QUOTED_EXPR (1u << 2)
+#define AKX_CELL_FLAG_BIGNUM (1u << 3)
+#define AKX_CELL_FLAG_IMMEDIATE (1u << 4)
+#define AKX_CELL_FLAG_TRACKED (1u << 5)
+#define AKX_CELL_FLAG_POOLED (1u << 6)
+#define AKX_CELL_FLAG_SITE (1u << 7)
+
+// Integers in this range have a shared immediate cell
+#define AKX_CELL_SMALL_INT_MIN (-256)
+#define AKX_CELL_SMALL_INT_MAX 1023
+
 typedef enum {
   AKX_TYPE_SYMBOL,
   AKX_TYPE_STRING_LITERAL,
@@ -38,19 +52,56 @@ typedef struct akx_parse_error_t {
   struct akx_parse_error_t *next;
 } akx_parse_error_t;
 
+typedef struct akx_cell_arena_t akx_cell_arena_t;
+
+// Scratch space parsed list and symbol cells carry for whoever evaluates
+// them; the cell package only zeroes it. A kind of 0 means nothing is cached.
+typedef struct {
+  uint32_t generation;
+  uint16_t kind;
+  uint16_t index;
+  void *target;
+} akx_cell_site_t;
+
+typedef struct akx_cell_stream_t akx_cell_stream_t;
+
+// Allocator for heap cells owned by a collector. Cells it hands out carry
+// AKX_CELL_FLAG_TRACKED: akx_cell_free() leaves them (and their children)
+// alone, and the collector reclaims them with akx_cell_destroy().
+typedef struct {
+  void *(*alloc)(void *user, size_t size);
+  void *user;
+} akx_cell_heap_t;
+
+// Allocator that heap cells and continuation frames come from when no
+// collector is installed. Cells it hands out carry AKX_CELL_FLAG_POOLED and
+// are returned to the freeing thread's pool with the size they were
+// allocated with.
+typedef struct {
+  void *(*alloc)(void *user, size_t size);
+  void (*free)(void *user, void *ptr, size_t size);
+  void *user;
+} akx_cell_pool_t;
+
 typedef struct {
   list_t(akx_cell_t *) cells;
   akx_parse_error_t *errors;
   ak_source_file_t *source_file;
+  akx_cell_arena_t *arena;
 } akx_parse_result_t;
 
 struct akx_cell_t {
-  akx_type_t type;
+  uint8_t type;
+  uint8_t flags;
+  // Owners beyond the first; see akx_cell_retain()
+  uint16_t refs;
+  uint32_t source;
   akx_cell_t *next;
 
   union {
     const char *symbol;
-    int integer_literal;
+    int64_t integer_literal;
+    akx_bignum_t *bignum;
     double real_literal;
     ak_buffer_t *string_literal;
     akx_cell_t *list_head;
@@ -58,8 +109,6 @@ struct akx_cell_t {
     ak_lambda_t *lambda;
     akx_continuation_t *continuation;
   } value;
-
-  ak_source_range_t *sourceloc;
 };
 
 akx_parse_result_t akx_cell_parse_file(const char *path);
@@ -67,12 +116,80 @@ akx_parse_result_t akx_cell_parse_file(const char *path);
 akx_parse_result_t akx_cell_parse_buffer(ak_buffer_t *buf,
                                          const char *filename);
 
+akx_cell_stream_t *akx_cell_stream_open(const char *path);
+
+int akx_cell_stream_next(akx_cell_stream_t *stream,
+                         akx_parse_result_t *result);
+
+void akx_cell_stream_close(akx_cell_stream_t *stream);
+
+// Arena cells belong to their parse result and must not be passed here;
+// one that is is logged as an error and skipped
 void akx_cell_free(akx_cell_t *cell);
 
 void akx_parse_result_free(akx_parse_result_t *result);
 
+// The quoted expression, shared rather than copied when the quote kept its
+// parsed tree: release it with akx_cell_free() and copy it before changing
+// it, as with akx_cell_retain()
 akx_cell_t *akx_cell_unwrap_quoted(akx_cell_t *quoted_cell);
 
 akx_cell_t *akx_cell_clone(akx_cell_t *cell);
 
+akx_cell_t *akx_cell_promote(akx_cell_t *cell);
+
+// Shared, read-only integer cell for small values, or NULL when out of range.
+// Immediates are never freed and must be copied before being linked or set.
+akx_cell_t *akx_cell_small_int(int64_t value);
+
+void akx_cell_init_immediate(akx_cell_t *cell, akx_type_t type);
+
+// Adds an owner to a standalone heap cell and returns it. Arena cells, cells
+// linked into a list and cells at the share limit are copied instead. Every
+// owner releases with akx_cell_free(); only the last one frees the cell.
+akx_cell_t *akx_cell_retain(akx_cell_t *cell);
+
+// True when other owners can see the cell, so it must be copied before it is
+// linked into a list or modified
+int akx_cell_is_shared(const akx_cell_t *cell);
+
+// Routes new heap cells to a collector, or back to AK24_ALLOC when NULL. The
+// heap must outlive every cell it tracked.
+void akx_cell_set_heap(const akx_cell_heap_t *heap);
+
+// Routes new heap cells made on the calling thread to a pool, or back to
+// AK24_ALLOC when NULL; every thread has its own. The pool must outlive every
+// cell it handed out, and a pooled cell freed where no pool is installed is
+// logged as an error and leaked.
+void akx_cell_set_pool(const akx_cell_pool_t *pool);
+
+akx_cell_t *akx_cell_new(akx_type_t type);
+
+// Gives a continuation cell its frame, from wherever the cell itself came from
+akx_continuation_t *akx_cell_alloc_continuation(akx_cell_t *cell);
+
+// Frees what one heap cell owns (strings, bignums, lambdas) and the cell
+// itself unless it is tracked, but never the cells it points at
+void akx_cell_destroy(akx_cell_t *cell);
+
+// Stores the cells a cell points at, apart from its next sibling, and
+// returns how many there are (at most two)
+size_t akx_cell_children(akx_cell_t *cell, akx_cell_t *out[2]);
+
+// Evaluator cache of a parsed list or symbol cell, NULL for every other cell
+akx_cell_site_t *akx_cell_site(akx_cell_t *cell);
+
+int akx_cell_has_location(akx_cell_t *cell);
+
+ak_source_file_t *akx_cell_source_file(akx_cell_t *cell);
+
+ak_source_loc_t akx_cell_location(akx_cell_t *cell);
+
+ak_source_range_t akx_cell_range(akx_cell_t *cell);
+
+int akx_cell_serialize(akx_parse_result_t *result, ak_buffer_t *out);
+
+int akx_cell_deserialize(const uint8_t *data, size_t len, ak_buffer_t *source,
+                         const char *filename, akx_parse_result_t *result);
+
 #endif
@@ -0,0 +1,542 @@
+#include "akx_cell_bignum.h"
+#include <ak24/kernel.h>
+#include <string.h>
+
+#define BIGNUM_DECIMAL_BASE 1000000000u
+#define BIGNUM_DECIMAL_DIGITS 9
+
+static akx_bignum_t *bignum_alloc(size_t count) {
+  akx_bignum_t *num =
+      AK24_ALLOC(sizeof(akx_bignum_t) + sizeof(uint32_t) * count);
+  if (!num) {
+    return NULL;
+  }
+  num->sign = 0;
+  num->count = (uint32_t)count;
+  if (count) {
+    memset(num->limbs, 0, sizeof(uint32_t) * count);
+  }
+  return num;
+}
+
+static size_t mag_trim(const uint32_t *limbs, size_t count) {
+  while (count > 0 && limbs[count - 1] == 0) {
+    count--;
+  }
+  return count;
+}
+
+// Drops leading zero limbs and fixes the sign of zero
+static akx_bignum_t *bignum_finish(akx_bignum_t *num, int32_t sign) {
+  if (!num) {
+    return NULL;
+  }
+  num->count = (uint32_t)mag_trim(num->limbs, num->count);
+  num->sign = num->count ? sign : 0;
+  return num;
+}
+
+static int mag_cmp(const uint32_t *a, size_t an, const uint32_t *b,
+                   size_t bn) {
+  if (an != bn) {
+    return an < bn ? -1 : 1;
+  }
+  while (an > 0) {
+    an--;
+    if (a[an] != b[an]) {
+      return a[an] < b[an] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+// out += a; out must be long enough to hold the carry
+static void mag_add_into(uint32_t *out, size_t out_len, const uint32_t *a,
+                         size_t an) {
+  uint64_t carry = 0;
+  size_t i = 0;
+  for (; i < an; i++) {
+    uint64_t sum = (uint64_t)out[i] + a[i] + carry;
+    out[i] = (uint32_t)sum;
+    carry = sum >> 32;
+  }
+  for (; carry && i < out_len; i++) {
+    uint64_t sum = (uint64_t)out[i] + carry;
+    out[i] = (uint32_t)sum;
+    carry = sum >> 32;
+  }
+}
+
+// out -= a; out must be at least a
+static void mag_sub_into(uint32_t *out, size_t out_len, const uint32_t *a,
+                         size_t an) {
+  uint64_t borrow = 0;
+  size_t i = 0;
+  for (; i < an; i++) {
+    uint64_t diff = (uint64_t)out[i] - a[i] - borrow;
+    out[i] = (uint32_t)diff;
+    borrow = (diff >> 63) & 1;
+  }
+  for (; borrow && i < out_len; i++) {
+    uint64_t diff = (uint64_t)out[i] - borrow;
+    out[i] = (uint32_t)diff;
+    borrow = (diff >> 63) & 1;
+  }
+}
+
+// out[an + bn] = a * b; out must be zeroed
+static void mag_mul_school(uint32_t *out, const uint32_t *a, size_t an,
+                           const uint32_t *b, size_t bn) {
+  for (size_t i = 0; i < an; i++) {
+    uint64_t carry = 0;
+    uint64_t ai = a[i];
+    if (ai == 0) {
+      continue;
+    }
+    for (size_t j = 0; j < bn; j++) {
+      uint64_t cur = ai * b[j] + out[i + j] + carry;
+      out[i + j] = (uint32_t)cur;
+      carry = cur >> 32;
+    }
+    out[i + bn] = (uint32_t)carry;
+  }
+}
+
+static int mag_mul(uint32_t *out, const uint32_t *a, size_t an,
+                   const uint32_t *b, size_t bn);
+
+// Karatsuba on a = a1 * B^h + a0, b = b1 * B^h + b0:
+// a * b = z2 * B^2h + (z1 - z2 - z0) * B^h + z0
+static int mag_mul_karatsuba(uint32_t *out, const uint32_t *a, size_t an,
+                             const uint32_t *b, size_t bn) {
+  size_t h = (an + 1) / 2;
+
+  // b is too short to split; multiply each half of a by all of b
+  if (bn <= h) {
+    size_t hi_len = an - h + bn;
+    uint32_t *hi = AK24_ALLOC(sizeof(uint32_t) * hi_len);
+    if (!hi) {
+      return -1;
+    }
+    memset(hi, 0, sizeof(uint32_t) * hi_len);
+    if (mag_mul(out, a, h, b, bn) != 0 || mag_mul(hi, a + h, an - h, b, bn)) {
+      AK24_FREE(hi);
+      return -1;
+    }
+    mag_add_into(out + h, an + bn - h, hi, mag_trim(hi, hi_len));
+    AK24_FREE(hi);
+    return 0;
+  }
+
+  size_t sum_len = h + 1;
+  size_t mid_len = 2 * sum_len;
+  uint32_t *scratch = AK24_ALLOC(sizeof(uint32_t) * (2 * sum_len + mid_len));
+  if (!scratch) {
+    return -1;
+  }
+  memset(scratch, 0, sizeof(uint32_t) * (2 * sum_len + mid_len));
+
+  uint32_t *sa = scratch;
+  uint32_t *sb = scratch + sum_len;
+  uint32_t *mid = scratch + 2 * sum_len;
+
+  memcpy(sa, a, sizeof(uint32_t) * h);
+  mag_add_into(sa, sum_len, a + h, an - h);
+  memcpy(sb, b, sizeof(uint32_t) * h);
+  mag_add_into(sb, sum_len, b + h, bn - h);
+
+  // z0 and z2 land directly in their final, non-overlapping places
+  uint32_t *z0 = out;
+  uint32_t *z2 = out + 2 * h;
+  size_t z2_len = an + bn - 2 * h;
+
+  if (mag_mul(z0, a, h, b, h) != 0 ||
+      mag_mul(z2, a + h, an - h, b + h, bn - h) != 0 ||
+      mag_mul(mid, sa, mag_trim(sa, sum_len), sb, mag_trim(sb, sum_len)) !=
+          0) {
+    AK24_FREE(scratch);
+    return -1;
+  }
+
+  mag_sub_into(mid, mid_len, z0, mag_trim(z0, 2 * h));
+  mag_sub_into(mid, mid_len, z2, mag_trim(z2, z2_len));
+  mag_add_into(out + h, an + bn - h, mid, mag_trim(mid, mid_len));
+
+  AK24_FREE(scratch);
+  return 0;
+}
+
+static int mag_mul(uint32_t *out, const uint32_t *a, size_t an,
+                   const uint32_t *b, size_t bn) {
+  an = mag_trim(a, an);
+  bn = mag_trim(b, bn);
+  if (an < bn) {
+    const uint32_t *t = a;
+    a = b;
+    b = t;
+    size_t tn = an;
+    an = bn;
+    bn = tn;
+  }
+  if (bn == 0) {
+    return 0;
+  }
+  if (bn < AKX_BIGNUM_KARATSUBA_THRESHOLD) {
+    mag_mul_school(out, a, an, b, bn);
+    return 0;
+  }
+  return mag_mul_karatsuba(out, a, an, b, bn);
+}
+
+// Divides a in place by a single limb and returns the remainder
+static uint32_t mag_div_small(uint32_t *a, size_t an, uint32_t divisor) {
+  uint64_t rem = 0;
+  while (an > 0) {
+    an--;
+    uint64_t cur = (rem << 32) | a[an];
+    a[an] = (uint32_t)(cur / divisor);
+    rem = cur % divisor;
+  }
+  return (uint32_t)rem;
+}
+
+static unsigned leading_zeros(uint32_t x) {
+  unsigned n = 0;
+  while (!(x & 0x80000000u)) {
+    x <<= 1;
+    n++;
+  }
+  return n;
+}
+
+// Knuth, TAOCP vol. 2, 4.3.1 algorithm D. q has an - bn + 1 limbs, r has bn.
+static int mag_divmod(const uint32_t *a, size_t an, const uint32_t *b,
+                      size_t bn, uint32_t *q, uint32_t *r) {
+  unsigned shift = leading_zeros(b[bn - 1]);
+
+  uint32_t *work = AK24_ALLOC(sizeof(uint32_t) * (an + 1 + bn));
+  if (!work) {
+    return -1;
+  }
+  uint32_t *u = work;
+  uint32_t *v = work + an + 1;
+
+  // Normalize so the top divisor limb has its high bit set
+  for (size_t i = bn - 1; i > 0; i--) {
+    v[i] = shift ? (b[i] << shift) | (b[i - 1] >> (32 - shift)) : b[i];
+  }
+  v[0] = b[0] << shift;
+  u[an] = shift ? a[an - 1] >> (32 - shift) : 0;
+  for (size_t i = an - 1; i > 0; i--) {
+    u[i] = shift ? (a[i] << shift) | (a[i - 1] >> (32 - shift)) : a[i];
+  }
+  u[0] = a[0] << shift;
+
+  uint64_t base = (uint64_t)1 << 32;
+  for (size_t j = an - bn + 1; j-- > 0;) {
+    uint64_t top = ((uint64_t)u[j + bn] << 32) | u[j + bn - 1];
+    uint64_t qhat = top / v[bn - 1];
+    uint64_t rhat = top % v[bn - 1];
+
+    while (qhat >= base ||
+           (bn > 1 && qhat * v[bn - 2] > ((rhat << 32) | u[j + bn - 2]))) {
+      qhat--;
+      rhat += v[bn - 1];
+      if (rhat >= base) {
+        break;
+      }
+    }
+
+    // u[j .. j + bn] -= qhat * v
+    int64_t borrow = 0;
+    uint64_t carry = 0;
+    for (size_t i = 0; i < bn; i++) {
+      uint64_t prod = qhat * v[i] + carry;
+      carry = prod >> 32;
+      int64_t diff = (int64_t)u[i + j] - (int64_t)(uint32_t)prod - borrow;
+      u[i + j] = (uint32_t)diff;
+      borrow = diff < 0 ? 1 : 0;
+    }
+    int64_t diff = (int64_t)u[j + bn] - (int64_t)carry - borrow;
+    u[j + bn] = (uint32_t)diff;
+
+    // qhat was one too large; add v back
+    if (diff < 0) {
+      qhat--;
+      uint64_t c = 0;
+      for (size_t i = 0; i < bn; i++) {
+        uint64_t sum = (uint64_t)u[i + j] + v[i] + c;
+        u[i + j] = (uint32_t)sum;
+        c = sum >> 32;
+      }
+      u[j + bn] += (uint32_t)c;
+    }
+
+    q[j] = (uint32_t)qhat;
+  }
+
+  for (size_t i = 0; i < bn; i++) {
+    r[i] = shift ? (u[i] >> shift) | (u[i + 1] << (32 - shift)) : u[i];
+  }
+
+  AK24_FREE(work);
+  return 0;
+}
+
+akx_bignum_t *akx_bignum_from_i64(int64_t value) {
+  akx_bignum_t *num = bignum_alloc(2);
+  if (!num) {
+    return NULL;
+  }
+  uint64_t mag = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+  num->limbs[0] = (uint32_t)mag;
+  num->limbs[1] = (uint32_t)(mag >> 32);
+  return bignum_finish(num, value < 0 ? -1 : 1);
+}
+
+akx_bignum_t *akx_bignum_from_string(const char *str, size_t len) {
+  int32_t sign = 1;
+  size_t pos = 0;
+  if (pos < len && (str[pos] == '-' || str[pos] == '+')) {
+    sign = str[pos] == '-' ? -1 : 1;
+    pos++;
+  }
+  if (pos >= len) {
+    return NULL;
+  }
+
+  // Every 9 decimal digits need a little under one 32-bit limb
+  akx_bignum_t *num = bignum_alloc((len - pos) / 9 + 2);
+  if (!num) {
+    return NULL;
+  }
+
+  size_t used = 0;
+  while (pos < len) {
+    uint32_t chunk = 0;
+    uint32_t scale = 1;
+    for (int i = 0; i < BIGNUM_DECIMAL_DIGITS && pos < len; i++, pos++) {
+      if (str[pos] < '0' || str[pos] > '9') {
+        akx_bignum_free(num);
+        return NULL;
+      }
+      chunk = chunk * 10 + (uint32_t)(str[pos] - '0');
+      scale *= 10;
+    }
+
+    uint64_t carry = chunk;
+    for (size_t i = 0; i < used; i++) {
+      uint64_t cur = (uint64_t)num->limbs[i] * scale + carry;
+      num->limbs[i] = (uint32_t)cur;
+      carry = cur >> 32;
+    }
+    if (carry) {
+      num->limbs[used++] = (uint32_t)carry;
+    }
+  }
+
+  return bignum_finish(num, sign);
+}
+
+akx_bignum_t *akx_bignum_clone(const akx_bignum_t *num) {
+  if (!num) {
+    return NULL;
+  }
+  akx_bignum_t *copy = AK24_ALLOC(akx_bignum_size(num));
+  if (copy) {
+    memcpy(copy, num, akx_bignum_size(num));
+  }
+  return copy;
+}
+
+size_t akx_bignum_size(const akx_bignum_t *num) {
+  return sizeof(akx_bignum_t) + sizeof(uint32_t) * num->count;
+}
+
+void akx_bignum_free(akx_bignum_t *num) {
+  if (num) {
+    AK24_FREE(num);
+  }
+}
+
+int akx_bignum_to_i64(const akx_bignum_t *num, int64_t *out) {
+  if (num->count > 2) {
+    return 0;
+  }
+  uint64_t mag = 0;
+  for (size_t i = num->count; i > 0; i--) {
+    mag = (mag << 32) | num->limbs[i - 1];
+  }
+  if (num->sign >= 0) {
+    if (mag > (uint64_t)INT64_MAX) {
+      return 0;
+    }
+    *out = (int64_t)mag;
+  } else {
+    if (mag > (uint64_t)INT64_MAX + 1) {
+      return 0;
+    }
+    *out = mag == (uint64_t)INT64_MAX + 1 ? INT64_MIN : -(int64_t)mag;
+  }
+  return 1;
+}
+
+int akx_bignum_cmp(const akx_bignum_t *a, const akx_bignum_t *b) {
+  if (a->sign != b->sign) {
+    return a->sign < b->sign ? -1 : 1;
+  }
+  int mag = mag_cmp(a->limbs, a->count, b->limbs, b->count);
+  return a->sign < 0 ? -mag : mag;
+}
+
+// |a| + |b| or |a| - |b| with the given sign on the larger magnitude
+static akx_bignum_t *bignum_add_signed(const akx_bignum_t *a, int32_t a_sign,
+                                       const akx_bignum_t *b, int32_t b_sign) {
+  if (a_sign == b_sign || b_sign == 0 || a_sign == 0) {
+    if (a_sign == 0) {
+      a = b;
+      a_sign = b_sign;
+      b_sign = 0;
+    }
+    size_t len = (a->count > b->count ? a->count : b->count) + 1;
+    akx_bignum_t *out = bignum_alloc(len);
+    if (!out) {
+      return NULL;
+    }
+    memcpy(out->limbs, a->limbs, sizeof(uint32_t) * a->count);
+    if (b_sign != 0) {
+      mag_add_into(out->limbs, len, b->limbs, b->count);
+    }
+    return bignum_finish(out, a_sign);
+  }
+
+  const akx_bignum_t *big = a;
+  const akx_bignum_t *small = b;
+  int32_t sign = a_sign;
+  if (mag_cmp(a->limbs, a->count, b->limbs, b->count) < 0) {
+    big = b;
+    small = a;
+    sign = b_sign;
+  }
+
+  akx_bignum_t *out = bignum_alloc(big->count);
+  if (!out) {
+    return NULL;
+  }
+  memcpy(out->limbs, big->limbs, sizeof(uint32_t) * big->count);
+  mag_sub_into(out->limbs, big->count, small->limbs, small->count);
+  return bignum_finish(out, sign);
+}
+
+akx_bignum_t *akx_bignum_add(const akx_bignum_t *a, const akx_bignum_t *b) {
+  return bignum_add_signed(a, a->sign, b, b->sign);
+}
+
+akx_bignum_t *akx_bignum_sub(const akx_bignum_t *a, const akx_bignum_t *b) {
+  return bignum_add_signed(a, a->sign, b, -b->sign);
+}
+
+akx_bignum_t *akx_bignum_mul(const akx_bignum_t *a, const akx_bignum_t *b) {
+  akx_bignum_t *out = bignum_alloc((size_t)a->count + b->count);
+  if (!out) {
+    return NULL;
+  }
+  if (mag_mul(out->limbs, a->limbs, a->count, b->limbs, b->count) != 0) {
+    akx_bignum_free(out);
+    return NULL;
+  }
+  return bignum_finish(out, a->sign * b->sign);
+}
+
+int akx_bignum_divmod(const akx_bignum_t *a, const akx_bignum_t *b,
+                      akx_bignum_t **quotient, akx_bignum_t **remainder) {
+  if (b->count == 0) {
+    return -1;
+  }
+
+  size_t q_len = a->count >= b->count ? a->count - b->count + 1 : 1;
+  akx_bignum_t *q = bignum_alloc(q_len);
+  akx_bignum_t *r = bignum_alloc(b->count);
+  if (!q || !r) {
+    akx_bignum_free(q);
+    akx_bignum_free(r);
+    return -1;
+  }
+
+  if (mag_cmp(a->limbs, a->count, b->limbs, b->count) < 0) {
+    memcpy(r->limbs, a->limbs, sizeof(uint32_t) * a->count);
+  } else if (b->count == 1) {
+    memcpy(q->limbs, a->limbs, sizeof(uint32_t) * a->count);
+    r->limbs[0] = mag_div_small(q->limbs, a->count, b->limbs[0]);
+  } else if (mag_divmod(a->limbs, a->count, b->limbs, b->count, q->limbs,
+                        r->limbs) != 0) {
+    akx_bignum_free(q);
+    akx_bignum_free(r);
+    return -1;
+  }
+
+  // Truncating division, like C: the remainder takes the dividend's sign
+  bignum_finish(q, a->sign * b->sign);
+  bignum_finish(r, a->sign);
+
+  if (quotient) {
+    *quotient = q;
+  } else {
+    akx_bignum_free(q);
+  }
+  if (remainder) {
+    *remainder = r;
+  } else {
+    akx_bignum_free(r);
+  }
+  return 0;
+}
+
+ak_buffer_t *akx_bignum_to_buffer(const akx_bignum_t *num) {
+  // Each limb is at most ~9.63 decimal digits
+  size_t max_digits = (size_t)num->count * 10 + 2;
+  ak_buffer_t *buf = ak_buffer_new(max_digits + 1);
+  if (!buf) {
+    return NULL;
+  }
+
+  if (num->count == 0) {
+    ak_buffer_copy_to(buf, (uint8_t *)"0", 2);
+    buf->count = 1;
+    return buf;
+  }
+
+  uint32_t *work = AK24_ALLOC(sizeof(uint32_t) * num->count);
+  char *digits = AK24_ALLOC(max_digits);
+  if (!work || !digits) {
+    AK24_FREE(work);
+    AK24_FREE(digits);
+    ak_buffer_free(buf);
+    return NULL;
+  }
+  memcpy(work, num->limbs, sizeof(uint32_t) * num->count);
+
+  // Peel off nine digits at a time, least significant first
+  size_t len = num->count;
+  size_t pos = max_digits;
+  while (len > 0) {
+    uint32_t chunk = mag_div_small(work, len, BIGNUM_DECIMAL_BASE);
+    len = mag_trim(work, len);
+    for (int i = 0; i < BIGNUM_DECIMAL_DIGITS && (len > 0 || chunk > 0);
+         i++) {
+      digits[--pos] = (char)('0' + chunk % 10);
+      chunk /= 10;
+    }
+  }
+  if (num->sign < 0) {
+    digits[--pos] = '-';
+  }
+
+  ak_buffer_copy_to(buf, (uint8_t *)(digits + pos), max_digits - pos);
+  ak_buffer_copy_to(buf, (uint8_t *)"", 1);
+  buf->count = max_digits - pos;
+
+  AK24_FREE(work);
+  AK24_FREE(digits);
+  return buf;
+}
@@ -0,0 +1,45 @@
+#ifndef AKX_CELL_BIGNUM_H
+#define AKX_CELL_BIGNUM_H
+
+#include <ak24/buffer.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Operands of at least this many 32-bit limbs are multiplied with Karatsuba
+#define AKX_BIGNUM_KARATSUBA_THRESHOLD 32
+
+// Arbitrary-precision integer: sign and magnitude in little-endian 32-bit
+// limbs. Values are immutable once built and are never zero-length; zero is
+// { sign 0, count 0 }.
+typedef struct akx_bignum_t {
+  int32_t sign;
+  uint32_t count;
+  uint32_t limbs[];
+} akx_bignum_t;
+
+akx_bignum_t *akx_bignum_from_i64(int64_t value);
+
+akx_bignum_t *akx_bignum_from_string(const char *str, size_t len);
+
+akx_bignum_t *akx_bignum_clone(const akx_bignum_t *num);
+
+size_t akx_bignum_size(const akx_bignum_t *num);
+
+void akx_bignum_free(akx_bignum_t *num);
+
+int akx_bignum_to_i64(const akx_bignum_t *num, int64_t *out);
+
+int akx_bignum_cmp(const akx_bignum_t *a, const akx_bignum_t *b);
+
+akx_bignum_t *akx_bignum_add(const akx_bignum_t *a, const akx_bignum_t *b);
+
+akx_bignum_t *akx_bignum_sub(const akx_bignum_t *a, const akx_bignum_t *b);
+
+akx_bignum_t *akx_bignum_mul(const akx_bignum_t *a, const akx_bignum_t *b);
+
+int akx_bignum_divmod(const akx_bignum_t *a, const akx_bignum_t *b,
+                      akx_bignum_t **quotient, akx_bignum_t **remainder);
+
+ak_buffer_t *akx_bignum_to_buffer(const akx_bignum_t *num);
+
+#endif
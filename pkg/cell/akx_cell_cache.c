@@ -0,0 +1,454 @@
+#include "akx_cell_cache.h"
+#include <ak24/filepath.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef AK24_PLATFORM_WINDOWS
+#include <direct.h>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define AKX_CELL_CACHE_MAGIC 0x43584B41u
+
+typedef struct cache_header_t {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t content_hash;
+  uint64_t source_size;
+  uint32_t path_len;
+  uint32_t reserved;
+} cache_header_t;
+
+typedef struct cache_mapping_t {
+  const uint8_t *data;
+  size_t len;
+  ak_buffer_t *buf;
+} cache_mapping_t;
+
+typedef void (*cache_entry_fn)(const char *entry_path, void *ctx);
+
+static uint64_t hash_bytes(const uint8_t *data, size_t len) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < len; i++) {
+    hash ^= data[i];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+static int cache_enabled(void) {
+  const char *flag = getenv("AKX_NO_CACHE");
+  return !flag || !flag[0] || strcmp(flag, "0") == 0;
+}
+
+static ak_buffer_t *cache_entry_path(ak_buffer_t *dir, const char *path) {
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx%s",
+           (unsigned long long)hash_bytes((const uint8_t *)path, strlen(path)),
+           AKX_CELL_CACHE_EXTENSION);
+  return ak_filepath_join(2, (const char *)ak_buffer_data(dir), name);
+}
+
+static void make_dir(const char *path) {
+#ifdef AK24_PLATFORM_WINDOWS
+  _mkdir(path);
+#else
+  mkdir(path, 0755);
+#endif
+}
+
+static int ensure_dir(ak_buffer_t *dir) {
+  char path[1024];
+  const char *dir_path = (const char *)ak_buffer_data(dir);
+  size_t len = strlen(dir_path);
+  if (len == 0 || len >= sizeof(path)) {
+    return -1;
+  }
+  memcpy(path, dir_path, len + 1);
+
+  for (size_t i = 1; i < len; i++) {
+    if (path[i] == '/' || path[i] == '\\') {
+      char sep = path[i];
+      path[i] = '\0';
+      make_dir(path);
+      path[i] = sep;
+    }
+  }
+  make_dir(path);
+
+#ifdef AK24_PLATFORM_WINDOWS
+  DWORD attrs = GetFileAttributesA(path);
+  return (attrs != INVALID_FILE_ATTRIBUTES &&
+          (attrs & FILE_ATTRIBUTE_DIRECTORY))
+             ? 0
+             : -1;
+#else
+  struct stat st;
+  return (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) ? 0 : -1;
+#endif
+}
+
+static int cache_map(const char *entry_path, cache_mapping_t *mapping) {
+  mapping->data = NULL;
+  mapping->len = 0;
+  mapping->buf = NULL;
+
+#ifdef AK24_PLATFORM_WINDOWS
+  mapping->buf = ak_buffer_from_file(entry_path);
+  if (!mapping->buf) {
+    return -1;
+  }
+  mapping->data = ak_buffer_data(mapping->buf);
+  mapping->len = ak_buffer_count(mapping->buf);
+  return 0;
+#else
+  int fd = open(entry_path, O_RDONLY);
+  if (fd < 0) {
+    return -1;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return -1;
+  }
+
+  void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return -1;
+  }
+
+  mapping->data = data;
+  mapping->len = (size_t)st.st_size;
+  return 0;
+#endif
+}
+
+static void cache_unmap(cache_mapping_t *mapping) {
+  if (mapping->buf) {
+    ak_buffer_free(mapping->buf);
+  }
+#ifndef AK24_PLATFORM_WINDOWS
+  else if (mapping->data) {
+    munmap((void *)mapping->data, mapping->len);
+  }
+#endif
+  mapping->data = NULL;
+  mapping->len = 0;
+  mapping->buf = NULL;
+}
+
+// The same file reached through different relative paths or links shares
+// one entry; a path that cannot be resolved is used as given
+static char *cache_key(const char *path) {
+#ifdef AK24_PLATFORM_WINDOWS
+  char *key = _fullpath(NULL, path, 0);
+#else
+  char *key = realpath(path, NULL);
+#endif
+  return key ? key : strdup(path);
+}
+
+// Opens a file only this process writes, named <entry_path>.XXXXXX, and
+// leaves its name in tmp_path
+static FILE *cache_temp(ak_buffer_t *entry_path, ak_buffer_t *tmp_path) {
+  ak_buffer_copy_to(tmp_path, ak_buffer_data(entry_path),
+                    ak_buffer_count(entry_path));
+  ak_buffer_copy_to(tmp_path, (uint8_t *)".XXXXXX", 7);
+  char *tmp = (char *)ak_buffer_data(tmp_path);
+
+#ifdef AK24_PLATFORM_WINDOWS
+  if (_mktemp_s(tmp, strlen(tmp) + 1) != 0) {
+    return NULL;
+  }
+  int fd = _open(tmp, _O_CREAT | _O_EXCL | _O_WRONLY | _O_BINARY,
+                 _S_IREAD | _S_IWRITE);
+  FILE *f = fd >= 0 ? _fdopen(fd, "wb") : NULL;
+  if (fd >= 0 && !f) {
+    _close(fd);
+    remove(tmp);
+  }
+#else
+  int fd = mkstemp(tmp);
+  if (fd >= 0) {
+    // mkstemp makes the file private; entries are as readable as before
+    fchmod(fd, 0644);
+  }
+  FILE *f = fd >= 0 ? fdopen(fd, "wb") : NULL;
+  if (fd >= 0 && !f) {
+    close(fd);
+    remove(tmp);
+  }
+#endif
+  return f;
+}
+
+static int cache_load(const char *entry_path, const char *key,
+                      const char *path, ak_buffer_t *source, uint64_t hash,
+                      akx_parse_result_t *result) {
+  cache_mapping_t mapping;
+  if (cache_map(entry_path, &mapping) != 0) {
+    return -1;
+  }
+
+  int rc = -1;
+  size_t path_len = strlen(key);
+  cache_header_t header;
+
+  if (mapping.len >= sizeof(header)) {
+    memcpy(&header, mapping.data, sizeof(header));
+
+    size_t body = sizeof(header) + path_len;
+    if (header.magic == AKX_CELL_CACHE_MAGIC &&
+        header.version == AKX_CELL_CACHE_VERSION &&
+        header.content_hash == hash &&
+        header.source_size == ak_buffer_count(source) &&
+        header.path_len == path_len && mapping.len >= body &&
+        memcmp(mapping.data + sizeof(header), key, path_len) == 0) {
+      rc = akx_cell_deserialize(mapping.data + body, mapping.len - body,
+                                source, path, result);
+    }
+  }
+
+  cache_unmap(&mapping);
+  return rc;
+}
+
+static void cache_store(ak_buffer_t *dir, ak_buffer_t *entry_path,
+                        const char *key, ak_buffer_t *source, uint64_t hash,
+                        akx_parse_result_t *result) {
+  ak_buffer_t *body = ak_buffer_new(ak_buffer_count(source) + 64);
+  if (!body) {
+    return;
+  }
+
+  if (akx_cell_serialize(result, body) != 0 || ensure_dir(dir) != 0) {
+    ak_buffer_free(body);
+    return;
+  }
+
+  ak_buffer_t *tmp_path = ak_buffer_new(ak_buffer_count(entry_path) + 8);
+  if (!tmp_path) {
+    ak_buffer_free(body);
+    return;
+  }
+
+  cache_header_t header;
+  memset(&header, 0, sizeof(header));
+  header.magic = AKX_CELL_CACHE_MAGIC;
+  header.version = AKX_CELL_CACHE_VERSION;
+  header.content_hash = hash;
+  header.source_size = ak_buffer_count(source);
+  header.path_len = (uint32_t)strlen(key);
+
+  FILE *f = cache_temp(entry_path, tmp_path);
+  const char *tmp = (const char *)ak_buffer_data(tmp_path);
+  const char *dst = (const char *)ak_buffer_data(entry_path);
+  if (f) {
+    size_t written = fwrite(&header, 1, sizeof(header), f);
+    written += fwrite(key, 1, header.path_len, f);
+    written += fwrite(ak_buffer_data(body), 1, ak_buffer_count(body), f);
+    int closed = fclose(f);
+
+    if (closed == 0 && written == sizeof(header) + header.path_len +
+                                       ak_buffer_count(body)) {
+#ifdef AK24_PLATFORM_WINDOWS
+      remove(dst);
+#endif
+      if (rename(tmp, dst) != 0) {
+        remove(tmp);
+      }
+    } else {
+      remove(tmp);
+    }
+  }
+
+  ak_buffer_free(tmp_path);
+  ak_buffer_free(body);
+}
+
+ak_buffer_t *akx_cell_cache_dir(void) {
+  const char *akx_home = getenv("AKX_HOME");
+  if (akx_home) {
+    return ak_filepath_join(2, akx_home, "cache");
+  }
+
+  const char *home = getenv("HOME");
+  if (!home) {
+    return NULL;
+  }
+
+  return ak_filepath_join(3, home, ".akx", "cache");
+}
+
+akx_parse_result_t akx_cell_cache_parse_file(const char *path) {
+  if (!path || !cache_enabled()) {
+    return akx_cell_parse_file(path);
+  }
+
+  ak_buffer_t *source = ak_buffer_from_file(path);
+  if (!source) {
+    return akx_cell_parse_file(path);
+  }
+
+  uint64_t hash = hash_bytes(ak_buffer_data(source), ak_buffer_count(source));
+  char *key = cache_key(path);
+  ak_buffer_t *dir = key ? akx_cell_cache_dir() : NULL;
+  ak_buffer_t *entry_path = dir ? cache_entry_path(dir, key) : NULL;
+
+  akx_parse_result_t result;
+  if (entry_path && cache_load((const char *)ak_buffer_data(entry_path), key,
+                               path, source, hash, &result) == 0) {
+    AK24_LOG_TRACE("AST cache hit: %s", path);
+  } else {
+    result = akx_cell_parse_buffer(source, path);
+    if (entry_path && !result.errors) {
+      cache_store(dir, entry_path, key, source, hash, &result);
+    }
+  }
+
+  free(key);
+  if (entry_path) {
+    ak_buffer_free(entry_path);
+  }
+  if (dir) {
+    ak_buffer_free(dir);
+  }
+  ak_buffer_free(source);
+
+  return result;
+}
+
+#ifdef AK24_PLATFORM_WINDOWS
+
+static int cache_for_each(ak_buffer_t *dir, cache_entry_fn fn, void *ctx) {
+  char search_path[MAX_PATH];
+  snprintf(search_path, MAX_PATH, "%s\\*%s", (const char *)ak_buffer_data(dir),
+           AKX_CELL_CACHE_EXTENSION);
+
+  WIN32_FIND_DATAA find_data;
+  HANDLE hFind = FindFirstFileA(search_path, &find_data);
+  if (hFind == INVALID_HANDLE_VALUE) {
+    return 0;
+  }
+
+  do {
+    if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+      char entry_path[MAX_PATH];
+      snprintf(entry_path, MAX_PATH, "%s\\%s",
+               (const char *)ak_buffer_data(dir), find_data.cFileName);
+      fn(entry_path, ctx);
+    }
+  } while (FindNextFileA(hFind, &find_data));
+
+  FindClose(hFind);
+  return 0;
+}
+
+#else
+
+static int ends_with(const char *str, const char *suffix) {
+  size_t str_len = strlen(str);
+  size_t suffix_len = strlen(suffix);
+  if (suffix_len > str_len) {
+    return 0;
+  }
+  return strcmp(str + str_len - suffix_len, suffix) == 0;
+}
+
+static int cache_for_each(ak_buffer_t *dir, cache_entry_fn fn, void *ctx) {
+  DIR *d = opendir((const char *)ak_buffer_data(dir));
+  if (!d) {
+    return 0;
+  }
+
+  struct dirent *entry;
+  while ((entry = readdir(d)) != NULL) {
+    if (!ends_with(entry->d_name, AKX_CELL_CACHE_EXTENSION)) {
+      continue;
+    }
+
+    char entry_path[1024];
+    snprintf(entry_path, sizeof(entry_path), "%s/%s",
+             (const char *)ak_buffer_data(dir), entry->d_name);
+    fn(entry_path, ctx);
+  }
+
+  closedir(d);
+  return 0;
+}
+
+#endif
+
+static void collect_stats(const char *entry_path, void *ctx) {
+  akx_cell_cache_stats_t *stats = ctx;
+
+  FILE *f = fopen(entry_path, "rb");
+  if (!f) {
+    return;
+  }
+
+  cache_header_t header;
+  int valid = fread(&header, 1, sizeof(header), f) == sizeof(header) &&
+              header.magic == AKX_CELL_CACHE_MAGIC &&
+              header.version == AKX_CELL_CACHE_VERSION;
+
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fclose(f);
+
+  stats->entries++;
+  if (!valid) {
+    stats->stale_entries++;
+  }
+  if (size > 0) {
+    stats->total_bytes += (size_t)size;
+  }
+}
+
+static void remove_entry(const char *entry_path, void *ctx) {
+  int *removed = ctx;
+  if (remove(entry_path) == 0) {
+    (*removed)++;
+  }
+}
+
+int akx_cell_cache_stats(akx_cell_cache_stats_t *stats) {
+  if (!stats) {
+    return -1;
+  }
+
+  memset(stats, 0, sizeof(*stats));
+
+  ak_buffer_t *dir = akx_cell_cache_dir();
+  if (!dir) {
+    return -1;
+  }
+
+  int rc = cache_for_each(dir, collect_stats, stats);
+  ak_buffer_free(dir);
+  return rc;
+}
+
+int akx_cell_cache_clear(void) {
+  ak_buffer_t *dir = akx_cell_cache_dir();
+  if (!dir) {
+    return -1;
+  }
+
+  int removed = 0;
+  cache_for_each(dir, remove_entry, &removed);
+  ak_buffer_free(dir);
+  return removed;
+}
@@ -0,0 +1,23 @@
+#ifndef AKX_CELL_CACHE_H
+#define AKX_CELL_CACHE_H
+
+#include "akx_cell.h"
+
+#define AKX_CELL_CACHE_VERSION 3
+#define AKX_CELL_CACHE_EXTENSION ".akxc"
+
+typedef struct {
+  size_t entries;
+  size_t stale_entries;
+  size_t total_bytes;
+} akx_cell_cache_stats_t;
+
+ak_buffer_t *akx_cell_cache_dir(void);
+
+akx_parse_result_t akx_cell_cache_parse_file(const char *path);
+
+int akx_cell_cache_stats(akx_cell_cache_stats_t *stats);
+
+int akx_cell_cache_clear(void);
+
+#endif
@@ -0,0 +1,256 @@
+#include "akx_cell_lex.h"
+
+#if defined(AKX_CELL_LEX_NO_SIMD)
+#elif defined(__AVX2__)
+#define AKX_CELL_LEX_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AKX_CELL_LEX_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#define S AKX_CELL_LEX_SPACE
+#define N (AKX_CELL_LEX_SPACE | AKX_CELL_LEX_NEWLINE)
+#define D AKX_CELL_LEX_DELIM
+#define SD (S | D)
+#define ND (N | D)
+
+const uint8_t akx_cell_lex_class[256] = {
+    ['\t'] = SD, ['\n'] = ND, ['\v'] = SD, ['\f'] = SD, ['\r'] = ND,
+    [' '] = SD,  [';'] = D,   ['"'] = D,  ['('] = D,  [')'] = D,
+    ['['] = D,   [']'] = D,   ['{'] = D,  ['}'] = D,
+};
+
+#undef S
+#undef N
+#undef D
+#undef SD
+#undef ND
+
+#if defined(AKX_CELL_LEX_AVX2) || defined(AKX_CELL_LEX_SSE2)
+
+static unsigned first_bit(uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (unsigned)index;
+#else
+  return (unsigned)__builtin_ctz(mask);
+#endif
+}
+
+#endif
+
+#if defined(AKX_CELL_LEX_AVX2)
+
+#define LEX_BLOCK 32
+
+typedef __m256i lex_vec_t;
+
+static lex_vec_t lex_load(const uint8_t *p) {
+  return _mm256_loadu_si256((const __m256i *)p);
+}
+
+static lex_vec_t lex_eq(lex_vec_t v, uint8_t c) {
+  return _mm256_cmpeq_epi8(v, _mm256_set1_epi8((char)c));
+}
+
+static lex_vec_t lex_or(lex_vec_t a, lex_vec_t b) {
+  return _mm256_or_si256(a, b);
+}
+
+// Bytes 9..13 (\t \n \v \f \r) are the ones left at zero after x - 9 - 4
+static lex_vec_t lex_control_space(lex_vec_t v) {
+  lex_vec_t shifted = _mm256_sub_epi8(v, _mm256_set1_epi8(9));
+  return _mm256_cmpeq_epi8(_mm256_subs_epu8(shifted, _mm256_set1_epi8(4)),
+                           _mm256_setzero_si256());
+}
+
+static uint32_t lex_mask(lex_vec_t v) {
+  return (uint32_t)_mm256_movemask_epi8(v);
+}
+
+#elif defined(AKX_CELL_LEX_SSE2)
+
+#define LEX_BLOCK 16
+
+typedef __m128i lex_vec_t;
+
+static lex_vec_t lex_load(const uint8_t *p) {
+  return _mm_loadu_si128((const __m128i *)p);
+}
+
+static lex_vec_t lex_eq(lex_vec_t v, uint8_t c) {
+  return _mm_cmpeq_epi8(v, _mm_set1_epi8((char)c));
+}
+
+static lex_vec_t lex_or(lex_vec_t a, lex_vec_t b) { return _mm_or_si128(a, b); }
+
+// Bytes 9..13 (\t \n \v \f \r) are the ones left at zero after x - 9 - 4
+static lex_vec_t lex_control_space(lex_vec_t v) {
+  lex_vec_t shifted = _mm_sub_epi8(v, _mm_set1_epi8(9));
+  return _mm_cmpeq_epi8(_mm_subs_epu8(shifted, _mm_set1_epi8(4)),
+                        _mm_setzero_si128());
+}
+
+static uint32_t lex_mask(lex_vec_t v) {
+  return (uint32_t)_mm_movemask_epi8(v);
+}
+
+#endif
+
+#ifdef LEX_BLOCK
+
+static lex_vec_t lex_space(lex_vec_t v) {
+  return lex_or(lex_eq(v, ' '), lex_control_space(v));
+}
+
+static lex_vec_t lex_newline(lex_vec_t v) {
+  return lex_or(lex_eq(v, '\n'), lex_eq(v, '\r'));
+}
+
+static lex_vec_t lex_delim(lex_vec_t v, uint8_t close_delim) {
+  lex_vec_t brackets = lex_or(lex_or(lex_eq(v, '('), lex_eq(v, ')')),
+                              lex_or(lex_eq(v, '['), lex_eq(v, ']')));
+  lex_vec_t braces = lex_or(lex_eq(v, '{'), lex_eq(v, '}'));
+  lex_vec_t other = lex_or(lex_or(lex_eq(v, ';'), lex_eq(v, '"')),
+                           lex_eq(v, close_delim));
+  return lex_or(lex_or(brackets, braces), lex_or(other, lex_space(v)));
+}
+
+#endif
+
+const char *akx_cell_lex_backend(void) {
+#if defined(AKX_CELL_LEX_AVX2)
+  return "avx2";
+#elif defined(AKX_CELL_LEX_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+size_t akx_cell_lex_skip_space(const uint8_t *data, size_t pos, size_t len,
+                               int *newline) {
+  // Most gaps are a single space, so check a few bytes before going wide
+  for (int i = 0; i < 4; i++) {
+    if (pos >= len) {
+      return pos;
+    }
+    uint8_t cls = akx_cell_lex_class[data[pos]];
+    if (!(cls & AKX_CELL_LEX_SPACE)) {
+      return pos;
+    }
+    if ((cls & AKX_CELL_LEX_NEWLINE) && newline) {
+      *newline = 1;
+    }
+    pos++;
+  }
+
+#ifdef LEX_BLOCK
+  while (pos + LEX_BLOCK <= len) {
+    lex_vec_t v = lex_load(data + pos);
+    uint32_t other = ~lex_mask(lex_space(v));
+    uint32_t lines = newline ? lex_mask(lex_newline(v)) : 0;
+
+#if LEX_BLOCK < 32
+    other &= (1u << LEX_BLOCK) - 1;
+#endif
+
+    if (other) {
+      unsigned first = first_bit(other);
+      if (lines & ((1u << first) - 1)) {
+        *newline = 1;
+      }
+      return pos + first;
+    }
+
+    if (lines) {
+      *newline = 1;
+    }
+    pos += LEX_BLOCK;
+  }
+#endif
+
+  while (pos < len) {
+    uint8_t cls = akx_cell_lex_class[data[pos]];
+    if (!(cls & AKX_CELL_LEX_SPACE)) {
+      break;
+    }
+    if ((cls & AKX_CELL_LEX_NEWLINE) && newline) {
+      *newline = 1;
+    }
+    pos++;
+  }
+
+  return pos;
+}
+
+size_t akx_cell_lex_skip_blank(const uint8_t *data, size_t pos, size_t len) {
+  for (;;) {
+    pos = akx_cell_lex_skip_space(data, pos, len, NULL);
+    if (pos >= len || data[pos] != ';') {
+      return pos;
+    }
+    pos = akx_cell_lex_find_newline(data, pos, len);
+  }
+}
+
+size_t akx_cell_lex_find_newline(const uint8_t *data, size_t pos, size_t len) {
+#ifdef LEX_BLOCK
+  while (pos + LEX_BLOCK <= len) {
+    uint32_t mask = lex_mask(lex_eq(lex_load(data + pos), '\n'));
+    if (mask) {
+      return pos + first_bit(mask);
+    }
+    pos += LEX_BLOCK;
+  }
+#endif
+
+  while (pos < len && data[pos] != '\n') {
+    pos++;
+  }
+  return pos;
+}
+
+size_t akx_cell_lex_find_quote(const uint8_t *data, size_t pos, size_t len) {
+#ifdef LEX_BLOCK
+  while (pos + LEX_BLOCK <= len) {
+    lex_vec_t v = lex_load(data + pos);
+    uint32_t mask = lex_mask(lex_or(lex_eq(v, '"'), lex_eq(v, '\\')));
+    if (mask) {
+      return pos + first_bit(mask);
+    }
+    pos += LEX_BLOCK;
+  }
+#endif
+
+  while (pos < len && data[pos] != '"' && data[pos] != '\\') {
+    pos++;
+  }
+  return pos;
+}
+
+size_t akx_cell_lex_atom_end(const uint8_t *data, size_t pos, size_t len,
+                             uint8_t close_delim) {
+#ifdef LEX_BLOCK
+  while (pos + LEX_BLOCK <= len) {
+    uint32_t mask = lex_mask(lex_delim(lex_load(data + pos), close_delim));
+    if (mask) {
+      return pos + first_bit(mask);
+    }
+    pos += LEX_BLOCK;
+  }
+#endif
+
+  while (pos < len && !(akx_cell_lex_class[data[pos]] & AKX_CELL_LEX_DELIM) &&
+         data[pos] != close_delim) {
+    pos++;
+  }
+  return pos;
+}
@@ -0,0 +1,27 @@
+#ifndef AKX_CELL_LEX_H
+#define AKX_CELL_LEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define AKX_CELL_LEX_SPACE (1u << 0)
+#define AKX_CELL_LEX_NEWLINE (1u << 1)
+#define AKX_CELL_LEX_DELIM (1u << 2)
+
+extern const uint8_t akx_cell_lex_class[256];
+
+const char *akx_cell_lex_backend(void);
+
+size_t akx_cell_lex_skip_space(const uint8_t *data, size_t pos, size_t len,
+                               int *newline);
+
+size_t akx_cell_lex_skip_blank(const uint8_t *data, size_t pos, size_t len);
+
+size_t akx_cell_lex_find_newline(const uint8_t *data, size_t pos, size_t len);
+
+size_t akx_cell_lex_find_quote(const uint8_t *data, size_t pos, size_t len);
+
+size_t akx_cell_lex_atom_end(const uint8_t *data, size_t pos, size_t len,
+                             uint8_t close_delim);
+
+#endif
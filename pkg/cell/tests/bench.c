@@ -0,0 +1,355 @@
+#include "akx_cell.h"
+#include "akx_cell_lex.h"
+#include <ak24/kernel.h>
+#include <ak24/log.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ITERATIONS 20
+
+static double now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+static ak_buffer_t *make_nested_source(size_t depth) {
+  static const char open_delims[] = "([{<";
+  static const char close_delims[] = ")]}>";
+
+  ak_buffer_t *buf = ak_buffer_new(depth * 4 + 16);
+  if (!buf) {
+    return NULL;
+  }
+
+  for (size_t i = 0; i < depth; i++) {
+    uint8_t chunk[2] = {(uint8_t)open_delims[i % 4], 'a'};
+    ak_buffer_copy_to(buf, chunk, 2);
+    ak_buffer_copy_to(buf, (uint8_t *)" ", 1);
+  }
+
+  ak_buffer_copy_to(buf, (uint8_t *)"42", 2);
+
+  for (size_t i = depth; i > 0; i--) {
+    uint8_t c = (uint8_t)close_delims[(i - 1) % 4];
+    ak_buffer_copy_to(buf, &c, 1);
+  }
+
+  ak_buffer_copy_to(buf, (uint8_t *)"\n", 1);
+  return buf;
+}
+
+static int bench_depth(size_t depth) {
+  ak_buffer_t *source = make_nested_source(depth);
+  if (!source) {
+    return 1;
+  }
+
+  size_t bytes = ak_buffer_count(source);
+  double best_ms = 0;
+
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    double start = now_ms();
+    akx_parse_result_t result = akx_cell_parse_buffer(source, "bench");
+    double elapsed = now_ms() - start;
+
+    if (result.errors || list_count(&result.cells) != 1) {
+      printf("depth %zu: unexpected parse result\n", depth);
+      akx_parse_result_free(&result);
+      ak_buffer_free(source);
+      return 1;
+    }
+
+    akx_parse_result_free(&result);
+
+    if (i == 0 || elapsed < best_ms) {
+      best_ms = elapsed;
+    }
+  }
+
+  printf("%8zu %10zu %10.3f %10.2f\n", depth, bytes, best_ms,
+         best_ms * 1000000.0 / (double)bytes);
+
+  ak_buffer_free(source);
+  return 0;
+}
+
+static ak_buffer_t *make_wide_source(size_t forms) {
+  ak_buffer_t *buf = ak_buffer_new(forms * 48 + 16);
+  if (!buf) {
+    return NULL;
+  }
+
+  char line[96];
+  for (size_t i = 0; i < forms; i++) {
+    int len = snprintf(line, sizeof(line),
+                       "(set value-%zu [%zu 2.5 \"item\" {nested sym}])\n",
+                       i, i);
+    ak_buffer_copy_to(buf, (uint8_t *)line, (size_t)len);
+  }
+
+  return buf;
+}
+
+static int bench_wide(size_t forms) {
+  ak_buffer_t *source = make_wide_source(forms);
+  if (!source) {
+    return 1;
+  }
+
+  size_t bytes = ak_buffer_count(source);
+  double best_parse_ms = 0;
+  double best_free_ms = 0;
+
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    double start = now_ms();
+    akx_parse_result_t result = akx_cell_parse_buffer(source, "bench");
+    double parsed = now_ms();
+
+    if (result.errors || list_count(&result.cells) != forms) {
+      printf("forms %zu: unexpected parse result\n", forms);
+      akx_parse_result_free(&result);
+      ak_buffer_free(source);
+      return 1;
+    }
+
+    akx_parse_result_free(&result);
+    double freed = now_ms();
+
+    if (i == 0 || parsed - start < best_parse_ms) {
+      best_parse_ms = parsed - start;
+    }
+    if (i == 0 || freed - parsed < best_free_ms) {
+      best_free_ms = freed - parsed;
+    }
+  }
+
+  printf("%8zu %10zu %10.3f %10.3f\n", forms, bytes, best_parse_ms,
+         best_free_ms);
+
+  ak_buffer_free(source);
+  return 0;
+}
+
+static int bench_stream(size_t forms) {
+  ak_buffer_t *source = make_wide_source(forms);
+  if (!source) {
+    return 1;
+  }
+
+  char path[] = "/tmp/akx_cell_bench_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    ak_buffer_free(source);
+    return 1;
+  }
+  FILE *f = fdopen(fd, "wb");
+  fwrite(ak_buffer_data(source), 1, ak_buffer_count(source), f);
+  fclose(f);
+
+  size_t bytes = ak_buffer_count(source);
+  ak_buffer_free(source);
+
+  double best_whole_ms = 0;
+  double best_stream_ms = 0;
+  int rc = 0;
+
+  for (int i = 0; i < BENCH_ITERATIONS && rc == 0; i++) {
+    double start = now_ms();
+    akx_parse_result_t whole = akx_cell_parse_file(path);
+    size_t whole_count = list_count(&whole.cells);
+    akx_parse_result_free(&whole);
+    double parsed = now_ms();
+
+    size_t stream_count = 0;
+    akx_cell_stream_t *stream = akx_cell_stream_open(path);
+    akx_parse_result_t result;
+    while (stream && akx_cell_stream_next(stream, &result) > 0) {
+      stream_count += list_count(&result.cells);
+      akx_parse_result_free(&result);
+    }
+    akx_cell_stream_close(stream);
+    double streamed = now_ms();
+
+    if (whole_count != forms || stream_count != forms) {
+      printf("forms %zu: unexpected stream result\n", forms);
+      rc = 1;
+    }
+
+    if (i == 0 || parsed - start < best_whole_ms) {
+      best_whole_ms = parsed - start;
+    }
+    if (i == 0 || streamed - parsed < best_stream_ms) {
+      best_stream_ms = streamed - parsed;
+    }
+  }
+
+  if (rc == 0) {
+    printf("%8zu %10zu %10.3f %10.3f\n", forms, bytes, best_whole_ms,
+           best_stream_ms);
+  }
+
+  remove(path);
+  return rc;
+}
+
+static int bench_clone(size_t count) {
+  ak_buffer_t *source = ak_buffer_new(count * 3 + 2);
+  if (!source) {
+    return 1;
+  }
+
+  ak_buffer_copy_to(source, (uint8_t *)"(", 1);
+  for (size_t i = 0; i < count; i++) {
+    ak_buffer_copy_to(source, (uint8_t *)"42 ", 3);
+  }
+  ak_buffer_copy_to(source, (uint8_t *)")", 1);
+
+  akx_parse_result_t result = akx_cell_parse_buffer(source, "bench");
+  ak_buffer_free(source);
+  if (result.errors || list_count(&result.cells) != 1) {
+    printf("count %zu: unexpected parse result\n", count);
+    akx_parse_result_free(&result);
+    return 1;
+  }
+
+  akx_cell_t *list = *((akx_cell_t **)list_get(&result.cells, 0));
+
+  double start = now_ms();
+  akx_cell_t *cloned = akx_cell_clone(list);
+  double cloned_at = now_ms();
+  akx_cell_free(cloned);
+  double freed = now_ms();
+
+  akx_parse_result_free(&result);
+
+  if (!cloned) {
+    printf("count %zu: clone failed\n", count);
+    return 1;
+  }
+
+  printf("%8zu %10.3f %10.3f\n", count, cloned_at - start, freed - cloned_at);
+  return 0;
+}
+
+static ak_buffer_t *make_corpus_source(size_t target_bytes) {
+  static const char *const forms[] = {
+      ";; ---------------------------------------------------------------\n"
+      ";; Section header comment describing the definitions that follow\n"
+      ";; ---------------------------------------------------------------\n",
+      "(let make-counter (lambda [start step]\n"
+      "  (let value start)\n"
+      "  (lambda []\n"
+      "    (set value (+ value step))\n"
+      "    value)))\n",
+      "io/putf \"counter %d reached %d after %d steps\\n\" id value steps\n",
+      "(if (and (gte total 1000) (lt total 100000))\n"
+      "    (io/putf \"total in range: \\\"%d\\\"\\t(ok)\\n\" total)\n"
+      "    (io/putf \"total out of range: %d\\n\" total))\n",
+      "{config [name \"akx-corpus\"] [version 2.5] [tags alpha beta gamma]}\n",
+      "<html <body <p \"A paragraph of plain text that is long enough to "
+      "span several vector blocks without any escapes in it at all.\">>>\n",
+      "(loop (lt i 100)\n"
+      "  (begin\n"
+      "    (set acc (cons (* i i) acc)) ; squares, newest first\n"
+      "    (set i (+ i 1))))\n",
+  };
+  size_t form_count = sizeof(forms) / sizeof(forms[0]);
+
+  ak_buffer_t *buf = ak_buffer_new(target_bytes + 512);
+  if (!buf) {
+    return NULL;
+  }
+
+  for (size_t i = 0; ak_buffer_count(buf) < target_bytes; i++) {
+    const char *form = forms[i % form_count];
+    ak_buffer_copy_to(buf, (uint8_t *)form, strlen(form));
+  }
+
+  return buf;
+}
+
+static int bench_throughput(size_t target_bytes) {
+  ak_buffer_t *source = make_corpus_source(target_bytes);
+  if (!source) {
+    return 1;
+  }
+
+  size_t bytes = ak_buffer_count(source);
+  double best_ms = 0;
+
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    double start = now_ms();
+    akx_parse_result_t result = akx_cell_parse_buffer(source, "corpus");
+    double elapsed = now_ms() - start;
+
+    if (result.errors || list_count(&result.cells) == 0) {
+      printf("corpus: unexpected parse result\n");
+      akx_parse_result_free(&result);
+      ak_buffer_free(source);
+      return 1;
+    }
+
+    akx_parse_result_free(&result);
+
+    if (i == 0 || elapsed < best_ms) {
+      best_ms = elapsed;
+    }
+  }
+
+  double mb = (double)bytes / (1024.0 * 1024.0);
+  printf("%8s %10zu %10.3f %10.1f\n", akx_cell_lex_backend(), bytes, best_ms,
+         mb * 1000.0 / best_ms);
+
+  ak_buffer_free(source);
+  return 0;
+}
+
+int main(void) {
+  ak_kernel_init("akx-cell-bench");
+  ak_log_set_level(AK24_LOG_LEVEL_INFO);
+
+  printf("=== AKX Cell Parser Depth Scaling ===\n");
+  printf("%8s %10s %10s %10s\n", "depth", "bytes", "best ms", "ns/byte");
+
+  int result = 0;
+  for (size_t depth = 1000; depth <= 16000 && result == 0; depth *= 2) {
+    result = bench_depth(depth);
+  }
+
+  printf("\n=== AKX Cell Parse/Free of Wide Files ===\n");
+  printf("%8s %10s %10s %10s\n", "forms", "bytes", "parse ms", "free ms");
+
+  for (size_t forms = 10000; forms <= 160000 && result == 0; forms *= 4) {
+    result = bench_wide(forms);
+  }
+
+  printf("\n=== AKX Cell Whole-File vs Streamed Parse ===\n");
+  printf("%8s %10s %10s %10s\n", "forms", "bytes", "whole ms", "stream ms");
+
+  for (size_t forms = 10000; forms <= 160000 && result == 0; forms *= 4) {
+    result = bench_stream(forms);
+  }
+
+  printf("\n=== AKX Cell Clone/Free of Long Lists ===\n");
+  printf("%8s %10s %10s\n", "cells", "clone ms", "free ms");
+
+  for (size_t count = 1000000; count <= 10000000 && result == 0;
+       count *= 10) {
+    result = bench_clone(count);
+  }
+
+  printf("\n=== AKX Cell Parse Throughput (mixed corpus) ===\n");
+  printf("%8s %10s %10s %10s\n", "lexer", "bytes", "best ms", "MB/s");
+
+  if (result == 0) {
+    result = bench_throughput(8 * 1024 * 1024);
+  }
+
+  printf("======================================\n");
+
+  ak_kernel_deinit();
+  return result;
+}
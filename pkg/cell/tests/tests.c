@@ -1,8 +1,10 @@
 #include "tests.h"
 #include "akx_cell.h"
+#include "akx_cell_lex.h"
 #include "testing.h"
 #include <ak24/filepath.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -30,7 +32,7 @@ static void assert_symbol(akx_cell_t *cell, const char *expected) {
   ASSERT_STREQ(cell->value.symbol, expected);
 }
 
-static void assert_integer(akx_cell_t *cell, int expected) {
+static void assert_integer(akx_cell_t *cell, int64_t expected) {
   assert_cell_type(cell, AKX_TYPE_INTEGER_LITERAL);
   ASSERT_EQ(cell->value.integer_literal, expected);
 }
@@ -117,7 +119,8 @@ static akx_cell_t *parse_string_as_file(const char *content,
   akx_cell_t *tail = NULL;
 
   for (size_t i = 0; i < list_count(&result.cells); i++) {
-    akx_cell_t *cell = *((akx_cell_t **)list_get(&result.cells, i));
+    akx_cell_t *cell =
+        akx_cell_promote(*((akx_cell_t **)list_get(&result.cells, i)));
     if (!head) {
       head = cell;
       tail = cell;
@@ -127,10 +130,7 @@ static akx_cell_t *parse_string_as_file(const char *content,
     }
   }
 
-  list_deinit(&result.cells);
-  if (result.source_file) {
-    ak_source_file_release(result.source_file);
-  }
+  akx_parse_result_free(&result);
 
   return head;
 }
@@ -156,6 +156,127 @@ static void test_integer_literals(void) {
   akx_cell_free(cells);
 }
 
+static void assert_bignum(akx_cell_t *cell, const char *expected) {
+  assert_cell_type(cell, AKX_TYPE_INTEGER_LITERAL);
+  ASSERT_TRUE(cell->flags & AKX_CELL_FLAG_BIGNUM);
+  ak_buffer_t *digits = akx_bignum_to_buffer(cell->value.bignum);
+  ASSERT_NOT_NULL(digits);
+  ASSERT_STREQ((const char *)ak_buffer_data(digits), expected);
+  ak_buffer_free(digits);
+}
+
+static void test_wide_integer_literals(void) {
+  printf("  test_wide_integer_literals...\n");
+
+  akx_cell_t *cells = parse_string_as_file(
+      "(9223372036854775807 -9223372036854775808 9223372036854775808 "
+      "-123456789012345678901234567890)",
+      "int_wide");
+  ASSERT_NOT_NULL(cells);
+  assert_list_length(cells, 4);
+  akx_cell_t *item = cells->value.list_head;
+  assert_integer(item, INT64_MAX);
+  ASSERT_FALSE(item->flags & AKX_CELL_FLAG_BIGNUM);
+  assert_integer(item->next, INT64_MIN);
+  assert_bignum(item->next->next, "9223372036854775808");
+  assert_bignum(item->next->next->next, "-123456789012345678901234567890");
+
+  akx_cell_t *clone = akx_cell_clone(cells);
+  ASSERT_NOT_NULL(clone);
+  ASSERT_TRUE(clone->value.list_head->next->next->value.bignum !=
+              item->next->next->value.bignum);
+  assert_bignum(clone->value.list_head->next->next->next,
+                "-123456789012345678901234567890");
+  akx_cell_free(clone);
+  akx_cell_free(cells);
+}
+
+static void assert_bignum_op(akx_bignum_t *num, const char *expected) {
+  ASSERT_NOT_NULL(num);
+  ak_buffer_t *digits = akx_bignum_to_buffer(num);
+  ASSERT_NOT_NULL(digits);
+  ASSERT_STREQ((const char *)ak_buffer_data(digits), expected);
+  ak_buffer_free(digits);
+  akx_bignum_free(num);
+}
+
+static void test_bignum_arithmetic(void) {
+  printf("  test_bignum_arithmetic...\n");
+
+  const char *a_str = "-340282366920938463463374607431768211457";
+  akx_bignum_t *a = akx_bignum_from_string(a_str, strlen(a_str));
+  akx_bignum_t *b = akx_bignum_from_i64(INT64_MIN);
+  ASSERT_NOT_NULL(a);
+  ASSERT_NOT_NULL(b);
+
+  assert_bignum_op(akx_bignum_add(a, b),
+                   "-340282366920938463472597979468622987265");
+  assert_bignum_op(akx_bignum_sub(a, b),
+                   "-340282366920938463454151235394913435649");
+  assert_bignum_op(akx_bignum_mul(a, b),
+                   "3138550867693340381917894711603833208060401094268872032"
+                   "256");
+
+  akx_bignum_t *q = NULL;
+  akx_bignum_t *r = NULL;
+  ASSERT_EQ(akx_bignum_divmod(a, b, &q, &r), 0);
+  assert_bignum_op(q, "36893488147419103232");
+  assert_bignum_op(r, "-1");
+
+  akx_bignum_t *zero = akx_bignum_from_i64(0);
+  ASSERT_EQ(akx_bignum_divmod(a, zero, &q, &r), -1);
+  ASSERT_TRUE(akx_bignum_cmp(a, b) < 0);
+  ASSERT_TRUE(akx_bignum_cmp(b, zero) < 0);
+
+  int64_t out = 0;
+  ASSERT_FALSE(akx_bignum_to_i64(a, &out));
+  ASSERT_TRUE(akx_bignum_to_i64(b, &out));
+  ASSERT_EQ(out, INT64_MIN);
+
+  akx_bignum_free(zero);
+  akx_bignum_free(a);
+  akx_bignum_free(b);
+}
+
+static void test_bignum_karatsuba(void) {
+  printf("  test_bignum_karatsuba...\n");
+
+  // (10^600 - 1)^2 = 10^1200 - 2 * 10^600 + 1, well past the threshold
+  char nines[601];
+  memset(nines, '9', 600);
+  nines[600] = '\0';
+  akx_bignum_t *n = akx_bignum_from_string(nines, 600);
+  ASSERT_NOT_NULL(n);
+  ASSERT_TRUE(n->count > AKX_BIGNUM_KARATSUBA_THRESHOLD);
+
+  akx_bignum_t *square = akx_bignum_mul(n, n);
+  ASSERT_NOT_NULL(square);
+  ak_buffer_t *digits = akx_bignum_to_buffer(square);
+  ASSERT_NOT_NULL(digits);
+  const char *text = (const char *)ak_buffer_data(digits);
+  ASSERT_EQ(strlen(text), 1200);
+  for (size_t i = 0; i < 599; i++) {
+    ASSERT_EQ(text[i], '9');
+  }
+  ASSERT_EQ(text[599], '8');
+  for (size_t i = 600; i < 1199; i++) {
+    ASSERT_EQ(text[i], '0');
+  }
+  ASSERT_EQ(text[1199], '1');
+  ak_buffer_free(digits);
+
+  akx_bignum_t *q = NULL;
+  akx_bignum_t *r = NULL;
+  ASSERT_EQ(akx_bignum_divmod(square, n, &q, &r), 0);
+  ASSERT_EQ(akx_bignum_cmp(q, n), 0);
+  ASSERT_EQ(r->count, 0);
+
+  akx_bignum_free(q);
+  akx_bignum_free(r);
+  akx_bignum_free(square);
+  akx_bignum_free(n);
+}
+
 static void test_real_literals(void) {
   printf("  test_real_literals...\n");
 
@@ -502,6 +623,79 @@ static void test_unwrap_quoted(void) {
   akx_cell_free(cells);
 }
 
+static void test_unwrap_quoted_uses_parsed_tree(void) {
+  printf("  test_unwrap_quoted_uses_parsed_tree...\n");
+
+  akx_cell_t *cells =
+      parse_string_as_file("put 1\n  '(a [b] c)", "unwrap_tree");
+  ASSERT_NOT_NULL(cells);
+  akx_cell_t *quoted = cells->next;
+  assert_cell_type(quoted, AKX_TYPE_QUOTED);
+  ASSERT_TRUE(quoted->flags & AKX_CELL_FLAG_QUOTED_EXPR);
+
+  akx_cell_t *first = akx_cell_unwrap_quoted(quoted);
+  akx_cell_t *second = akx_cell_unwrap_quoted(quoted);
+  ASSERT_NOT_NULL(first);
+  ASSERT_NOT_NULL(second);
+  ASSERT_TRUE(first == second);
+  ASSERT_TRUE(akx_cell_is_shared(first));
+  assert_list_length(first, 3);
+  assert_cell_type(first->value.list_head->next, AKX_TYPE_LIST_SQUARE);
+
+  ak_source_loc_t loc = akx_cell_location(first);
+  ASSERT_EQ(loc.line, 2);
+  ASSERT_EQ(loc.column, 4);
+
+  akx_cell_t *copy = akx_cell_promote(first);
+  ASSERT_NOT_NULL(copy);
+  copy->value.list_head->value.symbol = "z";
+  assert_symbol(second->value.list_head, "a");
+
+  akx_cell_free(copy);
+  akx_cell_free(first);
+  akx_cell_free(second);
+  akx_cell_free(cells);
+}
+
+static void test_unwrap_quoted_shares_arena_view(void) {
+  printf("  test_unwrap_quoted_shares_arena_view...\n");
+
+  ak_buffer_t *buf = ak_buffer_new(32);
+  ASSERT_NOT_NULL(buf);
+  const char *source = "'(1 2) '42 '\"s\"";
+  ak_buffer_copy_to(buf, (uint8_t *)source, strlen(source));
+
+  akx_parse_result_t result = akx_cell_parse_buffer(buf, "arena_view");
+  ak_buffer_free(buf);
+  ASSERT_EQ(list_count(&result.cells), 3);
+
+  akx_cell_t *list_quote = *((akx_cell_t **)list_get(&result.cells, 0));
+  akx_cell_t *first = akx_cell_unwrap_quoted(list_quote);
+  akx_cell_t *second = akx_cell_unwrap_quoted(list_quote);
+  ASSERT_NOT_NULL(first);
+  ASSERT_TRUE(first == second);
+  ASSERT_TRUE(!(first->flags & AKX_CELL_FLAG_ARENA));
+  assert_list_length(first, 2);
+  akx_cell_free(second);
+
+  akx_cell_t *int_quote = *((akx_cell_t **)list_get(&result.cells, 1));
+  akx_cell_t *children[2];
+  ASSERT_EQ(akx_cell_children(int_quote, children), 1);
+  akx_cell_t *number = akx_cell_unwrap_quoted(int_quote);
+  assert_integer(number, 42);
+  akx_cell_free(number);
+
+  akx_cell_t *string_quote = *((akx_cell_t **)list_get(&result.cells, 2));
+  akx_cell_t *text = akx_cell_unwrap_quoted(string_quote);
+  assert_string(text, "s");
+  akx_cell_free(text);
+
+  // The view outlives the parse result while a holder keeps it
+  akx_parse_result_free(&result);
+  assert_list_length(first, 2);
+  akx_cell_free(first);
+}
+
 static void test_multiple_expressions(void) {
   printf("  test_multiple_expressions...\n");
 
@@ -1105,6 +1299,78 @@ static void test_whitespace_in_deep_nesting(void) {
   akx_cell_free(cells);
 }
 
+static void test_delimiters_in_strings_and_comments(void) {
+  printf("  test_delimiters_in_strings_and_comments...\n");
+
+  akx_cell_t *cells = parse_string_as_file(
+      "(put \"a) b\" ; not a close )\n  [x \"]\"])", "delims_in_strings");
+  ASSERT_NOT_NULL(cells);
+  ASSERT_EQ(count_cells(cells), 1);
+  assert_cell_type(cells, AKX_TYPE_LIST);
+  assert_list_length(cells, 3);
+
+  assert_symbol(cells->value.list_head, "put");
+  assert_string(cells->value.list_head->next, "a) b");
+
+  akx_cell_t *square = cells->value.list_head->next->next;
+  assert_cell_type(square, AKX_TYPE_LIST_SQUARE);
+  assert_list_length(square, 2);
+  assert_symbol(square->value.list_head, "x");
+  assert_string(square->value.list_head->next, "]");
+
+  akx_cell_free(cells);
+}
+
+static void test_very_deep_nesting(void) {
+  printf("  test_very_deep_nesting...\n");
+
+  const size_t depth = 10000;
+  char *source = AK24_ALLOC(depth * 2 + 2);
+  ASSERT_NOT_NULL(source);
+  memset(source, '(', depth);
+  source[depth] = 'x';
+  memset(source + depth + 1, ')', depth);
+  source[depth * 2 + 1] = '\0';
+
+  akx_cell_t *cells = parse_string_as_file(source, "very_deep");
+  AK24_FREE(source);
+  ASSERT_NOT_NULL(cells);
+
+  akx_cell_t *current = cells;
+  for (size_t i = 0; i < depth; i++) {
+    assert_cell_type(current, AKX_TYPE_LIST);
+    ASSERT_TRUE(akx_cell_has_location(current));
+    ak_source_range_t range = akx_cell_range(current);
+    ASSERT_EQ(range.start.offset, i);
+    ASSERT_EQ(range.end.offset, depth * 2 + 1 - i);
+    current = current->value.list_head;
+  }
+  assert_symbol(current, "x");
+
+  akx_cell_free(cells);
+}
+
+static void test_unterminated_nested_list_location(void) {
+  printf("  test_unterminated_nested_list_location...\n");
+
+  ak_buffer_t *buf = ak_buffer_new(32);
+  ASSERT_NOT_NULL(buf);
+  const char *source = "(a [b c] (d e";
+  ak_buffer_copy_to(buf, (uint8_t *)source, strlen(source));
+
+  akx_parse_result_t result = akx_cell_parse_buffer(buf, "unterminated");
+  ak_buffer_free(buf);
+
+  ASSERT_EQ(list_count(&result.cells), 0);
+  ASSERT_NOT_NULL(result.errors);
+  ASSERT_NULL(result.errors->next);
+  ASSERT_EQ(result.errors->location.offset, 9);
+  ASSERT_STREQ(result.errors->message,
+               "unterminated list - missing closing ')'");
+
+  akx_parse_result_free(&result);
+}
+
 static void test_symbol_identity_nested(void) {
   printf("  test_symbol_identity_nested...\n");
 
@@ -1151,16 +1417,45 @@ static void test_sourceloc_nested(void) {
   akx_cell_t *cells = parse_string_as_file("(outer (inner))", "sourceloc_nest");
   ASSERT_NOT_NULL(cells);
 
-  ASSERT_NOT_NULL(cells->sourceloc);
+  ASSERT_TRUE(akx_cell_has_location(cells));
 
   akx_cell_t *outer_sym = cells->value.list_head;
-  ASSERT_NOT_NULL(outer_sym->sourceloc);
+  ASSERT_TRUE(akx_cell_has_location(outer_sym));
 
   akx_cell_t *inner_list = outer_sym->next;
-  ASSERT_NOT_NULL(inner_list->sourceloc);
+  ASSERT_TRUE(akx_cell_has_location(inner_list));
 
   akx_cell_t *inner_sym = inner_list->value.list_head;
-  ASSERT_NOT_NULL(inner_sym->sourceloc);
+  ASSERT_TRUE(akx_cell_has_location(inner_sym));
+
+  akx_cell_free(cells);
+}
+
+static void test_location_resolved_on_demand(void) {
+  printf("  test_location_resolved_on_demand...\n");
+
+  akx_cell_t *cells = parse_string_as_file("(a\n  (b c)\n\t\"s\")", "lazy_loc");
+  ASSERT_NOT_NULL(cells);
+  ASSERT_TRUE(sizeof(akx_cell_t) <= 24);
+
+  akx_cell_t *inner = cells->value.list_head->next;
+  ak_source_loc_t loc = akx_cell_location(inner);
+  ASSERT_EQ(loc.offset, 5);
+  ASSERT_EQ(loc.line, 2);
+  ASSERT_EQ(loc.column, 3);
+
+  ak_source_range_t range = akx_cell_range(inner->next);
+  ASSERT_EQ(range.start.line, 3);
+  ASSERT_EQ(range.start.offset, 12);
+  ASSERT_EQ(range.end.offset, 15);
+
+  ASSERT_NOT_NULL(akx_cell_source_file(inner));
+  ASSERT_STREQ(ak_source_file_name(akx_cell_source_file(inner)),
+               ak_source_file_name(akx_cell_source_file(cells)));
+
+  akx_cell_t *plain = akx_cell_clone(NULL);
+  ASSERT_FALSE(akx_cell_has_location(plain));
+  ASSERT_NULL(akx_cell_location(plain).file);
 
   akx_cell_free(cells);
 }
@@ -1447,18 +1742,18 @@ static void test_clone_sourceloc_preservation(void) {
   akx_cell_t *cloned = akx_cell_clone(cells);
   ASSERT_NOT_NULL(cloned);
 
-  ASSERT_NOT_NULL(cells->sourceloc);
-  ASSERT_NOT_NULL(cloned->sourceloc);
+  ASSERT_TRUE(akx_cell_has_location(cells));
+  ASSERT_TRUE(akx_cell_has_location(cloned));
 
   akx_cell_t *orig_outer = cells->value.list_head;
   akx_cell_t *clone_outer = cloned->value.list_head;
-  ASSERT_NOT_NULL(orig_outer->sourceloc);
-  ASSERT_NOT_NULL(clone_outer->sourceloc);
+  ASSERT_TRUE(akx_cell_has_location(orig_outer));
+  ASSERT_TRUE(akx_cell_has_location(clone_outer));
 
   akx_cell_t *orig_inner = orig_outer->next;
   akx_cell_t *clone_inner = clone_outer->next;
-  ASSERT_NOT_NULL(orig_inner->sourceloc);
-  ASSERT_NOT_NULL(clone_inner->sourceloc);
+  ASSERT_TRUE(akx_cell_has_location(orig_inner));
+  ASSERT_TRUE(akx_cell_has_location(clone_inner));
 
   akx_cell_free(cells);
   akx_cell_free(cloned);
@@ -1471,6 +1766,615 @@ static void test_clone_null_cell(void) {
   ASSERT_TRUE(cloned == NULL);
 }
 
+static void test_clone_long_list(void) {
+  printf("  test_clone_long_list...\n");
+
+  const size_t count = 1000000;
+  ak_buffer_t *buf = ak_buffer_new(count * 2 + 2);
+  ASSERT_NOT_NULL(buf);
+  ak_buffer_copy_to(buf, (uint8_t *)"(", 1);
+  for (size_t i = 0; i < count; i++) {
+    ak_buffer_copy_to(buf, (uint8_t *)"x ", 2);
+  }
+  ak_buffer_copy_to(buf, (uint8_t *)")", 1);
+
+  akx_parse_result_t result = akx_cell_parse_buffer(buf, "clone_long");
+  ASSERT_TRUE(result.errors == NULL);
+  ASSERT_EQ(list_count(&result.cells), 1);
+  akx_cell_t *list = *((akx_cell_t **)list_get(&result.cells, 0));
+
+  akx_cell_t *cloned = akx_cell_clone(list);
+  ASSERT_NOT_NULL(cloned);
+  akx_parse_result_free(&result);
+  ak_buffer_free(buf);
+
+  ASSERT_EQ(count_cells(cloned->value.list_head), (int)count);
+  assert_symbol(cloned->value.list_head, "x");
+
+  akx_cell_t *again = akx_cell_clone(cloned->value.list_head);
+  ASSERT_NOT_NULL(again);
+  ASSERT_EQ(count_cells(again), (int)count);
+
+  akx_cell_free(cloned);
+  akx_cell_free(again);
+}
+
+static void test_clone_deep_nesting(void) {
+  printf("  test_clone_deep_nesting...\n");
+
+  // Built by hand; the parser itself still recurses on nesting
+  const size_t depth = 1000000;
+  akx_cell_t *outer = NULL;
+  for (size_t i = 0; i < depth; i++) {
+    akx_cell_t *cell = AK24_ALLOC(sizeof(akx_cell_t));
+    ASSERT_NOT_NULL(cell);
+    memset(cell, 0, sizeof(akx_cell_t));
+    cell->type = i % 2 ? AKX_TYPE_LIST_SQUARE : AKX_TYPE_LIST;
+    cell->value.list_head = outer;
+    outer = cell;
+  }
+
+  akx_cell_t *cloned = akx_cell_promote(outer);
+  ASSERT_NOT_NULL(cloned);
+
+  size_t seen = 0;
+  akx_cell_t *a = outer;
+  akx_cell_t *b = cloned;
+  while (a) {
+    ASSERT_NOT_NULL(b);
+    ASSERT_TRUE(a != b);
+    ASSERT_EQ(a->type, b->type);
+    a = a->value.list_head;
+    b = b->value.list_head;
+    seen++;
+  }
+  ASSERT_TRUE(b == NULL);
+  ASSERT_EQ(seen, depth);
+
+  akx_cell_free(outer);
+  akx_cell_free(cloned);
+}
+
+static void test_arena_owns_parsed_cells(void) {
+  printf("  test_arena_owns_parsed_cells...\n");
+
+  ak_buffer_t *buf = ak_buffer_new(32);
+  ASSERT_NOT_NULL(buf);
+  const char *source = "(a \"s\" [1 2.5] 'q)";
+  ak_buffer_copy_to(buf, (uint8_t *)source, strlen(source));
+
+  akx_parse_result_t result = akx_cell_parse_buffer(buf, "arena_owned");
+  ak_buffer_free(buf);
+
+  ASSERT_NOT_NULL(result.arena);
+  ASSERT_EQ(list_count(&result.cells), 1);
+
+  akx_cell_t *list = *((akx_cell_t **)list_get(&result.cells, 0));
+  ASSERT_TRUE(list->flags & AKX_CELL_FLAG_ARENA);
+  for (akx_cell_t *c = list->value.list_head; c; c = c->next) {
+    ASSERT_TRUE(c->flags & AKX_CELL_FLAG_ARENA);
+  }
+
+  assert_string(list->value.list_head->next, "s");
+
+  akx_parse_result_free(&result);
+  ASSERT_NULL(result.arena);
+}
+
+static void test_promote_outlives_parse_result(void) {
+  printf("  test_promote_outlives_parse_result...\n");
+
+  ak_buffer_t *buf = ak_buffer_new(64);
+  ASSERT_NOT_NULL(buf);
+  const char *source = "(body \"text\" (inner 7) 'q) (sibling)";
+  ak_buffer_copy_to(buf, (uint8_t *)source, strlen(source));
+
+  akx_parse_result_t result = akx_cell_parse_buffer(buf, "promote");
+  ak_buffer_free(buf);
+  ASSERT_EQ(list_count(&result.cells), 2);
+
+  akx_cell_t *first = *((akx_cell_t **)list_get(&result.cells, 0));
+  akx_cell_t *second = *((akx_cell_t **)list_get(&result.cells, 1));
+  first->next = second;
+
+  akx_cell_t *promoted = akx_cell_promote(first);
+  akx_parse_result_free(&result);
+
+  ASSERT_NOT_NULL(promoted);
+  ASSERT_NULL(promoted->next);
+  ASSERT_EQ(promoted->flags & AKX_CELL_FLAG_ARENA, 0);
+  ASSERT_TRUE(akx_cell_has_location(promoted));
+  ASSERT_EQ(akx_cell_range(promoted).start.offset, 0);
+  ASSERT_EQ(akx_cell_range(promoted).end.offset, 26);
+  assert_list_length(promoted, 4);
+
+  akx_cell_t *head = promoted->value.list_head;
+  assert_symbol(head, "body");
+  assert_string(head->next, "text");
+  assert_list_length(head->next->next, 2);
+  assert_integer(head->next->next->value.list_head->next, 7);
+  assert_cell_type(head->next->next->next, AKX_TYPE_QUOTED);
+  for (akx_cell_t *c = head; c; c = c->next) {
+    ASSERT_EQ(c->flags & AKX_CELL_FLAG_ARENA, 0);
+  }
+
+  akx_cell_free(promoted);
+}
+
+static void test_serialize_round_trip(void) {
+  printf("  test_serialize_round_trip...\n");
+
+  ak_buffer_t *buf = ak_buffer_new(64);
+  ASSERT_NOT_NULL(buf);
+  const char *source = "(def x [1 2.5 \"s\"])\n'(q {r})\n"
+                       "(-5000000000 18446744073709551616)\n";
+  ak_buffer_copy_to(buf, (uint8_t *)source, strlen(source));
+
+  akx_parse_result_t parsed = akx_cell_parse_buffer(buf, "round_trip");
+  ASSERT_NULL(parsed.errors);
+
+  ak_buffer_t *data = ak_buffer_new(128);
+  ASSERT_NOT_NULL(data);
+  ASSERT_EQ(akx_cell_serialize(&parsed, data), 0);
+
+  akx_parse_result_t loaded;
+  ASSERT_EQ(akx_cell_deserialize(ak_buffer_data(data), ak_buffer_count(data),
+                                 buf, "round_trip", &loaded),
+            0);
+  ASSERT_EQ(list_count(&loaded.cells), 3);
+
+  akx_cell_t *def = *((akx_cell_t **)list_get(&loaded.cells, 0));
+  assert_list_length(def, 3);
+  assert_symbol(def->value.list_head, "def");
+  akx_cell_t *vec = def->value.list_head->next->next;
+  assert_list_length(vec, 3);
+  assert_integer(vec->value.list_head, 1);
+  assert_real(vec->value.list_head->next, 2.5, 0.0001);
+  assert_string(vec->value.list_head->next->next, "s");
+
+  akx_cell_t *quoted = *((akx_cell_t **)list_get(&loaded.cells, 1));
+  assert_cell_type(quoted, AKX_TYPE_QUOTED);
+  akx_cell_t *unwrapped = akx_cell_unwrap_quoted(quoted);
+  assert_list_length(unwrapped, 2);
+  assert_symbol(unwrapped->value.list_head, "q");
+  assert_cell_type(unwrapped->value.list_head->next, AKX_TYPE_LIST_CURLY);
+  akx_cell_free(unwrapped);
+
+  akx_cell_t *wide = *((akx_cell_t **)list_get(&loaded.cells, 2));
+  assert_integer(wide->value.list_head, -5000000000LL);
+  assert_bignum(wide->value.list_head->next, "18446744073709551616");
+
+  ASSERT_TRUE(akx_cell_has_location(vec));
+  ak_source_range_t range = akx_cell_range(vec);
+  ASSERT_EQ(range.start.offset, 7);
+  ASSERT_EQ(range.end.offset, 18);
+  ak_source_loc_t loc = akx_cell_location(quoted);
+  ASSERT_EQ(loc.line, 2);
+  ASSERT_EQ(loc.column, 1);
+
+  akx_parse_result_t truncated;
+  ASSERT_EQ(akx_cell_deserialize(ak_buffer_data(data),
+                                 ak_buffer_count(data) - 1, buf, "round_trip",
+                                 &truncated),
+            -1);
+  ASSERT_NULL(truncated.arena);
+
+  ak_buffer_free(data);
+  ak_buffer_free(buf);
+  akx_parse_result_free(&parsed);
+  akx_parse_result_free(&loaded);
+}
+
+static akx_cell_stream_t *open_string_as_stream(const char *content,
+                                                const char *test_name,
+                                                char *path, size_t path_len) {
+  ak_buffer_t *temp_dir = ak_filepath_temp();
+  if (!temp_dir) {
+    return NULL;
+  }
+
+  char filename[TEST_FILENAME_MAX_SIZE_MAX];
+  snprintf(filename, sizeof(filename), "akx_test_%s_%d.akx", test_name,
+           (int)getpid());
+
+  ak_buffer_t *temp_path =
+      ak_filepath_join(2, (const char *)ak_buffer_data(temp_dir), filename);
+  ak_buffer_free(temp_dir);
+  if (!temp_path) {
+    return NULL;
+  }
+
+  snprintf(path, path_len, "%s", (const char *)ak_buffer_data(temp_path));
+  ak_buffer_free(temp_path);
+
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    return NULL;
+  }
+  fwrite(content, 1, strlen(content), f);
+  fclose(f);
+
+  return akx_cell_stream_open(path);
+}
+
+static void test_stream_forms_and_locations(void) {
+  printf("  test_stream_forms_and_locations...\n");
+
+  char path[TEST_FILENAME_MAX_SIZE_MAX * 2];
+  akx_cell_stream_t *stream = open_string_as_stream(
+      "; header\n(a 1)\n\n  [b \"two\nlines\"] (c)\nd e\n", "stream_forms",
+      path, sizeof(path));
+  ASSERT_NOT_NULL(stream);
+
+  size_t forms = 0;
+  akx_cell_t *kept = NULL;
+  akx_parse_result_t result;
+  while (akx_cell_stream_next(stream, &result) > 0) {
+    ASSERT_NULL(result.errors);
+    for (size_t i = 0; i < list_count(&result.cells); i++) {
+      akx_cell_t *cell = *((akx_cell_t **)list_get(&result.cells, i));
+      forms++;
+      if (forms == 2) {
+        kept = akx_cell_promote(cell);
+      }
+      if (forms == 3) {
+        ak_source_loc_t loc = akx_cell_location(cell);
+        ASSERT_EQ(loc.line, 5);
+        ASSERT_EQ(loc.column, 9);
+      }
+      if (forms == 4) {
+        assert_symbol(cell->value.list_head, "d");
+        ASSERT_EQ(akx_cell_location(cell).line, 6);
+      }
+    }
+    akx_parse_result_free(&result);
+  }
+  akx_cell_stream_close(stream);
+  remove(path);
+
+  ASSERT_EQ(forms, 4);
+  ASSERT_NOT_NULL(kept);
+  assert_string(kept->value.list_head->next, "two\nlines");
+  ak_source_range_t range = akx_cell_range(kept);
+  ASSERT_EQ(range.start.line, 4);
+  ASSERT_EQ(range.start.column, 3);
+  ASSERT_EQ(range.end.line, 5);
+  ASSERT_STREQ(ak_source_file_name(akx_cell_source_file(kept)), path);
+  akx_cell_free(kept);
+}
+
+static void test_stream_error_location(void) {
+  printf("  test_stream_error_location...\n");
+
+  char path[TEST_FILENAME_MAX_SIZE_MAX * 2];
+  akx_cell_stream_t *stream = open_string_as_stream(
+      "(ok 1)\n(ok 2)\n  (broken [x)\n(never)\n", "stream_error", path,
+      sizeof(path));
+  ASSERT_NOT_NULL(stream);
+
+  size_t forms = 0;
+  int saw_error = 0;
+  akx_parse_result_t result;
+  while (akx_cell_stream_next(stream, &result) > 0) {
+    forms += list_count(&result.cells);
+    if (result.errors) {
+      saw_error = 1;
+      ASSERT_EQ(result.errors->location.line, 3);
+      ASSERT_EQ(result.errors->location.column, 11);
+    }
+    akx_parse_result_free(&result);
+  }
+  akx_cell_stream_close(stream);
+  remove(path);
+
+  ASSERT_EQ(forms, 2);
+  ASSERT_TRUE(saw_error);
+}
+
+static void test_lex_primitives_across_blocks(void) {
+  printf("  test_lex_primitives_across_blocks...\n");
+
+  static const char delims[] = " \t\n;\"()[]{}>";
+  uint8_t buf[96];
+
+  for (size_t len = 0; len <= sizeof(buf); len++) {
+    for (size_t at = 0; at <= len; at++) {
+      memset(buf, 'a', sizeof(buf));
+      ASSERT_EQ(akx_cell_lex_atom_end(buf, 0, len, '>'), len);
+
+      for (size_t d = 0; at < len && d < sizeof(delims) - 1; d++) {
+        buf[at] = (uint8_t)delims[d];
+        ASSERT_EQ(akx_cell_lex_atom_end(buf, 0, len, '>'), at);
+      }
+      if (at < len) {
+        buf[at] = '>';
+        ASSERT_EQ(akx_cell_lex_atom_end(buf, 0, len, ')'), len);
+      }
+
+      memset(buf, 'a', sizeof(buf));
+      if (at < len) {
+        buf[at] = '\\';
+      }
+      ASSERT_EQ(akx_cell_lex_find_quote(buf, 0, len), at);
+      if (at < len) {
+        buf[at] = '\n';
+      }
+      ASSERT_EQ(akx_cell_lex_find_newline(buf, 0, len), at);
+
+      memset(buf, ' ', sizeof(buf));
+      if (at < len) {
+        buf[at] = 'x';
+      }
+      for (size_t nl = 0; nl < len; nl += 7) {
+        buf[nl] = nl == at ? 'x' : '\r';
+        int newline = 0;
+        ASSERT_EQ(akx_cell_lex_skip_space(buf, 0, len, &newline), at);
+        ASSERT_EQ(newline, nl < at ? 1 : 0);
+        buf[nl] = nl == at ? 'x' : ' ';
+      }
+    }
+  }
+
+  const char *blank = "  ; first\n\t; second ; still\n  x";
+  size_t blank_len = strlen(blank);
+  ASSERT_EQ(akx_cell_lex_skip_blank((const uint8_t *)blank, 0, blank_len),
+            blank_len - 1);
+}
+
+static void test_long_string_escapes(void) {
+  printf("  test_long_string_escapes...\n");
+
+  akx_cell_t *cells = parse_string_as_file(
+      "put \"0123456789abcdef0123456789\\tabcdef0123456789abcdef\\\"q\\\\\" "
+      "\"plain text that spans more than one thirty-two byte block\"",
+      "long_escapes");
+  ASSERT_NOT_NULL(cells);
+  assert_list_length(cells, 3);
+  assert_string(cells->value.list_head->next,
+                "0123456789abcdef0123456789\tabcdef0123456789abcdef\"q\\");
+  assert_string(cells->value.list_head->next->next,
+                "plain text that spans more than one thirty-two byte block");
+
+  akx_cell_free(cells);
+}
+
+static void test_small_int_immediates(void) {
+  printf("  test_small_int_immediates...\n");
+
+  akx_cell_t *seven = akx_cell_small_int(7);
+  ASSERT_NOT_NULL(seven);
+  ASSERT_TRUE(seven == akx_cell_small_int(7));
+  ASSERT_TRUE(seven->flags & AKX_CELL_FLAG_IMMEDIATE);
+  assert_integer(seven, 7);
+  assert_integer(akx_cell_small_int(AKX_CELL_SMALL_INT_MIN),
+                 AKX_CELL_SMALL_INT_MIN);
+  assert_integer(akx_cell_small_int(AKX_CELL_SMALL_INT_MAX),
+                 AKX_CELL_SMALL_INT_MAX);
+  ASSERT_NULL(akx_cell_small_int(AKX_CELL_SMALL_INT_MIN - 1));
+  ASSERT_NULL(akx_cell_small_int(AKX_CELL_SMALL_INT_MAX + 1));
+
+  // Freeing an immediate is a no-op; clones are ordinary heap cells
+  akx_cell_free(seven);
+  assert_integer(akx_cell_small_int(7), 7);
+
+  akx_cell_t *copy = akx_cell_clone(seven);
+  ASSERT_NOT_NULL(copy);
+  ASSERT_TRUE(copy != seven);
+  ASSERT_EQ(copy->flags & AKX_CELL_FLAG_IMMEDIATE, 0);
+  assert_integer(copy, 7);
+  akx_cell_free(copy);
+}
+
+static void test_retain_shares_cells(void) {
+  printf("  test_retain_shares_cells...\n");
+
+  akx_cell_t *cells = parse_string_as_file("(1 (2 3) \"s\")", "retain");
+  ASSERT_NOT_NULL(cells);
+  akx_cell_t *list = akx_cell_promote(cells);
+  akx_cell_free(cells);
+  ASSERT_NOT_NULL(list);
+  ASSERT_FALSE(akx_cell_is_shared(list));
+
+  akx_cell_t *shared = akx_cell_retain(list);
+  ASSERT_TRUE(shared == list);
+  ASSERT_TRUE(akx_cell_is_shared(list));
+
+  // Dropping one owner leaves the tree intact for the other
+  akx_cell_free(shared);
+  ASSERT_FALSE(akx_cell_is_shared(list));
+  assert_list_length(list, 3);
+  assert_integer(list->value.list_head, 1);
+
+  // Linked cells are copied rather than shared
+  akx_cell_t *head = list->value.list_head;
+  akx_cell_t *copy = akx_cell_retain(head);
+  ASSERT_TRUE(copy != head);
+  ASSERT_NULL(copy->next);
+  ASSERT_FALSE(akx_cell_is_shared(head));
+  akx_cell_free(copy);
+
+  // Saturated cells are copied as well
+  list->refs = UINT16_MAX;
+  copy = akx_cell_retain(list);
+  ASSERT_TRUE(copy != list);
+  ASSERT_EQ(copy->refs, 0);
+  assert_list_length(copy, 3);
+  akx_cell_free(copy);
+  list->refs = 0;
+
+  akx_cell_free(list);
+}
+
+typedef struct {
+  void *blocks[16];
+  size_t count;
+} test_heap_t;
+
+static void *test_heap_alloc(void *user, size_t size) {
+  test_heap_t *heap = user;
+  if (heap->count == 16) {
+    return NULL;
+  }
+  void *block = malloc(size);
+  heap->blocks[heap->count++] = block;
+  return block;
+}
+
+static void test_heap_hook_tracks_cells(void) {
+  printf("  test_heap_hook_tracks_cells...\n");
+
+  akx_cell_t *cells = parse_string_as_file("(1 \"s\")", "heap");
+  ASSERT_NOT_NULL(cells);
+
+  test_heap_t heap = {0};
+  akx_cell_heap_t hook = {test_heap_alloc, &heap};
+  akx_cell_set_heap(&hook);
+  akx_cell_t *list = akx_cell_promote(cells);
+  akx_cell_set_heap(NULL);
+  akx_cell_free(cells);
+
+  ASSERT_NOT_NULL(list);
+  ASSERT_EQ(heap.count, 3);
+  ASSERT_TRUE(list->flags & AKX_CELL_FLAG_TRACKED);
+
+  // Freeing tracked cells leaves them for the collector
+  akx_cell_free(list);
+  assert_list_length(list, 2);
+  assert_integer(list->value.list_head, 1);
+
+  akx_cell_t *children[2];
+  ASSERT_EQ(akx_cell_children(list, children), 1);
+  ASSERT_TRUE(children[0] == list->value.list_head);
+
+  // Once the hook is gone cells come from the regular allocator again
+  akx_cell_t *plain = akx_cell_new(AKX_TYPE_INTEGER_LITERAL);
+  ASSERT_NOT_NULL(plain);
+  ASSERT_EQ(plain->flags & AKX_CELL_FLAG_TRACKED, 0);
+  ASSERT_EQ(heap.count, 3);
+  akx_cell_free(plain);
+
+  for (size_t i = 0; i < heap.count; i++) {
+    akx_cell_destroy(heap.blocks[i]);
+  }
+  for (size_t i = 0; i < heap.count; i++) {
+    free(heap.blocks[i]);
+  }
+}
+
+typedef struct {
+  size_t allocated;
+  size_t freed;
+  size_t freed_bytes;
+} test_pool_t;
+
+static void *test_pool_alloc(void *user, size_t size) {
+  ((test_pool_t *)user)->allocated++;
+  return malloc(size);
+}
+
+static void test_pool_free(void *user, void *ptr, size_t size) {
+  test_pool_t *pool = user;
+  pool->freed++;
+  pool->freed_bytes += size;
+  free(ptr);
+}
+
+static void test_pool_hook_returns_cells(void) {
+  printf("  test_pool_hook_returns_cells...\n");
+
+  test_pool_t pool = {0};
+  akx_cell_pool_t hook = {test_pool_alloc, test_pool_free, &pool};
+  akx_cell_set_pool(&hook);
+
+  akx_cell_t *cont = akx_cell_new(AKX_TYPE_CONTINUATION);
+  ASSERT_NOT_NULL(cont);
+  ASSERT_TRUE(cont->flags & AKX_CELL_FLAG_POOLED);
+  ASSERT_NOT_NULL(akx_cell_alloc_continuation(cont));
+  ASSERT_NULL(cont->value.continuation->args);
+  ASSERT_EQ(pool.allocated, 2);
+
+  // Cell and frame both go back with the sizes they were allocated with
+  akx_cell_free(cont);
+  ASSERT_EQ(pool.freed, 2);
+  ASSERT_EQ(pool.freed_bytes,
+            sizeof(akx_cell_t) + sizeof(akx_continuation_t));
+
+  // Clones of parsed cells drop the span, so they fit the plain cell size
+  akx_cell_t *cells = parse_string_as_file("(1 'x)", "pool");
+  ASSERT_NOT_NULL(cells);
+  akx_cell_t *list = akx_cell_promote(cells);
+  akx_cell_free(cells);
+  ASSERT_NOT_NULL(list);
+  ASSERT_TRUE(list->flags & AKX_CELL_FLAG_POOLED);
+  assert_list_length(list, 2);
+  akx_cell_free(list);
+  ASSERT_EQ(pool.freed, pool.allocated);
+
+  akx_cell_set_pool(NULL);
+  akx_cell_t *plain = akx_cell_new(AKX_TYPE_INTEGER_LITERAL);
+  ASSERT_NOT_NULL(plain);
+  ASSERT_EQ(plain->flags & AKX_CELL_FLAG_POOLED, 0);
+  akx_cell_free(plain);
+  ASSERT_EQ(pool.freed, pool.allocated);
+}
+
+static void test_pool_cell_freed_without_pool(void) {
+  printf("  test_pool_cell_freed_without_pool...\n");
+
+  test_pool_t pool = {0};
+  akx_cell_pool_t hook = {test_pool_alloc, test_pool_free, &pool};
+  akx_cell_set_pool(&hook);
+  akx_cell_t *cont = akx_cell_new(AKX_TYPE_CONTINUATION);
+  ASSERT_NOT_NULL(cont);
+  akx_cell_set_pool(NULL);
+
+  // With its pool gone the cell gets no frame and is leaked, not freed
+  ASSERT_NULL(akx_cell_alloc_continuation(cont));
+  akx_cell_free(cont);
+  ASSERT_EQ(pool.allocated, 1);
+  ASSERT_EQ(pool.freed, 0);
+  free(cont);
+}
+
+static void test_site_slots(void) {
+  printf("  test_site_slots...\n");
+
+  akx_cell_t *cells = parse_string_as_file("(f (g 1) x)", "site");
+  ASSERT_NOT_NULL(cells);
+
+  akx_cell_site_t *site = akx_cell_site(cells);
+  ASSERT_NOT_NULL(site);
+  ASSERT_EQ(site->generation, 0);
+  ASSERT_EQ(site->kind, 0);
+  ASSERT_NULL(site->target);
+  akx_cell_t *inner = cells->value.list_head->next;
+  ASSERT_NOT_NULL(akx_cell_site(inner));
+  ASSERT_NOT_NULL(akx_cell_site(cells->value.list_head));
+  ASSERT_NOT_NULL(akx_cell_site(inner->next));
+  ASSERT_NULL(akx_cell_site(inner->value.list_head->next));
+
+  // The slot sits after the span and leaves it intact
+  site->generation = 7;
+  site->target = cells;
+  ak_source_loc_t loc = akx_cell_location(cells);
+  ASSERT_EQ(loc.line, 1);
+  ASSERT_EQ(loc.column, 1);
+
+  // Copies of parsed code get a fresh slot; lists built at runtime get none
+  akx_cell_t *copy = akx_cell_promote(cells);
+  ASSERT_NOT_NULL(copy);
+  ASSERT_NOT_NULL(akx_cell_site(copy));
+  ASSERT_EQ(akx_cell_site(copy)->generation, 0);
+  akx_cell_free(copy);
+
+  akx_cell_t *list = akx_cell_new(AKX_TYPE_LIST);
+  ASSERT_NOT_NULL(list);
+  ASSERT_NULL(akx_cell_site(list));
+  akx_cell_free(list);
+
+  akx_cell_free(cells);
+}
+
 void run_all_tests(void) {
   printf("Running akx_cell tests...\n");
 
@@ -1480,6 +2384,11 @@ void run_all_tests(void) {
   test_string_literals();
   test_string_with_single_char();
   test_symbols();
+  test_wide_integer_literals();
+
+  printf("\n=== Bignum Tests ===\n");
+  test_bignum_arithmetic();
+  test_bignum_karatsuba();
 
   printf("\n=== Virtual Lists ===\n");
   test_simple_virtual_list();
@@ -1502,6 +2411,8 @@ void run_all_tests(void) {
   test_quoted_list();
   test_quoted_virtual_list();
   test_unwrap_quoted();
+  test_unwrap_quoted_uses_parsed_tree();
+  test_unwrap_quoted_shares_arena_view();
 
   printf("\n=== Multiple Expressions ===\n");
   test_multiple_expressions();
@@ -1536,11 +2447,16 @@ void run_all_tests(void) {
   test_adjacent_nested_lists();
   test_deeply_nested_empty();
   test_whitespace_in_deep_nesting();
+  test_delimiters_in_strings_and_comments();
+  test_very_deep_nesting();
+  test_unterminated_nested_list_location();
 
   printf("\n=== Data Integrity Checks ===\n");
   test_symbol_identity_nested();
   test_list_chain_integrity();
   test_sourceloc_nested();
+  test_location_resolved_on_demand();
+  test_site_slots();
 
   printf("\n=== Clone Tests ===\n");
   test_clone_simple_types();
@@ -1554,6 +2470,30 @@ void run_all_tests(void) {
   test_clone_independence();
   test_clone_sourceloc_preservation();
   test_clone_null_cell();
+  test_clone_long_list();
+  test_clone_deep_nesting();
+
+  printf("\n=== Arena Tests ===\n");
+  test_arena_owns_parsed_cells();
+  test_promote_outlives_parse_result();
+
+  printf("\n=== Sharing Tests ===\n");
+  test_small_int_immediates();
+  test_retain_shares_cells();
+  test_heap_hook_tracks_cells();
+  test_pool_hook_returns_cells();
+  test_pool_cell_freed_without_pool();
+
+  printf("\n=== Serialization Tests ===\n");
+  test_serialize_round_trip();
+
+  printf("\n=== Streaming Tests ===\n");
+  test_stream_forms_and_locations();
+  test_stream_error_location();
+
+  printf("\n=== Lexer Tests (%s) ===\n", akx_cell_lex_backend());
+  test_lex_primitives_across_blocks();
+  test_long_string_escapes();
 
   printf("\nAll tests passed!\n");
 }
@@ -12,9 +12,14 @@ static void display_cell_internal(akx_cell_t *cell) {
   }
 
   switch (cell->type) {
-  case AKX_TYPE_INTEGER_LITERAL:
-    printf("%d", cell->value.integer_literal);
+  case AKX_TYPE_INTEGER_LITERAL: {
+    ak_buffer_t *digits = akx_rt_int_to_buffer(cell);
+    if (digits) {
+      printf("%s", (const char *)ak_buffer_data(digits));
+      ak_buffer_free(digits);
+    }
     break;
+  }
 
   case AKX_TYPE_REAL_LITERAL:
     printf("%f", cell->value.real_literal);
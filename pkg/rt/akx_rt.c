@@ -1,5 +1,10 @@
 #include "akx_rt.h"
 #include "akx_rt_builtins.h"
+#include "akx_rt_gc.h"
+#include "akx_rt_slab.h"
+#include "akx_rt_jit.h"
+#include "akx_rt_vm.h"
+#include "akx_rt_aot.h"
 #include "builtin_registry.h"
 #include <ak24/buffer.h>
 #include <ak24/filepath.h>
@@ -10,26 +15,234 @@
 #include <signal.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#define AKX_RT_IMMEDIATE_SYMBOL_COUNT 4
+#define AKX_RT_FRAME_CHUNK_SIZE (64 * 1024)
+// Frames with more slots than this keep them on the heap, so any frame fits
+// in a fresh chunk
+#define AKX_RT_FRAME_INLINE_SLOTS 64
+#define AKX_RT_FRAME_DEFAULT_SLOTS 4
+#define AKX_RT_SHADOW_INITIAL_CAPACITY 64
+
 struct akx_rt_error_ctx_t {
   int error_count;
   akx_parse_error_t *errors;
 };
 
+// The frame stack: chunks are kept once allocated and reused as it regrows
+typedef struct frame_chunk_t {
+  struct frame_chunk_t *prev;
+  struct frame_chunk_t *next;
+  char *end;
+} frame_chunk_t;
+
+#define AKX_RT_FRAME_CHUNK_HEADER ((sizeof(frame_chunk_t) + 15) & ~(size_t)15)
+
+static char *chunk_data(frame_chunk_t *chunk) {
+  return (char *)chunk + AKX_RT_FRAME_CHUNK_HEADER;
+}
+
+// One level of the scope chain. Lambda calls and loop iterations get flat
+// frames on the frame stack, a name and value slot per parameter and let;
+// the global scope, and frames handed out as an ak_context_t, keep their
+// values in a map and only list their names.
+struct akx_rt_scope_t {
+  akx_rt_scope_t *parent;
+  // Lambda frames: the lambda, and the next lambda frame out
+  const void *owner;
+  akx_rt_scope_t *caller;
+  ak_context_t *map;
+  const char **names;
+  void **values;
+  uint32_t count;
+  uint32_t capacity;
+  int heap;
+  // Frame stack position to return to when the frame is popped
+  frame_chunk_t *chunk;
+  char *top;
+};
+
+// What the stack evaluator does with the next value it produces
+enum {
+  // Pop the frame of a lambda call whose body is done
+  KONT_RETURN,
+  // Evaluate the rest of a lambda body or begin
+  KONT_SEQ,
+  // Take a branch of an if
+  KONT_IF,
+  // Bind a lambda call's next parameter
+  KONT_BIND,
+  // Collect a strict builtin's next argument
+  KONT_STRICT,
+  // Call the lambda a computed call head evaluated to
+  KONT_HEAD,
+};
+
+typedef struct {
+  uint32_t kind;
+  // KONT_BIND: the parameter being bound; KONT_STRICT: where its arguments
+  // start on the value stack
+  uint32_t index;
+  // Expressions still to evaluate
+  akx_cell_t *expr;
+  akx_lambda_context_t *lambda_ctx;
+  akx_builtin_info_t *info;
+  // A lambda made by evaluating a call head, freed when its call returns
+  akx_cell_t *owned;
+} kont_t;
+
+#define AKX_RT_KONT_CHUNK 512
+
+typedef struct kont_chunk_t {
+  struct kont_chunk_t *prev;
+  struct kont_chunk_t *next;
+  kont_t konts[AKX_RT_KONT_CHUNK];
+} kont_chunk_t;
+
+// How many scopes other than the global one bind a name
+typedef struct {
+  const char *name;
+  uint32_t count;
+} shadow_t;
+
 struct akx_runtime_ctx_t {
   int initialized;
   akx_rt_error_ctx_t *error_ctx;
-  ak_context_t *current_context;
+  akx_rt_scope_t global;
+  akx_rt_scope_t *scope;
+  akx_rt_scope_t *frame;
+  frame_chunk_t *stack_chunk;
+  char *stack_top;
+  // Lets a lookup of a name no frame binds go straight to the global scope;
+  // if the table cannot grow, every lookup walks the chain instead
+  shadow_t *shadows;
+  size_t shadow_count;
+  size_t shadow_capacity;
+  int shadows_lost;
   map_void_t builtins;
   list_t(ak_cjit_unit_t *) cjit_units;
-  const char *current_module_name;
+  akx_builtin_info_t *current_builtin;
+  // Set while a builtin called in tail position runs
   int in_tail_position;
+  // Every tail call returns this immediate continuation, naming its lambda
+  // in tail_cont, so taking one allocates nothing
+  akx_cell_t tail_cell;
+  akx_continuation_t tail_cont;
+  // Bindings of that call, made over the caller's frame and rebound by the
+  // trampoline after it is popped
+  const char **tail_names;
+  akx_cell_t **tail_args;
+  size_t tail_argc;
+  size_t tail_capacity;
+  // AKX_ENGINE=stack: lists are evaluated on an explicit continuation
+  // stack, with strict builtin arguments gathered on a value stack
+  int stack_engine;
+  // AKX_QUICKEN=0 leaves builtin call sites generic
+  int quicken;
+  kont_chunk_t *kont_chunk;
+  size_t kont_used;
+  size_t kont_depth;
+  akx_value_t *kont_values;
+  size_t kont_value_count;
+  size_t kont_value_capacity;
+  const char *if_name;
+  const char *begin_name;
+  // --engine=vm: top-level forms and lambda bodies run as bytecode
+  akx_rt_vm_t *vm;
+  // AKX_JIT=1: hot lambdas the tree walker calls run as native code
+  akx_rt_jit_t *jit;
+  // akx compile: calls lowered to C, indexed by their sites
+  const akx_rt_aot_site_t *native_sites;
+  size_t native_site_count;
   int script_argc;
   char **script_argv;
+  akx_cell_t symbols[AKX_RT_IMMEDIATE_SYMBOL_COUNT];
+  akx_rt_gc_t *gc;
+  akx_rt_slab_t *slab;
+};
+
+static const char *immediate_symbol_names[AKX_RT_IMMEDIATE_SYMBOL_COUNT] = {
+    "nil", "t", "true", "false"};
+
+// Call sites cache builtin lookups stamped with this; registering or
+// reloading any builtin moves it on, so stale entries miss. Never 0, which
+// marks an empty call site.
+static uint32_t g_builtin_generation = 1;
+
+enum {
+  AKX_RT_SITE_BUILTIN = 1,
+  AKX_RT_SITE_NOT_BUILTIN = 2,
+  AKX_RT_SITE_LOCAL = 3,
+  // A builtin call quickened into the int operation in index
+  AKX_RT_SITE_QUICK = 4,
+  // A builtin call left generic until its builtin is next resolved
+  AKX_RT_SITE_GENERIC = 5,
+  // A builtin call akx compile lowered to the native site in index
+  AKX_RT_SITE_NATIVE = 6,
 };
 
+static void next_builtin_generation(void) {
+  if (++g_builtin_generation == 0) {
+    g_builtin_generation = 1;
+  }
+}
+
+static akx_builtin_info_t *resolve_builtin(akx_runtime_ctx_t *rt,
+                                           akx_cell_t *call,
+                                           const char *name) {
+  akx_cell_site_t *site = akx_cell_site(call);
+  if (site && site->generation == g_builtin_generation) {
+    return (akx_builtin_info_t *)site->target;
+  }
+
+  void **builtin_ptr = map_get_generic(&rt->builtins, &name);
+  akx_builtin_info_t *info =
+      builtin_ptr ? (akx_builtin_info_t *)*builtin_ptr : NULL;
+  if (site) {
+    site->generation = g_builtin_generation;
+    site->kind =
+        info ? AKX_RT_SITE_BUILTIN : AKX_RT_SITE_NOT_BUILTIN;
+    site->target = info;
+  }
+  return info;
+}
+
+uint32_t akx_rt_builtin_generation(void) { return g_builtin_generation; }
+
+void akx_rt_bind_native_site(akx_cell_t *call, akx_builtin_info_t *info,
+                             uint16_t index) {
+  akx_cell_site_t *site = akx_cell_site(call);
+  if (site && info) {
+    site->generation = g_builtin_generation;
+    site->kind = AKX_RT_SITE_NATIVE;
+    site->index = index;
+    site->target = info;
+  }
+}
+
+void akx_rt_set_native_sites(akx_runtime_ctx_t *rt,
+                             const akx_rt_aot_site_t *sites, size_t count) {
+  rt->native_sites = sites;
+  rt->native_site_count = count;
+}
+
+int akx_rt_native_bound(akx_cell_t *call) {
+  akx_cell_site_t *site = akx_cell_site(call);
+  return site && site->kind == AKX_RT_SITE_NATIVE &&
+         site->generation == g_builtin_generation;
+}
+
+static int env_flag(const char *name, int fallback) {
+  const char *flag = getenv(name);
+  if (!flag || !flag[0]) {
+    return fallback;
+  }
+  return strcmp(flag, "0") != 0;
+}
+
 akx_runtime_ctx_t *akx_runtime_init(void) {
   akx_runtime_ctx_t *ctx = AK24_ALLOC(sizeof(akx_runtime_ctx_t));
   if (!ctx) {
@@ -48,27 +261,103 @@ akx_runtime_ctx_t *akx_runtime_init(void) {
   ctx->error_ctx->error_count = 0;
   ctx->error_ctx->errors = NULL;
 
-  ctx->current_context = ak_context_new();
-  if (!ctx->current_context) {
+  memset(&ctx->global, 0, sizeof(akx_rt_scope_t));
+  ctx->global.map = ak_context_new();
+  ctx->stack_chunk = AK24_ALLOC(AKX_RT_FRAME_CHUNK_SIZE);
+  if (!ctx->global.map || !ctx->stack_chunk) {
     AK24_LOG_ERROR("Failed to create runtime context");
+    if (ctx->global.map) {
+      ak_context_free(ctx->global.map);
+    }
+    if (ctx->stack_chunk) {
+      AK24_FREE(ctx->stack_chunk);
+    }
     AK24_FREE(ctx->error_ctx);
     AK24_FREE(ctx);
     return NULL;
   }
+  ctx->stack_chunk->prev = NULL;
+  ctx->stack_chunk->next = NULL;
+  ctx->stack_chunk->end = (char *)ctx->stack_chunk + AKX_RT_FRAME_CHUNK_SIZE;
+  ctx->stack_top = chunk_data(ctx->stack_chunk);
+  ctx->scope = &ctx->global;
+  ctx->frame = NULL;
+  ctx->shadows = NULL;
+  ctx->shadow_count = 0;
+  ctx->shadow_capacity = 0;
+  ctx->shadows_lost = 0;
+
+  ctx->slab = NULL;
+  if (env_flag("AKX_SLAB", 0)) {
+    ctx->slab = akx_rt_slab_new(env_flag("AKX_SLAB_HUGEPAGES", 0));
+    if (!ctx->slab) {
+      AK24_LOG_ERROR("Slab allocator unavailable, using the general heap");
+    } else if (akx_rt_slab_install(ctx->slab) != 0) {
+      // Same thread, so sharing that runtime's pool takes no locks
+      AK24_LOG_TRACE("Cell pool on this thread belongs to another runtime");
+    }
+  }
+
+  ctx->gc = NULL;
+  if (env_flag("AKX_GC", 0)) {
+    ctx->gc = akx_rt_gc_new(ctx->slab);
+    if (!ctx->gc) {
+      AK24_LOG_ERROR("Collector unavailable, cells will be freed explicitly");
+    }
+  }
 
   map_init_generic(&ctx->builtins, sizeof(char *), map_hash_str, map_cmp_str);
   list_init(&ctx->cjit_units);
-  ctx->current_module_name = NULL;
+  ctx->current_builtin = NULL;
   ctx->in_tail_position = 0;
+  akx_cell_init_immediate(&ctx->tail_cell, AKX_TYPE_CONTINUATION);
+  ctx->tail_cell.value.continuation = &ctx->tail_cont;
+  ctx->tail_cont.lambda_cell = NULL;
+  ctx->tail_cont.args = NULL;
+  ctx->tail_names = NULL;
+  ctx->tail_args = NULL;
+  ctx->tail_argc = 0;
+  ctx->tail_capacity = 0;
+  ctx->stack_engine = 0;
+  ctx->quicken = env_flag("AKX_QUICKEN", 1);
+  ctx->vm = NULL;
+  ctx->kont_chunk = NULL;
+  ctx->kont_used = 0;
+  ctx->kont_depth = 0;
+  ctx->kont_values = NULL;
+  ctx->kont_value_count = 0;
+  ctx->kont_value_capacity = 0;
+  ctx->if_name = ak_intern("if");
+  ctx->begin_name = ak_intern("begin");
+  const char *engine = getenv("AKX_ENGINE");
+  if (engine && engine[0] && akx_runtime_set_engine(ctx, engine) != 0) {
+    AK24_LOG_ERROR("Unknown engine '%s', using the tree walker", engine);
+  }
   ctx->script_argc = 0;
   ctx->script_argv = NULL;
 
+  ctx->native_sites = NULL;
+  ctx->native_site_count = 0;
+
+  ctx->jit = NULL;
+  if (env_flag("AKX_JIT", 0)) {
+    const char *threshold = getenv("AKX_JIT_THRESHOLD");
+    ctx->jit = akx_rt_jit_new(
+        ctx, threshold ? (uint32_t)strtoul(threshold, NULL, 10) : 0);
+    if (!ctx->jit) {
+      AK24_LOG_ERROR("JIT unavailable, lambdas stay interpreted");
+    }
+  }
+
+  for (size_t i = 0; i < AKX_RT_IMMEDIATE_SYMBOL_COUNT; i++) {
+    akx_cell_init_immediate(&ctx->symbols[i], AKX_TYPE_SYMBOL);
+    ctx->symbols[i].value.symbol = ak_intern(immediate_symbol_names[i]);
+  }
+
   akx_rt_register_bootstrap_builtins(ctx);
   akx_rt_register_compiled_nuclei(ctx);
 
-  akx_cell_t *nil_cell = akx_rt_alloc_cell(ctx, AKX_TYPE_SYMBOL);
-  akx_rt_set_symbol(ctx, nil_cell, "nil");
-  akx_rt_scope_set(ctx, "nil", nil_cell);
+  akx_rt_scope_set(ctx, "nil", akx_rt_nil(ctx));
 
   AK24_LOG_TRACE("AKX runtime initialized");
 
@@ -86,12 +375,25 @@ void akx_runtime_deinit(akx_runtime_ctx_t *ctx) {
     void **info_ptr = map_get_generic(&ctx->builtins, key_ptr);
     if (info_ptr && *info_ptr) {
       akx_builtin_info_t *info = (akx_builtin_info_t *)*info_ptr;
-
       if (info->deinit_fn) {
-        ctx->current_module_name = info->module_name;
+        ctx->current_builtin = info;
         info->deinit_fn(ctx);
-        ctx->current_module_name = NULL;
+        ctx->current_builtin = NULL;
       }
+    }
+  }
+
+  // Collected lambdas may still call into CJIT units, so cells go first
+  akx_rt_gc_free(ctx->gc);
+  ctx->gc = NULL;
+  akx_rt_vm_free(ctx->vm);
+  ctx->vm = NULL;
+
+  iter = map_iter(&ctx->builtins);
+  while ((key_ptr = (const char **)map_next_generic(&ctx->builtins, &iter))) {
+    void **info_ptr = map_get_generic(&ctx->builtins, key_ptr);
+    if (info_ptr && *info_ptr) {
+      akx_builtin_info_t *info = (akx_builtin_info_t *)*info_ptr;
 
       if (info->unit) {
         ak_cjit_unit_free(info->unit);
@@ -114,10 +416,37 @@ void akx_runtime_deinit(akx_runtime_ctx_t *ctx) {
   }
   list_deinit(&ctx->cjit_units);
 
-  while (ctx->current_context) {
-    ak_context_t *parent = ctx->current_context->parent;
-    ak_context_free(ctx->current_context);
-    ctx->current_context = parent;
+  while (ctx->scope != &ctx->global) {
+    akx_rt_pop_scope(ctx);
+  }
+  ak_context_free(ctx->global.map);
+  if (ctx->global.heap) {
+    AK24_FREE(ctx->global.names);
+  }
+  if (ctx->shadows) {
+    AK24_FREE(ctx->shadows);
+  }
+  if (ctx->tail_names) {
+    AK24_FREE(ctx->tail_names);
+  }
+  while (ctx->kont_chunk && ctx->kont_chunk->next) {
+    ctx->kont_chunk = ctx->kont_chunk->next;
+  }
+  while (ctx->kont_chunk) {
+    kont_chunk_t *prev = ctx->kont_chunk->prev;
+    AK24_FREE(ctx->kont_chunk);
+    ctx->kont_chunk = prev;
+  }
+  if (ctx->kont_values) {
+    AK24_FREE(ctx->kont_values);
+  }
+  while (ctx->stack_chunk->next) {
+    ctx->stack_chunk = ctx->stack_chunk->next;
+  }
+  while (ctx->stack_chunk) {
+    frame_chunk_t *prev = ctx->stack_chunk->prev;
+    AK24_FREE(ctx->stack_chunk);
+    ctx->stack_chunk = prev;
   }
 
   if (ctx->error_ctx) {
@@ -130,6 +459,13 @@ void akx_runtime_deinit(akx_runtime_ctx_t *ctx) {
     AK24_FREE(ctx->error_ctx);
   }
 
+  // After the lambdas, which may have handed code to the JIT's worker
+  akx_rt_jit_free(ctx->jit);
+  ctx->jit = NULL;
+
+  akx_rt_slab_free(ctx->slab);
+  ctx->slab = NULL;
+
   AK24_LOG_TRACE("AKX runtime deinitialized");
 
   AK24_FREE(ctx);
@@ -149,7 +485,9 @@ int akx_runtime_start(akx_runtime_ctx_t *ctx, akx_cell_list_t *cells) {
   list_iter_t iter = list_iter(cells);
   akx_cell_t **cell_ptr;
   while ((cell_ptr = list_next(cells, &iter))) {
-    akx_cell_t *result = akx_rt_eval(ctx, *cell_ptr);
+    akx_rt_gc_safepoint(ctx);
+    akx_cell_t *result = ctx->vm ? akx_rt_vm_eval(ctx->vm, *cell_ptr)
+                                 : akx_rt_eval(ctx, *cell_ptr);
     if (!result) {
       if (ctx->error_ctx && ctx->error_ctx->error_count > 0) {
         akx_parse_error_t *err = ctx->error_ctx->errors;
@@ -166,11 +504,42 @@ int akx_runtime_start(akx_runtime_ctx_t *ctx, akx_cell_list_t *cells) {
   return 0;
 }
 
+int akx_runtime_set_engine(akx_runtime_ctx_t *ctx, const char *name) {
+  if (!ctx || !name) {
+    return -1;
+  }
+  int stack = strcmp(name, "stack") == 0;
+  int vm = strcmp(name, "vm") == 0;
+  if (!stack && !vm && strcmp(name, "tree") != 0) {
+    return -1;
+  }
+  if (vm && !ctx->vm) {
+    ctx->vm = akx_rt_vm_new(ctx);
+    if (!ctx->vm) {
+      return -1;
+    }
+  } else if (!vm && ctx->vm) {
+    akx_rt_vm_free(ctx->vm);
+    ctx->vm = NULL;
+  }
+  ctx->stack_engine = stack;
+  return 0;
+}
+
+void akx_runtime_set_quicken(akx_runtime_ctx_t *ctx, int enabled) {
+  if (!ctx) {
+    return;
+  }
+  ctx->quicken = enabled;
+  // Quickened sites fall back to plain builtin calls
+  next_builtin_generation();
+}
+
 ak_context_t *akx_runtime_get_current_scope(akx_runtime_ctx_t *ctx) {
   if (!ctx) {
     return NULL;
   }
-  return ctx->current_context;
+  return akx_rt_get_scope(ctx);
 }
 
 akx_parse_error_t *akx_runtime_get_errors(akx_runtime_ctx_t *ctx) {
@@ -182,42 +551,101 @@ akx_parse_error_t *akx_runtime_get_errors(akx_runtime_ctx_t *ctx) {
 
 akx_cell_t *akx_rt_alloc_cell(akx_runtime_ctx_t *rt, akx_type_t type) {
   (void)rt;
-  akx_cell_t *cell = AK24_ALLOC(sizeof(akx_cell_t));
-  if (!cell) {
-    return NULL;
+  return akx_cell_new(type);
+}
+
+void akx_rt_free_cell(akx_runtime_ctx_t *rt, akx_cell_t *cell) {
+  (void)rt;
+  akx_cell_free(cell);
+}
+
+akx_cell_t *akx_rt_make_int(akx_runtime_ctx_t *rt, int64_t value) {
+  akx_cell_t *cell = akx_cell_small_int(value);
+  if (cell) {
+    return cell;
+  }
+  cell = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
+  if (cell) {
+    cell->value.integer_literal = value;
   }
-  memset(cell, 0, sizeof(akx_cell_t));
-  cell->type = type;
-  cell->next = NULL;
-  cell->sourceloc = NULL;
   return cell;
 }
 
-void akx_rt_free_cell(akx_runtime_ctx_t *rt, akx_cell_t *cell) {
+akx_cell_t *akx_rt_make_symbol(akx_runtime_ctx_t *rt, const char *sym) {
+  const char *interned = ak_intern(sym);
+  for (size_t i = 0; i < AKX_RT_IMMEDIATE_SYMBOL_COUNT; i++) {
+    if (rt->symbols[i].value.symbol == interned) {
+      return &rt->symbols[i];
+    }
+  }
+  akx_cell_t *cell = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
+  if (cell) {
+    cell->value.symbol = interned;
+  }
+  return cell;
+}
+
+akx_cell_t *akx_rt_nil(akx_runtime_ctx_t *rt) { return &rt->symbols[0]; }
+
+akx_cell_t *akx_rt_unshare(akx_runtime_ctx_t *rt, akx_cell_t *cell) {
   (void)rt;
+  if (!akx_cell_is_shared(cell)) {
+    return cell;
+  }
+  akx_cell_t *copy = akx_cell_promote(cell);
   akx_cell_free(cell);
+  return copy;
+}
+
+akx_cell_t *akx_rt_copy(akx_runtime_ctx_t *rt, akx_cell_t *cell) {
+  (void)rt;
+  if (!cell || (cell->flags & AKX_CELL_FLAG_IMMEDIATE)) {
+    return cell;
+  }
+  if (cell->type == AKX_TYPE_INTEGER_LITERAL &&
+      !(cell->flags & AKX_CELL_FLAG_BIGNUM)) {
+    akx_cell_t *small = akx_cell_small_int(cell->value.integer_literal);
+    if (small) {
+      return small;
+    }
+  }
+  return akx_cell_retain(cell);
+}
+
+// Immediates are shared by every holder of that value, so writing one in
+// place would change it for all of them
+static int writable(akx_runtime_ctx_t *rt, akx_cell_t *cell,
+                    const char *setter) {
+  if (!(cell->flags & AKX_CELL_FLAG_IMMEDIATE)) {
+    return 1;
+  }
+  akx_rt_error_fmt(rt, "%s: cell is a shared immediate, akx_rt_unshare() it "
+                       "first", setter);
+  return 0;
 }
 
 void akx_rt_set_symbol(akx_runtime_ctx_t *rt, akx_cell_t *cell,
                        const char *sym) {
-  (void)rt;
-  if (!cell || !sym) {
+  if (!cell || !sym || !writable(rt, cell, "akx_rt_set_symbol")) {
     return;
   }
   cell->value.symbol = ak_intern(sym);
 }
 
-void akx_rt_set_int(akx_runtime_ctx_t *rt, akx_cell_t *cell, int value) {
-  (void)rt;
-  if (!cell) {
+void akx_rt_set_int(akx_runtime_ctx_t *rt, akx_cell_t *cell, int64_t value) {
+  if (!cell || !writable(rt, cell, "akx_rt_set_int")) {
     return;
   }
+  if ((cell->flags & AKX_CELL_FLAG_BIGNUM) &&
+      !(cell->flags & AKX_CELL_FLAG_ARENA)) {
+    akx_bignum_free(cell->value.bignum);
+  }
+  cell->flags &= ~AKX_CELL_FLAG_BIGNUM;
   cell->value.integer_literal = value;
 }
 
 void akx_rt_set_real(akx_runtime_ctx_t *rt, akx_cell_t *cell, double value) {
-  (void)rt;
-  if (!cell) {
+  if (!cell || !writable(rt, cell, "akx_rt_set_real")) {
     return;
   }
   cell->value.real_literal = value;
@@ -225,8 +653,7 @@ void akx_rt_set_real(akx_runtime_ctx_t *rt, akx_cell_t *cell, double value) {
 
 void akx_rt_set_string(akx_runtime_ctx_t *rt, akx_cell_t *cell,
                        const char *str) {
-  (void)rt;
-  if (!cell || !str) {
+  if (!cell || !str || !writable(rt, cell, "akx_rt_set_string")) {
     return;
   }
   size_t len = strlen(str);
@@ -238,8 +665,7 @@ void akx_rt_set_string(akx_runtime_ctx_t *rt, akx_cell_t *cell,
 
 void akx_rt_set_list(akx_runtime_ctx_t *rt, akx_cell_t *cell,
                      akx_cell_t *head) {
-  (void)rt;
-  if (!cell) {
+  if (!cell || !writable(rt, cell, "akx_rt_set_list")) {
     return;
   }
   cell->value.list_head = head;
@@ -247,8 +673,7 @@ void akx_rt_set_list(akx_runtime_ctx_t *rt, akx_cell_t *cell,
 
 void akx_rt_set_lambda(akx_runtime_ctx_t *rt, akx_cell_t *cell,
                        ak_lambda_t *lambda) {
-  (void)rt;
-  if (!cell) {
+  if (!cell || !writable(rt, cell, "akx_rt_set_lambda")) {
     return;
   }
   cell->value.lambda = lambda;
@@ -275,13 +700,238 @@ const char *akx_rt_cell_as_symbol(akx_cell_t *cell) {
   return cell->value.symbol;
 }
 
-int akx_rt_cell_as_int(akx_cell_t *cell) {
-  if (!cell || cell->type != AKX_TYPE_INTEGER_LITERAL) {
+int64_t akx_rt_cell_as_int(akx_cell_t *cell) {
+  if (!cell || cell->type != AKX_TYPE_INTEGER_LITERAL ||
+      (cell->flags & AKX_CELL_FLAG_BIGNUM)) {
     return 0;
   }
   return cell->value.integer_literal;
 }
 
+int akx_rt_cell_to_int(akx_runtime_ctx_t *rt, akx_cell_t *cell,
+                       int64_t *out) {
+  if (!cell || cell->type != AKX_TYPE_INTEGER_LITERAL) {
+    akx_rt_error(rt, "expected an integer");
+    return -1;
+  }
+  if (cell->flags & AKX_CELL_FLAG_BIGNUM) {
+    akx_rt_error(rt, "integer does not fit in 64 bits");
+    return -1;
+  }
+  *out = cell->value.integer_literal;
+  return 0;
+}
+
+int akx_rt_cell_is_bignum(akx_cell_t *cell) {
+  return cell && cell->type == AKX_TYPE_INTEGER_LITERAL &&
+         (cell->flags & AKX_CELL_FLAG_BIGNUM);
+}
+
+// Checked int64 arithmetic; returns 1 when the result does not fit.
+static int int_add_overflow(int64_t a, int64_t b, int64_t *out) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_add_overflow(a, b, out);
+#else
+  if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b)) {
+    return 1;
+  }
+  *out = a + b;
+  return 0;
+#endif
+}
+
+static int int_sub_overflow(int64_t a, int64_t b, int64_t *out) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_sub_overflow(a, b, out);
+#else
+  if ((b < 0 && a > INT64_MAX + b) || (b > 0 && a < INT64_MIN + b)) {
+    return 1;
+  }
+  *out = a - b;
+  return 0;
+#endif
+}
+
+static int int_mul_overflow(int64_t a, int64_t b, int64_t *out) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_mul_overflow(a, b, out);
+#else
+  if (a != 0 && b != 0) {
+    if ((a == -1 && b == INT64_MIN) || (b == -1 && a == INT64_MIN)) {
+      return 1;
+    }
+    if (a != -1 && b != -1 &&
+        (a > 0 ? (b > 0 ? a > INT64_MAX / b : b < INT64_MIN / a)
+               : (b > 0 ? a < INT64_MIN / b : a < INT64_MAX / b))) {
+      return 1;
+    }
+  }
+  *out = a * b;
+  return 0;
+#endif
+}
+
+// Borrows the bignum of a promoted cell, or widens a fixnum into *tmp.
+static const akx_bignum_t *int_as_bignum(akx_cell_t *cell,
+                                         akx_bignum_t **tmp) {
+  *tmp = NULL;
+  if (cell->flags & AKX_CELL_FLAG_BIGNUM) {
+    return cell->value.bignum;
+  }
+  *tmp = akx_bignum_from_i64(cell->value.integer_literal);
+  return *tmp;
+}
+
+// Wraps an owned bignum in a new cell, demoting it when it fits in 64 bits.
+static akx_cell_t *int_from_bignum(akx_runtime_ctx_t *rt, akx_bignum_t *num) {
+  if (!num) {
+    akx_rt_error(rt, "integer: out of memory");
+    return NULL;
+  }
+  akx_cell_t *cell = akx_rt_alloc_cell(rt, AKX_TYPE_INTEGER_LITERAL);
+  if (!cell) {
+    akx_bignum_free(num);
+    return NULL;
+  }
+  int64_t value;
+  if (akx_bignum_to_i64(num, &value)) {
+    akx_rt_free_cell(rt, cell);
+    akx_bignum_free(num);
+    return akx_rt_make_int(rt, value);
+  } else {
+    cell->value.bignum = num;
+    cell->flags |= AKX_CELL_FLAG_BIGNUM;
+  }
+  return cell;
+}
+
+typedef akx_bignum_t *(*int_bignum_op_t)(const akx_bignum_t *,
+                                         const akx_bignum_t *);
+
+static akx_cell_t *int_slow_path(akx_runtime_ctx_t *rt, akx_cell_t *a,
+                                 akx_cell_t *b, int_bignum_op_t op) {
+  akx_bignum_t *ta;
+  akx_bignum_t *tb;
+  const akx_bignum_t *na = int_as_bignum(a, &ta);
+  const akx_bignum_t *nb = int_as_bignum(b, &tb);
+  akx_bignum_t *out = (na && nb) ? op(na, nb) : NULL;
+  akx_bignum_free(ta);
+  akx_bignum_free(tb);
+  return int_from_bignum(rt, out);
+}
+
+akx_cell_t *akx_rt_int_add(akx_runtime_ctx_t *rt, akx_cell_t *a,
+                           akx_cell_t *b) {
+  int64_t out;
+  if (!((a->flags | b->flags) & AKX_CELL_FLAG_BIGNUM) &&
+      !int_add_overflow(a->value.integer_literal, b->value.integer_literal,
+                        &out)) {
+    return akx_rt_make_int(rt, out);
+  }
+  return int_slow_path(rt, a, b, akx_bignum_add);
+}
+
+akx_cell_t *akx_rt_int_sub(akx_runtime_ctx_t *rt, akx_cell_t *a,
+                           akx_cell_t *b) {
+  int64_t out;
+  if (!((a->flags | b->flags) & AKX_CELL_FLAG_BIGNUM) &&
+      !int_sub_overflow(a->value.integer_literal, b->value.integer_literal,
+                        &out)) {
+    return akx_rt_make_int(rt, out);
+  }
+  return int_slow_path(rt, a, b, akx_bignum_sub);
+}
+
+akx_cell_t *akx_rt_int_mul(akx_runtime_ctx_t *rt, akx_cell_t *a,
+                           akx_cell_t *b) {
+  int64_t out;
+  if (!((a->flags | b->flags) & AKX_CELL_FLAG_BIGNUM) &&
+      !int_mul_overflow(a->value.integer_literal, b->value.integer_literal,
+                        &out)) {
+    return akx_rt_make_int(rt, out);
+  }
+  return int_slow_path(rt, a, b, akx_bignum_mul);
+}
+
+static akx_cell_t *int_divmod(akx_runtime_ctx_t *rt, akx_cell_t *a,
+                              akx_cell_t *b, int want_remainder) {
+  if (!(b->flags & AKX_CELL_FLAG_BIGNUM) && b->value.integer_literal == 0) {
+    akx_rt_error(rt, want_remainder ? "% division by zero"
+                                    : "/ division by zero");
+    return NULL;
+  }
+
+  // INT64_MIN / -1 is the only fixnum quotient that overflows
+  if (!((a->flags | b->flags) & AKX_CELL_FLAG_BIGNUM) &&
+      !(a->value.integer_literal == INT64_MIN &&
+        b->value.integer_literal == -1)) {
+    int64_t x = a->value.integer_literal;
+    int64_t y = b->value.integer_literal;
+    return akx_rt_make_int(rt, want_remainder ? x % y : x / y);
+  }
+
+  akx_bignum_t *ta;
+  akx_bignum_t *tb;
+  akx_bignum_t *quotient = NULL;
+  akx_bignum_t *remainder = NULL;
+  const akx_bignum_t *na = int_as_bignum(a, &ta);
+  const akx_bignum_t *nb = int_as_bignum(b, &tb);
+  if (na && nb) {
+    akx_bignum_divmod(na, nb, &quotient, &remainder);
+  }
+  akx_bignum_free(ta);
+  akx_bignum_free(tb);
+  if (want_remainder) {
+    akx_bignum_free(quotient);
+    return int_from_bignum(rt, remainder);
+  }
+  akx_bignum_free(remainder);
+  return int_from_bignum(rt, quotient);
+}
+
+akx_cell_t *akx_rt_int_div(akx_runtime_ctx_t *rt, akx_cell_t *a,
+                           akx_cell_t *b) {
+  return int_divmod(rt, a, b, 0);
+}
+
+akx_cell_t *akx_rt_int_mod(akx_runtime_ctx_t *rt, akx_cell_t *a,
+                           akx_cell_t *b) {
+  return int_divmod(rt, a, b, 1);
+}
+
+int akx_rt_int_cmp(akx_cell_t *a, akx_cell_t *b) {
+  if (!((a->flags | b->flags) & AKX_CELL_FLAG_BIGNUM)) {
+    int64_t x = a->value.integer_literal;
+    int64_t y = b->value.integer_literal;
+    return (x > y) - (x < y);
+  }
+  // A bignum never holds a value that fits in 64 bits
+  if (!(b->flags & AKX_CELL_FLAG_BIGNUM)) {
+    return a->value.bignum->sign;
+  }
+  if (!(a->flags & AKX_CELL_FLAG_BIGNUM)) {
+    return -b->value.bignum->sign;
+  }
+  return akx_bignum_cmp(a->value.bignum, b->value.bignum);
+}
+
+ak_buffer_t *akx_rt_int_to_buffer(akx_cell_t *cell) {
+  if (!cell || cell->type != AKX_TYPE_INTEGER_LITERAL) {
+    return NULL;
+  }
+  if (cell->flags & AKX_CELL_FLAG_BIGNUM) {
+    return akx_bignum_to_buffer(cell->value.bignum);
+  }
+  char digits[24];
+  int len = snprintf(digits, sizeof(digits), "%lld",
+                     (long long)cell->value.integer_literal);
+  ak_buffer_t *buffer = ak_buffer_new((size_t)len + 1);
+  if (buffer) {
+    ak_buffer_copy_to(buffer, (uint8_t *)digits, (size_t)len);
+  }
+  return buffer;
+}
+
 double akx_rt_cell_as_real(akx_cell_t *cell) {
   if (!cell || cell->type != AKX_TYPE_REAL_LITERAL) {
     return 0.0;
@@ -349,7 +999,7 @@ akx_cell_t *akx_rt_list_nth(akx_cell_t *list, size_t n) {
 
 akx_cell_t *akx_rt_list_append(akx_runtime_ctx_t *rt, akx_cell_t *list,
                                akx_cell_t *item) {
-  (void)rt;
+  item = akx_rt_unshare(rt, item);
   if (!item) {
     return list;
   }
@@ -364,149 +1014,1774 @@ akx_cell_t *akx_rt_list_append(akx_runtime_ctx_t *rt, akx_cell_t *list,
   return list;
 }
 
-ak_context_t *akx_rt_get_scope(akx_runtime_ctx_t *rt) {
-  if (!rt) {
-    return NULL;
+int akx_rt_list_builder_push(akx_runtime_ctx_t *rt,
+                             akx_rt_list_builder_t *builder, akx_cell_t *item) {
+  item = akx_rt_unshare(rt, item);
+  if (!item) {
+    return -1;
+  }
+  if (builder->tail) {
+    builder->tail->next = item;
+  } else {
+    builder->head = item;
+  }
+  builder->tail = item;
+  return 0;
+}
+
+akx_cell_t *akx_rt_list_builder_finish(akx_runtime_ctx_t *rt,
+                                       akx_rt_list_builder_t *builder) {
+  akx_cell_t *list = akx_rt_alloc_cell(rt, AKX_TYPE_LIST);
+  if (!list) {
+    akx_rt_list_builder_discard(rt, builder);
+    return NULL;
+  }
+  list->value.list_head = builder->head;
+  builder->head = NULL;
+  builder->tail = NULL;
+  return list;
+}
+
+void akx_rt_list_builder_discard(akx_runtime_ctx_t *rt,
+                                 akx_rt_list_builder_t *builder) {
+  akx_rt_free_cell(rt, builder->head);
+  builder->head = NULL;
+  builder->tail = NULL;
+}
+
+// Parameters are known before they are bound; a slot holding this is
+// skipped by lookups as if the name were absent
+static char unbound_value;
+#define AKX_RT_UNBOUND ((void *)&unbound_value)
+
+static shadow_t *shadow_find(shadow_t *shadows, size_t capacity,
+                             const char *name) {
+  size_t mask = capacity - 1;
+  size_t i = (size_t)(((uint64_t)(uintptr_t)name >> 3) *
+                      0x9E3779B97F4A7C15ull >> 32) &
+             mask;
+  while (shadows[i].name && shadows[i].name != name) {
+    i = (i + 1) & mask;
+  }
+  return &shadows[i];
+}
+
+static int shadow_grow(akx_runtime_ctx_t *rt) {
+  size_t capacity = rt->shadow_capacity ? rt->shadow_capacity * 2
+                                        : AKX_RT_SHADOW_INITIAL_CAPACITY;
+  shadow_t *shadows = AK24_ALLOC(sizeof(shadow_t) * capacity);
+  if (!shadows) {
+    return -1;
+  }
+  memset(shadows, 0, sizeof(shadow_t) * capacity);
+  for (size_t i = 0; i < rt->shadow_capacity; i++) {
+    if (rt->shadows[i].name) {
+      *shadow_find(shadows, capacity, rt->shadows[i].name) = rt->shadows[i];
+    }
+  }
+  if (rt->shadows) {
+    AK24_FREE(rt->shadows);
+  }
+  rt->shadows = shadows;
+  rt->shadow_capacity = capacity;
+  return 0;
+}
+
+static void shadow_add(akx_runtime_ctx_t *rt, const char *name) {
+  if (rt->shadows_lost) {
+    return;
+  }
+  if ((rt->shadow_count + 1) * 2 > rt->shadow_capacity &&
+      shadow_grow(rt) != 0) {
+    rt->shadows_lost = 1;
+    return;
+  }
+  shadow_t *shadow = shadow_find(rt->shadows, rt->shadow_capacity, name);
+  if (!shadow->name) {
+    shadow->name = name;
+    rt->shadow_count++;
+  }
+  shadow->count++;
+}
+
+static void shadow_remove(akx_runtime_ctx_t *rt, const char *name) {
+  if (rt->shadows_lost) {
+    return;
+  }
+  shadow_t *shadow = shadow_find(rt->shadows, rt->shadow_capacity, name);
+  if (shadow->count) {
+    shadow->count--;
+  }
+}
+
+static int shadowed(akx_runtime_ctx_t *rt, const char *name) {
+  return rt->shadows_lost ||
+         (rt->shadow_capacity &&
+          shadow_find(rt->shadows, rt->shadow_capacity, name)->count);
+}
+
+static void *stack_alloc(akx_runtime_ctx_t *rt, size_t size) {
+  size = (size + 15) & ~(size_t)15;
+  if (rt->stack_top + size > rt->stack_chunk->end) {
+    frame_chunk_t *next = rt->stack_chunk->next;
+    if (!next) {
+      next = AK24_ALLOC(AKX_RT_FRAME_CHUNK_SIZE);
+      if (!next) {
+        return NULL;
+      }
+      next->prev = rt->stack_chunk;
+      next->next = NULL;
+      next->end = (char *)next + AKX_RT_FRAME_CHUNK_SIZE;
+      rt->stack_chunk->next = next;
+    }
+    rt->stack_chunk = next;
+    rt->stack_top = chunk_data(next);
+  }
+  void *ptr = rt->stack_top;
+  rt->stack_top += size;
+  return ptr;
+}
+
+static akx_rt_scope_t *push_frame(akx_runtime_ctx_t *rt, size_t capacity) {
+  frame_chunk_t *chunk = rt->stack_chunk;
+  char *top = rt->stack_top;
+
+  int heap = capacity > AKX_RT_FRAME_INLINE_SLOTS;
+  size_t slots_size = (sizeof(char *) + sizeof(void *)) * capacity;
+  akx_rt_scope_t *scope =
+      stack_alloc(rt, sizeof(akx_rt_scope_t) + (heap ? 0 : slots_size));
+  if (!scope) {
+    return NULL;
+  }
+  memset(scope, 0, sizeof(akx_rt_scope_t));
+  if (heap) {
+    scope->names = AK24_ALLOC(slots_size);
+    if (!scope->names) {
+      rt->stack_chunk = chunk;
+      rt->stack_top = top;
+      return NULL;
+    }
+  } else {
+    scope->names = (const char **)(scope + 1);
+  }
+  scope->values = (void **)(scope->names + capacity);
+  scope->capacity = (uint32_t)capacity;
+  scope->heap = heap;
+  scope->chunk = chunk;
+  scope->top = top;
+  scope->parent = rt->scope;
+  rt->scope = scope;
+  return scope;
+}
+
+static void pop_frame(akx_runtime_ctx_t *rt) {
+  akx_rt_scope_t *scope = rt->scope;
+  for (size_t i = 0; i < scope->count; i++) {
+    shadow_remove(rt, scope->names[i]);
+  }
+  if (scope->map) {
+    ak_context_free(scope->map);
+  }
+  if (scope->heap) {
+    AK24_FREE(scope->names);
+  }
+  rt->scope = scope->parent;
+  rt->stack_chunk = scope->chunk;
+  rt->stack_top = scope->top;
+}
+
+static int grow_frame(akx_rt_scope_t *scope) {
+  size_t capacity = scope->capacity < 4 ? 8 : (size_t)scope->capacity * 2;
+  const char **names = AK24_ALLOC((sizeof(char *) + sizeof(void *)) * capacity);
+  if (!names) {
+    return -1;
+  }
+  void **values = (void **)(names + capacity);
+  if (scope->count) {
+    memcpy(names, scope->names, sizeof(char *) * scope->count);
+    memcpy(values, scope->values, sizeof(void *) * scope->count);
+  }
+  if (scope->heap) {
+    AK24_FREE(scope->names);
+  }
+  scope->names = names;
+  scope->values = values;
+  scope->capacity = (uint32_t)capacity;
+  scope->heap = 1;
+  return 0;
+}
+
+// Stored names are interned, so a lookup with an interned key compares
+// pointers only
+static size_t name_index(const akx_rt_scope_t *scope, const char *key) {
+  for (size_t i = 0; i < scope->count; i++) {
+    if (scope->names[i] == key) {
+      return i;
+    }
+  }
+  return scope->count;
+}
+
+// Map scopes list their keys too, for the collector and for materializing
+static int record_name(akx_runtime_ctx_t *rt, akx_rt_scope_t *scope,
+                       const char *key) {
+  if (scope->count == scope->capacity && grow_frame(scope) != 0) {
+    return -1;
+  }
+  if (scope != &rt->global) {
+    shadow_add(rt, key);
+  }
+  scope->names[scope->count] = key;
+  scope->values[scope->count] = NULL;
+  scope->count++;
+  return 0;
+}
+
+static int scope_bind(akx_runtime_ctx_t *rt, akx_rt_scope_t *scope,
+                      const char *key, void *value) {
+  if (scope->map) {
+    if (!ak_context_has_local(scope->map, key) &&
+        record_name(rt, scope, key) != 0) {
+      return -1;
+    }
+    return ak_context_set(scope->map, key, value);
+  }
+  size_t i = name_index(scope, key);
+  if (i == scope->count && record_name(rt, scope, key) != 0) {
+    return -1;
+  }
+  scope->values[i] = value;
+  return 0;
+}
+
+static int scope_binds(akx_rt_scope_t *scope, const char *key) {
+  if (scope->map) {
+    return ak_context_has_local(scope->map, key);
+  }
+  size_t i = name_index(scope, key);
+  return i < scope->count && scope->values[i] != AKX_RT_UNBOUND;
+}
+
+static akx_rt_scope_t *find_scope(akx_runtime_ctx_t *rt, const char *key) {
+  if (!shadowed(rt, key)) {
+    return scope_binds(&rt->global, key) ? &rt->global : NULL;
+  }
+  for (akx_rt_scope_t *scope = rt->scope; scope; scope = scope->parent) {
+    if (scope_binds(scope, key)) {
+      return scope;
+    }
+  }
+  return NULL;
+}
+
+static void *lookup_name(akx_runtime_ctx_t *rt, const char *key) {
+  if (!shadowed(rt, key)) {
+    return ak_context_get_local(rt->global.map, key);
+  }
+  for (akx_rt_scope_t *scope = rt->scope; scope; scope = scope->parent) {
+    if (scope->map) {
+      void *value = ak_context_get_local(scope->map, key);
+      if (value || ak_context_has_local(scope->map, key)) {
+        return value;
+      }
+      continue;
+    }
+    size_t i = name_index(scope, key);
+    if (i < scope->count && scope->values[i] != AKX_RT_UNBOUND) {
+      return scope->values[i];
+    }
+  }
+  return NULL;
+}
+
+// Gives a frame (and the frames around it) a map, so it can be handed out
+// as an ak_context_t; bindings live in the map from then on
+static ak_context_t *materialize(akx_runtime_ctx_t *rt,
+                                 akx_rt_scope_t *scope) {
+  if (scope->map) {
+    return scope->map;
+  }
+  ak_context_t *parent =
+      scope->parent ? materialize(rt, scope->parent) : NULL;
+  if (scope->parent && !parent) {
+    return NULL;
+  }
+  ak_context_t *map = parent ? ak_context_push(parent) : ak_context_new();
+  if (!map) {
+    return NULL;
+  }
+  size_t kept = 0;
+  for (size_t i = 0; i < scope->count; i++) {
+    if (scope->values[i] == AKX_RT_UNBOUND) {
+      shadow_remove(rt, scope->names[i]);
+      continue;
+    }
+    ak_context_set(map, scope->names[i], scope->values[i]);
+    scope->names[kept++] = scope->names[i];
+  }
+  scope->count = (uint32_t)kept;
+  scope->map = map;
+  return map;
+}
+
+ak_context_t *akx_rt_get_scope(akx_runtime_ctx_t *rt) {
+  if (!rt) {
+    return NULL;
+  }
+  return materialize(rt, rt->scope);
+}
+
+// A resolved reference may use its slot only while its own lambda's call is
+// the innermost one and the parameter is bound. Arguments being bound for
+// another call, and tail-call arguments, fall back to the name, which
+// dynamic scoping makes the authority.
+static void **local_slot(akx_runtime_ctx_t *rt, akx_cell_t *symbol) {
+  akx_cell_site_t *site = akx_cell_site(symbol);
+  akx_rt_scope_t *frame = rt->frame;
+  if (!site || site->kind != AKX_RT_SITE_LOCAL || !frame ||
+      frame->owner != site->target || frame->map ||
+      frame->values[site->index] == AKX_RT_UNBOUND) {
+    return NULL;
+  }
+  return &frame->values[site->index];
+}
+
+static void *lookup_symbol(akx_runtime_ctx_t *rt, akx_cell_t *symbol) {
+  void **slot = local_slot(rt, symbol);
+  if (slot) {
+    return *slot;
+  }
+  return lookup_name(rt, symbol->value.symbol);
+}
+
+int akx_rt_scope_set(akx_runtime_ctx_t *rt, const char *key, void *value) {
+  if (!rt || !key) {
+    return -1;
+  }
+  return scope_bind(rt, rt->scope, ak_intern(key), value);
+}
+
+void *akx_rt_scope_get(akx_runtime_ctx_t *rt, const char *key) {
+  if (!rt || !key) {
+    return NULL;
+  }
+  return lookup_name(rt, ak_intern(key));
+}
+
+int akx_rt_scope_has_local(akx_runtime_ctx_t *rt, const char *key) {
+  if (!rt || !key) {
+    return 0;
+  }
+  return scope_binds(rt->scope, ak_intern(key));
+}
+
+akx_rt_scope_t *akx_rt_scope_find(akx_runtime_ctx_t *rt,
+                                  akx_cell_t *symbol) {
+  if (!rt || !symbol || symbol->type != AKX_TYPE_SYMBOL) {
+    return NULL;
+  }
+  if (local_slot(rt, symbol)) {
+    return rt->frame;
+  }
+  return find_scope(rt, symbol->value.symbol);
+}
+
+int akx_rt_scope_assign(akx_runtime_ctx_t *rt, akx_rt_scope_t *scope,
+                        const char *key, void *value, void **old_value) {
+  if (!rt || !scope || !key) {
+    return -1;
+  }
+  key = ak_intern(key);
+  if (old_value) {
+    if (scope->map) {
+      *old_value = ak_context_get_local(scope->map, key);
+    } else {
+      size_t i = name_index(scope, key);
+      *old_value = i < scope->count && scope->values[i] != AKX_RT_UNBOUND
+                       ? scope->values[i]
+                       : NULL;
+    }
+  }
+  return scope_bind(rt, scope, key, value);
+}
+
+void akx_rt_push_scope(akx_runtime_ctx_t *rt) {
+  akx_rt_push_scope_sized(rt, AKX_RT_FRAME_DEFAULT_SLOTS);
+}
+
+void akx_rt_push_scope_sized(akx_runtime_ctx_t *rt, size_t slots) {
+  if (!rt) {
+    return;
+  }
+  if (!push_frame(rt, slots)) {
+    akx_rt_error(rt, "failed to allocate a scope frame");
+  }
+}
+
+void akx_rt_pop_scope(akx_runtime_ctx_t *rt) {
+  if (!rt || rt->scope == &rt->global) {
+    return;
+  }
+  pop_frame(rt);
+}
+
+static int push_lambda_frame(akx_runtime_ctx_t *rt,
+                             akx_lambda_context_t *lambda_ctx) {
+  size_t capacity = lambda_ctx->local_count;
+  if (capacity < lambda_ctx->param_count) {
+    capacity = lambda_ctx->param_count;
+  }
+  akx_rt_scope_t *frame = push_frame(rt, capacity);
+  if (!frame) {
+    return -1;
+  }
+  for (size_t i = 0; i < lambda_ctx->param_count; i++) {
+    frame->names[i] = lambda_ctx->param_names[i];
+    frame->values[i] = AKX_RT_UNBOUND;
+    shadow_add(rt, frame->names[i]);
+  }
+  frame->count = (uint32_t)lambda_ctx->param_count;
+  frame->owner = lambda_ctx;
+  frame->caller = rt->frame;
+  rt->frame = frame;
+  return 0;
+}
+
+static void pop_lambda_frame(akx_runtime_ctx_t *rt) {
+  rt->frame = rt->scope->caller;
+  pop_frame(rt);
+}
+
+static size_t param_index(const char **names, size_t count,
+                          const char *key) {
+  for (size_t i = 0; i < count; i++) {
+    if (names[i] == key || strcmp(names[i], key) == 0) {
+      return i;
+    }
+  }
+  return count;
+}
+
+static int is_list_cell(akx_cell_t *cell) {
+  return cell->type == AKX_TYPE_LIST || cell->type == AKX_TYPE_LIST_SQUARE ||
+         cell->type == AKX_TYPE_LIST_CURLY ||
+         cell->type == AKX_TYPE_LIST_TEMPLE;
+}
+
+// Also marks the parameters a let can rebind in a loop scope nested inside
+// the call, where the parameter's slot would be the wrong binding
+static size_t scan_lets(akx_cell_t *cell, const char **names, size_t count,
+                        uint8_t *shadowed) {
+  size_t lets = 0;
+  for (; cell; cell = cell->next) {
+    if (!is_list_cell(cell)) {
+      continue;
+    }
+    akx_cell_t *head = cell->value.list_head;
+    if (head && head->type == AKX_TYPE_SYMBOL && head->next &&
+        head->next->type == AKX_TYPE_SYMBOL &&
+        strcmp(head->value.symbol, "let") == 0) {
+      lets++;
+      size_t i = param_index(names, count, head->next->value.symbol);
+      if (i < count) {
+        shadowed[i] = 1;
+      }
+    }
+    lets += scan_lets(head, names, count, shadowed);
+  }
+  return lets;
+}
+
+size_t akx_rt_count_lets(akx_cell_t *body) {
+  return scan_lets(body, NULL, 0, NULL);
+}
+
+static void annotate_locals(akx_cell_t *cell, const void *owner,
+                            const char **names, size_t count,
+                            const uint8_t *shadowed) {
+  for (; cell; cell = cell->next) {
+    if (is_list_cell(cell)) {
+      annotate_locals(cell->value.list_head, owner, names, count, shadowed);
+      continue;
+    }
+    akx_cell_site_t *site = akx_cell_site(cell);
+    if (!site || cell->type != AKX_TYPE_SYMBOL) {
+      continue;
+    }
+    size_t i = param_index(names, count, cell->value.symbol);
+    if (i < count && i <= UINT16_MAX && !shadowed[i]) {
+      site->kind = AKX_RT_SITE_LOCAL;
+      site->index = (uint16_t)i;
+      site->target = (void *)owner;
+    }
+  }
+}
+
+void akx_rt_resolve_locals(akx_runtime_ctx_t *rt, const void *owner,
+                           const char **names, size_t count,
+                           akx_cell_t *body) {
+  if (!rt || !owner || count == 0) {
+    return;
+  }
+  uint8_t *shadowed = akx_rt_alloc_mem(rt, count);
+  if (!shadowed) {
+    return;
+  }
+  memset(shadowed, 0, count);
+  scan_lets(body, names, count, shadowed);
+  annotate_locals(body, owner, names, count, shadowed);
+  akx_rt_free_mem(rt, shadowed, count);
+}
+
+void akx_rt_error(akx_runtime_ctx_t *rt, const char *message) {
+  if (!rt || !rt->error_ctx || !message) {
+    return;
+  }
+
+  akx_parse_error_t *error = AK24_ALLOC(sizeof(akx_parse_error_t));
+  if (!error) {
+    return;
+  }
+
+  memset(error, 0, sizeof(akx_parse_error_t));
+  snprintf(error->message, sizeof(error->message), "%s", message);
+  error->next = NULL;
+
+  if (!rt->error_ctx->errors) {
+    rt->error_ctx->errors = error;
+  } else {
+    akx_parse_error_t *current = rt->error_ctx->errors;
+    while (current->next) {
+      current = current->next;
+    }
+    current->next = error;
+  }
+  rt->error_ctx->error_count++;
+}
+
+void akx_rt_error_at(akx_runtime_ctx_t *rt, akx_cell_t *cell,
+                     const char *message) {
+  if (!rt || !rt->error_ctx || !message) {
+    return;
+  }
+
+  akx_parse_error_t *error = AK24_ALLOC(sizeof(akx_parse_error_t));
+  if (!error) {
+    return;
+  }
+
+  memset(error, 0, sizeof(akx_parse_error_t));
+  snprintf(error->message, sizeof(error->message), "%s", message);
+  error->next = NULL;
+
+  if (akx_cell_has_location(cell)) {
+    error->location = akx_cell_location(cell);
+  }
+
+  if (!rt->error_ctx->errors) {
+    rt->error_ctx->errors = error;
+  } else {
+    akx_parse_error_t *current = rt->error_ctx->errors;
+    while (current->next) {
+      current = current->next;
+    }
+    current->next = error;
+  }
+  rt->error_ctx->error_count++;
+}
+
+void akx_rt_error_fmt(akx_runtime_ctx_t *rt, const char *fmt, ...) {
+  if (!rt || !rt->error_ctx || !fmt) {
+    return;
+  }
+
+  akx_parse_error_t *error = AK24_ALLOC(sizeof(akx_parse_error_t));
+  if (!error) {
+    return;
+  }
+
+  memset(error, 0, sizeof(akx_parse_error_t));
+
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(error->message, sizeof(error->message), fmt, args);
+  va_end(args);
+
+  error->next = NULL;
+
+  if (!rt->error_ctx->errors) {
+    rt->error_ctx->errors = error;
+  } else {
+    akx_parse_error_t *current = rt->error_ctx->errors;
+    while (current->next) {
+      current = current->next;
+    }
+    current->next = error;
+  }
+  rt->error_ctx->error_count++;
+}
+
+static const char *type_name(akx_type_t type) {
+  switch (type) {
+  case AKX_TYPE_SYMBOL:
+    return "symbol";
+  case AKX_TYPE_STRING_LITERAL:
+    return "string";
+  case AKX_TYPE_INTEGER_LITERAL:
+    return "integer";
+  case AKX_TYPE_REAL_LITERAL:
+    return "real";
+  case AKX_TYPE_LIST:
+  case AKX_TYPE_LIST_SQUARE:
+  case AKX_TYPE_LIST_CURLY:
+  case AKX_TYPE_LIST_TEMPLE:
+    return "list";
+  case AKX_TYPE_QUOTED:
+    return "quoted";
+  case AKX_TYPE_LAMBDA:
+    return "lambda";
+  default:
+    return "continuation";
+  }
+}
+
+static void signature_error(akx_runtime_ctx_t *rt,
+                            const akx_builtin_signature_t *signature,
+                            size_t argc) {
+  int exact = signature->min_args == signature->max_args;
+  if (exact && argc != signature->min_args) {
+    akx_rt_error_fmt(rt, "%s requires exactly %u arguments", signature->name,
+                     (unsigned)signature->min_args);
+  } else if (argc < signature->min_args) {
+    akx_rt_error_fmt(rt, "%s requires at least %u arguments", signature->name,
+                     (unsigned)signature->min_args);
+  } else if (argc > signature->max_args) {
+    akx_rt_error_fmt(rt, "%s takes at most %u arguments", signature->name,
+                     (unsigned)signature->max_args);
+  } else {
+    char accepted[AKX_RT_META_STRING_SIZE_MAX] = "";
+    const char *last = NULL;
+    for (akx_type_t type = AKX_TYPE_SYMBOL; type <= AKX_TYPE_CONTINUATION;
+         type++) {
+      if (!(signature->accepts & AKX_ARG(type)) || type_name(type) == last) {
+        continue;
+      }
+      size_t used = strlen(accepted);
+      snprintf(accepted + used, sizeof(accepted) - used, "%s%s",
+               last ? " or " : "", type_name(type));
+      last = type_name(type);
+    }
+    akx_rt_error_fmt(rt, "%s requires %s arguments", signature->name,
+                     accepted);
+  }
+}
+
+static void decode_value(akx_value_t *value, akx_cell_t *cell) {
+  value->cell = cell;
+  value->type = cell->type;
+  switch (cell->type) {
+  case AKX_TYPE_INTEGER_LITERAL:
+    value->as.integer = akx_rt_cell_as_int(cell);
+    break;
+  case AKX_TYPE_REAL_LITERAL:
+    value->as.real = cell->value.real_literal;
+    break;
+  case AKX_TYPE_SYMBOL:
+    value->as.text = cell->value.symbol;
+    break;
+  case AKX_TYPE_STRING_LITERAL:
+    value->as.text = akx_rt_cell_as_string(cell);
+    break;
+  default:
+    value->as.text = NULL;
+    break;
+  }
+}
+
+static akx_cell_t *box_result(akx_runtime_ctx_t *rt,
+                              const akx_builtin_signature_t *signature,
+                              const akx_value_t *result) {
+  if (result->cell) {
+    return result->cell;
+  }
+  akx_cell_t *cell = NULL;
+  switch (result->type) {
+  case AKX_TYPE_INTEGER_LITERAL:
+    return akx_rt_make_int(rt, result->as.integer);
+  case AKX_TYPE_REAL_LITERAL:
+    cell = akx_rt_alloc_cell(rt, AKX_TYPE_REAL_LITERAL);
+    akx_rt_set_real(rt, cell, result->as.real);
+    return cell;
+  case AKX_TYPE_SYMBOL:
+    if (result->as.text) {
+      return akx_rt_make_symbol(rt, result->as.text);
+    }
+    break;
+  case AKX_TYPE_STRING_LITERAL:
+    if (result->as.text) {
+      cell = akx_rt_alloc_cell(rt, AKX_TYPE_STRING_LITERAL);
+      akx_rt_set_string(rt, cell, result->as.text);
+      return cell;
+    }
+    break;
+  default:
+    break;
+  }
+  akx_rt_error_fmt(rt, "%s returned no value", signature->name);
+  return NULL;
+}
+
+#define AKX_RT_INLINE_ARGS 8
+
+static void free_strict_args(akx_runtime_ctx_t *rt, akx_value_t *argv,
+                             size_t argc) {
+  // Lambda values are the bindings themselves, not copies
+  for (size_t i = 0; i < argc; i++) {
+    if (argv[i].type != AKX_TYPE_LAMBDA) {
+      akx_rt_free_cell(rt, argv[i].cell);
+    }
+  }
+}
+
+// A builtin that names the types it accepts gets bignums only if it asks
+// for them, since as.integer cannot hold one
+static int reject_bignums(akx_runtime_ctx_t *rt,
+                          const akx_builtin_signature_t *signature,
+                          akx_value_t *argv, size_t argc) {
+  if (!signature->accepts || (signature->accepts & AKX_ARG_BIGNUM)) {
+    return 0;
+  }
+  for (size_t i = 0; i < argc; i++) {
+    if (akx_rt_cell_is_bignum(argv[i].cell)) {
+      akx_rt_error_fmt(rt, "%s: integer does not fit in 64 bits",
+                       signature->name);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// Calls a strict builtin on its checked arguments, which it then frees
+static akx_cell_t *apply_strict(akx_runtime_ctx_t *rt,
+                                akx_builtin_info_t *info, akx_value_t *argv,
+                                size_t argc) {
+  akx_cell_t *result = NULL;
+  akx_value_t value = {0};
+  if (reject_bignums(rt, info->signature, argv, argc) == 0 &&
+      info->strict_function(rt, argv, argc, &value) == 0) {
+    result = box_result(rt, info->signature, &value);
+  }
+  free_strict_args(rt, argv, argc);
+  return result;
+}
+
+// Arguments stay on the C stack, which the collector scans, unless there
+// are too many for it
+static akx_cell_t *call_strict(akx_runtime_ctx_t *rt, akx_builtin_info_t *info,
+                               akx_cell_t *args) {
+  const akx_builtin_signature_t *signature = info->signature;
+  size_t argc = 0;
+  for (akx_cell_t *arg = args; arg; arg = arg->next) {
+    argc++;
+  }
+  if (argc < signature->min_args || argc > signature->max_args) {
+    signature_error(rt, signature, argc);
+    return NULL;
+  }
+
+  akx_value_t inline_argv[AKX_RT_INLINE_ARGS];
+  akx_value_t *argv = inline_argv;
+  akx_cell_t **roots = NULL;
+  if (argc > AKX_RT_INLINE_ARGS) {
+    argv = AK24_ALLOC(argc * (sizeof(akx_value_t) + sizeof(akx_cell_t *)));
+    if (!argv) {
+      akx_rt_error_fmt(rt, "%s: memory allocation failed", signature->name);
+      return NULL;
+    }
+    roots = (akx_cell_t **)(argv + argc);
+    memset(roots, 0, argc * sizeof(akx_cell_t *));
+    akx_rt_gc_push_roots(rt, roots, argc);
+  }
+
+  akx_cell_t *result = NULL;
+  size_t evaluated = 0;
+  for (akx_cell_t *arg = args; arg; arg = arg->next) {
+    akx_cell_t *cell = akx_rt_eval(rt, arg);
+    if (!cell) {
+      goto done;
+    }
+    decode_value(&argv[evaluated], cell);
+    if (roots) {
+      roots[evaluated] = cell;
+    }
+    evaluated++;
+    if (signature->accepts && !(signature->accepts & AKX_ARG(cell->type))) {
+      signature_error(rt, signature, argc);
+      goto done;
+    }
+  }
+
+  result = apply_strict(rt, info, argv, argc);
+  evaluated = 0;
+
+done:
+  free_strict_args(rt, argv, evaluated);
+  if (roots) {
+    akx_rt_gc_pop_roots(rt, roots);
+    AK24_FREE(argv);
+  }
+  return result;
+}
+
+static akx_cell_t *call_builtin(akx_runtime_ctx_t *rt, akx_builtin_info_t *info,
+                                akx_cell_t *args, int tail) {
+  akx_builtin_info_t *caller = rt->current_builtin;
+  int caller_tail = rt->in_tail_position;
+  rt->current_builtin = info;
+  rt->in_tail_position = tail;
+  akx_cell_t *result = NULL;
+  if (info->signature) {
+    result = call_strict(rt, info, args);
+  } else {
+    // An error raised inside the builtin, such as writing a shared
+    // immediate, fails the call even if the builtin went on to return
+    int errors = rt->error_ctx->error_count;
+    result = info->function(rt, args);
+    if (result && rt->error_ctx->error_count > errors) {
+      if (result->type != AKX_TYPE_LAMBDA) {
+        akx_rt_free_cell(rt, result);
+      }
+      result = NULL;
+    }
+  }
+  rt->current_builtin = caller;
+  rt->in_tail_position = caller_tail;
+  return result;
+}
+
+enum {
+  QUICK_ADD,
+  QUICK_SUB,
+  QUICK_MUL,
+  QUICK_DIV,
+  QUICK_MOD,
+  QUICK_EQ,
+  QUICK_NEQ,
+  QUICK_LT,
+  QUICK_GT,
+  QUICK_LTE,
+  QUICK_GTE,
+};
+
+static const char *const quick_names[] = {
+    "+", "-", "*", "/", "%", "eq", "neq", "lt", "gt", "lte", "gte",
+};
+
+// A two-argument call of one of the int nuclei becomes a quick site; any
+// other builtin call, or one reloaded under such a name, stays generic
+static void quicken_site(akx_cell_site_t *site, akx_builtin_info_t *info,
+                         akx_cell_t *args) {
+  site->kind = AKX_RT_SITE_GENERIC;
+  if (info->unit || !info->signature || !info->module_name || !args ||
+      !args->next || args->next->next) {
+    return;
+  }
+  size_t count = sizeof(quick_names) / sizeof(quick_names[0]);
+  for (size_t op = 0; op < count; op++) {
+    if (strcmp(quick_names[op], info->module_name) == 0) {
+      site->kind = AKX_RT_SITE_QUICK;
+      site->index = (uint16_t)op;
+      return;
+    }
+  }
+}
+
+static akx_cell_t *quick_apply(akx_runtime_ctx_t *rt, uint16_t op,
+                               akx_cell_t *a, akx_cell_t *b) {
+  switch (op) {
+  case QUICK_ADD:
+    return akx_rt_int_add(rt, a, b);
+  case QUICK_SUB:
+    return akx_rt_int_sub(rt, a, b);
+  case QUICK_MUL:
+    return akx_rt_int_mul(rt, a, b);
+  case QUICK_DIV:
+    return akx_rt_int_div(rt, a, b);
+  case QUICK_MOD:
+    return akx_rt_int_mod(rt, a, b);
+  case QUICK_EQ:
+    return akx_rt_make_int(rt, akx_rt_int_cmp(a, b) == 0);
+  case QUICK_NEQ:
+    return akx_rt_make_int(rt, akx_rt_int_cmp(a, b) != 0);
+  case QUICK_LT:
+    return akx_rt_make_int(rt, akx_rt_int_cmp(a, b) < 0);
+  case QUICK_GT:
+    return akx_rt_make_int(rt, akx_rt_int_cmp(a, b) > 0);
+  case QUICK_LTE:
+    return akx_rt_make_int(rt, akx_rt_int_cmp(a, b) <= 0);
+  default:
+    return akx_rt_make_int(rt, akx_rt_int_cmp(a, b) >= 0);
+  }
+}
+
+// Symbols and int literals are used in place when nothing evaluated later
+// can rebind them; anything else is evaluated into a cell the call owns
+static akx_cell_t *quick_operand(akx_runtime_ctx_t *rt, akx_cell_t *arg,
+                                 int borrow, int *owned) {
+  *owned = 0;
+  if (borrow && arg->type == AKX_TYPE_INTEGER_LITERAL) {
+    return arg;
+  }
+  if (borrow && arg->type == AKX_TYPE_SYMBOL) {
+    akx_cell_t *value = lookup_symbol(rt, arg);
+    if (value) {
+      return value;
+    }
+  }
+  *owned = 1;
+  return akx_rt_eval(rt, arg);
+}
+
+static void release_operand(akx_runtime_ctx_t *rt, akx_cell_t *cell,
+                            int owned) {
+  if (cell && owned && cell->type != AKX_TYPE_LAMBDA) {
+    akx_rt_free_cell(rt, cell);
+  }
+}
+
+// Runs a quick site on two ints; other operands turn the site generic and
+// go through the builtin, with its errors in the order call_strict raises
+// them
+static akx_cell_t *call_quick(akx_runtime_ctx_t *rt, akx_cell_site_t *site,
+                              akx_builtin_info_t *info, akx_cell_t *args) {
+  akx_cell_t *second = args->next;
+  int borrow_first = second->type == AKX_TYPE_SYMBOL ||
+                     second->type == AKX_TYPE_INTEGER_LITERAL;
+  int owned[2];
+  akx_cell_t *argv[2];
+  argv[0] = quick_operand(rt, args, borrow_first, &owned[0]);
+  if (!argv[0]) {
+    return NULL;
+  }
+  const akx_builtin_signature_t *signature = info->signature;
+  if (argv[0]->type != AKX_TYPE_INTEGER_LITERAL && signature->accepts &&
+      !(signature->accepts & AKX_ARG(argv[0]->type))) {
+    site->kind = AKX_RT_SITE_GENERIC;
+    signature_error(rt, signature, 2);
+    release_operand(rt, argv[0], owned[0]);
+    return NULL;
+  }
+  argv[1] = quick_operand(rt, second, 1, &owned[1]);
+  if (!argv[1]) {
+    release_operand(rt, argv[0], owned[0]);
+    return NULL;
+  }
+
+  if (argv[0]->type == AKX_TYPE_INTEGER_LITERAL &&
+      argv[1]->type == AKX_TYPE_INTEGER_LITERAL) {
+    akx_cell_t *result = quick_apply(rt, site->index, argv[0], argv[1]);
+    release_operand(rt, argv[0], owned[0]);
+    release_operand(rt, argv[1], owned[1]);
+    return result;
+  }
+
+  site->kind = AKX_RT_SITE_GENERIC;
+  for (size_t i = 0; i < 2; i++) {
+    if (!owned[i] && argv[i]->type != AKX_TYPE_LAMBDA) {
+      argv[i] = akx_rt_copy(rt, argv[i]);
+    }
+  }
+  return akx_rt_call_strict(rt, info, argv, 2);
+}
+
+// Calls the builtin a list's site resolved to, quickening the site the
+// first time it runs
+static akx_cell_t *call_site(akx_runtime_ctx_t *rt, akx_cell_t *call,
+                             akx_builtin_info_t *info, akx_cell_t *args,
+                             int tail) {
+  akx_cell_site_t *site = akx_cell_site(call);
+  if (site && site->kind == AKX_RT_SITE_NATIVE &&
+      site->index < rt->native_site_count) {
+    return rt->native_sites[site->index].function(rt, call, tail);
+  }
+  if (!site || !rt->quicken) {
+    return call_builtin(rt, info, args, tail);
+  }
+  if (site->kind == AKX_RT_SITE_BUILTIN) {
+    quicken_site(site, info, args);
+  }
+  if (site->kind != AKX_RT_SITE_QUICK) {
+    return call_builtin(rt, info, args, tail);
+  }
+  akx_builtin_info_t *caller = rt->current_builtin;
+  int caller_tail = rt->in_tail_position;
+  rt->current_builtin = info;
+  rt->in_tail_position = tail;
+  akx_cell_t *result = call_quick(rt, site, info, args);
+  rt->current_builtin = caller;
+  rt->in_tail_position = caller_tail;
+  return result;
+}
+
+// Evaluates a call's arguments one at a time in the callee's frame, so each
+// sees the parameters bound before it
+static int bind_args(akx_runtime_ctx_t *rt, akx_lambda_context_t *lambda_ctx,
+                     akx_cell_t *args) {
+  size_t arg_count = akx_rt_list_length(args);
+  if (arg_count != lambda_ctx->param_count) {
+    akx_rt_error_fmt(rt, "lambda: expected %zu arguments, got %zu",
+                     lambda_ctx->param_count, arg_count);
+    return -1;
+  }
+
+  size_t i = 0;
+  for (akx_cell_t *arg = args; arg; arg = arg->next, i++) {
+    akx_cell_t *evaled = akx_rt_eval(rt, arg);
+    if (!evaled ||
+        scope_bind(rt, rt->scope, lambda_ctx->param_names[i], evaled) != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static int reserve_tail_args(akx_runtime_ctx_t *rt, size_t count) {
+  if (count <= rt->tail_capacity) {
+    return 0;
+  }
+  size_t capacity = count < AKX_RT_INLINE_ARGS ? AKX_RT_INLINE_ARGS : count;
+  const char **names =
+      AK24_ALLOC((sizeof(char *) + sizeof(akx_cell_t *)) * capacity);
+  if (!names) {
+    return -1;
+  }
+  if (rt->tail_names) {
+    AK24_FREE(rt->tail_names);
+  }
+  rt->tail_names = names;
+  rt->tail_args = (akx_cell_t **)(names + capacity);
+  rt->tail_capacity = capacity;
+  return 0;
+}
+
+// Moves the bindings out of the frame on top before it is popped
+static int save_tail_args(akx_runtime_ctx_t *rt) {
+  akx_rt_scope_t *frame = rt->scope;
+  if (reserve_tail_args(rt, frame->count) != 0) {
+    return -1;
+  }
+  for (size_t i = 0; i < frame->count; i++) {
+    rt->tail_names[i] = frame->names[i];
+    rt->tail_args[i] =
+        frame->map ? ak_context_get_local(frame->map, frame->names[i])
+                   : frame->values[i];
+  }
+  rt->tail_argc = frame->count;
+  return 0;
+}
+
+static void drop_tail_args(akx_runtime_ctx_t *rt) {
+  // Lambda values are the bindings themselves, not copies
+  for (size_t i = 0; i < rt->tail_argc; i++) {
+    akx_cell_t *value = rt->tail_args[i];
+    if (value && value != AKX_RT_UNBOUND && value->type != AKX_TYPE_LAMBDA) {
+      akx_rt_free_cell(rt, value);
+    }
+  }
+  rt->tail_argc = 0;
+}
+
+// The trampoline has just pushed the callee's frame with its parameters
+// first, so saved parameters go straight back into their slots
+static int bind_tail_args(akx_runtime_ctx_t *rt) {
+  akx_rt_scope_t *frame = rt->scope;
+  for (size_t i = 0; i < rt->tail_argc; i++) {
+    if (i < frame->count && frame->names[i] == rt->tail_names[i]) {
+      frame->values[i] = rt->tail_args[i];
+    } else if (rt->tail_args[i] != AKX_RT_UNBOUND &&
+               scope_bind(rt, frame, rt->tail_names[i], rt->tail_args[i]) !=
+                   0) {
+      rt->tail_argc = 0;
+      return -1;
+    }
+  }
+  rt->tail_argc = 0;
+  return 0;
+}
+
+// A tail call binds its arguments exactly as any other call does, in a
+// callee frame pushed over the caller's. The bindings are then moved into
+// the runtime and the frame is dropped; the runtime's continuation only
+// names the lambda, and the trampoline rebinds them once the caller has
+// been popped.
+static akx_cell_t *tail_call(akx_runtime_ctx_t *rt, akx_cell_t *lambda_cell,
+                             akx_cell_t *args) {
+  akx_lambda_context_t *lambda_ctx =
+      lambda_cell->value.lambda
+          ? (akx_lambda_context_t *)ak_lambda_get_context(
+                lambda_cell->value.lambda)
+          : NULL;
+  if (!lambda_ctx || push_lambda_frame(rt, lambda_ctx) != 0) {
+    akx_rt_error(rt, "failed to allocate a lambda frame");
+    return NULL;
+  }
+
+  akx_cell_t *result = NULL;
+  if (bind_args(rt, lambda_ctx, args) == 0) {
+    if (save_tail_args(rt) == 0) {
+      rt->tail_cont.lambda_cell = lambda_cell;
+      result = &rt->tail_cell;
+    } else {
+      akx_rt_error(rt, "lambda: memory allocation failed");
+    }
+  }
+  pop_lambda_frame(rt);
+  return result;
+}
+
+akx_builtin_info_t *akx_rt_resolve_builtin(akx_runtime_ctx_t *rt,
+                                           akx_cell_t *call,
+                                           const char *name) {
+  return resolve_builtin(rt, call, name);
+}
+
+void *akx_rt_lookup_symbol(akx_runtime_ctx_t *rt, akx_cell_t *symbol) {
+  return lookup_symbol(rt, symbol);
+}
+
+akx_cell_t *akx_rt_call_builtin(akx_runtime_ctx_t *rt,
+                                akx_builtin_info_t *info, akx_cell_t *args,
+                                int tail) {
+  return call_builtin(rt, info, args, tail);
+}
+
+void akx_rt_signature_error(akx_runtime_ctx_t *rt,
+                            const akx_builtin_signature_t *signature,
+                            size_t argc) {
+  signature_error(rt, signature, argc);
+}
+
+akx_cell_t *akx_rt_call_strict(akx_runtime_ctx_t *rt,
+                               akx_builtin_info_t *info, akx_cell_t **args,
+                               size_t argc) {
+  const akx_builtin_signature_t *signature = info->signature;
+  akx_value_t inline_argv[AKX_RT_INLINE_ARGS];
+  akx_value_t *argv = inline_argv;
+  if (argc > AKX_RT_INLINE_ARGS) {
+    argv = AK24_ALLOC(argc * sizeof(akx_value_t));
+    if (!argv) {
+      akx_rt_error_fmt(rt, "%s: memory allocation failed", signature->name);
+      for (size_t i = 0; i < argc; i++) {
+        if (args[i]->type != AKX_TYPE_LAMBDA) {
+          akx_rt_free_cell(rt, args[i]);
+        }
+      }
+      return NULL;
+    }
+  }
+
+  int accepted = 1;
+  for (size_t i = 0; i < argc; i++) {
+    decode_value(&argv[i], args[i]);
+    if (signature->accepts && !(signature->accepts & AKX_ARG(args[i]->type))) {
+      accepted = 0;
+    }
+  }
+
+  akx_cell_t *result = NULL;
+  if (!accepted) {
+    signature_error(rt, signature, argc);
+    free_strict_args(rt, argv, argc);
+  } else {
+    akx_builtin_info_t *caller = rt->current_builtin;
+    int caller_tail = rt->in_tail_position;
+    rt->current_builtin = info;
+    rt->in_tail_position = 0;
+    result = apply_strict(rt, info, argv, argc);
+    rt->current_builtin = caller;
+    rt->in_tail_position = caller_tail;
+  }
+  if (argv != inline_argv) {
+    AK24_FREE(argv);
+  }
+  return result;
+}
+
+// Lowered calls make the same steps as call_builtin and call_strict, in the
+// same order, so they fail with the same errors
+static void native_enter(akx_runtime_ctx_t *rt, akx_rt_native_frame_t *frame,
+                         akx_cell_t *call, int tail) {
+  frame->info = (akx_builtin_info_t *)akx_cell_site(call)->target;
+  frame->caller = rt->current_builtin;
+  frame->caller_tail = rt->in_tail_position;
+  frame->errors = rt->error_ctx->error_count;
+  frame->argc = 0;
+  frame->count = 0;
+  rt->current_builtin = frame->info;
+  rt->in_tail_position = tail;
+}
+
+static void native_exit(akx_runtime_ctx_t *rt, akx_rt_native_frame_t *frame) {
+  rt->current_builtin = frame->caller;
+  rt->in_tail_position = frame->caller_tail;
+}
+
+void akx_rt_native_enter(akx_runtime_ctx_t *rt, akx_rt_native_frame_t *frame,
+                         akx_cell_t *call, int tail) {
+  native_enter(rt, frame, call, tail);
+}
+
+akx_cell_t *akx_rt_native_leave(akx_runtime_ctx_t *rt,
+                                akx_rt_native_frame_t *frame,
+                                akx_cell_t *result) {
+  if (result && rt->error_ctx->error_count > frame->errors) {
+    if (result->type != AKX_TYPE_LAMBDA) {
+      akx_rt_free_cell(rt, result);
+    }
+    result = NULL;
   }
-  return rt->current_context;
+  native_exit(rt, frame);
+  return result;
 }
 
-int akx_rt_scope_set(akx_runtime_ctx_t *rt, const char *key, void *value) {
-  if (!rt || !rt->current_context || !key) {
+int akx_rt_native_enter_strict(akx_runtime_ctx_t *rt,
+                               akx_rt_native_frame_t *frame, akx_cell_t *call,
+                               int tail, size_t argc) {
+  native_enter(rt, frame, call, tail);
+  frame->argc = argc;
+  const akx_builtin_signature_t *signature = frame->info->signature;
+  if (argc < signature->min_args || argc > signature->max_args) {
+    signature_error(rt, signature, argc);
+    native_exit(rt, frame);
     return -1;
   }
-  return ak_context_set(rt->current_context, key, value);
+  return 0;
 }
 
-void *akx_rt_scope_get(akx_runtime_ctx_t *rt, const char *key) {
-  if (!rt || !rt->current_context || !key) {
-    return NULL;
+int akx_rt_native_arg(akx_runtime_ctx_t *rt, akx_rt_native_frame_t *frame,
+                      akx_value_t *argv, akx_cell_t *value) {
+  if (!value) {
+    return -1;
   }
-  return ak_context_get(rt->current_context, key);
-}
-
-void akx_rt_push_scope(akx_runtime_ctx_t *rt) {
-  if (!rt || !rt->current_context) {
-    return;
+  decode_value(&argv[frame->count++], value);
+  const akx_builtin_signature_t *signature = frame->info->signature;
+  if (signature->accepts && !(signature->accepts & AKX_ARG(value->type))) {
+    signature_error(rt, signature, frame->argc);
+    return -1;
   }
-  rt->current_context = ak_context_push(rt->current_context);
+  return 0;
 }
 
-void akx_rt_pop_scope(akx_runtime_ctx_t *rt) {
-  if (!rt || !rt->current_context) {
-    return;
-  }
-  rt->current_context = ak_context_pop(rt->current_context);
+int akx_rt_native_check(akx_runtime_ctx_t *rt, akx_rt_native_frame_t *frame,
+                        akx_value_t *argv) {
+  return reject_bignums(rt, frame->info->signature, argv, frame->count);
 }
 
-void akx_rt_error(akx_runtime_ctx_t *rt, const char *message) {
-  if (!rt || !rt->error_ctx || !message) {
-    return;
-  }
+akx_cell_t *akx_rt_native_finish(akx_runtime_ctx_t *rt,
+                                 akx_rt_native_frame_t *frame,
+                                 akx_value_t *argv, int status,
+                                 const akx_value_t *result) {
+  akx_cell_t *cell =
+      status == 0 ? box_result(rt, frame->info->signature, result) : NULL;
+  free_strict_args(rt, argv, frame->count);
+  native_exit(rt, frame);
+  return cell;
+}
 
-  akx_parse_error_t *error = AK24_ALLOC(sizeof(akx_parse_error_t));
-  if (!error) {
-    return;
-  }
+akx_cell_t *akx_rt_native_fail(akx_runtime_ctx_t *rt,
+                               akx_rt_native_frame_t *frame,
+                               akx_value_t *argv) {
+  free_strict_args(rt, argv, frame->count);
+  native_exit(rt, frame);
+  return NULL;
+}
 
-  memset(error, 0, sizeof(akx_parse_error_t));
-  snprintf(error->message, sizeof(error->message), "%s", message);
-  error->next = NULL;
+akx_rt_scope_t *akx_rt_current_scope(akx_runtime_ctx_t *rt) {
+  return rt->scope;
+}
 
-  if (!rt->error_ctx->errors) {
-    rt->error_ctx->errors = error;
-  } else {
-    akx_parse_error_t *current = rt->error_ctx->errors;
-    while (current->next) {
-      current = current->next;
+void akx_rt_unwind_scope(akx_runtime_ctx_t *rt, akx_rt_scope_t *scope) {
+  while (rt->scope != scope && rt->scope != &rt->global) {
+    if (rt->scope == rt->frame) {
+      pop_lambda_frame(rt);
+    } else {
+      pop_frame(rt);
     }
-    current->next = error;
   }
-  rt->error_ctx->error_count++;
 }
 
-void akx_rt_error_at(akx_runtime_ctx_t *rt, akx_cell_t *cell,
-                     const char *message) {
-  if (!rt || !rt->error_ctx || !message) {
-    return;
+int akx_rt_enter_scope(akx_runtime_ctx_t *rt, size_t slots) {
+  if (!push_frame(rt, slots)) {
+    akx_rt_error(rt, "failed to allocate a scope frame");
+    return -1;
   }
+  return 0;
+}
 
-  akx_parse_error_t *error = AK24_ALLOC(sizeof(akx_parse_error_t));
-  if (!error) {
-    return;
+int akx_rt_bind(akx_runtime_ctx_t *rt, const char *name, void *value) {
+  return scope_bind(rt, rt->scope, name, value);
+}
+
+int akx_rt_binds_locally(akx_runtime_ctx_t *rt, const char *name) {
+  return scope_binds(rt->scope, name);
+}
+
+int akx_rt_push_call(akx_runtime_ctx_t *rt,
+                     akx_lambda_context_t *lambda_ctx) {
+  if (push_lambda_frame(rt, lambda_ctx) != 0) {
+    akx_rt_error(rt, "failed to allocate a lambda frame");
+    return -1;
   }
+  return 0;
+}
 
-  memset(error, 0, sizeof(akx_parse_error_t));
-  snprintf(error->message, sizeof(error->message), "%s", message);
-  error->next = NULL;
+void akx_rt_pop_call(akx_runtime_ctx_t *rt) { pop_lambda_frame(rt); }
+
+int akx_rt_bind_args(akx_runtime_ctx_t *rt, akx_lambda_context_t *lambda_ctx,
+                     akx_cell_t *args) {
+  return bind_args(rt, lambda_ctx, args);
+}
 
-  if (cell && cell->sourceloc) {
-    error->location = cell->sourceloc->start;
+int akx_rt_replace_call(akx_runtime_ctx_t *rt,
+                        akx_lambda_context_t *lambda_ctx, int saved) {
+  if (!saved) {
+    if (save_tail_args(rt) != 0) {
+      akx_rt_error(rt, "lambda: memory allocation failed");
+      return -1;
+    }
+    pop_lambda_frame(rt);
+  }
+  pop_lambda_frame(rt);
+  if (push_lambda_frame(rt, lambda_ctx) != 0 || bind_tail_args(rt) != 0) {
+    drop_tail_args(rt);
+    akx_rt_error(rt, "failed to allocate a lambda frame");
+    return -1;
   }
+  return 0;
+}
 
-  if (!rt->error_ctx->errors) {
-    rt->error_ctx->errors = error;
-  } else {
-    akx_parse_error_t *current = rt->error_ctx->errors;
-    while (current->next) {
-      current = current->next;
+static kont_t *push_kont(akx_runtime_ctx_t *rt) {
+  if (!rt->kont_chunk || rt->kont_used == AKX_RT_KONT_CHUNK) {
+    kont_chunk_t *chunk = rt->kont_chunk ? rt->kont_chunk->next : NULL;
+    if (!chunk) {
+      chunk = AK24_ALLOC(sizeof(kont_chunk_t));
+      if (!chunk) {
+        return NULL;
+      }
+      chunk->prev = rt->kont_chunk;
+      chunk->next = NULL;
+      if (rt->kont_chunk) {
+        rt->kont_chunk->next = chunk;
+      }
     }
-    current->next = error;
+    rt->kont_chunk = chunk;
+    rt->kont_used = 0;
   }
-  rt->error_ctx->error_count++;
+  rt->kont_depth++;
+  kont_t *k = &rt->kont_chunk->konts[rt->kont_used++];
+  k->owned = NULL;
+  return k;
 }
 
-void akx_rt_error_fmt(akx_runtime_ctx_t *rt, const char *fmt, ...) {
-  if (!rt || !rt->error_ctx || !fmt) {
-    return;
+static kont_t *top_kont(akx_runtime_ctx_t *rt) {
+  return &rt->kont_chunk->konts[rt->kont_used - 1];
+}
+
+static void pop_kont(akx_runtime_ctx_t *rt) {
+  rt->kont_depth--;
+  if (--rt->kont_used == 0 && rt->kont_chunk->prev) {
+    rt->kont_chunk = rt->kont_chunk->prev;
+    rt->kont_used = AKX_RT_KONT_CHUNK;
   }
+}
 
-  akx_parse_error_t *error = AK24_ALLOC(sizeof(akx_parse_error_t));
-  if (!error) {
-    return;
+static int push_kont_value(akx_runtime_ctx_t *rt, akx_cell_t *cell) {
+  if (rt->kont_value_count == rt->kont_value_capacity) {
+    size_t capacity =
+        rt->kont_value_capacity ? rt->kont_value_capacity * 2 : 64;
+    akx_value_t *values = AK24_ALLOC(sizeof(akx_value_t) * capacity);
+    if (!values) {
+      return -1;
+    }
+    if (rt->kont_values) {
+      memcpy(values, rt->kont_values,
+             sizeof(akx_value_t) * rt->kont_value_count);
+      AK24_FREE(rt->kont_values);
+    }
+    rt->kont_values = values;
+    rt->kont_value_capacity = capacity;
   }
+  decode_value(&rt->kont_values[rt->kont_value_count++], cell);
+  return 0;
+}
 
-  memset(error, 0, sizeof(akx_parse_error_t));
+static void free_owned(akx_cell_t *owned) {
+  if (owned) {
+    akx_cell_free(owned);
+  }
+}
 
-  va_list args;
-  va_start(args, fmt);
-  vsnprintf(error->message, sizeof(error->message), fmt, args);
-  va_end(args);
+// Evaluates a list without recursing on the C stack for lambda calls, if,
+// begin and strict builtins. Other builtins are called as usual, and
+// re-enter here through akx_rt_eval for their own evaluations; each entry
+// only ever touches the continuations it pushed itself.
+static akx_cell_t *machine_eval(akx_runtime_ctx_t *rt, akx_cell_t *expr) {
+  const size_t base = rt->kont_depth;
+  akx_cell_t *value = NULL;
+  akx_cell_t *call_lambda = NULL;
+  akx_cell_t *call_args = NULL;
+  akx_cell_t *owned = NULL;
+  akx_lambda_context_t *lambda_ctx = NULL;
+  kont_t *k = NULL;
+
+eval:
+  if (!is_list_cell(expr)) {
+    value = akx_rt_eval(rt, expr);
+    goto apply;
+  }
+  {
+    akx_cell_t *head = expr->value.list_head;
+    if (!head) {
+      value = akx_rt_nil(rt);
+      goto apply;
+    }
+    akx_cell_t *args = head->next;
 
-  error->next = NULL;
+    if (head->type != AKX_TYPE_SYMBOL) {
+      if (!(k = push_kont(rt))) {
+        goto out_of_memory;
+      }
+      k->kind = KONT_HEAD;
+      k->expr = expr;
+      expr = head;
+      goto eval;
+    }
 
-  if (!rt->error_ctx->errors) {
-    rt->error_ctx->errors = error;
+    akx_builtin_info_t *info = resolve_builtin(rt, expr, head->value.symbol);
+    // A reloaded if or begin is called like any other builtin
+    if (info && !info->unit && info->module_name == rt->if_name) {
+      size_t argc = akx_rt_list_length(args);
+      if (argc < 2 || argc > 3) {
+        akx_rt_error(rt, "if: requires 2 or 3 arguments (condition "
+                         "then-branch [else-branch])");
+        goto fail;
+      }
+      if (!(k = push_kont(rt))) {
+        goto out_of_memory;
+      }
+      k->kind = KONT_IF;
+      k->expr = args->next;
+      expr = args;
+      goto eval;
+    }
+    if (info && !info->unit && info->module_name == rt->begin_name) {
+      if (!args) {
+        value = akx_rt_nil(rt);
+        goto apply;
+      }
+      if (args->next) {
+        if (!(k = push_kont(rt))) {
+          goto out_of_memory;
+        }
+        k->kind = KONT_SEQ;
+        k->expr = args->next;
+      }
+      expr = args;
+      goto eval;
+    }
+    if (info && info->signature && args) {
+      size_t argc = akx_rt_list_length(args);
+      if (argc < info->signature->min_args ||
+          argc > info->signature->max_args) {
+        signature_error(rt, info->signature, argc);
+        goto fail;
+      }
+      if (!(k = push_kont(rt))) {
+        goto out_of_memory;
+      }
+      k->kind = KONT_STRICT;
+      k->index = (uint32_t)rt->kont_value_count;
+      k->info = info;
+      k->expr = args->next;
+      expr = args;
+      goto eval;
+    }
+    if (info) {
+      value = call_builtin(rt, info, args, 0);
+      goto apply;
+    }
+
+    akx_cell_t *bound = lookup_symbol(rt, head);
+    if (bound && ((akx_cell_t *)bound)->type == AKX_TYPE_LAMBDA) {
+      call_lambda = bound;
+      call_args = args;
+      owned = NULL;
+      goto call;
+    }
+    char error_msg[256];
+    snprintf(error_msg, sizeof(error_msg), "undefined function: %s",
+             head->value.symbol);
+    akx_rt_error_at(rt, head, error_msg);
+    goto fail;
+  }
+
+call:
+  // Same steps as the trampoline: the callee's frame goes on the frame
+  // stack and its arguments bind in it one at a time
+  akx_rt_gc_safepoint(rt);
+  lambda_ctx = call_lambda->value.lambda
+                   ? (akx_lambda_context_t *)ak_lambda_get_context(
+                         call_lambda->value.lambda)
+                   : NULL;
+  if (!lambda_ctx || push_lambda_frame(rt, lambda_ctx) != 0) {
+    free_owned(owned);
+    akx_rt_error(rt, "failed to allocate a lambda frame");
+    goto fail;
+  }
+  if (akx_rt_list_length(call_args) != lambda_ctx->param_count) {
+    akx_rt_error_fmt(rt, "lambda: expected %zu arguments, got %zu",
+                     lambda_ctx->param_count,
+                     akx_rt_list_length(call_args));
+    pop_lambda_frame(rt);
+    free_owned(owned);
+    value = akx_rt_nil(rt);
+    goto apply;
+  }
+  if (call_args) {
+    if (!(k = push_kont(rt))) {
+      pop_lambda_frame(rt);
+      free_owned(owned);
+      goto out_of_memory;
+    }
+    k->kind = KONT_BIND;
+    k->index = 0;
+    k->lambda_ctx = lambda_ctx;
+    k->owned = owned;
+    k->expr = call_args->next;
+    expr = call_args;
+    goto eval;
+  }
+
+enter:
+  // A call whose value is its caller's value replaces the caller: the
+  // bindings move past the caller's frame, which is popped, and the
+  // caller's return continuation is reused
+  if (rt->kont_depth > base && top_kont(rt)->kind == KONT_RETURN) {
+    k = top_kont(rt);
+    if (save_tail_args(rt) != 0) {
+      pop_lambda_frame(rt);
+      free_owned(owned);
+      goto out_of_memory;
+    }
+    pop_lambda_frame(rt);
+    pop_lambda_frame(rt);
+    if (push_lambda_frame(rt, lambda_ctx) != 0 || bind_tail_args(rt) != 0) {
+      drop_tail_args(rt);
+      free_owned(owned);
+      akx_rt_error(rt, "failed to allocate a lambda frame");
+      // The caller's frame is gone, so its return must not pop again
+      owned = k->owned;
+      pop_kont(rt);
+      free_owned(owned);
+      owned = NULL;
+      goto fail;
+    }
+    k->lambda_ctx = lambda_ctx;
+    if (owned) {
+      if (k->owned) {
+        free_owned(k->owned);
+      }
+      k->owned = owned;
+    }
   } else {
-    akx_parse_error_t *current = rt->error_ctx->errors;
-    while (current->next) {
-      current = current->next;
+    if (!(k = push_kont(rt))) {
+      pop_lambda_frame(rt);
+      free_owned(owned);
+      goto out_of_memory;
     }
-    current->next = error;
+    k->kind = KONT_RETURN;
+    k->lambda_ctx = lambda_ctx;
+    k->owned = owned;
+  }
+  owned = NULL;
+  if (!lambda_ctx->body) {
+    value = akx_rt_nil(rt);
+    goto apply;
+  }
+  if (lambda_ctx->body->next) {
+    if (!(k = push_kont(rt))) {
+      goto out_of_memory;
+    }
+    k->kind = KONT_SEQ;
+    k->expr = lambda_ctx->body->next;
+  }
+  expr = lambda_ctx->body;
+  goto eval;
+
+apply:
+  if (!value) {
+    goto fail;
+  }
+  if (rt->kont_depth == base) {
+    return value;
+  }
+  k = top_kont(rt);
+  switch (k->kind) {
+  case KONT_RETURN:
+    pop_lambda_frame(rt);
+    owned = k->owned;
+    pop_kont(rt);
+    free_owned(owned);
+    owned = NULL;
+    goto apply;
+
+  case KONT_SEQ:
+    if (value->type != AKX_TYPE_LAMBDA) {
+      akx_rt_free_cell(rt, value);
+    }
+    expr = k->expr;
+    if (expr->next) {
+      k->expr = expr->next;
+    } else {
+      pop_kont(rt);
+    }
+    goto eval;
+
+  case KONT_IF: {
+    akx_cell_t *then_branch = k->expr;
+    pop_kont(rt);
+    int is_true = value->type == AKX_TYPE_INTEGER_LITERAL &&
+                  akx_rt_cell_as_int(value) == 1;
+    if (value->type != AKX_TYPE_LAMBDA) {
+      akx_rt_free_cell(rt, value);
+    }
+    if (is_true) {
+      expr = then_branch;
+      goto eval;
+    }
+    if (then_branch->next) {
+      expr = then_branch->next;
+      goto eval;
+    }
+    value = akx_rt_nil(rt);
+    goto apply;
   }
-  rt->error_ctx->error_count++;
+
+  case KONT_BIND:
+    if (scope_bind(rt, rt->scope, k->lambda_ctx->param_names[k->index],
+                   value) != 0) {
+      goto fail;
+    }
+    k->index++;
+    if (k->expr) {
+      expr = k->expr;
+      k->expr = expr->next;
+      goto eval;
+    }
+    lambda_ctx = k->lambda_ctx;
+    owned = k->owned;
+    pop_kont(rt);
+    goto enter;
+
+  case KONT_STRICT: {
+    const akx_builtin_signature_t *signature = k->info->signature;
+    if (push_kont_value(rt, value) != 0) {
+      if (value->type != AKX_TYPE_LAMBDA) {
+        akx_rt_free_cell(rt, value);
+      }
+      goto out_of_memory;
+    }
+    if (signature->accepts && !(signature->accepts & AKX_ARG(value->type))) {
+      signature_error(rt, signature, akx_rt_list_length(k->expr) +
+                                         rt->kont_value_count - k->index);
+      goto fail;
+    }
+    if (k->expr) {
+      expr = k->expr;
+      k->expr = expr->next;
+      goto eval;
+    }
+    akx_builtin_info_t *caller = rt->current_builtin;
+    int caller_tail = rt->in_tail_position;
+    rt->current_builtin = k->info;
+    rt->in_tail_position = 0;
+    size_t argc = rt->kont_value_count - k->index;
+    value = apply_strict(rt, k->info, &rt->kont_values[k->index], argc);
+    rt->current_builtin = caller;
+    rt->in_tail_position = caller_tail;
+    rt->kont_value_count = k->index;
+    pop_kont(rt);
+    goto apply;
+  }
+
+  case KONT_HEAD:
+    expr = k->expr;
+    call_args = expr->value.list_head->next;
+    pop_kont(rt);
+    if (value->type != AKX_TYPE_LAMBDA) {
+      akx_rt_free_cell(rt, value);
+      akx_rt_error_at(rt, expr, "cannot evaluate list - not a function call");
+      goto fail;
+    }
+    call_lambda = value;
+    owned = value;
+    goto call;
+  }
+
+out_of_memory:
+  akx_rt_error(rt, "stack evaluator: memory allocation failed");
+fail:
+  // As in the trampoline, a lambda call that fails returns nil to its
+  // caller; only a failure outside every call fails the evaluation
+  while (rt->kont_depth > base) {
+    k = top_kont(rt);
+    switch (k->kind) {
+    case KONT_RETURN:
+    case KONT_BIND:
+      pop_lambda_frame(rt);
+      owned = k->owned;
+      pop_kont(rt);
+      free_owned(owned);
+      owned = NULL;
+      value = akx_rt_nil(rt);
+      goto apply;
+    case KONT_STRICT:
+      free_strict_args(rt, &rt->kont_values[k->index],
+                       rt->kont_value_count - k->index);
+      rt->kont_value_count = k->index;
+      pop_kont(rt);
+      break;
+    default:
+      pop_kont(rt);
+      break;
+    }
+  }
+  return NULL;
 }
 
 akx_cell_t *akx_rt_eval(akx_runtime_ctx_t *rt, akx_cell_t *expr) {
   if (!rt || !expr) {
     return NULL;
   }
+  if (rt->stack_engine && is_list_cell(expr)) {
+    return machine_eval(rt, expr);
+  }
 
   switch (expr->type) {
   case AKX_TYPE_INTEGER_LITERAL:
   case AKX_TYPE_REAL_LITERAL:
   case AKX_TYPE_STRING_LITERAL:
-    return akx_cell_clone(expr);
+    return akx_rt_copy(rt, expr);
 
   case AKX_TYPE_SYMBOL: {
     const char *sym = expr->value.symbol;
-    void *value = akx_rt_scope_get(rt, sym);
+    void *value = lookup_symbol(rt, expr);
     if (value) {
       akx_cell_t *stored = (akx_cell_t *)value;
       if (stored->type == AKX_TYPE_LAMBDA) {
         return stored;
       }
-      return akx_cell_clone(stored);
+      return akx_rt_copy(rt, stored);
     }
     char error_msg[256];
     snprintf(error_msg, sizeof(error_msg), "undefined symbol: %s", sym);
@@ -520,25 +2795,18 @@ akx_cell_t *akx_rt_eval(akx_runtime_ctx_t *rt, akx_cell_t *expr) {
   case AKX_TYPE_LIST_TEMPLE: {
     akx_cell_t *head = expr->value.list_head;
     if (!head) {
-      akx_cell_t *nil = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
-      akx_rt_set_symbol(rt, nil, "nil");
-      return nil;
+      return akx_rt_nil(rt);
     }
 
     if (head->type == AKX_TYPE_SYMBOL) {
       const char *func_name = head->value.symbol;
 
-      void **builtin_ptr = map_get_generic(&rt->builtins, &func_name);
-      if (builtin_ptr && *builtin_ptr) {
-        akx_builtin_info_t *info = (akx_builtin_info_t *)*builtin_ptr;
-        akx_cell_t *args = head->next;
-        rt->current_module_name = info->module_name;
-        akx_cell_t *result = info->function(rt, args);
-        rt->current_module_name = NULL;
-        return result;
+      akx_builtin_info_t *info = resolve_builtin(rt, expr, func_name);
+      if (info) {
+        return call_site(rt, expr, info, head->next, 0);
       }
 
-      void *value = akx_rt_scope_get(rt, func_name);
+      void *value = lookup_symbol(rt, head);
       if (value) {
         akx_cell_t *func_cell = (akx_cell_t *)value;
         if (func_cell->type == AKX_TYPE_LAMBDA) {
@@ -581,26 +2849,23 @@ akx_cell_t *akx_rt_eval_tail(akx_runtime_ctx_t *rt, akx_cell_t *expr) {
     return NULL;
   }
 
-  int saved_tail_flag = rt->in_tail_position;
-  rt->in_tail_position = 1;
-
   akx_cell_t *result = NULL;
   switch (expr->type) {
   case AKX_TYPE_INTEGER_LITERAL:
   case AKX_TYPE_REAL_LITERAL:
   case AKX_TYPE_STRING_LITERAL:
-    result = akx_cell_clone(expr);
+    result = akx_rt_copy(rt, expr);
     break;
 
   case AKX_TYPE_SYMBOL: {
     const char *sym = expr->value.symbol;
-    void *value = akx_rt_scope_get(rt, sym);
+    void *value = lookup_symbol(rt, expr);
     if (value) {
       akx_cell_t *stored = (akx_cell_t *)value;
       if (stored->type == AKX_TYPE_LAMBDA) {
         result = stored;
       } else {
-        result = akx_cell_clone(stored);
+        result = akx_rt_copy(rt, stored);
       }
     } else {
       char error_msg[256];
@@ -616,30 +2881,24 @@ akx_cell_t *akx_rt_eval_tail(akx_runtime_ctx_t *rt, akx_cell_t *expr) {
   case AKX_TYPE_LIST_TEMPLE: {
     akx_cell_t *head = expr->value.list_head;
     if (!head) {
-      akx_cell_t *nil = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
-      akx_rt_set_symbol(rt, nil, "nil");
-      result = nil;
+      result = akx_rt_nil(rt);
       break;
     }
 
     if (head->type == AKX_TYPE_SYMBOL) {
       const char *func_name = head->value.symbol;
 
-      void **builtin_ptr = map_get_generic(&rt->builtins, &func_name);
-      if (builtin_ptr && *builtin_ptr) {
-        akx_builtin_info_t *info = (akx_builtin_info_t *)*builtin_ptr;
-        akx_cell_t *args = head->next;
-        rt->current_module_name = info->module_name;
-        result = info->function(rt, args);
-        rt->current_module_name = NULL;
+      akx_builtin_info_t *info = resolve_builtin(rt, expr, func_name);
+      if (info) {
+        result = call_site(rt, expr, info, head->next, 1);
         break;
       }
 
-      void *value = akx_rt_scope_get(rt, func_name);
+      void *value = lookup_symbol(rt, head);
       if (value) {
         akx_cell_t *func_cell = (akx_cell_t *)value;
         if (func_cell->type == AKX_TYPE_LAMBDA) {
-          result = akx_rt_alloc_continuation(rt, func_cell, head->next);
+          result = tail_call(rt, func_cell, head->next);
           break;
         }
       }
@@ -653,7 +2912,7 @@ akx_cell_t *akx_rt_eval_tail(akx_runtime_ctx_t *rt, akx_cell_t *expr) {
 
     akx_cell_t *evaled_head = akx_rt_eval(rt, head);
     if (evaled_head && evaled_head->type == AKX_TYPE_LAMBDA) {
-      result = akx_rt_alloc_continuation(rt, evaled_head, head->next);
+      result = tail_call(rt, evaled_head, head->next);
     } else {
       if (evaled_head) {
         akx_cell_free(evaled_head);
@@ -672,10 +2931,16 @@ akx_cell_t *akx_rt_eval_tail(akx_runtime_ctx_t *rt, akx_cell_t *expr) {
     break;
   }
 
-  rt->in_tail_position = saved_tail_flag;
   return result;
 }
 
+akx_cell_t *akx_rt_eval_in_tail(akx_runtime_ctx_t *rt, akx_cell_t *expr) {
+  if (rt && rt->in_tail_position) {
+    return akx_rt_eval_tail(rt, expr);
+  }
+  return akx_rt_eval(rt, expr);
+}
+
 akx_cell_t *akx_rt_eval_list(akx_runtime_ctx_t *rt, akx_cell_t *list) {
   if (!rt || !list) {
     return NULL;
@@ -694,6 +2959,12 @@ akx_cell_t *akx_rt_eval_list(akx_runtime_ctx_t *rt, akx_cell_t *list) {
       return NULL;
     }
 
+    evaled = akx_rt_unshare(rt, evaled);
+    if (!evaled) {
+      akx_cell_free(result_head);
+      return NULL;
+    }
+
     if (!result_head) {
       result_head = evaled;
       result_tail = evaled;
@@ -740,7 +3011,7 @@ akx_cell_t *akx_rt_alloc_continuation(akx_runtime_ctx_t *rt,
     return NULL;
   }
 
-  akx_continuation_t *cont = AK24_ALLOC(sizeof(akx_continuation_t));
+  akx_continuation_t *cont = akx_cell_alloc_continuation(cont_cell);
   if (!cont) {
     akx_cell_free(cont_cell);
     return NULL;
@@ -748,7 +3019,6 @@ akx_cell_t *akx_rt_alloc_continuation(akx_runtime_ctx_t *rt,
 
   cont->lambda_cell = lambda_cell;
   cont->args = args;
-  cont_cell->value.continuation = cont;
 
   return cont_cell;
 }
@@ -762,42 +3032,51 @@ akx_cell_t *akx_rt_invoke_lambda(akx_runtime_ctx_t *rt, akx_cell_t *lambda_cell,
   if (!rt || !lambda_cell || lambda_cell->type != AKX_TYPE_LAMBDA) {
     return NULL;
   }
+  if (rt->vm) {
+    return akx_rt_vm_invoke(rt->vm, lambda_cell, args);
+  }
 
   akx_cell_t *current_lambda = lambda_cell;
   akx_cell_t *current_args = args;
   akx_cell_t *result = NULL;
+  // Set once the runtime's continuation has been taken; its arguments are
+  // already bound and wait in the runtime
+  int tail = 0;
 
   while (1) {
+    akx_rt_gc_safepoint(rt);
+
     if (!current_lambda || current_lambda->type != AKX_TYPE_LAMBDA) {
-      if (result) {
-        akx_cell_free(result);
-      }
+      drop_tail_args(rt);
       akx_rt_error(rt, "invalid lambda cell in trampoline");
       return NULL;
     }
 
     ak_lambda_t *lambda = current_lambda->value.lambda;
     if (!lambda) {
-      if (result) {
-        akx_cell_free(result);
-      }
+      drop_tail_args(rt);
       akx_rt_error(rt, "invalid lambda cell - no lambda data");
       return NULL;
     }
 
-    akx_rt_push_scope(rt);
-    ak_lambda_invoke(lambda, current_args);
-
     akx_lambda_context_t *lambda_ctx =
         (akx_lambda_context_t *)ak_lambda_get_context(lambda);
-    result = lambda_ctx ? lambda_ctx->result : NULL;
-
-    akx_rt_pop_scope(rt);
+    if (!lambda_ctx || push_lambda_frame(rt, lambda_ctx) != 0) {
+      drop_tail_args(rt);
+      akx_rt_error(rt, "failed to allocate a lambda frame");
+      return NULL;
+    }
+    int bound = tail ? bind_tail_args(rt)
+                     : bind_args(rt, lambda_ctx, current_args);
+    lambda_ctx->result = NULL;
+    if (bound == 0) {
+      ak_lambda_invoke(lambda, NULL);
+    }
+    result = lambda_ctx->result;
+    pop_lambda_frame(rt);
 
     if (!result) {
-      result = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
-      akx_rt_set_symbol(rt, result, "nil");
-      return result;
+      return akx_rt_nil(rt);
     }
 
     if (result->type != AKX_TYPE_CONTINUATION) {
@@ -807,12 +3086,15 @@ akx_cell_t *akx_rt_invoke_lambda(akx_runtime_ctx_t *rt, akx_cell_t *lambda_cell,
     akx_continuation_t *cont = result->value.continuation;
     if (!cont) {
       akx_cell_free(result);
+      drop_tail_args(rt);
       akx_rt_error(rt, "invalid continuation - no data");
       return NULL;
     }
 
+    // One from akx_rt_alloc_continuation still has its argument expressions
     current_lambda = cont->lambda_cell;
     current_args = cont->args;
+    tail = result == &rt->tail_cell;
 
     cont->lambda_cell = NULL;
     cont->args = NULL;
@@ -822,29 +3104,16 @@ akx_cell_t *akx_rt_invoke_lambda(akx_runtime_ctx_t *rt, akx_cell_t *lambda_cell,
 }
 
 void akx_rt_module_set_data(akx_runtime_ctx_t *rt, void *data) {
-  if (!rt || !rt->current_module_name) {
-    return;
-  }
-
-  void **info_ptr = map_get_generic(&rt->builtins, &rt->current_module_name);
-  if (info_ptr && *info_ptr) {
-    akx_builtin_info_t *info = (akx_builtin_info_t *)*info_ptr;
-    info->module_data = data;
+  if (rt && rt->current_builtin) {
+    rt->current_builtin->module_data = data;
   }
 }
 
 void *akx_rt_module_get_data(akx_runtime_ctx_t *rt) {
-  if (!rt || !rt->current_module_name) {
+  if (!rt || !rt->current_builtin) {
     return NULL;
   }
-
-  void **info_ptr = map_get_generic(&rt->builtins, &rt->current_module_name);
-  if (info_ptr && *info_ptr) {
-    akx_builtin_info_t *info = (akx_builtin_info_t *)*info_ptr;
-    return info->module_data;
-  }
-
-  return NULL;
+  return rt->current_builtin->module_data;
 }
 
 void akx_rt_add_builtin(akx_runtime_ctx_t *rt, const char *name,
@@ -853,6 +3122,7 @@ void akx_rt_add_builtin(akx_runtime_ctx_t *rt, const char *name,
     return;
   }
   map_set_generic(&rt->builtins, &name, info);
+  next_builtin_generation();
 }
 
 int akx_rt_register_builtin(akx_runtime_ctx_t *rt, const char *name,
@@ -860,7 +3130,8 @@ int akx_rt_register_builtin(akx_runtime_ctx_t *rt, const char *name,
                             ak_cjit_unit_t *unit,
                             void (*init_fn)(akx_runtime_ctx_t *),
                             void (*deinit_fn)(akx_runtime_ctx_t *),
-                            void (*reload_fn)(akx_runtime_ctx_t *, void *)) {
+                            void (*reload_fn)(akx_runtime_ctx_t *, void *),
+                            const akx_builtin_signature_t *signature) {
   if (!rt || !name) {
     return -1;
   }
@@ -874,7 +3145,7 @@ int akx_rt_register_builtin(akx_runtime_ctx_t *rt, const char *name,
     AK24_LOG_TRACE("Hot-reloading builtin: %s", name);
 
     void *old_state = existing_info->module_data;
-    rt->current_module_name = existing_info->module_name;
+    rt->current_builtin = existing_info;
 
     if (reload_fn) {
       AK24_LOG_DEBUG("Calling reload hook for %s", name);
@@ -893,6 +3164,7 @@ int akx_rt_register_builtin(akx_runtime_ctx_t *rt, const char *name,
     }
 
     existing_info->function = function;
+    existing_info->signature = signature;
     if (root_path) {
       existing_info->source_path = AK24_ALLOC(strlen(root_path) + 1);
       if (existing_info->source_path) {
@@ -912,7 +3184,7 @@ int akx_rt_register_builtin(akx_runtime_ctx_t *rt, const char *name,
       init_fn(rt);
     }
 
-    rt->current_module_name = NULL;
+    rt->current_builtin = NULL;
   } else {
     akx_builtin_info_t *info = AK24_ALLOC(sizeof(akx_builtin_info_t));
     if (!info) {
@@ -924,6 +3196,7 @@ int akx_rt_register_builtin(akx_runtime_ctx_t *rt, const char *name,
     }
 
     info->function = function;
+    info->signature = signature;
     if (root_path) {
       info->source_path = AK24_ALLOC(strlen(root_path) + 1);
       if (info->source_path) {
@@ -945,13 +3218,16 @@ int akx_rt_register_builtin(akx_runtime_ctx_t *rt, const char *name,
     AK24_LOG_DEBUG("Builtin info stored");
 
     if (init_fn) {
-      rt->current_module_name = info->module_name;
+      rt->current_builtin = info;
       AK24_LOG_DEBUG("Calling init hook for %s", name);
       init_fn(rt);
-      rt->current_module_name = NULL;
+      rt->current_builtin = NULL;
     }
   }
 
+  // Reloads keep the info in place, but its function and hooks changed
+  next_builtin_generation();
+
   AK24_LOG_TRACE("Successfully registered builtin '%s'", name);
   return 0;
 }
@@ -1097,3 +3373,159 @@ char **akx_rt_get_script_argv(akx_runtime_ctx_t *rt) {
   }
   return rt->script_argv;
 }
+
+int akx_rt_gc_enabled(akx_runtime_ctx_t *rt) { return rt && rt->gc ? 1 : 0; }
+
+void akx_rt_gc_collect(akx_runtime_ctx_t *rt) {
+  if (!rt || !rt->gc) {
+    return;
+  }
+
+  akx_rt_gc_begin(rt->gc);
+
+  // Module data is opaque; it is kept when it is a cell itself, anything a
+  // module holds inside it has to be rooted explicitly
+  map_iter_t iter = map_iter(&rt->builtins);
+  const char **key_ptr;
+  while ((key_ptr = (const char **)map_next_generic(&rt->builtins, &iter))) {
+    void **info_ptr = map_get_generic(&rt->builtins, key_ptr);
+    if (info_ptr && *info_ptr) {
+      akx_rt_gc_mark(rt->gc, ((akx_builtin_info_t *)*info_ptr)->module_data);
+    }
+  }
+
+  for (akx_rt_scope_t *scope = rt->scope; scope; scope = scope->parent) {
+    for (size_t i = 0; i < scope->count; i++) {
+      void *value = scope->map
+                        ? ak_context_get_local(scope->map, scope->names[i])
+                        : scope->values[i];
+      akx_rt_gc_mark(rt->gc, value);
+    }
+  }
+  for (size_t i = 0; i < rt->tail_argc; i++) {
+    akx_rt_gc_mark(rt->gc, rt->tail_args[i]);
+  }
+  for (size_t i = 0; i < rt->kont_value_count; i++) {
+    akx_rt_gc_mark(rt->gc, rt->kont_values[i].cell);
+  }
+  kont_chunk_t *chunk = rt->kont_chunk;
+  size_t used = rt->kont_used;
+  for (size_t depth = rt->kont_depth; depth > 0; depth--) {
+    if (used == 0) {
+      chunk = chunk->prev;
+      used = AKX_RT_KONT_CHUNK;
+    }
+    akx_rt_gc_mark(rt->gc, chunk->konts[--used].owned);
+  }
+  akx_rt_vm_mark(rt->vm, rt->gc);
+
+  akx_rt_gc_finish(rt->gc);
+}
+
+void akx_rt_gc_safepoint(akx_runtime_ctx_t *rt) {
+  if (rt && akx_rt_gc_due(rt->gc)) {
+    akx_rt_gc_collect(rt);
+  }
+}
+
+void akx_rt_gc_push_roots(akx_runtime_ctx_t *rt, akx_cell_t **slots,
+                          size_t count) {
+  if (rt && rt->gc && slots) {
+    akx_rt_gc_push(rt->gc, slots, count);
+  }
+}
+
+void akx_rt_gc_pop_roots(akx_runtime_ctx_t *rt, akx_cell_t **slots) {
+  if (rt && rt->gc) {
+    akx_rt_gc_pop(rt->gc, slots);
+  }
+}
+
+int akx_rt_gc_get_stats(akx_runtime_ctx_t *rt, akx_rt_gc_stats_t *stats) {
+  if (!stats) {
+    return -1;
+  }
+  memset(stats, 0, sizeof(*stats));
+  if (!rt || !rt->gc) {
+    return -1;
+  }
+  akx_rt_gc_read_stats(rt->gc, stats);
+  return 0;
+}
+
+int akx_rt_jit_get_stats(akx_runtime_ctx_t *rt, akx_rt_jit_stats_t *stats) {
+  if (!stats) {
+    return -1;
+  }
+  memset(stats, 0, sizeof(*stats));
+  if (!rt || !rt->jit) {
+    return -1;
+  }
+  akx_rt_jit_read_stats(rt->jit, stats);
+  return 0;
+}
+
+akx_cell_t *akx_rt_jit_run(akx_runtime_ctx_t *rt,
+                           akx_lambda_context_t *lambda_ctx) {
+  return rt->jit ? akx_rt_jit_enter(rt->jit, lambda_ctx) : NULL;
+}
+
+akx_rt_jit_trace_t *akx_rt_jit_loop_trace(akx_runtime_ctx_t *rt,
+                                          akx_cell_t *args) {
+  return rt->jit && args ? akx_rt_jit_trace_get(rt->jit, args) : NULL;
+}
+
+int akx_rt_jit_loop_run(akx_runtime_ctx_t *rt, akx_rt_jit_trace_t *trace,
+                        akx_cell_t **last) {
+  *last = NULL;
+  return trace ? akx_rt_jit_trace_run(rt->jit, trace, last) : 0;
+}
+
+void akx_rt_jit_loop_step(akx_runtime_ctx_t *rt, akx_rt_jit_trace_t *trace) {
+  if (trace) {
+    akx_rt_jit_trace_step(rt->jit, trace);
+  }
+}
+
+void akx_rt_jit_branch(akx_runtime_ctx_t *rt, akx_cell_t *args, int taken) {
+  if (rt->jit) {
+    akx_rt_jit_record_branch(rt->jit, args, taken);
+  }
+}
+
+// The parameters are the first slots of a frame without a map
+void **akx_rt_frame_slots(akx_runtime_ctx_t *rt,
+                          akx_lambda_context_t *lambda_ctx) {
+  akx_rt_scope_t *frame = rt->frame;
+  if (!frame || frame->owner != lambda_ctx || frame->map) {
+    return NULL;
+  }
+  return frame->values;
+}
+
+void *akx_rt_alloc_mem(akx_runtime_ctx_t *rt, size_t size) {
+  if (rt && rt->slab) {
+    return akx_rt_slab_alloc(rt->slab, size);
+  }
+  return AK24_ALLOC(size);
+}
+
+void akx_rt_free_mem(akx_runtime_ctx_t *rt, void *ptr, size_t size) {
+  if (rt && rt->slab) {
+    akx_rt_slab_release(rt->slab, ptr, size);
+  } else if (ptr) {
+    AK24_FREE(ptr);
+  }
+}
+
+int akx_rt_slab_get_stats(akx_runtime_ctx_t *rt, akx_rt_slab_stats_t *stats) {
+  if (!stats) {
+    return -1;
+  }
+  memset(stats, 0, sizeof(*stats));
+  if (!rt || !rt->slab) {
+    return -1;
+  }
+  akx_rt_slab_read_stats(rt->slab, stats);
+  return 0;
+}
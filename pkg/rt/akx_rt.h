@@ -8,6 +8,7 @@
 #include <ak24/kernel.h>
 #include <ak24/list.h>
 #include <stdarg.h>
+#include <stdint.h>
 
 #define AKX_RT_META_STRING_SIZE_MAX 256
 
@@ -19,8 +20,58 @@ typedef list_t(akx_cell_t *) akx_cell_list_t;
 
 typedef akx_cell_t *(*akx_builtin_fn)(akx_runtime_ctx_t *, akx_cell_t *);
 
+// An evaluated argument of a v2 builtin. cell belongs to the runtime; the
+// scalar fields are decoded from it. A bignum leaves as.integer 0 and is
+// read through cell.
 typedef struct {
-  akx_builtin_fn function;
+  akx_cell_t *cell;
+  akx_type_t type;
+  union {
+    int64_t integer;
+    double real;
+    const char *text;
+  } as;
+} akx_value_t;
+
+// A v2 builtin result: either a cell the builtin made, or a scalar the
+// runtime turns into a cell (small integers and symbols need no allocation)
+#define AKX_VALUE_CELL(c) ((akx_value_t){.cell = (c)})
+#define AKX_VALUE_INT(v)                                                       \
+  ((akx_value_t){.type = AKX_TYPE_INTEGER_LITERAL, .as.integer = (v)})
+#define AKX_VALUE_REAL(v)                                                      \
+  ((akx_value_t){.type = AKX_TYPE_REAL_LITERAL, .as.real = (v)})
+#define AKX_VALUE_SYMBOL(v)                                                    \
+  ((akx_value_t){.type = AKX_TYPE_SYMBOL, .as.text = (v)})
+
+#define AKX_ARG(type) (1u << (type))
+#define AKX_ARG_ANY 0u
+// Lets integers that do not fit int64 through; without it (and without
+// AKX_ARG_ANY) a bignum argument is a runtime error
+#define AKX_ARG_BIGNUM (1u << 31)
+#define AKX_ARGS_VARIADIC UINT16_MAX
+
+// Builtin ABI v2. A builtin that defines `<fn>_signature` next to `<fn>` is
+// strict: the runtime checks its arity, evaluates every argument in order
+// and checks it against accepts (a mask of AKX_ARG bits, or AKX_ARG_ANY),
+// then calls it with the values. The function reports errors itself and
+// returns -1; on success it stores its result and returns 0.
+typedef struct {
+  const char *name;
+  uint16_t min_args;
+  uint16_t max_args;
+  uint32_t accepts;
+} akx_builtin_signature_t;
+
+typedef int (*akx_builtin_v2_fn)(akx_runtime_ctx_t *, akx_value_t *argv,
+                                 size_t argc, akx_value_t *result);
+
+typedef struct {
+  union {
+    akx_builtin_fn function;
+    // Called instead of function when signature is set
+    akx_builtin_v2_fn strict_function;
+  };
+  const akx_builtin_signature_t *signature;
   char *source_path;
   time_t load_time;
 
@@ -51,6 +102,14 @@ akx_runtime_ctx_t *akx_runtime_init(void);
 
 void akx_runtime_deinit(akx_runtime_ctx_t *ctx);
 
+// Picks the evaluator before any code runs: "tree" (the default), "stack"
+// or "vm". Returns -1 for a name it does not know.
+int akx_runtime_set_engine(akx_runtime_ctx_t *ctx, const char *name);
+
+// Quickening rewrites builtin calls of the int nuclei into direct int
+// operations after their first run; disabling it reverts every such site
+void akx_runtime_set_quicken(akx_runtime_ctx_t *ctx, int enabled);
+
 void akx_runtime_set_script_args(akx_runtime_ctx_t *ctx, int argc, char **argv);
 
 int akx_rt_get_script_argc(akx_runtime_ctx_t *rt);
@@ -69,9 +128,23 @@ int akx_runtime_load_builtin_ex(akx_runtime_ctx_t *rt, const char *name,
 akx_cell_t *akx_rt_alloc_cell(akx_runtime_ctx_t *rt, akx_type_t type);
 void akx_rt_free_cell(akx_runtime_ctx_t *rt, akx_cell_t *cell);
 
+// Small integers and the nil, t, true and false symbols are shared immediate
+// cells, and values read from bindings are shared with the binding. Freeing a
+// shared cell only drops that owner; shared cells must not be linked into a
+// list or modified, so use akx_rt_unshare() first when a result will be.
+akx_cell_t *akx_rt_make_int(akx_runtime_ctx_t *rt, int64_t value);
+akx_cell_t *akx_rt_make_symbol(akx_runtime_ctx_t *rt, const char *sym);
+akx_cell_t *akx_rt_nil(akx_runtime_ctx_t *rt);
+akx_cell_t *akx_rt_unshare(akx_runtime_ctx_t *rt, akx_cell_t *cell);
+// Takes another owner of a single value (not its siblings); copies only when
+// the cell cannot be shared
+akx_cell_t *akx_rt_copy(akx_runtime_ctx_t *rt, akx_cell_t *cell);
+
+// Setters raise a runtime error, and leave the cell alone, when it is a
+// shared immediate
 void akx_rt_set_symbol(akx_runtime_ctx_t *rt, akx_cell_t *cell,
                        const char *sym);
-void akx_rt_set_int(akx_runtime_ctx_t *rt, akx_cell_t *cell, int value);
+void akx_rt_set_int(akx_runtime_ctx_t *rt, akx_cell_t *cell, int64_t value);
 void akx_rt_set_real(akx_runtime_ctx_t *rt, akx_cell_t *cell, double value);
 void akx_rt_set_string(akx_runtime_ctx_t *rt, akx_cell_t *cell,
                        const char *str);
@@ -82,25 +155,85 @@ void akx_rt_set_lambda(akx_runtime_ctx_t *rt, akx_cell_t *cell,
 int akx_rt_cell_is_type(akx_cell_t *cell, akx_type_t type);
 akx_type_t akx_rt_cell_get_type(akx_cell_t *cell);
 const char *akx_rt_cell_as_symbol(akx_cell_t *cell);
-int akx_rt_cell_as_int(akx_cell_t *cell);
+// 0 for anything but an integer that fits int64; akx_rt_cell_to_int() is
+// the checked form
+int64_t akx_rt_cell_as_int(akx_cell_t *cell);
+// Stores an integer cell's value in *out. A bignum raises a runtime error
+// and returns -1 instead of being cut down to 64 bits.
+int akx_rt_cell_to_int(akx_runtime_ctx_t *rt, akx_cell_t *cell,
+                       int64_t *out);
 double akx_rt_cell_as_real(akx_cell_t *cell);
 const char *akx_rt_cell_as_string(akx_cell_t *cell);
 akx_cell_t *akx_rt_cell_as_list(akx_cell_t *cell);
 ak_lambda_t *akx_rt_cell_as_lambda(akx_cell_t *cell);
 akx_cell_t *akx_rt_cell_next(akx_cell_t *cell);
 
+// Integer cells hold an int64 and promote to a bignum on overflow. These
+// take evaluated integer cells and return a new cell, demoted back to int64
+// whenever the result fits. Division truncates toward zero like C.
+int akx_rt_cell_is_bignum(akx_cell_t *cell);
+akx_cell_t *akx_rt_int_add(akx_runtime_ctx_t *rt, akx_cell_t *a,
+                           akx_cell_t *b);
+akx_cell_t *akx_rt_int_sub(akx_runtime_ctx_t *rt, akx_cell_t *a,
+                           akx_cell_t *b);
+akx_cell_t *akx_rt_int_mul(akx_runtime_ctx_t *rt, akx_cell_t *a,
+                           akx_cell_t *b);
+akx_cell_t *akx_rt_int_div(akx_runtime_ctx_t *rt, akx_cell_t *a,
+                           akx_cell_t *b);
+akx_cell_t *akx_rt_int_mod(akx_runtime_ctx_t *rt, akx_cell_t *a,
+                           akx_cell_t *b);
+int akx_rt_int_cmp(akx_cell_t *a, akx_cell_t *b);
+ak_buffer_t *akx_rt_int_to_buffer(akx_cell_t *cell);
+
 size_t akx_rt_list_length(akx_cell_t *list);
 akx_cell_t *akx_rt_list_nth(akx_cell_t *list, size_t n);
 akx_cell_t *akx_rt_list_append(akx_runtime_ctx_t *rt, akx_cell_t *list,
                                akx_cell_t *item);
 
+// Builds a list front to back in O(1) per item; start from a zeroed builder
+typedef struct {
+  akx_cell_t *head;
+  akx_cell_t *tail;
+} akx_rt_list_builder_t;
+
+// Takes ownership of item, unsharing it first
+int akx_rt_list_builder_push(akx_runtime_ctx_t *rt,
+                             akx_rt_list_builder_t *builder, akx_cell_t *item);
+// Wraps the items in a list cell and empties the builder
+akx_cell_t *akx_rt_list_builder_finish(akx_runtime_ctx_t *rt,
+                                       akx_rt_list_builder_t *builder);
+void akx_rt_list_builder_discard(akx_runtime_ctx_t *rt,
+                                 akx_rt_list_builder_t *builder);
+
+// Scopes are flat frames on the runtime's frame stack, apart from the global
+// scope. akx_rt_get_scope() is the escape hatch for code that needs an
+// ak_context_t: it moves the current scope and those around it into maps,
+// which keep working (more slowly) until their frames are popped.
+typedef struct akx_rt_scope_t akx_rt_scope_t;
+
 ak_context_t *akx_rt_get_scope(akx_runtime_ctx_t *rt);
 int akx_rt_scope_set(akx_runtime_ctx_t *rt, const char *key, void *value);
 void *akx_rt_scope_get(akx_runtime_ctx_t *rt, const char *key);
+int akx_rt_scope_has_local(akx_runtime_ctx_t *rt, const char *key);
+// The scope that binds a symbol cell's name, or NULL when it is unbound
+akx_rt_scope_t *akx_rt_scope_find(akx_runtime_ctx_t *rt, akx_cell_t *symbol);
+// Rebinds key in scope, which must be the current scope or enclose it, and
+// stores the value it replaced in old_value when that is not NULL
+int akx_rt_scope_assign(akx_runtime_ctx_t *rt, akx_rt_scope_t *scope,
+                        const char *key, void *value, void **old_value);
 
 void akx_rt_push_scope(akx_runtime_ctx_t *rt);
+// slots is how many bindings the scope is expected to hold; more still fit
+void akx_rt_push_scope_sized(akx_runtime_ctx_t *rt, size_t slots);
 void akx_rt_pop_scope(akx_runtime_ctx_t *rt);
 
+// Number of let forms anywhere in body, for sizing its scope
+size_t akx_rt_count_lets(akx_cell_t *body);
+// Points the parameter references in body at the slots of owner's frames
+void akx_rt_resolve_locals(akx_runtime_ctx_t *rt, const void *owner,
+                           const char **names, size_t count,
+                           akx_cell_t *body);
+
 void akx_rt_error(akx_runtime_ctx_t *rt, const char *message);
 void akx_rt_error_at(akx_runtime_ctx_t *rt, akx_cell_t *cell,
                      const char *message);
@@ -108,6 +241,10 @@ void akx_rt_error_fmt(akx_runtime_ctx_t *rt, const char *fmt, ...);
 
 akx_cell_t *akx_rt_eval(akx_runtime_ctx_t *rt, akx_cell_t *expr);
 akx_cell_t *akx_rt_eval_tail(akx_runtime_ctx_t *rt, akx_cell_t *expr);
+// For a builtin's last step: evaluates expr as a tail call when the builtin
+// itself was called in tail position. A continuation it returns must be
+// handed back unchanged as the builtin's result.
+akx_cell_t *akx_rt_eval_in_tail(akx_runtime_ctx_t *rt, akx_cell_t *expr);
 akx_cell_t *akx_rt_eval_list(akx_runtime_ctx_t *rt, akx_cell_t *list);
 akx_cell_t *akx_rt_eval_and_assert(akx_runtime_ctx_t *rt, akx_cell_t *expr,
                                    akx_type_t expected_type,
@@ -135,7 +272,70 @@ int akx_rt_register_builtin(akx_runtime_ctx_t *rt, const char *name,
                             ak_cjit_unit_t *unit,
                             void (*init_fn)(akx_runtime_ctx_t *),
                             void (*deinit_fn)(akx_runtime_ctx_t *),
-                            void (*reload_fn)(akx_runtime_ctx_t *, void *));
+                            void (*reload_fn)(akx_runtime_ctx_t *, void *),
+                            const akx_builtin_signature_t *signature);
 
 map_void_t *akx_rt_get_builtins(akx_runtime_ctx_t *rt);
+
+typedef struct {
+  size_t collections;
+  size_t heap_cells;
+  size_t heap_bytes;
+  size_t live_cells;
+  size_t freed_cells;
+  uint64_t last_pause_ns;
+  uint64_t max_pause_ns;
+  uint64_t total_pause_ns;
+} akx_rt_gc_stats_t;
+
+// With AKX_GC=1 at startup, heap cells belong to a tracing collector:
+// akx_cell_free() leaves them alone and unreachable cells are reclaimed at
+// safepoints. Cells held by a nucleus outside its locals (e.g. in a heap
+// array) must be rooted across evaluation; every push is undone by a pop of
+// the same slots. Without the collector these calls do nothing.
+int akx_rt_gc_enabled(akx_runtime_ctx_t *rt);
+void akx_rt_gc_collect(akx_runtime_ctx_t *rt);
+void akx_rt_gc_safepoint(akx_runtime_ctx_t *rt);
+void akx_rt_gc_push_roots(akx_runtime_ctx_t *rt, akx_cell_t **slots,
+                          size_t count);
+void akx_rt_gc_pop_roots(akx_runtime_ctx_t *rt, akx_cell_t **slots);
+int akx_rt_gc_get_stats(akx_runtime_ctx_t *rt, akx_rt_gc_stats_t *stats);
+
+typedef struct {
+  size_t slabs;
+  size_t peak_slabs;
+  size_t slab_bytes;
+  size_t live_objects;
+  size_t peak_objects;
+  size_t allocations;
+} akx_rt_slab_stats_t;
+
+// Small runtime objects (cells, continuation frames, lambda contexts) come
+// from per-runtime slabs when AKX_SLAB=1. Memory from akx_rt_alloc_mem()
+// goes back through akx_rt_free_mem() on the runtime's thread, with the size
+// it was allocated with.
+void *akx_rt_alloc_mem(akx_runtime_ctx_t *rt, size_t size);
+void akx_rt_free_mem(akx_runtime_ctx_t *rt, void *ptr, size_t size);
+int akx_rt_slab_get_stats(akx_runtime_ctx_t *rt, akx_rt_slab_stats_t *stats);
+
+typedef struct {
+  size_t tier_ups;
+  size_t rejected;
+  size_t failed;
+  size_t native_calls;
+  size_t deopts;
+  size_t invalidations;
+  // Loop traces compiled, runs that left them early, iterations they ran
+  size_t traces;
+  size_t side_exits;
+  uint64_t native_iterations;
+  uint64_t last_compile_ns;
+  uint64_t max_compile_ns;
+  uint64_t total_compile_ns;
+} akx_rt_jit_stats_t;
+
+// With AKX_JIT=1 at startup, lambdas called AKX_JIT_THRESHOLD times (1000
+// by default) are compiled to native code when their bodies allow it, and
+// so are loops that iterate as often. Returns -1 when the JIT is off.
+int akx_rt_jit_get_stats(akx_runtime_ctx_t *rt, akx_rt_jit_stats_t *stats);
 #endif
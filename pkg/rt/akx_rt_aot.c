@@ -0,0 +1,153 @@
+#include "akx_rt_aot.h"
+#include "akx_rt_vm.h"
+#include "akx_sv.h"
+#include <ak24/buffer.h>
+#include <ak24/intern.h>
+#include <string.h>
+
+static void show_errors(akx_parse_error_t *err) {
+  while (err) {
+    akx_sv_show_location(&err->location, AKX_ERROR_LEVEL_ERROR, err->message);
+    err = err->next;
+  }
+}
+
+typedef struct {
+  const akx_rt_aot_program_t *program;
+  // The runtime's info for each nucleus, NULL where it is not the one the
+  // program linked
+  akx_builtin_info_t **infos;
+  // The next site to bind, and the number of the next list cell
+  size_t site;
+  uint32_t cell;
+} aot_binder_t;
+
+static int is_list(const akx_cell_t *cell) {
+  return cell->type == AKX_TYPE_LIST || cell->type == AKX_TYPE_LIST_SQUARE ||
+         cell->type == AKX_TYPE_LIST_CURLY ||
+         cell->type == AKX_TYPE_LIST_TEMPLE;
+}
+
+// Numbers list cells the way akx compile did, binding each lowered one. A
+// site whose head is not the nucleus it was lowered for means the image and
+// the table disagree, and it is left to the interpreter.
+static void bind_sites(aot_binder_t *binder, akx_cell_t *cell) {
+  const akx_rt_aot_program_t *program = binder->program;
+  if (cell->type == AKX_TYPE_QUOTED) {
+    return;
+  }
+  if (is_list(cell)) {
+    uint32_t number = binder->cell++;
+    while (binder->site < program->site_count &&
+           program->sites[binder->site].cell < number) {
+      binder->site++;
+    }
+    if (binder->site < program->site_count &&
+        program->sites[binder->site].cell == number &&
+        binder->site <= UINT16_MAX) {
+      const akx_rt_aot_site_t *site = &program->sites[binder->site];
+      akx_cell_t *head = cell->value.list_head;
+      akx_builtin_info_t *info = binder->infos[site->nucleus];
+      if (info && head && head->type == AKX_TYPE_SYMBOL &&
+          strcmp(head->value.symbol, program->nuclei[site->nucleus].name) ==
+              0) {
+        akx_rt_bind_native_site(cell, info, (uint16_t)binder->site);
+      }
+    }
+  }
+
+  akx_cell_t *children[2];
+  size_t count = akx_cell_children(cell, children);
+  for (size_t i = 0; i < count; i++) {
+    for (akx_cell_t *child = children[i]; child; child = child->next) {
+      bind_sites(binder, child);
+    }
+  }
+}
+
+// The runtime registered the same compiled-in nuclei the binary linked; a
+// nucleus whose registration points elsewhere keeps being looked up
+static void bind_natives(akx_runtime_ctx_t *rt,
+                         const akx_rt_aot_program_t *program,
+                         akx_parse_result_t *result) {
+  if (program->nucleus_count == 0 || program->site_count == 0) {
+    return;
+  }
+  akx_builtin_info_t **infos =
+      AK24_ALLOC(program->nucleus_count * sizeof(akx_builtin_info_t *));
+  if (!infos) {
+    return;
+  }
+
+  for (size_t i = 0; i < program->nucleus_count; i++) {
+    const akx_rt_aot_nucleus_t *nucleus = &program->nuclei[i];
+    const char *name = ak_intern(nucleus->name);
+    akx_builtin_info_t *info = akx_rt_resolve_builtin(rt, NULL, name);
+    if (info && (nucleus->strict_function
+                     ? info->strict_function != nucleus->strict_function ||
+                           !info->signature
+                     : info->function != nucleus->function ||
+                           info->signature)) {
+      AK24_LOG_TRACE("Nucleus '%s' is not the one compiled in", name);
+      info = NULL;
+    }
+    infos[i] = info;
+  }
+
+  akx_rt_set_native_sites(rt, program->sites, program->site_count);
+  aot_binder_t binder = {program, infos, 0, 0};
+  list_iter_t iter = list_iter(&result->cells);
+  akx_cell_t **cell_ptr;
+  while ((cell_ptr = list_next(&result->cells, &iter))) {
+    bind_sites(&binder, *cell_ptr);
+  }
+  AK24_FREE(infos);
+}
+
+int akx_rt_aot_main(const akx_rt_aot_program_t *program, int argc,
+                    char **argv) {
+  ak_log_set_level(AK24_LOG_LEVEL_INFO);
+  ak_log_set_color(true);
+  ak_log_set_path_format(AK24_LOG_PATH_ABBREV);
+
+  akx_runtime_ctx_t *rt = akx_runtime_init();
+  if (!rt) {
+    AK24_LOG_ERROR("Failed to initialize AKX runtime");
+    return 1;
+  }
+  akx_runtime_set_script_args(rt, argc, argv);
+
+  ak_buffer_t *source = ak_buffer_new(program->source_length + 1);
+  if (!source ||
+      ak_buffer_copy_to(source, program->source, program->source_length) !=
+          0) {
+    AK24_LOG_ERROR("Failed to allocate script source");
+    if (source) {
+      ak_buffer_free(source);
+    }
+    akx_runtime_deinit(rt);
+    return 1;
+  }
+
+  akx_parse_result_t result;
+  int rc = akx_cell_deserialize(program->cells, program->cells_length, source,
+                                program->filename, &result);
+  ak_buffer_free(source);
+  if (rc != 0) {
+    AK24_LOG_ERROR("Corrupt program image for %s", program->filename);
+    akx_runtime_deinit(rt);
+    return 1;
+  }
+
+  bind_natives(rt, program, &result);
+
+  int status = 0;
+  if (akx_runtime_start(rt, (akx_cell_list_t *)&result.cells) != 0) {
+    show_errors(akx_runtime_get_errors(rt));
+    status = 1;
+  }
+
+  akx_parse_result_free(&result);
+  akx_runtime_deinit(rt);
+  return status;
+}
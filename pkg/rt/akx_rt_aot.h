@@ -0,0 +1,98 @@
+#ifndef AKX_RT_AOT_H
+#define AKX_RT_AOT_H
+
+#include "akx_rt.h"
+
+// Entry point of binaries built by akx compile. The script was parsed when
+// it was compiled and comes in serialized. Every call of a compiled-in
+// nucleus was lowered to a C function that calls the nucleus directly and
+// evaluates nested nucleus calls the same way; those functions are bound to
+// their call sites before the first form runs. Everything else (lambdas,
+// symbols, nuclei that are not compiled in) runs on the interpreter.
+typedef struct {
+  const char *name;
+  // One of the two, as the nucleus is legacy or strict
+  akx_builtin_fn function;
+  akx_builtin_v2_fn strict_function;
+} akx_rt_aot_nucleus_t;
+
+// Lowered code for one call. tail is set when the call is in tail position.
+typedef akx_cell_t *(*akx_rt_native_fn)(akx_runtime_ctx_t *rt,
+                                        akx_cell_t *call, int tail);
+
+// A call lowered to function. cell numbers the call among the program's list
+// cells, counted depth first through every form but not into quotes.
+typedef struct {
+  uint32_t cell;
+  uint32_t nucleus;
+  akx_rt_native_fn function;
+} akx_rt_aot_site_t;
+
+typedef struct {
+  const char *filename;
+  // The script's text, for error locations
+  const uint8_t *source;
+  size_t source_length;
+  // akx_cell_serialize() of the parsed script
+  const uint8_t *cells;
+  size_t cells_length;
+  const akx_rt_aot_nucleus_t *nuclei;
+  size_t nucleus_count;
+  const akx_rt_aot_site_t *sites;
+  size_t site_count;
+} akx_rt_aot_program_t;
+
+// Runs the program with argv as the script's arguments; returns the exit
+// status, 1 if a form failed
+int akx_rt_aot_main(const akx_rt_aot_program_t *program, int argc,
+                    char **argv);
+
+// What lowered code calls, from akx_rt.c. A frame stands for the nucleus
+// call in progress, as the interpreter would make it.
+typedef struct {
+  akx_builtin_info_t *info;
+  akx_builtin_info_t *caller;
+  int caller_tail;
+  int errors;
+  // Arguments the call was made with, and how many are in argv so far
+  size_t argc;
+  size_t count;
+} akx_rt_native_frame_t;
+
+// Whether call's site is still bound to its lowered function; a reloaded
+// nucleus unbinds every site, which then runs on the interpreter
+int akx_rt_native_bound(akx_cell_t *call);
+
+// A legacy nucleus call: enter, call the nucleus with the unevaluated
+// arguments, then leave with its result
+void akx_rt_native_enter(akx_runtime_ctx_t *rt, akx_rt_native_frame_t *frame,
+                         akx_cell_t *call, int tail);
+akx_cell_t *akx_rt_native_leave(akx_runtime_ctx_t *rt,
+                                akx_rt_native_frame_t *frame,
+                                akx_cell_t *result);
+
+// A strict nucleus call of argc arguments: enter (which checks the count),
+// hand over each evaluated argument in order, check, call the nucleus and
+// finish. Any step but the call returning non-zero ends it with fail.
+int akx_rt_native_enter_strict(akx_runtime_ctx_t *rt,
+                               akx_rt_native_frame_t *frame, akx_cell_t *call,
+                               int tail, size_t argc);
+int akx_rt_native_arg(akx_runtime_ctx_t *rt, akx_rt_native_frame_t *frame,
+                      akx_value_t *argv, akx_cell_t *value);
+int akx_rt_native_check(akx_runtime_ctx_t *rt, akx_rt_native_frame_t *frame,
+                        akx_value_t *argv);
+akx_cell_t *akx_rt_native_finish(akx_runtime_ctx_t *rt,
+                                 akx_rt_native_frame_t *frame,
+                                 akx_value_t *argv, int status,
+                                 const akx_value_t *result);
+akx_cell_t *akx_rt_native_fail(akx_runtime_ctx_t *rt,
+                               akx_rt_native_frame_t *frame,
+                               akx_value_t *argv);
+
+// From akx_rt.c: binds call to the index-th of the runtime's lowered sites
+void akx_rt_bind_native_site(akx_cell_t *call, akx_builtin_info_t *info,
+                             uint16_t index);
+void akx_rt_set_native_sites(akx_runtime_ctx_t *rt,
+                             const akx_rt_aot_site_t *sites, size_t count);
+
+#endif
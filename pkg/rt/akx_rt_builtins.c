@@ -112,13 +112,7 @@ static akx_cell_t *builtin_cjit_load_builtin(akx_runtime_ctx_t *rt,
     AK24_FREE((void *)c_function_name);
   akx_compiler_free_compile_opts(&opts);
 
-  akx_cell_t *ret = akx_rt_alloc_cell(rt, AKX_TYPE_SYMBOL);
-  if (result == 0) {
-    akx_rt_set_symbol(rt, ret, "t");
-  } else {
-    akx_rt_set_symbol(rt, ret, "nil");
-  }
-  return ret;
+  return akx_rt_make_symbol(rt, result == 0 ? "t" : "nil");
 
 cleanup_error:
   if (root_path)
@@ -137,6 +131,7 @@ void akx_rt_register_bootstrap_builtins(akx_runtime_ctx_t *rt) {
   akx_builtin_info_t *bootstrap_info = AK24_ALLOC(sizeof(akx_builtin_info_t));
   if (bootstrap_info) {
     bootstrap_info->function = builtin_cjit_load_builtin;
+    bootstrap_info->signature = NULL;
     bootstrap_info->source_path = NULL;
     bootstrap_info->load_time = time(NULL);
     bootstrap_info->init_fn = NULL;
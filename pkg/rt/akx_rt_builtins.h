@@ -3,14 +3,47 @@
 
 #include "akx_rt.h"
 
+// A lambda body compiled by the VM engine
+typedef struct akx_rt_code_t akx_rt_code_t;
+// Native code for a hot lambda body, from the JIT
+typedef struct akx_rt_jit_code_t akx_rt_jit_code_t;
+// What the JIT knows about one loop form
+typedef struct akx_rt_jit_trace_t akx_rt_jit_trace_t;
+
 typedef struct {
   akx_runtime_ctx_t *rt;
   const char **param_names;
   size_t param_count;
+  // Slots the call's frame starts with: parameters plus lets in the body
+  size_t local_count;
   akx_cell_t *body;
   akx_cell_t *result;
+  // Compiled on the first call under --engine=vm
+  akx_rt_code_t *code;
+  // Calls counted towards the JIT threshold, and the code they led to
+  uint32_t calls;
+  akx_rt_jit_code_t *jit;
 } akx_lambda_context_t;
 
+void akx_rt_code_free(akx_rt_code_t *code);
+void akx_rt_jit_code_free(akx_rt_jit_code_t *code);
+// The body's value computed by native code, or NULL to interpret it
+akx_cell_t *akx_rt_jit_run(akx_runtime_ctx_t *rt,
+                           akx_lambda_context_t *lambda_ctx);
+
+// For loop: the loop's trace (NULL without the JIT or once the loop is
+// known not to compile), run before each iteration and stepped after it.
+// akx_rt_jit_loop_run() returns 1 when native code ran the loop to the end,
+// 0 to interpret the next iteration and -1 on error; last is set to the
+// value of the last iteration native code ran, if any.
+akx_rt_jit_trace_t *akx_rt_jit_loop_trace(akx_runtime_ctx_t *rt,
+                                          akx_cell_t *args);
+int akx_rt_jit_loop_run(akx_runtime_ctx_t *rt, akx_rt_jit_trace_t *trace,
+                        akx_cell_t **last);
+void akx_rt_jit_loop_step(akx_runtime_ctx_t *rt, akx_rt_jit_trace_t *trace);
+// For if: the way an if went, recorded while a loop is being traced
+void akx_rt_jit_branch(akx_runtime_ctx_t *rt, akx_cell_t *args, int taken);
+
 void akx_rt_register_bootstrap_builtins(akx_runtime_ctx_t *rt);
 
 #endif
@@ -406,6 +406,7 @@ const char *akx_compiler_generate_abi_header(void) {
          "typedef struct akx_runtime_ctx_t akx_runtime_ctx_t;\n"
          "typedef struct akx_cell_t akx_cell_t;\n"
          "typedef struct ak_context_t ak_context_t;\n"
+         "typedef struct akx_rt_scope_t akx_rt_scope_t;\n"
          "typedef struct ak_lambda_t ak_lambda_t;\n"
          "\n"
          "typedef enum {\n"
@@ -425,17 +426,65 @@ const char *akx_compiler_generate_abi_header(void) {
          "typedef akx_cell_t* (*akx_builtin_fn)(akx_runtime_ctx_t*, "
          "akx_cell_t*);\n"
          "\n"
+         "typedef struct {\n"
+         "  akx_cell_t *cell;\n"
+         "  akx_type_t type;\n"
+         "  union {\n"
+         "    int64_t integer;\n"
+         "    double real;\n"
+         "    const char *text;\n"
+         "  } as;\n"
+         "} akx_value_t;\n"
+         "\n"
+         "#define AKX_VALUE_CELL(c) ((akx_value_t){.cell = (c)})\n"
+         "#define AKX_VALUE_INT(v) ((akx_value_t){.type = "
+         "AKX_TYPE_INTEGER_LITERAL, .as.integer = (v)})\n"
+         "#define AKX_VALUE_REAL(v) ((akx_value_t){.type = "
+         "AKX_TYPE_REAL_LITERAL, .as.real = (v)})\n"
+         "#define AKX_VALUE_SYMBOL(v) ((akx_value_t){.type = "
+         "AKX_TYPE_SYMBOL, .as.text = (v)})\n"
+         "\n"
+         "#define AKX_ARG(type) (1u << (type))\n"
+         "#define AKX_ARG_ANY 0u\n"
+         "#define AKX_ARG_BIGNUM (1u << 31)\n"
+         "#define AKX_ARGS_VARIADIC UINT16_MAX\n"
+         "\n"
+         "typedef struct {\n"
+         "  const char *name;\n"
+         "  uint16_t min_args;\n"
+         "  uint16_t max_args;\n"
+         "  uint32_t accepts;\n"
+         "} akx_builtin_signature_t;\n"
+         "\n"
+         "typedef struct {\n"
+         "  akx_cell_t *head;\n"
+         "  akx_cell_t *tail;\n"
+         "} akx_rt_list_builder_t;\n"
+         "\n"
          "extern akx_type_t akx_rt_cell_get_type(akx_cell_t *cell);\n"
          "\n"
          "extern akx_cell_t* akx_rt_alloc_cell(akx_runtime_ctx_t *rt, "
          "akx_type_t type);\n"
          "extern void akx_rt_free_cell(akx_runtime_ctx_t *rt, akx_cell_t "
          "*cell);\n"
+         "extern akx_cell_t* akx_rt_make_int(akx_runtime_ctx_t *rt, int64_t "
+         "value);\n"
+         "extern akx_cell_t* akx_rt_make_symbol(akx_runtime_ctx_t *rt, const "
+         "char *sym);\n"
+         "extern akx_cell_t* akx_rt_nil(akx_runtime_ctx_t *rt);\n"
+         "// Small ints, nil, t, true and false are shared immediates, and\n"
+         "// values read from bindings are shared with the binding; unshare\n"
+         "// a cell before changing it or linking it into a list\n"
+         "extern akx_cell_t* akx_rt_unshare(akx_runtime_ctx_t *rt, akx_cell_t "
+         "*cell);\n"
+         "extern akx_cell_t* akx_rt_copy(akx_runtime_ctx_t *rt, akx_cell_t "
+         "*cell);\n"
          "\n"
+         "// Setting a shared immediate is a runtime error\n"
          "extern void akx_rt_set_symbol(akx_runtime_ctx_t *rt, akx_cell_t "
          "*cell, const char *sym);\n"
          "extern void akx_rt_set_int(akx_runtime_ctx_t *rt, akx_cell_t *cell, "
-         "int value);\n"
+         "int64_t value);\n"
          "extern void akx_rt_set_real(akx_runtime_ctx_t *rt, akx_cell_t *cell, "
          "double value);\n"
          "extern void akx_rt_set_string(akx_runtime_ctx_t *rt, akx_cell_t "
@@ -447,25 +496,56 @@ const char *akx_compiler_generate_abi_header(void) {
          "\n"
          "extern int akx_rt_cell_is_type(akx_cell_t *cell, akx_type_t type);\n"
          "extern const char* akx_rt_cell_as_symbol(akx_cell_t *cell);\n"
-         "extern int akx_rt_cell_as_int(akx_cell_t *cell);\n"
+         "extern int64_t akx_rt_cell_as_int(akx_cell_t *cell);\n"
+         "extern int akx_rt_cell_to_int(akx_runtime_ctx_t *rt, akx_cell_t "
+         "*cell, int64_t *out);\n"
          "extern double akx_rt_cell_as_real(akx_cell_t *cell);\n"
          "extern const char* akx_rt_cell_as_string(akx_cell_t *cell);\n"
          "extern akx_cell_t* akx_rt_cell_as_list(akx_cell_t *cell);\n"
          "extern ak_lambda_t* akx_rt_cell_as_lambda(akx_cell_t *cell);\n"
          "extern akx_cell_t* akx_rt_cell_next(akx_cell_t *cell);\n"
          "\n"
+         "extern int akx_rt_cell_is_bignum(akx_cell_t *cell);\n"
+         "extern akx_cell_t* akx_rt_int_add(akx_runtime_ctx_t *rt, akx_cell_t "
+         "*a, akx_cell_t *b);\n"
+         "extern akx_cell_t* akx_rt_int_sub(akx_runtime_ctx_t *rt, akx_cell_t "
+         "*a, akx_cell_t *b);\n"
+         "extern akx_cell_t* akx_rt_int_mul(akx_runtime_ctx_t *rt, akx_cell_t "
+         "*a, akx_cell_t *b);\n"
+         "extern akx_cell_t* akx_rt_int_div(akx_runtime_ctx_t *rt, akx_cell_t "
+         "*a, akx_cell_t *b);\n"
+         "extern akx_cell_t* akx_rt_int_mod(akx_runtime_ctx_t *rt, akx_cell_t "
+         "*a, akx_cell_t *b);\n"
+         "extern int akx_rt_int_cmp(akx_cell_t *a, akx_cell_t *b);\n"
+         "\n"
          "extern size_t akx_rt_list_length(akx_cell_t *list);\n"
          "extern akx_cell_t* akx_rt_list_nth(akx_cell_t *list, size_t n);\n"
          "extern akx_cell_t* akx_rt_list_append(akx_runtime_ctx_t *rt, "
          "akx_cell_t *list, akx_cell_t *item);\n"
+         "extern int akx_rt_list_builder_push(akx_runtime_ctx_t *rt, "
+         "akx_rt_list_builder_t *builder, akx_cell_t *item);\n"
+         "extern akx_cell_t* akx_rt_list_builder_finish(akx_runtime_ctx_t "
+         "*rt, akx_rt_list_builder_t *builder);\n"
+         "extern void akx_rt_list_builder_discard(akx_runtime_ctx_t *rt, "
+         "akx_rt_list_builder_t *builder);\n"
          "\n"
          "extern ak_context_t* akx_rt_get_scope(akx_runtime_ctx_t *rt);\n"
          "extern int akx_rt_scope_set(akx_runtime_ctx_t *rt, const char *key, "
          "void *value);\n"
          "extern void* akx_rt_scope_get(akx_runtime_ctx_t *rt, const char "
          "*key);\n"
+         "extern int akx_rt_scope_has_local(akx_runtime_ctx_t *rt, const "
+         "char *key);\n"
+         "extern akx_rt_scope_t* akx_rt_scope_find(akx_runtime_ctx_t *rt, "
+         "akx_cell_t *symbol);\n"
+         "extern int akx_rt_scope_assign(akx_runtime_ctx_t *rt, "
+         "akx_rt_scope_t *scope, const char *key, void *value, void "
+         "**old_value);\n"
          "extern void akx_rt_push_scope(akx_runtime_ctx_t *rt);\n"
+         "extern void akx_rt_push_scope_sized(akx_runtime_ctx_t *rt, size_t "
+         "slots);\n"
          "extern void akx_rt_pop_scope(akx_runtime_ctx_t *rt);\n"
+         "extern size_t akx_rt_count_lets(akx_cell_t *body);\n"
          "\n"
          "extern void akx_rt_error(akx_runtime_ctx_t *rt, const char "
          "*message);\n"
@@ -474,6 +554,8 @@ const char *akx_compiler_generate_abi_header(void) {
          "\n"
          "extern akx_cell_t* akx_rt_eval(akx_runtime_ctx_t *rt, akx_cell_t "
          "*expr);\n"
+         "extern akx_cell_t* akx_rt_eval_in_tail(akx_runtime_ctx_t *rt, "
+         "akx_cell_t *expr);\n"
          "extern akx_cell_t* akx_rt_eval_list(akx_runtime_ctx_t *rt, "
          "akx_cell_t *list);\n"
          "extern akx_cell_t* akx_rt_eval_and_assert(akx_runtime_ctx_t *rt, "
@@ -488,6 +570,17 @@ const char *akx_compiler_generate_abi_header(void) {
          "*data);\n"
          "extern void* akx_rt_module_get_data(akx_runtime_ctx_t *rt);\n"
          "\n"
+         "extern int akx_rt_gc_enabled(akx_runtime_ctx_t *rt);\n"
+         "extern void akx_rt_gc_collect(akx_runtime_ctx_t *rt);\n"
+         "extern void akx_rt_gc_safepoint(akx_runtime_ctx_t *rt);\n"
+         "extern void akx_rt_gc_push_roots(akx_runtime_ctx_t *rt, akx_cell_t "
+         "**slots, size_t count);\n"
+         "extern void akx_rt_gc_pop_roots(akx_runtime_ctx_t *rt, akx_cell_t "
+         "**slots);\n"
+         "extern void* akx_rt_alloc_mem(akx_runtime_ctx_t *rt, size_t size);\n"
+         "extern void akx_rt_free_mem(akx_runtime_ctx_t *rt, void *ptr, size_t "
+         "size);\n"
+         "\n"
          "typedef struct ak_buffer_s ak_buffer_t;\n"
          "\n"
          "extern ak_buffer_t* ak_buffer_new(size_t initial_size);\n"
@@ -497,6 +590,7 @@ const char *akx_compiler_generate_abi_header(void) {
          "extern size_t ak_buffer_count(ak_buffer_t *buffer);\n"
          "extern int ak_buffer_copy_to(ak_buffer_t *buffer, uint8_t *src, "
          "size_t len);\n"
+         "extern ak_buffer_t* akx_rt_int_to_buffer(akx_cell_t *cell);\n"
          "\n"
          "extern ak_buffer_t* ak_filepath_join(size_t count, ...);\n"
          "extern ak_buffer_t* ak_filepath_basename(const char *path);\n"
@@ -621,6 +715,11 @@ int akx_compiler_load_builtin_ex(akx_runtime_ctx_t *rt, const char *name,
   ak_cjit_add_symbol(unit, "free", free);
   ak_cjit_add_symbol(unit, "akx_rt_alloc_cell", akx_rt_alloc_cell);
   ak_cjit_add_symbol(unit, "akx_rt_free_cell", akx_rt_free_cell);
+  ak_cjit_add_symbol(unit, "akx_rt_make_int", akx_rt_make_int);
+  ak_cjit_add_symbol(unit, "akx_rt_make_symbol", akx_rt_make_symbol);
+  ak_cjit_add_symbol(unit, "akx_rt_nil", akx_rt_nil);
+  ak_cjit_add_symbol(unit, "akx_rt_unshare", akx_rt_unshare);
+  ak_cjit_add_symbol(unit, "akx_rt_copy", akx_rt_copy);
   ak_cjit_add_symbol(unit, "akx_rt_set_symbol", akx_rt_set_symbol);
   ak_cjit_add_symbol(unit, "akx_rt_set_int", akx_rt_set_int);
   ak_cjit_add_symbol(unit, "akx_rt_set_real", akx_rt_set_real);
@@ -631,28 +730,56 @@ int akx_compiler_load_builtin_ex(akx_runtime_ctx_t *rt, const char *name,
   ak_cjit_add_symbol(unit, "akx_rt_cell_get_type", akx_rt_cell_get_type);
   ak_cjit_add_symbol(unit, "akx_rt_cell_as_symbol", akx_rt_cell_as_symbol);
   ak_cjit_add_symbol(unit, "akx_rt_cell_as_int", akx_rt_cell_as_int);
+  ak_cjit_add_symbol(unit, "akx_rt_cell_to_int", akx_rt_cell_to_int);
   ak_cjit_add_symbol(unit, "akx_rt_cell_as_real", akx_rt_cell_as_real);
   ak_cjit_add_symbol(unit, "akx_rt_cell_as_string", akx_rt_cell_as_string);
   ak_cjit_add_symbol(unit, "akx_rt_cell_as_list", akx_rt_cell_as_list);
   ak_cjit_add_symbol(unit, "akx_rt_cell_as_lambda", akx_rt_cell_as_lambda);
   ak_cjit_add_symbol(unit, "akx_rt_cell_next", akx_rt_cell_next);
+  ak_cjit_add_symbol(unit, "akx_rt_cell_is_bignum", akx_rt_cell_is_bignum);
+  ak_cjit_add_symbol(unit, "akx_rt_int_add", akx_rt_int_add);
+  ak_cjit_add_symbol(unit, "akx_rt_int_sub", akx_rt_int_sub);
+  ak_cjit_add_symbol(unit, "akx_rt_int_mul", akx_rt_int_mul);
+  ak_cjit_add_symbol(unit, "akx_rt_int_div", akx_rt_int_div);
+  ak_cjit_add_symbol(unit, "akx_rt_int_mod", akx_rt_int_mod);
+  ak_cjit_add_symbol(unit, "akx_rt_int_cmp", akx_rt_int_cmp);
+  ak_cjit_add_symbol(unit, "akx_rt_int_to_buffer", akx_rt_int_to_buffer);
   ak_cjit_add_symbol(unit, "akx_rt_list_length", akx_rt_list_length);
   ak_cjit_add_symbol(unit, "akx_rt_list_nth", akx_rt_list_nth);
   ak_cjit_add_symbol(unit, "akx_rt_list_append", akx_rt_list_append);
+  ak_cjit_add_symbol(unit, "akx_rt_list_builder_push",
+                     akx_rt_list_builder_push);
+  ak_cjit_add_symbol(unit, "akx_rt_list_builder_finish",
+                     akx_rt_list_builder_finish);
+  ak_cjit_add_symbol(unit, "akx_rt_list_builder_discard",
+                     akx_rt_list_builder_discard);
   ak_cjit_add_symbol(unit, "akx_rt_get_scope", akx_rt_get_scope);
   ak_cjit_add_symbol(unit, "akx_rt_scope_set", akx_rt_scope_set);
   ak_cjit_add_symbol(unit, "akx_rt_scope_get", akx_rt_scope_get);
+  ak_cjit_add_symbol(unit, "akx_rt_scope_has_local", akx_rt_scope_has_local);
+  ak_cjit_add_symbol(unit, "akx_rt_scope_find", akx_rt_scope_find);
+  ak_cjit_add_symbol(unit, "akx_rt_scope_assign", akx_rt_scope_assign);
   ak_cjit_add_symbol(unit, "akx_rt_push_scope", akx_rt_push_scope);
+  ak_cjit_add_symbol(unit, "akx_rt_push_scope_sized", akx_rt_push_scope_sized);
   ak_cjit_add_symbol(unit, "akx_rt_pop_scope", akx_rt_pop_scope);
+  ak_cjit_add_symbol(unit, "akx_rt_count_lets", akx_rt_count_lets);
   ak_cjit_add_symbol(unit, "akx_rt_error", akx_rt_error);
   ak_cjit_add_symbol(unit, "akx_rt_error_fmt", akx_rt_error_fmt);
   ak_cjit_add_symbol(unit, "akx_rt_eval", akx_rt_eval);
+  ak_cjit_add_symbol(unit, "akx_rt_eval_in_tail", akx_rt_eval_in_tail);
   ak_cjit_add_symbol(unit, "akx_rt_eval_list", akx_rt_eval_list);
   ak_cjit_add_symbol(unit, "akx_rt_eval_and_assert", akx_rt_eval_and_assert);
   ak_cjit_add_symbol(unit, "akx_rt_invoke_lambda", akx_rt_invoke_lambda);
   ak_cjit_add_symbol(unit, "akx_rt_expand_env_vars", akx_rt_expand_env_vars);
   ak_cjit_add_symbol(unit, "akx_rt_module_set_data", akx_rt_module_set_data);
   ak_cjit_add_symbol(unit, "akx_rt_module_get_data", akx_rt_module_get_data);
+  ak_cjit_add_symbol(unit, "akx_rt_gc_enabled", akx_rt_gc_enabled);
+  ak_cjit_add_symbol(unit, "akx_rt_gc_collect", akx_rt_gc_collect);
+  ak_cjit_add_symbol(unit, "akx_rt_gc_safepoint", akx_rt_gc_safepoint);
+  ak_cjit_add_symbol(unit, "akx_rt_gc_push_roots", akx_rt_gc_push_roots);
+  ak_cjit_add_symbol(unit, "akx_rt_gc_pop_roots", akx_rt_gc_pop_roots);
+  ak_cjit_add_symbol(unit, "akx_rt_alloc_mem", akx_rt_alloc_mem);
+  ak_cjit_add_symbol(unit, "akx_rt_free_mem", akx_rt_free_mem);
   ak_cjit_add_symbol(unit, "ak_buffer_new", ak_buffer_new);
   ak_cjit_add_symbol(unit, "ak_buffer_free", ak_buffer_free);
   ak_cjit_add_symbol(unit, "ak_buffer_from_file", ak_buffer_from_file);
@@ -747,9 +874,12 @@ int akx_compiler_load_builtin_ex(akx_runtime_ctx_t *rt, const char *name,
   char init_name[AKX_RT_META_STRING_SIZE_MAX];
   char deinit_name[AKX_RT_META_STRING_SIZE_MAX];
   char reload_name[AKX_RT_META_STRING_SIZE_MAX];
+  char signature_name[AKX_RT_META_STRING_SIZE_MAX];
   snprintf(init_name, sizeof(init_name), "%s_init", lookup_name);
   snprintf(deinit_name, sizeof(deinit_name), "%s_deinit", lookup_name);
   snprintf(reload_name, sizeof(reload_name), "%s_reload", lookup_name);
+  snprintf(signature_name, sizeof(signature_name), "%s_signature",
+           lookup_name);
 
   void (*init_fn)(akx_runtime_ctx_t *) =
       (void (*)(akx_runtime_ctx_t *))ak_cjit_get_symbol(unit, init_name);
@@ -758,7 +888,10 @@ int akx_compiler_load_builtin_ex(akx_runtime_ctx_t *rt, const char *name,
   void (*reload_fn)(akx_runtime_ctx_t *, void *) =
       (void (*)(akx_runtime_ctx_t *, void *))ak_cjit_get_symbol(unit,
                                                                 reload_name);
+  const akx_builtin_signature_t *signature =
+      (const akx_builtin_signature_t *)ak_cjit_get_symbol(unit,
+                                                          signature_name);
 
   return akx_rt_register_builtin(rt, name, root_path, function, unit, init_fn,
-                                 deinit_fn, reload_fn);
+                                 deinit_fn, reload_fn, signature);
 }
@@ -0,0 +1,458 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "akx_rt_gc.h"
+#include "akx_rt_builtins.h"
+#include "akx_rt_slab.h"
+#include <ak24/lambda.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(AK24_PLATFORM_WINDOWS)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+// Cells allocated between collections, at least; after a collection the
+// budget grows to the number of cells that survived it
+#define AKX_RT_GC_MIN_THRESHOLD (64 * 1024)
+#define AKX_RT_GC_INITIAL_CAPACITY 64
+
+#if defined(__GNUC__) || defined(__clang__)
+#define AKX_RT_GC_NOINLINE __attribute__((noinline))
+#else
+#define AKX_RT_GC_NOINLINE
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#define AKX_RT_GC_NO_ASAN __attribute__((no_sanitize_address))
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define AKX_RT_GC_NO_ASAN __attribute__((no_sanitize_address))
+#endif
+#endif
+#ifndef AKX_RT_GC_NO_ASAN
+#define AKX_RT_GC_NO_ASAN
+#endif
+
+// Every tracked cell sits right after one of these
+typedef struct gc_header_t {
+  struct gc_header_t *next;
+  uint32_t size;
+  uint32_t marked;
+} gc_header_t;
+
+typedef struct gc_root_t {
+  akx_cell_t **slots;
+  size_t count;
+} gc_root_t;
+
+struct akx_rt_gc_t {
+  akx_rt_slab_t *slab;
+  gc_header_t *cells;
+  size_t cell_count;
+  size_t cell_bytes;
+  size_t allocated;
+  size_t threshold;
+
+  gc_header_t **index;
+  size_t index_count;
+  size_t index_capacity;
+  uintptr_t index_low;
+  uintptr_t index_high;
+
+  akx_cell_t **marking;
+  size_t marking_count;
+  size_t marking_capacity;
+  int overflowed;
+
+  gc_root_t *roots;
+  size_t root_count;
+  size_t root_capacity;
+
+  // Set when a root could not be recorded; collecting after that could free
+  // a live cell, so the collector stops
+  int lost_roots;
+
+  // Only the stack of the thread that created the collector is scanned, so
+  // only that thread may allocate tracked cells
+  uintptr_t stack_top;
+#if defined(AK24_PLATFORM_WINDOWS)
+  DWORD owner;
+#else
+  pthread_t owner;
+#endif
+  uint64_t pause_start;
+  akx_rt_gc_stats_t stats;
+};
+
+static int g_gc_active = 0;
+
+static int grow(void **items, size_t *capacity, size_t item_size) {
+  size_t grown_capacity =
+      *capacity ? *capacity * 2 : AKX_RT_GC_INITIAL_CAPACITY;
+  void *grown = AK24_ALLOC(item_size * grown_capacity);
+  if (!grown) {
+    return -1;
+  }
+  memset(grown, 0, item_size * grown_capacity);
+  if (*items) {
+    memcpy(grown, *items, item_size * *capacity);
+    AK24_FREE(*items);
+  }
+  *items = grown;
+  *capacity = grown_capacity;
+  return 0;
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uintptr_t thread_stack_top(void) {
+#if defined(AK24_PLATFORM_WINDOWS)
+  ULONG_PTR low = 0;
+  ULONG_PTR high = 0;
+  GetCurrentThreadStackLimits(&low, &high);
+  return (uintptr_t)high;
+#elif defined(__APPLE__)
+  return (uintptr_t)pthread_get_stackaddr_np(pthread_self());
+#else
+  pthread_attr_t attr;
+  if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+    return 0;
+  }
+  void *addr = NULL;
+  size_t size = 0;
+  int rc = pthread_attr_getstack(&attr, &addr, &size);
+  pthread_attr_destroy(&attr);
+  return rc == 0 ? (uintptr_t)addr + size : 0;
+#endif
+}
+
+static int on_owner_thread(akx_rt_gc_t *gc) {
+#if defined(AK24_PLATFORM_WINDOWS)
+  return GetCurrentThreadId() == gc->owner;
+#else
+  return pthread_equal(pthread_self(), gc->owner);
+#endif
+}
+
+static akx_cell_t *header_cell(gc_header_t *header) {
+  return (akx_cell_t *)(header + 1);
+}
+
+// A cell allocated on another thread would be reachable only from a stack
+// the collector never scans, and would race the cell list; it fails like
+// an out-of-memory allocation
+static void *gc_alloc(void *user, size_t size) {
+  akx_rt_gc_t *gc = (akx_rt_gc_t *)user;
+  if (!on_owner_thread(gc)) {
+    AK24_LOG_ERROR("Tracked cell allocated off the collector's thread");
+    return NULL;
+  }
+  gc_header_t *header =
+      gc->slab ? akx_rt_slab_alloc(gc->slab, sizeof(gc_header_t) + size)
+               : AK24_ALLOC(sizeof(gc_header_t) + size);
+  if (!header) {
+    return NULL;
+  }
+  header->next = gc->cells;
+  header->size = (uint32_t)size;
+  header->marked = 0;
+  gc->cells = header;
+  gc->cell_count++;
+  gc->cell_bytes += size;
+  gc->allocated++;
+  return header_cell(header);
+}
+
+akx_rt_gc_t *akx_rt_gc_new(akx_rt_slab_t *slab) {
+  if (g_gc_active) {
+    return NULL;
+  }
+
+  uintptr_t stack_top = thread_stack_top();
+  if (!stack_top) {
+    return NULL;
+  }
+
+  akx_rt_gc_t *gc = AK24_ALLOC(sizeof(akx_rt_gc_t));
+  if (!gc) {
+    return NULL;
+  }
+  memset(gc, 0, sizeof(akx_rt_gc_t));
+  gc->slab = slab;
+  gc->threshold = AKX_RT_GC_MIN_THRESHOLD;
+  gc->stack_top = stack_top;
+#if defined(AK24_PLATFORM_WINDOWS)
+  gc->owner = GetCurrentThreadId();
+#else
+  gc->owner = pthread_self();
+#endif
+
+  akx_cell_heap_t heap = {.alloc = gc_alloc, .user = gc};
+  akx_cell_set_heap(&heap);
+  g_gc_active = 1;
+  return gc;
+}
+
+// Frees cell contents first and memory second: a lambda's free function may
+// still walk a body cell that is going away in the same batch
+static void destroy_cells(akx_rt_gc_t *gc, gc_header_t *headers) {
+  for (gc_header_t *header = headers; header; header = header->next) {
+    akx_cell_destroy(header_cell(header));
+  }
+  while (headers) {
+    gc_header_t *next = headers->next;
+    if (gc->slab) {
+      akx_rt_slab_release(gc->slab, headers,
+                          sizeof(gc_header_t) + headers->size);
+    } else {
+      AK24_FREE(headers);
+    }
+    headers = next;
+  }
+}
+
+void akx_rt_gc_free(akx_rt_gc_t *gc) {
+  if (!gc) {
+    return;
+  }
+
+  destroy_cells(gc, gc->cells);
+  akx_cell_set_heap(NULL);
+  g_gc_active = 0;
+
+  if (gc->roots) {
+    AK24_FREE(gc->roots);
+  }
+  if (gc->index) {
+    AK24_FREE(gc->index);
+  }
+  if (gc->marking) {
+    AK24_FREE(gc->marking);
+  }
+  AK24_FREE(gc);
+}
+
+int akx_rt_gc_due(akx_rt_gc_t *gc) {
+  return gc && !gc->lost_roots && gc->allocated >= gc->threshold;
+}
+
+int akx_rt_gc_push(akx_rt_gc_t *gc, akx_cell_t **slots, size_t count) {
+  if (gc->root_count == gc->root_capacity &&
+      grow((void **)&gc->roots, &gc->root_capacity, sizeof(gc_root_t)) != 0) {
+    gc->lost_roots = 1;
+    return -1;
+  }
+  gc->roots[gc->root_count].slots = slots;
+  gc->roots[gc->root_count].count = count;
+  gc->root_count++;
+  return 0;
+}
+
+void akx_rt_gc_pop(akx_rt_gc_t *gc, akx_cell_t **slots) {
+  for (size_t i = gc->root_count; i > 0; i--) {
+    if (gc->roots[i - 1].slots == slots) {
+      memmove(&gc->roots[i - 1], &gc->roots[i],
+              sizeof(gc_root_t) * (gc->root_count - i));
+      gc->root_count--;
+      return;
+    }
+  }
+}
+
+static int compare_headers(const void *a, const void *b) {
+  uintptr_t left = (uintptr_t)*(gc_header_t *const *)a;
+  uintptr_t right = (uintptr_t)*(gc_header_t *const *)b;
+  return (left > right) - (left < right);
+}
+
+void akx_rt_gc_begin(akx_rt_gc_t *gc) {
+  gc->pause_start = now_ns();
+  gc->index_count = 0;
+  gc->index_low = UINTPTR_MAX;
+  gc->index_high = 0;
+  gc->marking_count = 0;
+  gc->overflowed = 0;
+
+  if (gc->index_capacity < gc->cell_count) {
+    if (gc->index) {
+      AK24_FREE(gc->index);
+    }
+    gc->index_capacity = gc->cell_count * 2;
+    gc->index = AK24_ALLOC(sizeof(gc_header_t *) * gc->index_capacity);
+    if (!gc->index) {
+      gc->index_capacity = 0;
+      gc->overflowed = 1;
+      return;
+    }
+  }
+
+  for (gc_header_t *header = gc->cells; header; header = header->next) {
+    gc->index[gc->index_count++] = header;
+  }
+  qsort(gc->index, gc->index_count, sizeof(gc_header_t *), compare_headers);
+
+  if (gc->index_count) {
+    gc_header_t *last = gc->index[gc->index_count - 1];
+    gc->index_low = (uintptr_t)header_cell(gc->index[0]);
+    gc->index_high = (uintptr_t)header_cell(last) + last->size;
+  }
+}
+
+// Finds the tracked cell containing addr; stack words and scope values are
+// not known to be cells, so nothing is dereferenced before this says so
+static gc_header_t *find_cell(akx_rt_gc_t *gc, uintptr_t addr) {
+  if (addr < gc->index_low || addr >= gc->index_high) {
+    return NULL;
+  }
+  size_t low = 0;
+  size_t high = gc->index_count;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if ((uintptr_t)header_cell(gc->index[mid]) <= addr) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  if (low == 0) {
+    return NULL;
+  }
+  gc_header_t *header = gc->index[low - 1];
+  uintptr_t start = (uintptr_t)header_cell(header);
+  return addr < start + header->size ? header : NULL;
+}
+
+void akx_rt_gc_mark(akx_rt_gc_t *gc, const void *ptr) {
+  gc_header_t *header = find_cell(gc, (uintptr_t)ptr);
+  if (!header || header->marked) {
+    return;
+  }
+  header->marked = 1;
+  if (gc->marking_count == gc->marking_capacity &&
+      grow((void **)&gc->marking, &gc->marking_capacity,
+           sizeof(akx_cell_t *)) != 0) {
+    gc->overflowed = 1;
+    return;
+  }
+  gc->marking[gc->marking_count++] = header_cell(header);
+}
+
+static void mark_children(akx_rt_gc_t *gc) {
+  while (gc->marking_count) {
+    akx_cell_t *cell = gc->marking[--gc->marking_count];
+    akx_rt_gc_mark(gc, cell->next);
+
+    akx_cell_t *children[2];
+    size_t count = akx_cell_children(cell, children);
+    for (size_t i = 0; i < count; i++) {
+      akx_rt_gc_mark(gc, children[i]);
+    }
+
+    if (cell->type == AKX_TYPE_LAMBDA && cell->value.lambda) {
+      akx_lambda_context_t *lambda_ctx =
+          (akx_lambda_context_t *)ak_lambda_get_context(cell->value.lambda);
+      if (lambda_ctx) {
+        akx_rt_gc_mark(gc, lambda_ctx->body);
+      }
+    }
+  }
+}
+
+AKX_RT_GC_NO_ASAN AKX_RT_GC_NOINLINE static void
+mark_stack_range(akx_rt_gc_t *gc) {
+  volatile uintptr_t marker = 0;
+  uintptr_t addr = (uintptr_t)&marker & ~(uintptr_t)(sizeof(void *) - 1);
+  for (; addr + sizeof(void *) <= gc->stack_top; addr += sizeof(void *)) {
+    akx_rt_gc_mark(gc, *(void *const *)addr);
+  }
+}
+
+// Nuclei keep cells in locals, so the C stack is scanned conservatively;
+// setjmp spills callee-saved registers into this frame first
+AKX_RT_GC_NOINLINE static void mark_stack(akx_rt_gc_t *gc) {
+  jmp_buf registers;
+  (void)setjmp(registers);
+  mark_stack_range(gc);
+}
+
+static void mark_roots(akx_rt_gc_t *gc) {
+  for (size_t i = 0; i < gc->root_count; i++) {
+    for (size_t k = 0; k < gc->roots[i].count; k++) {
+      akx_rt_gc_mark(gc, gc->roots[i].slots[k]);
+    }
+  }
+}
+
+static void clear_marks(akx_rt_gc_t *gc) {
+  for (gc_header_t *header = gc->cells; header; header = header->next) {
+    header->marked = 0;
+  }
+}
+
+void akx_rt_gc_finish(akx_rt_gc_t *gc) {
+  if (!gc->overflowed) {
+    mark_roots(gc);
+    mark_stack(gc);
+    mark_children(gc);
+  }
+
+  // Without a complete mark nothing can be freed safely
+  if (gc->overflowed) {
+    clear_marks(gc);
+    gc->allocated = 0;
+    return;
+  }
+
+  gc_header_t *dead = NULL;
+  size_t freed = 0;
+  size_t freed_bytes = 0;
+  gc_header_t **link = &gc->cells;
+  while (*link) {
+    gc_header_t *header = *link;
+    if (header->marked) {
+      header->marked = 0;
+      link = &header->next;
+      continue;
+    }
+    *link = header->next;
+    header->next = dead;
+    dead = header;
+    freed++;
+    freed_bytes += header->size;
+  }
+  destroy_cells(gc, dead);
+
+  gc->cell_count -= freed;
+  gc->cell_bytes -= freed_bytes;
+  gc->allocated = 0;
+  gc->threshold = gc->cell_count > AKX_RT_GC_MIN_THRESHOLD
+                      ? gc->cell_count
+                      : AKX_RT_GC_MIN_THRESHOLD;
+
+  uint64_t pause = now_ns() - gc->pause_start;
+  gc->stats.collections++;
+  gc->stats.freed_cells += freed;
+  gc->stats.live_cells = gc->cell_count;
+  gc->stats.last_pause_ns = pause;
+  gc->stats.total_pause_ns += pause;
+  if (pause > gc->stats.max_pause_ns) {
+    gc->stats.max_pause_ns = pause;
+  }
+}
+
+void akx_rt_gc_read_stats(akx_rt_gc_t *gc, akx_rt_gc_stats_t *stats) {
+  *stats = gc->stats;
+  stats->heap_cells = gc->cell_count;
+  stats->heap_bytes = gc->cell_bytes;
+}
@@ -0,0 +1,34 @@
+#ifndef AKX_RT_GC_H
+#define AKX_RT_GC_H
+
+#include "akx_rt.h"
+#include "akx_rt_slab.h"
+
+// Mark-sweep collector behind AKX_GC. The runtime marks bindings and module
+// data; akx_rt_gc_finish() adds the root stack and the C stack and registers
+// before it sweeps.
+typedef struct akx_rt_gc_t akx_rt_gc_t;
+
+// Takes over cell allocation, or returns NULL when another collector already
+// has it. Cells come from slab when one is given. Only the calling thread
+// may allocate cells from then on: allocations on any other thread log an
+// error and fail, since their stacks are not scanned.
+akx_rt_gc_t *akx_rt_gc_new(akx_rt_slab_t *slab);
+
+// Destroys every cell the collector still owns and restores plain allocation
+void akx_rt_gc_free(akx_rt_gc_t *gc);
+
+int akx_rt_gc_due(akx_rt_gc_t *gc);
+
+int akx_rt_gc_push(akx_rt_gc_t *gc, akx_cell_t **slots, size_t count);
+void akx_rt_gc_pop(akx_rt_gc_t *gc, akx_cell_t **slots);
+
+// A collection runs between begin and finish; anything passed to mark in
+// between survives if it is a cell the collector owns
+void akx_rt_gc_begin(akx_rt_gc_t *gc);
+void akx_rt_gc_mark(akx_rt_gc_t *gc, const void *ptr);
+void akx_rt_gc_finish(akx_rt_gc_t *gc);
+
+void akx_rt_gc_read_stats(akx_rt_gc_t *gc, akx_rt_gc_stats_t *stats);
+
+#endif
@@ -0,0 +1,1753 @@
+#include "akx_rt_jit.h"
+#include "akx_rt_compiler.h"
+#include "akx_rt_vm.h"
+#include <ak24/cjit.h>
+#include <ak24/lambda.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if !defined(AK24_PLATFORM_WINDOWS)
+#include <pthread.h>
+#define AKX_RT_JIT_THREADED 1
+#endif
+
+#define AKX_RT_JIT_THRESHOLD 1000
+#define AKX_RT_JIT_MAX_PARAMS 16
+#define AKX_RT_JIT_MAX_ARGS 16
+// Deopts a lambda's code survives before the lambda stays interpreted
+#define AKX_RT_JIT_MAX_DEOPTS 8
+// Native self-recursion deeper than this deopts, so deep recursion and its
+// limit stay the interpreter's
+#define AKX_RT_JIT_MAX_DEPTH 1000
+
+// Loop traces: variables the body reads or sets, lambdas it calls, names
+// bound at once, and ifs whose direction is recorded
+#define AKX_RT_JIT_MAX_VARS 16
+#define AKX_RT_JIT_MAX_CALLEES 8
+#define AKX_RT_JIT_MAX_LOCALS 64
+#define AKX_RT_JIT_MAX_BRANCHES 32
+// Interpreted iterations recorded before a trace is compiled
+#define AKX_RT_JIT_TRACE_ITERATIONS 8
+// Times a trace is recorded again after leaving through a branch it had not
+// seen taken
+#define AKX_RT_JIT_MAX_RETRACES 4
+#define AKX_RT_JIT_TRACE_BUCKETS 64
+
+enum {
+  JIT_QUEUED,
+  JIT_READY,
+  // Not translatable, not compiled, or deoptimized too often
+  JIT_OFF,
+};
+
+// Unboxed types; JIT_ANY is what a call to the lambda itself yields before
+// its result type is known, and JIT_VOID an if whose branches disagree
+enum {
+  JIT_ANY,
+  JIT_INT,
+  JIT_REAL,
+  JIT_NIL,
+  JIT_VOID,
+};
+
+enum {
+  JIT_ADD,
+  JIT_SUB,
+  JIT_MUL,
+  JIT_DIV,
+  JIT_MOD,
+  JIT_EQ,
+  JIT_NEQ,
+  JIT_LT,
+  JIT_GT,
+  JIT_LTE,
+  JIT_GTE,
+  JIT_IF,
+  JIT_BEGIN,
+  JIT_SET,
+  JIT_LET,
+};
+
+// The builtins native code computes itself, with the operand type their
+// signatures accept (JIT_ANY for either) and their arity (0: variadic)
+static const struct {
+  const char *name;
+  uint8_t op;
+  uint8_t type;
+  uint8_t min_args;
+  uint8_t max_args;
+} jit_builtins[] = {
+    {"+", JIT_ADD, JIT_INT, 2, 0},
+    {"-", JIT_SUB, JIT_INT, 2, 2},
+    {"*", JIT_MUL, JIT_INT, 2, 0},
+    {"/", JIT_DIV, JIT_INT, 2, 2},
+    {"%", JIT_MOD, JIT_INT, 2, 2},
+    {"real/+", JIT_ADD, JIT_REAL, 2, 0},
+    {"real/-", JIT_SUB, JIT_REAL, 2, 0},
+    {"real/*", JIT_MUL, JIT_REAL, 2, 0},
+    {"real//", JIT_DIV, JIT_REAL, 2, 0},
+    {"eq", JIT_EQ, JIT_ANY, 2, 0},
+    {"neq", JIT_NEQ, JIT_ANY, 2, 0},
+    {"lt", JIT_LT, JIT_ANY, 2, 2},
+    {"gt", JIT_GT, JIT_ANY, 2, 2},
+    {"lte", JIT_LTE, JIT_ANY, 2, 2},
+    {"gte", JIT_GTE, JIT_ANY, 2, 2},
+    {"real/eq", JIT_EQ, JIT_REAL, 2, 0},
+    {"real/neq", JIT_NEQ, JIT_REAL, 2, 0},
+    {"real/lt", JIT_LT, JIT_REAL, 2, 2},
+    {"real/gt", JIT_GT, JIT_REAL, 2, 2},
+    {"real/lte", JIT_LTE, JIT_REAL, 2, 2},
+    {"real/gte", JIT_GTE, JIT_REAL, 2, 2},
+    {"if", JIT_IF, JIT_ANY, 2, 3},
+    {"begin", JIT_BEGIN, JIT_ANY, 1, 0},
+    {"set", JIT_SET, JIT_ANY, 2, 2},
+    {"let", JIT_LET, JIT_ANY, 2, 2},
+};
+
+// Overflow goes to the interpreter, which carries on in bignums
+static const char jit_prelude[] =
+    "static int akx_jit_add(int64_t a, int64_t b, int64_t *out) {\n"
+    "  if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b)) {\n"
+    "    return 1;\n"
+    "  }\n"
+    "  *out = a + b;\n"
+    "  return 0;\n"
+    "}\n"
+    "static int akx_jit_sub(int64_t a, int64_t b, int64_t *out) {\n"
+    "  if ((b < 0 && a > INT64_MAX + b) || (b > 0 && a < INT64_MIN + b)) {\n"
+    "    return 1;\n"
+    "  }\n"
+    "  *out = a - b;\n"
+    "  return 0;\n"
+    "}\n"
+    "static int akx_jit_mul(int64_t a, int64_t b, int64_t *out) {\n"
+    "  if (a > 0 ? (b > 0 ? a > INT64_MAX / b : b < INT64_MIN / a)\n"
+    "            : (b > 0 ? a < INT64_MIN / b\n"
+    "                     : (a != 0 && b < INT64_MAX / a))) {\n"
+    "    return 1;\n"
+    "  }\n"
+    "  *out = a * b;\n"
+    "  return 0;\n"
+    "}\n"
+    "typedef int (*akx_jit_fn)(const akx_value_t *argv, "
+    "akx_value_t *result);\n";
+
+typedef int (*jit_entry_fn)(const akx_value_t *argv, akx_value_t *result);
+// Runs iterations until the condition fails (0), native code cannot go on
+// (1), or an if goes a way the recording never saw (2). vars hold the
+// values after the last whole iteration.
+typedef int (*jit_loop_fn)(akx_value_t *vars, const jit_entry_fn *callees,
+                           akx_value_t *last, uint64_t *iterations);
+
+typedef struct {
+  const char *name;
+  // NULL for a call to a lambda, which must stay a lambda call
+  akx_builtin_info_t *info;
+} jit_guard_t;
+
+struct akx_rt_jit_code_t {
+  akx_rt_jit_t *jit;
+  atomic_int state;
+  jit_entry_fn entry;
+  jit_loop_fn loop_entry;
+  ak_cjit_unit_t *unit;
+  char *source;
+  // Set while the worker owns the code, and when the lambda goes away
+  // meanwhile
+  int queued;
+  int orphaned;
+  // A loop trace rather than a lambda body
+  int loop;
+  akx_rt_jit_code_t *next;
+  size_t param_count;
+  uint8_t types[AKX_RT_JIT_MAX_PARAMS];
+  uint8_t result_type;
+  // The symbol the body calls the lambda itself by
+  akx_cell_t *self;
+  // Calls the code depends on, rechecked when the builtin generation moves
+  jit_guard_t *guards;
+  size_t guard_count;
+  size_t guard_capacity;
+  uint32_t generation;
+  uint32_t deopts;
+};
+
+// A variable the loop reads or sets, looked up by name on the way in
+typedef struct {
+  const char *name;
+  akx_cell_t symbol;
+  uint8_t type;
+  uint8_t written;
+} jit_var_t;
+
+// A lambda the loop calls, which runs its own native code
+typedef struct {
+  const char *name;
+  const char *self;
+  akx_cell_t symbol;
+  size_t param_count;
+  uint8_t types[AKX_RT_JIT_MAX_PARAMS];
+  uint8_t result_type;
+} jit_callee_t;
+
+// Bit 1: the then branch was taken, bit 0: the else branch
+typedef struct {
+  const akx_cell_t *key;
+  uint8_t taken;
+} jit_branch_t;
+
+struct akx_rt_jit_trace_t {
+  // The loop's arguments, and a hash of them: the cells may be freed and
+  // their memory reused for another loop
+  const akx_cell_t *key;
+  uint64_t hash;
+  akx_cell_t *form;
+  akx_rt_jit_trace_t *next;
+  uint32_t iterations;
+  uint32_t recorded;
+  uint32_t retraces;
+  uint32_t deopts;
+  // Record the next iteration
+  int record;
+  int off;
+  akx_rt_jit_code_t *code;
+  jit_branch_t branches[AKX_RT_JIT_MAX_BRANCHES];
+  size_t branch_count;
+  jit_var_t vars[AKX_RT_JIT_MAX_VARS];
+  size_t var_count;
+  jit_callee_t callees[AKX_RT_JIT_MAX_CALLEES];
+  size_t callee_count;
+};
+
+struct akx_rt_jit_t {
+  akx_runtime_ctx_t *rt;
+  uint32_t threshold;
+  akx_rt_jit_stats_t stats;
+  akx_rt_jit_trace_t *traces[AKX_RT_JIT_TRACE_BUCKETS];
+  // The trace whose iterations if reports its branches to
+  akx_rt_jit_trace_t *recording;
+#ifdef AKX_RT_JIT_THREADED
+  pthread_t worker;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  akx_rt_jit_code_t *queue_head;
+  akx_rt_jit_code_t *queue_tail;
+  int stopping;
+#endif
+};
+
+typedef struct {
+  char *data;
+  size_t length;
+  size_t capacity;
+  int failed;
+} source_t;
+
+typedef struct {
+  uint8_t type;
+  // Set for a tail call to the lambda itself, which jumps instead
+  uint8_t jumps;
+  uint32_t var;
+} operand_t;
+
+typedef struct {
+  const char *name;
+  uint32_t var;
+  uint8_t type;
+} jit_local_t;
+
+typedef struct {
+  akx_runtime_ctx_t *rt;
+  akx_lambda_context_t *lambda_ctx;
+  akx_rt_jit_trace_t *trace;
+  akx_rt_jit_code_t *code;
+  source_t src;
+  // C locals are v0, v1, ...; parameters and loop variables come first
+  uint32_t next_var;
+  uint8_t result_type;
+  // What leaves native code for the interpreter
+  const char *deopt;
+  // Loops: names bound by let in the iteration, and by a lambda call to
+  // the arguments after them
+  jit_local_t locals[AKX_RT_JIT_MAX_LOCALS];
+  size_t local_count;
+  int statement;
+  int in_condition;
+  int failed;
+  // A callee is not compiled yet; try again later
+  int retry;
+} translator_t;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int grow(void **array, size_t *capacity, size_t count, size_t size) {
+  size_t next = *capacity ? *capacity * 2 : 16;
+  void *grown = AK24_ALLOC(next * size);
+  if (!grown) {
+    return -1;
+  }
+  if (*array) {
+    memcpy(grown, *array, count * size);
+    AK24_FREE(*array);
+  }
+  *array = grown;
+  *capacity = next;
+  return 0;
+}
+
+static void put(source_t *src, const char *fmt, ...) {
+  if (src->failed) {
+    return;
+  }
+  va_list args;
+  va_start(args, fmt);
+  va_list measure;
+  va_copy(measure, args);
+  int length = vsnprintf(NULL, 0, fmt, measure);
+  va_end(measure);
+  while (length >= 0 && src->length + (size_t)length + 1 > src->capacity) {
+    size_t capacity = src->capacity ? src->capacity * 2 : 4096;
+    char *grown = AK24_ALLOC(capacity);
+    if (!grown) {
+      length = -1;
+      break;
+    }
+    if (src->data) {
+      memcpy(grown, src->data, src->length + 1);
+      AK24_FREE(src->data);
+    }
+    src->data = grown;
+    src->capacity = capacity;
+  }
+  if (length < 0) {
+    src->failed = 1;
+  } else {
+    vsnprintf(src->data + src->length, (size_t)length + 1, fmt, args);
+    src->length += (size_t)length;
+  }
+  va_end(args);
+}
+
+static const char *c_type(uint8_t type) {
+  return type == JIT_REAL ? "double" : "int64_t";
+}
+
+static const char *c_field(uint8_t type) {
+  return type == JIT_REAL ? "real" : "integer";
+}
+
+static int same_name(const char *a, const char *b) {
+  return a == b || strcmp(a, b) == 0;
+}
+
+static int is_list_cell(akx_cell_t *cell) {
+  return cell->type == AKX_TYPE_LIST || cell->type == AKX_TYPE_LIST_SQUARE ||
+         cell->type == AKX_TYPE_LIST_CURLY ||
+         cell->type == AKX_TYPE_LIST_TEMPLE;
+}
+
+static uint8_t value_type(akx_cell_t *cell) {
+  if (cell->type == AKX_TYPE_INTEGER_LITERAL &&
+      !(cell->flags & AKX_CELL_FLAG_BIGNUM)) {
+    return JIT_INT;
+  }
+  return cell->type == AKX_TYPE_REAL_LITERAL ? JIT_REAL : JIT_ANY;
+}
+
+// A loop variable may also hold nil, as long as the loop only reads it
+static uint8_t variable_type(akx_runtime_ctx_t *rt, void *value) {
+  if (!value) {
+    return JIT_ANY;
+  }
+  if (value == akx_rt_nil(rt)) {
+    return JIT_NIL;
+  }
+  return value_type((akx_cell_t *)value);
+}
+
+static int is_self(void *value, akx_lambda_context_t *lambda_ctx) {
+  akx_cell_t *cell = (akx_cell_t *)value;
+  return cell && cell->type == AKX_TYPE_LAMBDA && cell->value.lambda &&
+         ak_lambda_get_context(cell->value.lambda) == lambda_ctx;
+}
+
+static size_t param_index(akx_lambda_context_t *lambda_ctx,
+                          const char *name) {
+  for (size_t i = 0; i < lambda_ctx->param_count; i++) {
+    if (same_name(lambda_ctx->param_names[i], name)) {
+      return i;
+    }
+  }
+  return lambda_ctx->param_count;
+}
+
+static akx_cell_t *box(akx_runtime_ctx_t *rt, uint8_t type,
+                       akx_value_t value) {
+  if (type == JIT_INT) {
+    return akx_rt_make_int(rt, value.as.integer);
+  }
+  akx_cell_t *cell = akx_rt_alloc_cell(rt, AKX_TYPE_REAL_LITERAL);
+  if (cell) {
+    akx_rt_set_real(rt, cell, value.as.real);
+  }
+  return cell;
+}
+
+static int reject(translator_t *tr) {
+  tr->failed = 1;
+  return -1;
+}
+
+static uint32_t declare(translator_t *tr, uint8_t type) {
+  uint32_t var = tr->next_var++;
+  put(&tr->src, "%s v%u", c_type(type), var);
+  return var;
+}
+
+static int add_guard(translator_t *tr, const char *name,
+                     akx_builtin_info_t *info) {
+  akx_rt_jit_code_t *code = tr->code;
+  if (code->guard_count == code->guard_capacity &&
+      grow((void **)&code->guards, &code->guard_capacity, code->guard_count,
+           sizeof(jit_guard_t)) != 0) {
+    return reject(tr);
+  }
+  code->guards[code->guard_count].name = name;
+  code->guards[code->guard_count].info = info;
+  code->guard_count++;
+  return 0;
+}
+
+static jit_local_t *find_local(translator_t *tr, const char *name) {
+  for (size_t i = tr->local_count; i > 0; i--) {
+    if (same_name(tr->locals[i - 1].name, name)) {
+      return &tr->locals[i - 1];
+    }
+  }
+  return NULL;
+}
+
+static int push_local(translator_t *tr, const char *name, uint32_t var,
+                      uint8_t type) {
+  if (tr->local_count == AKX_RT_JIT_MAX_LOCALS) {
+    return reject(tr);
+  }
+  tr->locals[tr->local_count].name = name;
+  tr->locals[tr->local_count].var = var;
+  tr->locals[tr->local_count].type = type;
+  tr->local_count++;
+  return 0;
+}
+
+// The first pass finds the loop's variables; the second expects the same
+static jit_var_t *find_var(translator_t *tr, const char *name) {
+  akx_rt_jit_trace_t *trace = tr->trace;
+  for (size_t i = 0; i < trace->var_count; i++) {
+    if (same_name(trace->vars[i].name, name)) {
+      return &trace->vars[i];
+    }
+  }
+  uint8_t type = variable_type(tr->rt, akx_rt_scope_get(tr->rt, name));
+  if (type == JIT_ANY || trace->var_count == AKX_RT_JIT_MAX_VARS) {
+    return NULL;
+  }
+  jit_var_t *var = &trace->vars[trace->var_count++];
+  var->name = name;
+  akx_cell_init_immediate(&var->symbol, AKX_TYPE_SYMBOL);
+  var->symbol.value.symbol = name;
+  var->type = type;
+  var->written = 0;
+  return var;
+}
+
+static int is_callee_name(translator_t *tr, const char *name) {
+  akx_rt_jit_trace_t *trace = tr->trace;
+  for (size_t i = 0; i < trace->callee_count; i++) {
+    if (same_name(trace->callees[i].name, name) ||
+        (trace->callees[i].self &&
+         same_name(trace->callees[i].self, name))) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static uint8_t branch_taken(translator_t *tr, akx_cell_t *args) {
+  if (tr->trace) {
+    for (size_t i = 0; i < tr->trace->branch_count; i++) {
+      if (tr->trace->branches[i].key == args) {
+        return tr->trace->branches[i].taken;
+      }
+    }
+  }
+  return 3;
+}
+
+static int translate_expr(translator_t *tr, akx_cell_t *expr,
+                          const uint32_t *env, int tail, operand_t *out);
+
+static int translate_literal(translator_t *tr, akx_cell_t *expr,
+                             operand_t *out) {
+  out->type = value_type(expr);
+  if (out->type == JIT_INT) {
+    int64_t value = expr->value.integer_literal;
+    out->var = declare(tr, JIT_INT);
+    if (value == INT64_MIN) {
+      put(&tr->src, " = INT64_MIN;\n");
+    } else {
+      put(&tr->src, " = %lldLL;\n", (long long)value);
+    }
+    return 0;
+  }
+  double value = expr->value.real_literal;
+  if (out->type != JIT_REAL || value - value != 0) {
+    return reject(tr);
+  }
+  char text[40];
+  snprintf(text, sizeof(text), "%.17g", value);
+  out->var = declare(tr, JIT_REAL);
+  put(&tr->src, " = %s%s;\n", text, strpbrk(text, ".e") ? "" : ".0");
+  return 0;
+}
+
+static int translate_name(translator_t *tr, akx_cell_t *expr,
+                          operand_t *out) {
+  jit_local_t *local = find_local(tr, expr->value.symbol);
+  uint32_t var;
+  if (local) {
+    out->type = local->type;
+    var = local->var;
+  } else {
+    jit_var_t *carried = find_var(tr, expr->value.symbol);
+    if (!carried) {
+      return reject(tr);
+    }
+    out->type = carried->type;
+    var = (uint32_t)(carried - tr->trace->vars);
+  }
+  if (out->type == JIT_NIL) {
+    out->var = 0;
+    return 0;
+  }
+  // Copied, so a later set or tail call leaves the value alone
+  out->var = declare(tr, out->type);
+  put(&tr->src, " = v%u;\n", var);
+  return 0;
+}
+
+static void assign_branch(translator_t *tr, uint32_t var,
+                          const operand_t *value) {
+  if (!value->jumps && (value->type == JIT_INT || value->type == JIT_REAL)) {
+    put(&tr->src, "v%u = v%u;\n", var, value->var);
+  }
+}
+
+static int translate_if(translator_t *tr, akx_cell_t *args,
+                        const uint32_t *env, int tail, operand_t *out) {
+  operand_t cond;
+  operand_t then_value;
+  operand_t else_value = {JIT_NIL, 0, 0};
+  akx_cell_t *else_branch = args->next->next;
+  if (translate_expr(tr, args, env, 0, &cond) != 0) {
+    return -1;
+  }
+  if (cond.type == JIT_NIL || cond.type == JIT_VOID) {
+    return reject(tr);
+  }
+  // Only the integer 1 is true
+  char test[48];
+  if (cond.type == JIT_REAL) {
+    snprintf(test, sizeof(test), "0");
+  } else {
+    snprintf(test, sizeof(test), "v%u == 1", cond.var);
+  }
+
+  // A loop trace follows the way the recording saw an if go, and leaves
+  // for the interpreter when it goes the other way
+  uint8_t taken = branch_taken(tr, args);
+  if (taken == 1 || taken == 2) {
+    put(&tr->src, "if (%s(%s)) {\nstatus = 2;\ngoto out;\n}\n",
+        taken == 2 ? "!" : "", test);
+    akx_cell_t *branch = taken == 2 ? args->next : else_branch;
+    if (!branch) {
+      *out = else_value;
+      return 0;
+    }
+    return translate_expr(tr, branch, env, tail, out);
+  }
+
+  // Declared int64_t and retyped once the branches are known; "double "
+  // is as long as "int64_t"
+  size_t decl = tr->src.length;
+  out->var = declare(tr, JIT_INT);
+  put(&tr->src, ";\nif (%s) {\n", test);
+  if (translate_expr(tr, args->next, env, tail, &then_value) != 0) {
+    return -1;
+  }
+  assign_branch(tr, out->var, &then_value);
+  put(&tr->src, "} else {\n");
+  if (else_branch &&
+      translate_expr(tr, else_branch, env, tail, &else_value) != 0) {
+    return -1;
+  }
+  assign_branch(tr, out->var, &else_value);
+  put(&tr->src, "}\n");
+
+  // Either side may still be JIT_ANY on the first pass
+  if (then_value.type == JIT_ANY || then_value.type == else_value.type) {
+    out->type = else_value.type;
+  } else if (else_value.type == JIT_ANY) {
+    out->type = then_value.type;
+  } else {
+    out->type = JIT_VOID;
+  }
+  if ((then_value.type == JIT_REAL || else_value.type == JIT_REAL) &&
+      !tr->src.failed) {
+    memcpy(tr->src.data + decl, "double ", 7);
+  }
+  out->jumps = then_value.jumps && else_value.jumps;
+  return 0;
+}
+
+static int translate_arith(translator_t *tr, int op, uint8_t type,
+                           const operand_t *argv, size_t argc,
+                           operand_t *out) {
+  for (size_t i = 0; i < argc; i++) {
+    if (argv[i].type != JIT_ANY && argv[i].type != type) {
+      return reject(tr);
+    }
+  }
+  static const char *const int_ops[] = {"akx_jit_add", "akx_jit_sub",
+                                        "akx_jit_mul"};
+  static const char real_ops[] = {'+', '-', '*', '/'};
+  uint32_t a = argv[0].var;
+  out->type = type;
+  if (type == JIT_INT && (op == JIT_DIV || op == JIT_MOD)) {
+    uint32_t b = argv[1].var;
+    put(&tr->src,
+        "if (v%u == 0 || (v%u == INT64_MIN && v%u == -1)) {\n%s;\n}\n", b,
+        a, b, tr->deopt);
+    out->var = declare(tr, JIT_INT);
+    put(&tr->src, " = v%u %c v%u;\n", a, op == JIT_DIV ? '/' : '%', b);
+    return 0;
+  }
+  out->var = declare(tr, type);
+  put(&tr->src, " = v%u;\n", a);
+  for (size_t i = 1; i < argc; i++) {
+    uint32_t b = argv[i].var;
+    if (type == JIT_INT) {
+      put(&tr->src, "if (%s(v%u, v%u, &v%u)) {\n%s;\n}\n",
+          int_ops[op - JIT_ADD], out->var, b, out->var, tr->deopt);
+      continue;
+    }
+    if (op == JIT_DIV) {
+      put(&tr->src, "if (v%u < 1e-10 && v%u > -1e-10) {\n%s;\n}\n", b, b,
+          tr->deopt);
+    }
+    put(&tr->src, "v%u %c= v%u;\n", out->var, real_ops[op - JIT_ADD], b);
+  }
+  return 0;
+}
+
+static int translate_compare(translator_t *tr, int op, uint8_t type,
+                             const operand_t *argv, size_t argc,
+                             operand_t *out) {
+  for (size_t i = 0; i < argc; i++) {
+    if (argv[i].type == JIT_NIL || argv[i].type == JIT_VOID ||
+        (type == JIT_REAL && argv[i].type == JIT_INT)) {
+      return reject(tr);
+    }
+  }
+  out->type = JIT_INT;
+  out->var = declare(tr, JIT_INT);
+  if (op == JIT_EQ || op == JIT_NEQ) {
+    // eq and neq compare values of different types as different; real/eq
+    // and real/neq allow for rounding
+    put(&tr->src, " = 1;\n");
+    for (size_t i = 0; i < argc; i++) {
+      for (size_t j = i + 1; j < argc; j++) {
+        if (op == JIT_EQ && i > 0) {
+          break;
+        }
+        uint32_t a = argv[i].var;
+        uint32_t b = argv[j].var;
+        int same = op == JIT_EQ;
+        if (argv[i].type != argv[j].type && argv[i].type != JIT_ANY &&
+            argv[j].type != JIT_ANY) {
+          if (same) {
+            put(&tr->src, "v%u = 0;\n", out->var);
+          }
+        } else if (type == JIT_REAL) {
+          put(&tr->src,
+              same ? "if (v%u - v%u > 1e-10 || v%u - v%u < -1e-10) {\n"
+                   : "if (v%u - v%u < 1e-10 && v%u - v%u > -1e-10) {\n",
+              a, b, a, b);
+          put(&tr->src, "v%u = 0;\n}\n", out->var);
+        } else {
+          put(&tr->src, "if (v%u %s v%u) {\nv%u = 0;\n}\n", a,
+              same ? "!=" : "==", b, out->var);
+        }
+      }
+    }
+    return 0;
+  }
+  if (argv[0].type != JIT_ANY && argv[1].type != JIT_ANY &&
+      argv[0].type != argv[1].type) {
+    return reject(tr);
+  }
+  static const char *const compare_ops[] = {"<", ">", "<=", ">="};
+  put(&tr->src, " = v%u %s v%u;\n", argv[0].var, compare_ops[op - JIT_LT],
+      argv[1].var);
+  return 0;
+}
+
+// set and let in a loop body work on C locals: let only where it binds in
+// the iteration's scope, set never in the condition
+static int translate_binding(translator_t *tr, int op, akx_cell_t *args,
+                             int statement, operand_t *out) {
+  if (!tr->trace || args->type != AKX_TYPE_SYMBOL ||
+      (op == JIT_LET && !statement) || (op == JIT_SET && tr->in_condition)) {
+    return reject(tr);
+  }
+  const char *name = args->value.symbol;
+  if (translate_expr(tr, args->next, NULL, 0, out) != 0) {
+    return -1;
+  }
+  if (out->type != JIT_INT && out->type != JIT_REAL) {
+    return reject(tr);
+  }
+  if (op == JIT_LET) {
+    if (find_local(tr, name) || is_callee_name(tr, name)) {
+      return reject(tr);
+    }
+    return push_local(tr, name, out->var, out->type);
+  }
+
+  jit_local_t *local = find_local(tr, name);
+  uint32_t var;
+  uint8_t type;
+  if (local) {
+    var = local->var;
+    type = local->type;
+  } else {
+    jit_var_t *carried = find_var(tr, name);
+    if (!carried) {
+      return reject(tr);
+    }
+    carried->written = 1;
+    var = (uint32_t)(carried - tr->trace->vars);
+    type = carried->type;
+  }
+  if (type != out->type) {
+    return reject(tr);
+  }
+  put(&tr->src, "v%u = v%u;\n", var, out->var);
+  return 0;
+}
+
+static int translate_builtin(translator_t *tr, akx_cell_t *expr,
+                             akx_builtin_info_t *info, const uint32_t *env,
+                             int tail, int statement, operand_t *out) {
+  akx_cell_t *head = expr->value.list_head;
+  const char *name = head->value.symbol;
+  size_t index = 0;
+  size_t count = sizeof(jit_builtins) / sizeof(jit_builtins[0]);
+  while (index < count && strcmp(jit_builtins[index].name, name) != 0) {
+    index++;
+  }
+  // A builtin loaded with cjit-load-builtin may mean anything
+  if (index == count || info->unit || !info->module_name ||
+      strcmp(info->module_name, name) != 0) {
+    return reject(tr);
+  }
+  int op = jit_builtins[index].op;
+  uint8_t type = jit_builtins[index].type;
+  size_t argc = akx_rt_list_length(head->next);
+  if (argc < jit_builtins[index].min_args ||
+      (jit_builtins[index].max_args && argc > jit_builtins[index].max_args) ||
+      argc > AKX_RT_JIT_MAX_ARGS || add_guard(tr, name, info) != 0) {
+    return reject(tr);
+  }
+
+  if (op == JIT_IF) {
+    return translate_if(tr, head->next, env, tail, out);
+  }
+  if (op == JIT_BEGIN) {
+    for (akx_cell_t *arg = head->next; arg; arg = arg->next) {
+      tr->statement = statement;
+      if (translate_expr(tr, arg, env, tail && !arg->next, out) != 0) {
+        return -1;
+      }
+    }
+    return 0;
+  }
+  if (op == JIT_SET || op == JIT_LET) {
+    return translate_binding(tr, op, head->next, statement, out);
+  }
+
+  operand_t argv[AKX_RT_JIT_MAX_ARGS];
+  size_t i = 0;
+  for (akx_cell_t *arg = head->next; arg; arg = arg->next, i++) {
+    if (translate_expr(tr, arg, env, 0, &argv[i]) != 0) {
+      return -1;
+    }
+  }
+  out->jumps = 0;
+  if (op <= JIT_MOD) {
+    return translate_arith(tr, op, type, argv, argc, out);
+  }
+  return translate_compare(tr, op, type, argv, argc, out);
+}
+
+// Arguments bind one at a time in the callee's frame, so each sees the
+// parameters bound before it and the caller's values of the rest
+static int translate_self_call(translator_t *tr, akx_cell_t *expr,
+                               const uint32_t *env, int tail,
+                               operand_t *out) {
+  akx_rt_jit_code_t *code = tr->code;
+  akx_cell_t *head = expr->value.list_head;
+  if (!code->self) {
+    if (!is_self(akx_rt_lookup_symbol(tr->rt, head), tr->lambda_ctx)) {
+      return reject(tr);
+    }
+    code->self = head;
+  } else if (!same_name(code->self->value.symbol, head->value.symbol)) {
+    return reject(tr);
+  }
+  if (akx_rt_list_length(head->next) != code->param_count ||
+      add_guard(tr, head->value.symbol, NULL) != 0) {
+    return reject(tr);
+  }
+
+  uint32_t bound[AKX_RT_JIT_MAX_PARAMS];
+  memcpy(bound, env, sizeof(uint32_t) * code->param_count);
+  size_t i = 0;
+  for (akx_cell_t *arg = head->next; arg; arg = arg->next, i++) {
+    operand_t value;
+    if (translate_expr(tr, arg, bound, 0, &value) != 0) {
+      return -1;
+    }
+    if (value.type != JIT_ANY && value.type != code->types[i]) {
+      return reject(tr);
+    }
+    bound[i] = value.var;
+  }
+
+  out->type = tr->result_type;
+  out->jumps = (uint8_t)tail;
+  if (tail) {
+    for (i = 0; i < code->param_count; i++) {
+      put(&tr->src, "v%zu = v%u;\n", i, bound[i]);
+    }
+    put(&tr->src, "goto top;\n");
+    return 0;
+  }
+  out->var = declare(tr, tr->result_type);
+  put(&tr->src, ";\nif (akx_jit_body(");
+  for (i = 0; i < code->param_count; i++) {
+    put(&tr->src, "v%u, ", bound[i]);
+  }
+  put(&tr->src, "&v%u, depth + 1)) {\nreturn 1;\n}\n", out->var);
+  return 0;
+}
+
+// A loop calls lambdas that already have native code, through their entry
+// points, which the trace is handed each time it runs
+static int translate_call(translator_t *tr, akx_cell_t *expr,
+                          operand_t *out) {
+  akx_rt_jit_trace_t *trace = tr->trace;
+  akx_cell_t *head = expr->value.list_head;
+  const char *name = head->value.symbol;
+  akx_cell_t *bound = find_local(tr, name)
+                          ? NULL
+                          : (akx_cell_t *)akx_rt_scope_get(tr->rt, name);
+  if (!bound || bound->type != AKX_TYPE_LAMBDA || !bound->value.lambda) {
+    return reject(tr);
+  }
+  akx_lambda_context_t *callee_ctx =
+      (akx_lambda_context_t *)ak_lambda_get_context(bound->value.lambda);
+  akx_rt_jit_code_t *code = callee_ctx ? callee_ctx->jit : NULL;
+  int state = code ? atomic_load_explicit(&code->state, memory_order_acquire)
+                   : (callee_ctx ? JIT_QUEUED : JIT_OFF);
+  if (state != JIT_READY) {
+    tr->retry = state == JIT_QUEUED;
+    return reject(tr);
+  }
+  const char *self = code->self ? code->self->value.symbol : NULL;
+  size_t argc = akx_rt_list_length(head->next);
+  if (argc != code->param_count || (self && find_local(tr, self)) ||
+      add_guard(tr, name, NULL) != 0) {
+    return reject(tr);
+  }
+
+  size_t index = 0;
+  while (index < trace->callee_count &&
+         !same_name(trace->callees[index].name, name)) {
+    index++;
+  }
+  jit_callee_t *callee = &trace->callees[index];
+  if (index == trace->callee_count) {
+    if (index == AKX_RT_JIT_MAX_CALLEES) {
+      return reject(tr);
+    }
+    trace->callee_count++;
+    callee->name = name;
+    callee->self = self;
+    akx_cell_init_immediate(&callee->symbol, AKX_TYPE_SYMBOL);
+    callee->symbol.value.symbol = name;
+    callee->param_count = argc;
+    memcpy(callee->types, code->types, sizeof(code->types));
+    callee->result_type = code->result_type;
+  } else if (callee->param_count != argc || callee->self != self ||
+             callee->result_type != code->result_type ||
+             memcmp(callee->types, code->types, sizeof(code->types)) != 0) {
+    return reject(tr);
+  }
+
+  operand_t values[AKX_RT_JIT_MAX_PARAMS];
+  size_t mark = tr->local_count;
+  size_t i = 0;
+  for (akx_cell_t *arg = head->next; arg; arg = arg->next, i++) {
+    if (translate_expr(tr, arg, NULL, 0, &values[i]) != 0) {
+      return -1;
+    }
+    if (values[i].type != code->types[i] ||
+        push_local(tr, callee_ctx->param_names[i], values[i].var,
+                   values[i].type) != 0) {
+      return reject(tr);
+    }
+  }
+  tr->local_count = mark;
+
+  uint32_t argv = tr->next_var++;
+  uint32_t result = tr->next_var++;
+  put(&tr->src, "akx_value_t v%u[%zu];\nakx_value_t v%u;\n", argv,
+      argc ? argc : 1, result);
+  for (i = 0; i < argc; i++) {
+    put(&tr->src, "v%u[%zu].as.%s = v%u;\n", argv, i,
+        c_field(values[i].type), values[i].var);
+  }
+  put(&tr->src, "if (callees[%zu](v%u, &v%u)) {\n%s;\n}\n", index, argv,
+      result, tr->deopt);
+  out->type = callee->result_type;
+  out->jumps = 0;
+  out->var = declare(tr, out->type);
+  put(&tr->src, " = v%u.as.%s;\n", result, c_field(out->type));
+  return 0;
+}
+
+static int translate_expr(translator_t *tr, akx_cell_t *expr,
+                          const uint32_t *env, int tail, operand_t *out) {
+  // Only a loop's body, and begins in it, are statements
+  int statement = tr->statement;
+  tr->statement = 0;
+  out->jumps = 0;
+  switch (expr->type) {
+  case AKX_TYPE_INTEGER_LITERAL:
+  case AKX_TYPE_REAL_LITERAL:
+    return translate_literal(tr, expr, out);
+  case AKX_TYPE_SYMBOL: {
+    if (tr->trace) {
+      return translate_name(tr, expr, out);
+    }
+    // Copied, so a tail call can reassign the parameters in any order
+    size_t i = param_index(tr->lambda_ctx, expr->value.symbol);
+    if (i == tr->code->param_count) {
+      return reject(tr);
+    }
+    out->type = tr->code->types[i];
+    out->var = declare(tr, out->type);
+    put(&tr->src, " = v%u;\n", env[i]);
+    return 0;
+  }
+  default:
+    break;
+  }
+  akx_cell_t *head = is_list_cell(expr) ? expr->value.list_head : NULL;
+  if (!head || head->type != AKX_TYPE_SYMBOL) {
+    return reject(tr);
+  }
+  akx_builtin_info_t *info =
+      akx_rt_resolve_builtin(tr->rt, expr, head->value.symbol);
+  if (info) {
+    return translate_builtin(tr, expr, info, env, tail, statement, out);
+  }
+  if (tr->trace) {
+    return translate_call(tr, expr, out);
+  }
+  return translate_self_call(tr, expr, env, tail, out);
+}
+
+// Emits the body as akx_jit_body() and returns the type of its value
+static uint8_t translate_body(translator_t *tr) {
+  akx_rt_jit_code_t *code = tr->code;
+  source_t *src = &tr->src;
+  put(src, "%s\n%s\n", akx_compiler_generate_abi_header(), jit_prelude);
+  put(src, "static int akx_jit_body(");
+  uint32_t env[AKX_RT_JIT_MAX_PARAMS];
+  for (size_t i = 0; i < code->param_count; i++) {
+    put(src, "%s v%zu, ", c_type(code->types[i]), i);
+    env[i] = (uint32_t)i;
+  }
+  put(src, "%s *out, unsigned depth) {\n", c_type(tr->result_type));
+  put(src, "if (depth > %d) {\nreturn 1;\n}\ntop:;\n", AKX_RT_JIT_MAX_DEPTH);
+
+  operand_t value = {0};
+  for (akx_cell_t *expr = tr->lambda_ctx->body; expr; expr = expr->next) {
+    if (translate_expr(tr, expr, env, !expr->next, &value) != 0) {
+      return JIT_ANY;
+    }
+  }
+  if (!value.jumps) {
+    put(src, "*out = v%u;\nreturn 0;\n", value.var);
+  }
+  put(src, "}\n\n");
+
+  put(src, "int akx_jit_entry(const akx_value_t *argv, akx_value_t *result) "
+           "{\n%s value;\nif (akx_jit_body(",
+      c_type(tr->result_type));
+  for (size_t i = 0; i < code->param_count; i++) {
+    put(src, "argv[%zu].as.%s, ", i, c_field(code->types[i]));
+  }
+  put(src, "&value, 0)) {\nreturn 1;\n}\n");
+  put(src, "result->as.%s = value;\nreturn 0;\n}\n",
+      c_field(tr->result_type));
+  return value.jumps ? tr->result_type : value.type;
+}
+
+// Specializes the body for the types of the arguments it has now. The
+// first pass finds the type of its value, the second emits code with it.
+static int translate(akx_rt_jit_t *jit, akx_lambda_context_t *lambda_ctx,
+                     akx_rt_jit_code_t *code, void **slots) {
+  size_t count = lambda_ctx->param_count;
+  if (count > AKX_RT_JIT_MAX_PARAMS || !lambda_ctx->body) {
+    return -1;
+  }
+  for (size_t i = 0; i < count; i++) {
+    code->types[i] = value_type((akx_cell_t *)slots[i]);
+    if (code->types[i] == JIT_ANY ||
+        param_index(lambda_ctx, lambda_ctx->param_names[i]) != i) {
+      return -1;
+    }
+  }
+  code->param_count = count;
+  code->generation = akx_rt_builtin_generation();
+
+  translator_t tr = {0};
+  tr.rt = jit->rt;
+  tr.lambda_ctx = lambda_ctx;
+  tr.code = code;
+  tr.deopt = "return 1";
+  tr.result_type = JIT_ANY;
+  for (int pass = 0; pass < 2; pass++) {
+    tr.src.length = 0;
+    tr.next_var = (uint32_t)count;
+    code->guard_count = 0;
+    uint8_t type = translate_body(&tr);
+    if (tr.failed || tr.src.failed || type == JIT_ANY || type > JIT_REAL ||
+        (pass == 1 && type != tr.result_type)) {
+      if (tr.src.data) {
+        AK24_FREE(tr.src.data);
+      }
+      return -1;
+    }
+    tr.result_type = type;
+  }
+  code->result_type = tr.result_type;
+  code->source = tr.src.data;
+  return 0;
+}
+
+// Emits one iteration of the loop, its condition first, as a C loop over
+// unboxed copies of the loop's variables. The copies are written back when
+// an iteration completes, so leaving in the middle of one loses nothing
+// the interpreter will not redo.
+static uint8_t translate_loop_body(translator_t *tr) {
+  akx_rt_jit_trace_t *trace = tr->trace;
+  source_t *src = &tr->src;
+  put(src, "%s\n%s\n", akx_compiler_generate_abi_header(), jit_prelude);
+  put(src, "int akx_jit_entry(akx_value_t *vars, const akx_jit_fn *callees, "
+           "akx_value_t *last, uint64_t *iterations) {\n");
+  for (size_t i = 0; i < trace->var_count; i++) {
+    uint8_t type = trace->vars[i].type;
+    if (type != JIT_NIL) {
+      put(src, "%s c%zu = vars[%zu].as.%s;\n%s v%zu = c%zu;\n", c_type(type),
+          i, i, c_field(type), c_type(type), i, i);
+    }
+  }
+  put(src, "%s l = 0;\nuint64_t n = 0;\nint status = 0;\nfor (;;) {\n",
+      c_type(tr->result_type));
+
+  operand_t value;
+  tr->in_condition = 1;
+  if (translate_expr(tr, trace->form, NULL, 0, &value) != 0) {
+    return JIT_ANY;
+  }
+  tr->in_condition = 0;
+  if (value.type != JIT_INT) {
+    return JIT_ANY;
+  }
+  put(src, "if (v%u != 1) {\nbreak;\n}\n", value.var);
+  for (akx_cell_t *expr = trace->form->next; expr; expr = expr->next) {
+    tr->statement = 1;
+    if (translate_expr(tr, expr, NULL, 0, &value) != 0) {
+      return JIT_ANY;
+    }
+  }
+  if (value.type != JIT_INT && value.type != JIT_REAL) {
+    return JIT_ANY;
+  }
+  put(src, "l = v%u;\n", value.var);
+  for (size_t i = 0; i < trace->var_count; i++) {
+    if (trace->vars[i].written) {
+      put(src, "c%zu = v%zu;\n", i, i);
+    }
+  }
+  put(src, "n++;\n}\nout:\n");
+  for (size_t i = 0; i < trace->var_count; i++) {
+    if (trace->vars[i].written) {
+      put(src, "vars[%zu].as.%s = c%zu;\n", i, c_field(trace->vars[i].type),
+          i);
+    }
+  }
+  put(src, "last->as.%s = l;\n*iterations = n;\nreturn status;\n}\n",
+      c_field(tr->result_type));
+  return value.type;
+}
+
+// Returns 1 when a lambda the loop calls is still being compiled
+static int translate_loop(akx_rt_jit_t *jit, akx_rt_jit_trace_t *trace,
+                          akx_rt_jit_code_t *code) {
+  trace->var_count = 0;
+  trace->callee_count = 0;
+  code->generation = akx_rt_builtin_generation();
+
+  translator_t tr = {0};
+  tr.rt = jit->rt;
+  tr.trace = trace;
+  tr.code = code;
+  tr.deopt = "status = 1;\ngoto out";
+  tr.result_type = JIT_ANY;
+  size_t vars = 0;
+  for (int pass = 0; pass < 2; pass++) {
+    tr.src.length = 0;
+    tr.next_var = pass ? (uint32_t)trace->var_count : AKX_RT_JIT_MAX_VARS;
+    tr.local_count = 0;
+    code->guard_count = 0;
+    uint8_t type = translate_loop_body(&tr);
+    if (tr.failed || tr.src.failed || type == JIT_ANY ||
+        (pass == 1 && (type != tr.result_type || trace->var_count != vars))) {
+      if (tr.src.data) {
+        AK24_FREE(tr.src.data);
+      }
+      return tr.retry ? 1 : -1;
+    }
+    tr.result_type = type;
+    vars = trace->var_count;
+  }
+  code->result_type = tr.result_type;
+  code->source = tr.src.data;
+  return 0;
+}
+
+static void code_destroy(akx_rt_jit_code_t *code) {
+  if (code->unit) {
+    ak_cjit_unit_free(code->unit);
+  }
+  if (code->source) {
+    AK24_FREE(code->source);
+  }
+  if (code->guards) {
+    AK24_FREE(code->guards);
+  }
+  AK24_FREE(code);
+}
+
+static akx_rt_jit_code_t *code_new(akx_rt_jit_t *jit) {
+  akx_rt_jit_code_t *code = AK24_ALLOC(sizeof(akx_rt_jit_code_t));
+  if (code) {
+    memset(code, 0, sizeof(*code));
+    code->jit = jit;
+    atomic_init(&code->state, JIT_OFF);
+  }
+  return code;
+}
+
+// Runs without the lock; returns how long CJIT took
+static uint64_t compile(akx_rt_jit_code_t *code) {
+  uint64_t start = now_ns();
+  ak_cjit_unit_t *unit = ak_cjit_unit_new(NULL, NULL, NULL);
+  void *entry = NULL;
+  if (unit && ak_cjit_add_source(unit, code->source, "akx-jit") ==
+                  AK_CJIT_OK &&
+      ak_cjit_relocate(unit) == AK_CJIT_OK) {
+    entry = ak_cjit_get_symbol(unit, "akx_jit_entry");
+  }
+  if (!entry && unit) {
+    ak_cjit_unit_free(unit);
+    unit = NULL;
+  }
+  AK24_FREE(code->source);
+  code->source = NULL;
+  code->unit = unit;
+  if (code->loop) {
+    code->loop_entry = (jit_loop_fn)entry;
+  } else {
+    code->entry = (jit_entry_fn)entry;
+  }
+  return now_ns() - start;
+}
+
+static void publish(akx_rt_jit_t *jit, akx_rt_jit_code_t *code,
+                    uint64_t elapsed) {
+  if (code->unit) {
+    if (code->loop) {
+      jit->stats.traces++;
+    } else {
+      jit->stats.tier_ups++;
+    }
+    jit->stats.last_compile_ns = elapsed;
+    jit->stats.total_compile_ns += elapsed;
+    if (elapsed > jit->stats.max_compile_ns) {
+      jit->stats.max_compile_ns = elapsed;
+    }
+  } else {
+    AK24_LOG_TRACE("JIT: CJIT did not compile hot code");
+    jit->stats.failed++;
+  }
+  atomic_store_explicit(&code->state, code->unit ? JIT_READY : JIT_OFF,
+                        memory_order_release);
+}
+
+#ifdef AKX_RT_JIT_THREADED
+static void *worker_main(void *arg) {
+  akx_rt_jit_t *jit = (akx_rt_jit_t *)arg;
+  pthread_mutex_lock(&jit->lock);
+  while (1) {
+    while (!jit->queue_head && !jit->stopping) {
+      pthread_cond_wait(&jit->wake, &jit->lock);
+    }
+    if (jit->stopping) {
+      break;
+    }
+    akx_rt_jit_code_t *code = jit->queue_head;
+    jit->queue_head = code->next;
+    if (!jit->queue_head) {
+      jit->queue_tail = NULL;
+    }
+    if (code->orphaned) {
+      code_destroy(code);
+      continue;
+    }
+    pthread_mutex_unlock(&jit->lock);
+    uint64_t elapsed = compile(code);
+    pthread_mutex_lock(&jit->lock);
+    code->queued = 0;
+    if (code->orphaned) {
+      code_destroy(code);
+    } else {
+      publish(jit, code, elapsed);
+    }
+  }
+  pthread_mutex_unlock(&jit->lock);
+  return NULL;
+}
+#endif
+
+static void submit(akx_rt_jit_t *jit, akx_rt_jit_code_t *code) {
+  atomic_store_explicit(&code->state, JIT_QUEUED, memory_order_relaxed);
+#ifdef AKX_RT_JIT_THREADED
+  pthread_mutex_lock(&jit->lock);
+  code->queued = 1;
+  code->next = NULL;
+  if (jit->queue_tail) {
+    jit->queue_tail->next = code;
+  } else {
+    jit->queue_head = code;
+  }
+  jit->queue_tail = code;
+  pthread_cond_signal(&jit->wake);
+  pthread_mutex_unlock(&jit->lock);
+#else
+  publish(jit, code, compile(code));
+#endif
+}
+
+static void tier_up(akx_rt_jit_t *jit, akx_lambda_context_t *lambda_ctx) {
+  // Types come from the arguments of this call
+  void **slots = akx_rt_frame_slots(jit->rt, lambda_ctx);
+  if (!slots) {
+    return;
+  }
+  akx_rt_jit_code_t *code = code_new(jit);
+  if (!code) {
+    return;
+  }
+  lambda_ctx->jit = code;
+  if (translate(jit, lambda_ctx, code, slots) != 0) {
+    jit->stats.rejected++;
+    return;
+  }
+  submit(jit, code);
+}
+
+static akx_cell_t *deopt(akx_rt_jit_t *jit, akx_rt_jit_code_t *code) {
+  jit->stats.deopts++;
+  if (++code->deopts == AKX_RT_JIT_MAX_DEOPTS) {
+    atomic_store_explicit(&code->state, JIT_OFF, memory_order_relaxed);
+    ak_cjit_unit_free(code->unit);
+    code->unit = NULL;
+    code->entry = NULL;
+  }
+  return NULL;
+}
+
+static int guards_hold(akx_runtime_ctx_t *rt, akx_rt_jit_code_t *code) {
+  for (size_t i = 0; i < code->guard_count; i++) {
+    jit_guard_t *guard = &code->guards[i];
+    akx_builtin_info_t *info = akx_rt_resolve_builtin(rt, NULL, guard->name);
+    if (info != guard->info || (info && info->unit)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static akx_cell_t *run(akx_rt_jit_t *jit, akx_lambda_context_t *lambda_ctx,
+                       akx_rt_jit_code_t *code) {
+  akx_runtime_ctx_t *rt = jit->rt;
+  uint32_t generation = akx_rt_builtin_generation();
+  if (code->generation != generation) {
+    if (!guards_hold(rt, code)) {
+      // A builtin the code computes itself has changed: count calls
+      // afresh and translate against the new one
+      jit->stats.invalidations++;
+      lambda_ctx->jit = NULL;
+      lambda_ctx->calls = 0;
+      akx_rt_jit_code_free(code);
+      return NULL;
+    }
+    code->generation = generation;
+  }
+
+  void **slots = akx_rt_frame_slots(rt, lambda_ctx);
+  if (!slots) {
+    return NULL;
+  }
+  akx_value_t argv[AKX_RT_JIT_MAX_PARAMS];
+  for (size_t i = 0; i < code->param_count; i++) {
+    akx_cell_t *cell = (akx_cell_t *)slots[i];
+    if (value_type(cell) != code->types[i]) {
+      return deopt(jit, code);
+    }
+    if (code->types[i] == JIT_INT) {
+      argv[i].as.integer = cell->value.integer_literal;
+    } else {
+      argv[i].as.real = cell->value.real_literal;
+    }
+  }
+  if (code->self &&
+      !is_self(akx_rt_lookup_symbol(rt, code->self), lambda_ctx)) {
+    return deopt(jit, code);
+  }
+
+  akx_value_t result;
+  if (code->entry(argv, &result) != 0) {
+    return deopt(jit, code);
+  }
+  jit->stats.native_calls++;
+  return box(rt, code->result_type, result);
+}
+
+akx_cell_t *akx_rt_jit_enter(akx_rt_jit_t *jit,
+                             akx_lambda_context_t *lambda_ctx) {
+  akx_rt_jit_code_t *code = lambda_ctx->jit;
+  if (!code) {
+    if (++lambda_ctx->calls >= jit->threshold) {
+      tier_up(jit, lambda_ctx);
+    }
+    return NULL;
+  }
+  if (atomic_load_explicit(&code->state, memory_order_acquire) !=
+      JIT_READY) {
+    return NULL;
+  }
+  return run(jit, lambda_ctx, code);
+}
+
+void akx_rt_jit_code_free(akx_rt_jit_code_t *code) {
+  if (!code) {
+    return;
+  }
+#ifdef AKX_RT_JIT_THREADED
+  akx_rt_jit_t *jit = code->jit;
+  pthread_mutex_lock(&jit->lock);
+  if (code->queued) {
+    // The worker has it; it frees it when it is done
+    code->orphaned = 1;
+    pthread_mutex_unlock(&jit->lock);
+    return;
+  }
+  pthread_mutex_unlock(&jit->lock);
+#endif
+  code_destroy(code);
+}
+
+static uint64_t form_hash(const akx_cell_t *cell, uint64_t hash) {
+  for (; cell; cell = cell->next) {
+    uint64_t bits = 0;
+    switch (cell->type) {
+    case AKX_TYPE_SYMBOL:
+      bits = (uint64_t)(uintptr_t)cell->value.symbol;
+      break;
+    case AKX_TYPE_INTEGER_LITERAL:
+    case AKX_TYPE_REAL_LITERAL:
+      memcpy(&bits, &cell->value, sizeof(bits));
+      break;
+    case AKX_TYPE_LIST:
+    case AKX_TYPE_LIST_SQUARE:
+    case AKX_TYPE_LIST_CURLY:
+    case AKX_TYPE_LIST_TEMPLE:
+      hash = form_hash(cell->value.list_head, hash);
+      break;
+    default:
+      bits = (uint64_t)(uintptr_t)cell->value.string_literal;
+      break;
+    }
+    hash = (hash ^ cell->type ^ ((uint64_t)cell->flags << 8)) *
+           1099511628211ull;
+    hash = (hash ^ bits) * 1099511628211ull;
+  }
+  return hash;
+}
+
+static void trace_drop_code(akx_rt_jit_trace_t *trace) {
+  akx_rt_jit_code_free(trace->code);
+  trace->code = NULL;
+}
+
+static void trace_off(akx_rt_jit_trace_t *trace) {
+  trace_drop_code(trace);
+  trace->off = 1;
+}
+
+akx_rt_jit_trace_t *akx_rt_jit_trace_get(akx_rt_jit_t *jit,
+                                         akx_cell_t *args) {
+  uint64_t hash = form_hash(args, 14695981039346656037ull);
+  size_t bucket = ((uintptr_t)args >> 4) % AKX_RT_JIT_TRACE_BUCKETS;
+  akx_rt_jit_trace_t *trace = jit->traces[bucket];
+  while (trace && trace->key != args) {
+    trace = trace->next;
+  }
+  if (trace && trace->hash != hash) {
+    // Another loop where a freed one was; no loop runs the old trace, as
+    // its cells are gone
+    akx_rt_jit_trace_t *next = trace->next;
+    trace_drop_code(trace);
+    if (jit->recording == trace) {
+      jit->recording = NULL;
+    }
+    memset(trace, 0, sizeof(*trace));
+    trace->next = next;
+    trace->key = args;
+    trace->hash = hash;
+  }
+  if (!trace) {
+    trace = AK24_ALLOC(sizeof(akx_rt_jit_trace_t));
+    if (!trace) {
+      return NULL;
+    }
+    memset(trace, 0, sizeof(*trace));
+    trace->key = args;
+    trace->hash = hash;
+    trace->next = jit->traces[bucket];
+    jit->traces[bucket] = trace;
+  }
+  trace->form = args;
+  return trace->off ? NULL : trace;
+}
+
+void akx_rt_jit_record_branch(akx_rt_jit_t *jit, const akx_cell_t *args,
+                              int taken) {
+  akx_rt_jit_trace_t *trace = jit->recording;
+  if (!trace) {
+    return;
+  }
+  uint8_t bit = taken ? 2 : 1;
+  for (size_t i = 0; i < trace->branch_count; i++) {
+    if (trace->branches[i].key == args) {
+      trace->branches[i].taken |= bit;
+      return;
+    }
+  }
+  if (trace->branch_count < AKX_RT_JIT_MAX_BRANCHES) {
+    trace->branches[trace->branch_count].key = args;
+    trace->branches[trace->branch_count].taken = bit;
+    trace->branch_count++;
+  }
+}
+
+static void compile_trace(akx_rt_jit_t *jit, akx_rt_jit_trace_t *trace) {
+  akx_rt_jit_code_t *code = code_new(jit);
+  if (!code) {
+    trace->off = 1;
+    return;
+  }
+  code->loop = 1;
+  int status = translate_loop(jit, trace, code);
+  if (status == 0) {
+    trace->code = code;
+    submit(jit, code);
+    return;
+  }
+  code_destroy(code);
+  if (status > 0) {
+    trace->iterations = 0;
+    return;
+  }
+  jit->stats.rejected++;
+  trace->off = 1;
+}
+
+void akx_rt_jit_trace_step(akx_rt_jit_t *jit, akx_rt_jit_trace_t *trace) {
+  if (trace->off) {
+    return;
+  }
+  if (jit->recording == trace) {
+    if (++trace->recorded < AKX_RT_JIT_TRACE_ITERATIONS) {
+      return;
+    }
+    jit->recording = NULL;
+    compile_trace(jit, trace);
+    return;
+  }
+  if (!trace->code && !trace->record &&
+      ++trace->iterations >= jit->threshold) {
+    trace->record = 1;
+  }
+}
+
+static int trace_deopt(akx_rt_jit_t *jit, akx_rt_jit_trace_t *trace) {
+  jit->stats.deopts++;
+  if (++trace->deopts == AKX_RT_JIT_MAX_DEOPTS) {
+    trace_off(trace);
+  }
+  return 0;
+}
+
+// Each lambda the trace calls must still have native code of the types the
+// trace was compiled against
+static int bind_callees(akx_runtime_ctx_t *rt, akx_rt_jit_trace_t *trace,
+                        jit_entry_fn *entries) {
+  uint32_t generation = akx_rt_builtin_generation();
+  for (size_t i = 0; i < trace->callee_count; i++) {
+    jit_callee_t *callee = &trace->callees[i];
+    akx_cell_t *bound =
+        (akx_cell_t *)akx_rt_lookup_symbol(rt, &callee->symbol);
+    if (!bound || bound->type != AKX_TYPE_LAMBDA || !bound->value.lambda) {
+      return -1;
+    }
+    akx_lambda_context_t *callee_ctx =
+        (akx_lambda_context_t *)ak_lambda_get_context(bound->value.lambda);
+    akx_rt_jit_code_t *code = callee_ctx ? callee_ctx->jit : NULL;
+    if (!code ||
+        atomic_load_explicit(&code->state, memory_order_acquire) !=
+            JIT_READY ||
+        code->generation != generation ||
+        code->param_count != callee->param_count ||
+        code->result_type != callee->result_type ||
+        memcmp(code->types, callee->types, sizeof(code->types)) != 0 ||
+        (code->self ? !callee->self ||
+                          !same_name(code->self->value.symbol,
+                                     callee->self) ||
+                          !is_self(akx_rt_lookup_symbol(rt, code->self),
+                                   callee_ctx)
+                    : callee->self != NULL)) {
+      return -1;
+    }
+    entries[i] = code->entry;
+  }
+  return 0;
+}
+
+int akx_rt_jit_trace_run(akx_rt_jit_t *jit, akx_rt_jit_trace_t *trace,
+                         akx_cell_t **last) {
+  akx_runtime_ctx_t *rt = jit->rt;
+  *last = NULL;
+  if (trace->off) {
+    return 0;
+  }
+  if (trace->record) {
+    trace->record = 0;
+    trace->recorded = 0;
+    jit->recording = trace;
+    return 0;
+  }
+  akx_rt_jit_code_t *code = trace->code;
+  int state = code ? atomic_load_explicit(&code->state, memory_order_acquire)
+                   : JIT_QUEUED;
+  if (state == JIT_OFF) {
+    trace_off(trace);
+  }
+  if (state != JIT_READY) {
+    return 0;
+  }
+  uint32_t generation = akx_rt_builtin_generation();
+  if (code->generation != generation) {
+    if (!guards_hold(rt, code)) {
+      jit->stats.invalidations++;
+      trace_drop_code(trace);
+      trace->iterations = 0;
+      return 0;
+    }
+    code->generation = generation;
+  }
+
+  akx_value_t vars[AKX_RT_JIT_MAX_VARS];
+  jit_entry_fn callees[AKX_RT_JIT_MAX_CALLEES];
+  for (size_t i = 0; i < trace->var_count; i++) {
+    jit_var_t *var = &trace->vars[i];
+    akx_cell_t *value =
+        (akx_cell_t *)akx_rt_lookup_symbol(rt, &var->symbol);
+    if (variable_type(rt, value) != var->type) {
+      return trace_deopt(jit, trace);
+    }
+    if (var->type == JIT_INT) {
+      vars[i].as.integer = value->value.integer_literal;
+    } else if (var->type == JIT_REAL) {
+      vars[i].as.real = value->value.real_literal;
+    }
+  }
+  if (bind_callees(rt, trace, callees) != 0) {
+    return trace_deopt(jit, trace);
+  }
+
+  akx_value_t result;
+  uint64_t iterations = 0;
+  int status = code->loop_entry(vars, callees, &result, &iterations);
+  jit->stats.native_iterations += iterations;
+  if (iterations) {
+    for (size_t i = 0; i < trace->var_count; i++) {
+      jit_var_t *var = &trace->vars[i];
+      if (!var->written) {
+        continue;
+      }
+      akx_rt_scope_t *scope = akx_rt_scope_find(rt, &var->symbol);
+      akx_cell_t *cell = box(rt, var->type, vars[i]);
+      void *old_value = NULL;
+      if (!scope || !cell ||
+          akx_rt_scope_assign(rt, scope, var->name, cell, &old_value) != 0) {
+        akx_rt_error(rt, "loop: failed to store a variable");
+        return -1;
+      }
+      if (old_value) {
+        akx_cell_free((akx_cell_t *)old_value);
+      }
+    }
+    *last = box(rt, code->result_type, result);
+    if (!*last) {
+      akx_rt_error(rt, "loop: failed to allocate the result");
+      return -1;
+    }
+  }
+
+  if (status == 0) {
+    return 1;
+  }
+  jit->stats.side_exits++;
+  if (status == 1) {
+    return trace_deopt(jit, trace);
+  }
+  // An if went a new way: record this iteration with the others and
+  // compile again
+  if (++trace->retraces > AKX_RT_JIT_MAX_RETRACES) {
+    trace_off(trace);
+    return 0;
+  }
+  trace_drop_code(trace);
+  trace->recorded = 0;
+  jit->recording = trace;
+  return 0;
+}
+
+akx_rt_jit_t *akx_rt_jit_new(akx_runtime_ctx_t *rt, uint32_t threshold) {
+  if (!rt || !ak_cjit_available()) {
+    return NULL;
+  }
+  akx_rt_jit_t *jit = AK24_ALLOC(sizeof(akx_rt_jit_t));
+  if (!jit) {
+    return NULL;
+  }
+  memset(jit, 0, sizeof(*jit));
+  jit->rt = rt;
+  jit->threshold = threshold ? threshold : AKX_RT_JIT_THRESHOLD;
+#ifdef AKX_RT_JIT_THREADED
+  if (pthread_mutex_init(&jit->lock, NULL) != 0) {
+    AK24_FREE(jit);
+    return NULL;
+  }
+  if (pthread_cond_init(&jit->wake, NULL) != 0) {
+    pthread_mutex_destroy(&jit->lock);
+    AK24_FREE(jit);
+    return NULL;
+  }
+  if (pthread_create(&jit->worker, NULL, worker_main, jit) != 0) {
+    pthread_cond_destroy(&jit->wake);
+    pthread_mutex_destroy(&jit->lock);
+    AK24_FREE(jit);
+    return NULL;
+  }
+#endif
+  return jit;
+}
+
+void akx_rt_jit_free(akx_rt_jit_t *jit) {
+  if (!jit) {
+    return;
+  }
+  for (size_t i = 0; i < AKX_RT_JIT_TRACE_BUCKETS; i++) {
+    while (jit->traces[i]) {
+      akx_rt_jit_trace_t *trace = jit->traces[i];
+      jit->traces[i] = trace->next;
+      akx_rt_jit_code_free(trace->code);
+      AK24_FREE(trace);
+    }
+  }
+#ifdef AKX_RT_JIT_THREADED
+  pthread_mutex_lock(&jit->lock);
+  jit->stopping = 1;
+  pthread_cond_signal(&jit->wake);
+  pthread_mutex_unlock(&jit->lock);
+  pthread_join(jit->worker, NULL);
+  // Lambdas, and so the code that is theirs, are gone by now
+  while (jit->queue_head) {
+    akx_rt_jit_code_t *code = jit->queue_head;
+    jit->queue_head = code->next;
+    if (code->orphaned) {
+      code_destroy(code);
+    } else {
+      code->queued = 0;
+    }
+  }
+  pthread_cond_destroy(&jit->wake);
+  pthread_mutex_destroy(&jit->lock);
+#endif
+  AK24_FREE(jit);
+}
+
+void akx_rt_jit_read_stats(akx_rt_jit_t *jit, akx_rt_jit_stats_t *stats) {
+#ifdef AKX_RT_JIT_THREADED
+  pthread_mutex_lock(&jit->lock);
+#endif
+  *stats = jit->stats;
+#ifdef AKX_RT_JIT_THREADED
+  pthread_mutex_unlock(&jit->lock);
+#endif
+}
@@ -0,0 +1,51 @@
+#ifndef AKX_RT_JIT_H
+#define AKX_RT_JIT_H
+
+#include "akx_rt.h"
+#include "akx_rt_builtins.h"
+
+// Tiered JIT behind AKX_JIT=1. A lambda whose body is integer and real
+// arithmetic, comparisons, if, begin and calls to itself is translated to C
+// once it has been called often enough. The C works on unboxed values, is
+// compiled by CJIT on a background thread and then runs in place of the
+// body. Anything the C cannot decide (a type, an overflow into a bignum, a
+// division by zero) sends the call back to the interpreter, which starts
+// the body over: nothing the body does is visible until it returns.
+//
+// Loops iterated as often are traced: a few iterations are recorded, with
+// the way each if went, and the condition and body are translated to a C
+// loop that keeps the loop's variables unboxed and stores them once it is
+// done. An if going a way no recorded iteration went, or anything else the
+// C cannot decide, leaves for the interpreter at the start of the
+// iteration.
+typedef struct akx_rt_jit_t akx_rt_jit_t;
+
+// A threshold of 0 means AKX_RT_JIT_THRESHOLD calls
+akx_rt_jit_t *akx_rt_jit_new(akx_runtime_ctx_t *rt, uint32_t threshold);
+
+// Waits for a compile in progress; compiled code stays with its lambdas
+void akx_rt_jit_free(akx_rt_jit_t *jit);
+
+// Called with lambda_ctx's frame bound: counts the call and returns the
+// body's value if native code computed it, or NULL to interpret the body
+akx_cell_t *akx_rt_jit_enter(akx_rt_jit_t *jit,
+                             akx_lambda_context_t *lambda_ctx);
+
+akx_rt_jit_trace_t *akx_rt_jit_trace_get(akx_rt_jit_t *jit,
+                                         akx_cell_t *args);
+int akx_rt_jit_trace_run(akx_rt_jit_t *jit, akx_rt_jit_trace_t *trace,
+                         akx_cell_t **last);
+void akx_rt_jit_trace_step(akx_rt_jit_t *jit, akx_rt_jit_trace_t *trace);
+void akx_rt_jit_record_branch(akx_rt_jit_t *jit, const akx_cell_t *args,
+                              int taken);
+
+void akx_rt_jit_read_stats(akx_rt_jit_t *jit, akx_rt_jit_stats_t *stats);
+
+// From akx_rt.c: the generation call sites stamp builtin lookups with, and
+// the values of the innermost call's parameters (NULL unless that call is
+// lambda_ctx's and its frame has no map)
+uint32_t akx_rt_builtin_generation(void);
+void **akx_rt_frame_slots(akx_runtime_ctx_t *rt,
+                          akx_lambda_context_t *lambda_ctx);
+
+#endif
@@ -0,0 +1,320 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "akx_rt_slab.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(AK24_PLATFORM_WINDOWS)
+#include <malloc.h>
+#include <windows.h>
+#else
+#include <pthread.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+#endif
+
+#define AKX_RT_SLAB_GRANULE 8
+#define AKX_RT_SLAB_CLASS_COUNT (AKX_RT_SLAB_MAX_SIZE / AKX_RT_SLAB_GRANULE)
+#define AKX_RT_SLAB_SIZE (64 * 1024)
+#define AKX_RT_SLAB_HUGE_SIZE (2 * 1024 * 1024)
+
+// Sits at the start of every slab; objects follow it
+typedef struct slab_t {
+  akx_rt_slab_t *owner;
+  // Slabs of the same class with room left
+  struct slab_t *prev;
+  struct slab_t *next;
+  // Every slab, so teardown finds the full ones too
+  struct slab_t *older;
+  struct slab_t *newer;
+  void *free_list;
+  char *bump;
+  char *end;
+  uint32_t live;
+  uint32_t size_class;
+} slab_t;
+
+#define AKX_RT_SLAB_HEADER_SIZE ((sizeof(slab_t) + 15) & ~(size_t)15)
+
+struct akx_rt_slab_t {
+  slab_t *partial[AKX_RT_SLAB_CLASS_COUNT];
+  slab_t *newest;
+  size_t slab_size;
+  int huge;
+  // Freed by its runtime while objects were live; the last release frees it
+  int retired;
+#if defined(AK24_PLATFORM_WINDOWS)
+  DWORD thread;
+#else
+  pthread_t thread;
+#endif
+  akx_rt_slab_stats_t stats;
+};
+
+// The cell pool of the calling thread
+static _Thread_local akx_rt_slab_t *g_installed = NULL;
+
+// Frees find their slab by masking with the slab size, so every slab in the
+// process uses the size the first one picked
+static atomic_size_t g_slab_size;
+
+static size_t object_size(uint32_t size_class) {
+  return ((size_t)size_class + 1) * AKX_RT_SLAB_GRANULE;
+}
+
+static int on_owner_thread(akx_rt_slab_t *slab) {
+#if defined(AK24_PLATFORM_WINDOWS)
+  return GetCurrentThreadId() == slab->thread;
+#else
+  return pthread_equal(pthread_self(), slab->thread);
+#endif
+}
+
+static int slab_full(const slab_t *slab) {
+  return !slab->free_list &&
+         slab->bump + object_size(slab->size_class) > slab->end;
+}
+
+static void *chunk_alloc(akx_rt_slab_t *slab) {
+#if defined(AK24_PLATFORM_WINDOWS)
+  return _aligned_malloc(slab->slab_size, slab->slab_size);
+#else
+  void *chunk = aligned_alloc(slab->slab_size, slab->slab_size);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (chunk && slab->huge) {
+    madvise(chunk, slab->slab_size, MADV_HUGEPAGE);
+  }
+#endif
+  return chunk;
+#endif
+}
+
+static void chunk_free(void *chunk) {
+#if defined(AK24_PLATFORM_WINDOWS)
+  _aligned_free(chunk);
+#else
+  free(chunk);
+#endif
+}
+
+static void unlink_partial(akx_rt_slab_t *slab, slab_t *chunk) {
+  if (chunk->prev) {
+    chunk->prev->next = chunk->next;
+  } else {
+    slab->partial[chunk->size_class] = chunk->next;
+  }
+  if (chunk->next) {
+    chunk->next->prev = chunk->prev;
+  }
+  chunk->prev = NULL;
+  chunk->next = NULL;
+}
+
+static void link_partial(akx_rt_slab_t *slab, slab_t *chunk) {
+  chunk->prev = NULL;
+  chunk->next = slab->partial[chunk->size_class];
+  if (chunk->next) {
+    chunk->next->prev = chunk;
+  }
+  slab->partial[chunk->size_class] = chunk;
+}
+
+static slab_t *new_chunk(akx_rt_slab_t *slab, uint32_t size_class) {
+  slab_t *chunk = chunk_alloc(slab);
+  if (!chunk) {
+    return NULL;
+  }
+  memset(chunk, 0, sizeof(slab_t));
+  chunk->owner = slab;
+  chunk->bump = (char *)chunk + AKX_RT_SLAB_HEADER_SIZE;
+  chunk->end = (char *)chunk + slab->slab_size;
+  chunk->size_class = size_class;
+
+  chunk->older = slab->newest;
+  if (slab->newest) {
+    slab->newest->newer = chunk;
+  }
+  slab->newest = chunk;
+  link_partial(slab, chunk);
+
+  slab->stats.slabs++;
+  slab->stats.slab_bytes += slab->slab_size;
+  if (slab->stats.slabs > slab->stats.peak_slabs) {
+    slab->stats.peak_slabs = slab->stats.slabs;
+  }
+  return chunk;
+}
+
+static void release_chunk(akx_rt_slab_t *slab, slab_t *chunk) {
+  unlink_partial(slab, chunk);
+  if (chunk->older) {
+    chunk->older->newer = chunk->newer;
+  }
+  if (chunk->newer) {
+    chunk->newer->older = chunk->older;
+  } else {
+    slab->newest = chunk->older;
+  }
+  slab->stats.slabs--;
+  slab->stats.slab_bytes -= slab->slab_size;
+  chunk_free(chunk);
+}
+
+static void *pool_alloc(void *user, size_t size) {
+  return akx_rt_slab_alloc((akx_rt_slab_t *)user, size);
+}
+
+static void pool_free(void *user, void *ptr, size_t size) {
+  akx_rt_slab_release((akx_rt_slab_t *)user, ptr, size);
+}
+
+akx_rt_slab_t *akx_rt_slab_new(int huge) {
+  akx_rt_slab_t *slab = AK24_ALLOC(sizeof(akx_rt_slab_t));
+  if (!slab) {
+    return NULL;
+  }
+  memset(slab, 0, sizeof(akx_rt_slab_t));
+#if !defined(__linux__) || !defined(MADV_HUGEPAGE)
+  huge = 0;
+#endif
+  size_t slab_size = huge ? AKX_RT_SLAB_HUGE_SIZE : AKX_RT_SLAB_SIZE;
+  size_t first = 0;
+  if (!atomic_compare_exchange_strong(&g_slab_size, &first, slab_size)) {
+    slab_size = first;
+  }
+  slab->slab_size = slab_size;
+  slab->huge = slab_size == AKX_RT_SLAB_HUGE_SIZE;
+#if defined(AK24_PLATFORM_WINDOWS)
+  slab->thread = GetCurrentThreadId();
+#else
+  slab->thread = pthread_self();
+#endif
+  return slab;
+}
+
+static void destroy_slab(akx_rt_slab_t *slab) {
+  if (g_installed == slab) {
+    akx_cell_set_pool(NULL);
+    g_installed = NULL;
+  }
+  while (slab->newest) {
+    slab_t *older = slab->newest->older;
+    chunk_free(slab->newest);
+    slab->newest = older;
+  }
+  AK24_FREE(slab);
+}
+
+void akx_rt_slab_free(akx_rt_slab_t *slab) {
+  if (!slab) {
+    return;
+  }
+  if (!on_owner_thread(slab)) {
+    AK24_LOG_ERROR("Slab freed off its owner's thread, leaving it in place");
+    return;
+  }
+  // Runtime bindings are never released, so cells usually outlive their
+  // runtime; the slab stays (as the cell pool too) until they come back
+  if (slab->stats.live_objects > 0) {
+    AK24_LOG_DEBUG("Slab kept for %zu live objects",
+                   slab->stats.live_objects);
+    slab->retired = 1;
+    return;
+  }
+  destroy_slab(slab);
+}
+
+void *akx_rt_slab_alloc(akx_rt_slab_t *slab, size_t size) {
+  if (size == 0 || size > AKX_RT_SLAB_MAX_SIZE) {
+    return AK24_ALLOC(size);
+  }
+  // Free lists belong to one thread and take no locks
+  if (!on_owner_thread(slab)) {
+    AK24_LOG_ERROR("Slab allocation off its owner's thread");
+    return NULL;
+  }
+
+  uint32_t size_class = (uint32_t)((size - 1) / AKX_RT_SLAB_GRANULE);
+  slab_t *chunk = slab->partial[size_class];
+  if (!chunk) {
+    chunk = new_chunk(slab, size_class);
+    if (!chunk) {
+      return NULL;
+    }
+  }
+
+  void *object;
+  if (chunk->free_list) {
+    object = chunk->free_list;
+    chunk->free_list = *(void **)object;
+  } else {
+    object = chunk->bump;
+    chunk->bump += object_size(size_class);
+  }
+  chunk->live++;
+  if (slab_full(chunk)) {
+    unlink_partial(slab, chunk);
+  }
+
+  slab->stats.allocations++;
+  slab->stats.live_objects++;
+  if (slab->stats.live_objects > slab->stats.peak_objects) {
+    slab->stats.peak_objects = slab->stats.live_objects;
+  }
+  return object;
+}
+
+void akx_rt_slab_release(akx_rt_slab_t *slab, void *ptr, size_t size) {
+  if (!ptr) {
+    return;
+  }
+  if (size == 0 || size > AKX_RT_SLAB_MAX_SIZE) {
+    AK24_FREE(ptr);
+    return;
+  }
+
+  uintptr_t mask = ~(uintptr_t)(slab->slab_size - 1);
+  slab_t *chunk = (slab_t *)((uintptr_t)ptr & mask);
+  // An object freed through another slab, or on another thread, would race
+  // its owner's free lists; it is reported and leaked instead
+  if (chunk->owner != slab || !on_owner_thread(slab)) {
+    AK24_LOG_ERROR("Slab object freed off its owner's thread");
+    return;
+  }
+  int was_full = slab_full(chunk);
+  *(void **)ptr = chunk->free_list;
+  chunk->free_list = ptr;
+  chunk->live--;
+  slab->stats.live_objects--;
+
+  if (was_full) {
+    link_partial(slab, chunk);
+  }
+  // Keep one empty slab per class around so a class that is allocated and
+  // freed in a tight loop does not map and unmap on every turn
+  if (chunk->live == 0 && (chunk->prev || chunk->next)) {
+    release_chunk(slab, chunk);
+  }
+  if (slab->retired && slab->stats.live_objects == 0) {
+    destroy_slab(slab);
+  }
+}
+
+int akx_rt_slab_install(akx_rt_slab_t *slab) {
+  if (g_installed) {
+    return -1;
+  }
+  akx_cell_pool_t pool = {.alloc = pool_alloc, .free = pool_free, .user = slab};
+  akx_cell_set_pool(&pool);
+  g_installed = slab;
+  return 0;
+}
+
+void akx_rt_slab_read_stats(akx_rt_slab_t *slab, akx_rt_slab_stats_t *stats) {
+  *stats = slab->stats;
+}
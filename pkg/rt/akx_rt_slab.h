@@ -0,0 +1,34 @@
+#ifndef AKX_RT_SLAB_H
+#define AKX_RT_SLAB_H
+
+#include "akx_rt.h"
+
+// Size-class allocator for the runtime's small objects. Each slab is an
+// aligned chunk holding objects of one size, so freeing finds its slab by
+// masking the address. Requests above AKX_RT_SLAB_MAX_SIZE go to AK24_ALLOC.
+// An allocator belongs to the thread that made it: its free lists take no
+// locks, and objects allocated or freed from other threads are refused.
+typedef struct akx_rt_slab_t akx_rt_slab_t;
+
+#define AKX_RT_SLAB_MAX_SIZE 64
+
+// huge asks for 2MB slabs backed by transparent huge pages where available;
+// the first allocator in the process fixes the slab size for all of them
+akx_rt_slab_t *akx_rt_slab_new(int huge);
+
+// Releases every slab once no objects are live. Until then the allocator
+// stays (and stays installed), and the last akx_rt_slab_release() frees it.
+void akx_rt_slab_free(akx_rt_slab_t *slab);
+
+void *akx_rt_slab_alloc(akx_rt_slab_t *slab, size_t size);
+
+// size must be the size the object was allocated with
+void akx_rt_slab_release(akx_rt_slab_t *slab, void *ptr, size_t size);
+
+// Makes the slab the calling thread's pool for heap cells, unless the thread
+// already has one
+int akx_rt_slab_install(akx_rt_slab_t *slab);
+
+void akx_rt_slab_read_stats(akx_rt_slab_t *slab, akx_rt_slab_stats_t *stats);
+
+#endif
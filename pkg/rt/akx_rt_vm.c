@@ -0,0 +1,1201 @@
+#include "akx_rt_vm.h"
+#include <ak24/intern.h>
+#include <ak24/lambda.h>
+#include <stdio.h>
+#include <string.h>
+
+#define AKX_RT_VM_CHUNK_SIZE (64 * 1024)
+
+#if defined(__GNUC__)
+#define AKX_RT_VM_THREADED 1
+#endif
+
+// Instructions are 32-bit words, an opcode followed by its operands: r is a
+// register, k an index into the constants (cells, builtin infos and
+// signatures) and pc an instruction index. Every instruction that reads a
+// register it owns clears it, so a register only holds a value while the
+// code that put it there still needs it.
+enum {
+  // r k: a copy of the literal k
+  OP_CONST,
+  // r k: the quoted cell k, unwrapped
+  OP_QUOTE,
+  // r
+  OP_NIL,
+  // r k: the binding of the symbol k
+  OP_SYMBOL,
+  // r k: the expression k, given to the tree evaluator
+  OP_EVAL,
+  // r: frees a value unless it is a lambda, as begin and loop do
+  OP_FREE,
+  // r: frees a value, as a lambda body does between its expressions
+  OP_DROP,
+  // r: nil unless r holds a value
+  OP_NIL_IF_EMPTY,
+  // pc
+  OP_JUMP,
+  // r pc: consumes a condition and jumps unless it is 1
+  OP_BRANCH,
+  // k_call k_info k_signature pc: jumps unless the call still names that
+  // builtin, unreloaded
+  OP_GUARD,
+  // r k_info argc: type-checks a strict argument before the next one runs
+  OP_CHECK,
+  // r first argc k_info: calls a strict builtin on registers first onwards
+  OP_STRICT,
+  // r k_call tail: calls whatever builtin the call names on its argument
+  // list as written
+  OP_BUILTIN,
+  // r callee k_call argc tail pc: looks up the call's lambda, pushes its
+  // frame and keeps it in callee; pc is past the call
+  OP_CALL,
+  // callee index r: binds the next argument
+  OP_BIND,
+  // r callee tail: runs the callee's body
+  OP_ENTER,
+  // r
+  OP_RETURN,
+  // k_symbol: fails if the symbol is already bound in the current scope
+  OP_LET_CHECK,
+  // r k_symbol
+  OP_LET,
+  // k_symbol: fails if the symbol is not bound anywhere
+  OP_SET_CHECK,
+  // r k_symbol
+  OP_SET,
+  // slots
+  OP_PUSH_SCOPE,
+  OP_POP_SCOPE,
+  OP_SAFEPOINT,
+};
+
+struct akx_rt_code_t {
+  uint32_t *ops;
+  void **consts;
+  uint32_t op_count;
+  uint32_t const_count;
+  uint32_t reg_count;
+};
+
+typedef struct vm_chunk_t {
+  struct vm_chunk_t *prev;
+  struct vm_chunk_t *next;
+  char *end;
+} vm_chunk_t;
+
+#define AKX_RT_VM_CHUNK_HEADER ((sizeof(vm_chunk_t) + 15) & ~(size_t)15)
+
+// One running piece of code with its registers
+typedef struct vm_frame_t {
+  struct vm_frame_t *caller;
+  const akx_rt_code_t *code;
+  // Where the frame goes on once a call it made returns
+  const uint32_t *pc;
+  // The scope to unwind to when the frame fails: for a lambda body, the
+  // scope under its call's frame
+  akx_rt_scope_t *outer;
+  // The caller's register that gets the result
+  uint32_t dst;
+  uint32_t capacity;
+  // The frame a run started with, which hands its result back to C
+  int base;
+  // The lambda whose body runs, NULL for a top-level form; kept alive for
+  // the collector as the trampoline keeps it in a local
+  akx_cell_t *lambda;
+  vm_chunk_t *chunk;
+  char *top;
+  akx_cell_t *regs[];
+} vm_frame_t;
+
+// A lambda call whose arguments are being bound. A failure there makes the
+// call nil, as bind_args does in the trampoline.
+typedef struct {
+  vm_frame_t *frame;
+  akx_rt_scope_t *scope;
+  const uint32_t *resume;
+  uint32_t dst;
+  // Registers from here up belong to the arguments
+  uint32_t mark;
+} vm_handler_t;
+
+struct akx_rt_vm_t {
+  akx_runtime_ctx_t *rt;
+  vm_chunk_t *chunk;
+  char *top;
+  vm_frame_t *frame;
+  vm_handler_t *handlers;
+  size_t handler_count;
+  size_t handler_capacity;
+  const char *if_name;
+  const char *begin_name;
+  const char *let_name;
+  const char *set_name;
+  const char *loop_name;
+};
+
+typedef struct {
+  akx_rt_vm_t *vm;
+  uint32_t *ops;
+  size_t op_count;
+  size_t op_capacity;
+  void **consts;
+  size_t const_count;
+  size_t const_capacity;
+  uint32_t next_reg;
+  uint32_t reg_count;
+  // Compiling a lambda body, where calls in tail position replace the call
+  int lambda;
+  int failed;
+} compiler_t;
+
+static int is_list_cell(akx_cell_t *cell) {
+  return cell->type == AKX_TYPE_LIST || cell->type == AKX_TYPE_LIST_SQUARE ||
+         cell->type == AKX_TYPE_LIST_CURLY ||
+         cell->type == AKX_TYPE_LIST_TEMPLE;
+}
+
+static int grow(void **array, size_t *capacity, size_t count, size_t size) {
+  size_t next = *capacity ? *capacity * 2 : 32;
+  void *grown = AK24_ALLOC(next * size);
+  if (!grown) {
+    return -1;
+  }
+  if (*array) {
+    memcpy(grown, *array, count * size);
+    AK24_FREE(*array);
+  }
+  *array = grown;
+  *capacity = next;
+  return 0;
+}
+
+static size_t emit(compiler_t *c, uint32_t word) {
+  if (c->op_count == c->op_capacity &&
+      grow((void **)&c->ops, &c->op_capacity, c->op_count,
+           sizeof(uint32_t)) != 0) {
+    c->failed = 1;
+    return 0;
+  }
+  c->ops[c->op_count] = word;
+  return c->op_count++;
+}
+
+static void patch(compiler_t *c, size_t at) {
+  if (!c->failed) {
+    c->ops[at] = (uint32_t)c->op_count;
+  }
+}
+
+static uint32_t constant(compiler_t *c, const void *ptr) {
+  if (c->const_count == c->const_capacity &&
+      grow((void **)&c->consts, &c->const_capacity, c->const_count,
+           sizeof(void *)) != 0) {
+    c->failed = 1;
+    return 0;
+  }
+  c->consts[c->const_count] = (void *)ptr;
+  return (uint32_t)c->const_count++;
+}
+
+static uint32_t alloc_regs(compiler_t *c, uint32_t count) {
+  uint32_t reg = c->next_reg;
+  c->next_reg += count;
+  if (c->next_reg > c->reg_count) {
+    c->reg_count = c->next_reg;
+  }
+  return reg;
+}
+
+static void compile_expr(compiler_t *c, akx_cell_t *expr, uint32_t r,
+                         int tail);
+
+static void compile_seq(compiler_t *c, akx_cell_t *exprs, uint32_t r,
+                        int tail, uint32_t discard) {
+  for (akx_cell_t *expr = exprs; expr; expr = expr->next) {
+    compile_expr(c, expr, r, tail && !expr->next);
+    if (expr->next) {
+      emit(c, discard);
+      emit(c, r);
+    }
+  }
+}
+
+static void compile_call(compiler_t *c, akx_cell_t *expr, uint32_t r,
+                         int tail) {
+  akx_cell_t *args = expr->value.list_head->next;
+  uint32_t argc = (uint32_t)akx_rt_list_length(args);
+  uint32_t callee = alloc_regs(c, 2);
+  uint32_t arg = callee + 1;
+  emit(c, OP_CALL);
+  emit(c, r);
+  emit(c, callee);
+  emit(c, constant(c, expr));
+  emit(c, argc);
+  emit(c, (uint32_t)tail);
+  size_t end = emit(c, 0);
+  uint32_t index = 0;
+  for (akx_cell_t *cell = args; cell; cell = cell->next, index++) {
+    compile_expr(c, cell, arg, 0);
+    emit(c, OP_BIND);
+    emit(c, callee);
+    emit(c, index);
+    emit(c, arg);
+  }
+  emit(c, OP_ENTER);
+  emit(c, r);
+  emit(c, callee);
+  emit(c, (uint32_t)tail);
+  patch(c, end);
+  c->next_reg = callee;
+}
+
+static void compile_if(compiler_t *c, akx_cell_t *args, uint32_t r,
+                       int tail) {
+  compile_expr(c, args, r, 0);
+  emit(c, OP_BRANCH);
+  emit(c, r);
+  size_t otherwise = emit(c, 0);
+  compile_expr(c, args->next, r, tail);
+  emit(c, OP_JUMP);
+  size_t end = emit(c, 0);
+  patch(c, otherwise);
+  if (args->next->next) {
+    compile_expr(c, args->next->next, r, tail);
+  } else {
+    emit(c, OP_NIL);
+    emit(c, r);
+  }
+  patch(c, end);
+}
+
+static void compile_binding(compiler_t *c, akx_cell_t *args, uint32_t r,
+                            uint32_t check, uint32_t bind) {
+  uint32_t symbol = constant(c, args);
+  emit(c, check);
+  emit(c, symbol);
+  compile_expr(c, args->next, r, 0);
+  emit(c, bind);
+  emit(c, r);
+  emit(c, symbol);
+}
+
+// Frees each iteration's intermediate values, which loop_impl leaves to the
+// collector
+static void compile_loop(compiler_t *c, akx_cell_t *args, uint32_t r) {
+  uint32_t condition = alloc_regs(c, 1);
+  size_t top = c->op_count;
+  emit(c, OP_SAFEPOINT);
+  compile_expr(c, args, condition, 0);
+  emit(c, OP_BRANCH);
+  emit(c, condition);
+  size_t done = emit(c, 0);
+  emit(c, OP_PUSH_SCOPE);
+  emit(c, (uint32_t)akx_rt_count_lets(args->next));
+  emit(c, OP_FREE);
+  emit(c, r);
+  compile_seq(c, args->next, r, 0, OP_FREE);
+  emit(c, OP_POP_SCOPE);
+  emit(c, OP_JUMP);
+  emit(c, (uint32_t)top);
+  patch(c, done);
+  emit(c, OP_NIL_IF_EMPTY);
+  emit(c, r);
+  c->next_reg = condition;
+}
+
+static void compile_strict(compiler_t *c, akx_cell_t *args, uint32_t argc,
+                           akx_builtin_info_t *info, uint32_t r) {
+  uint32_t first = alloc_regs(c, argc);
+  uint32_t k_info = constant(c, info);
+  // The tree walker checks each argument as soon as it has it, so a bad one
+  // stops the calls in the arguments after it
+  int check = 0;
+  if (info->signature->accepts) {
+    for (akx_cell_t *arg = args ? args->next : NULL; arg; arg = arg->next) {
+      check |= is_list_cell(arg);
+    }
+  }
+  uint32_t i = 0;
+  for (akx_cell_t *arg = args; arg; arg = arg->next, i++) {
+    compile_expr(c, arg, first + i, 0);
+    if (check && arg->next) {
+      emit(c, OP_CHECK);
+      emit(c, first + i);
+      emit(c, k_info);
+      emit(c, argc);
+    }
+  }
+  emit(c, OP_STRICT);
+  emit(c, r);
+  emit(c, first);
+  emit(c, argc);
+  emit(c, k_info);
+  c->next_reg = first;
+}
+
+enum {
+  FORM_NONE,
+  FORM_STRICT,
+  FORM_IF,
+  FORM_BEGIN,
+  FORM_LET,
+  FORM_SET,
+  FORM_LOOP,
+};
+
+// Which instruction sequence, if any, stands in for a call to info. A
+// builtin loaded with cjit-load-builtin is always called.
+static int builtin_form(compiler_t *c, akx_builtin_info_t *info,
+                        akx_cell_t *args) {
+  akx_rt_vm_t *vm = c->vm;
+  size_t argc = akx_rt_list_length(args);
+  const char *name = info->module_name;
+  if (info->unit) {
+    return FORM_NONE;
+  }
+  if (info->signature) {
+    return argc >= info->signature->min_args &&
+                   argc <= info->signature->max_args
+               ? FORM_STRICT
+               : FORM_NONE;
+  }
+  if (name == vm->if_name) {
+    return argc == 2 || argc == 3 ? FORM_IF : FORM_NONE;
+  }
+  if (name == vm->begin_name) {
+    return FORM_BEGIN;
+  }
+  if (name == vm->let_name || name == vm->set_name) {
+    if (argc < 2 || args->type != AKX_TYPE_SYMBOL) {
+      return FORM_NONE;
+    }
+    return name == vm->let_name ? FORM_LET : FORM_SET;
+  }
+  if (name == vm->loop_name) {
+    return argc >= 2 ? FORM_LOOP : FORM_NONE;
+  }
+  return FORM_NONE;
+}
+
+static void compile_form(compiler_t *c, int form, akx_builtin_info_t *info,
+                         akx_cell_t *args, uint32_t r, int tail) {
+  switch (form) {
+  case FORM_STRICT:
+    compile_strict(c, args, (uint32_t)akx_rt_list_length(args), info, r);
+    break;
+  case FORM_IF:
+    compile_if(c, args, r, tail);
+    break;
+  case FORM_BEGIN:
+    if (!args) {
+      emit(c, OP_NIL);
+      emit(c, r);
+    }
+    compile_seq(c, args, r, tail, OP_FREE);
+    break;
+  case FORM_LET:
+    compile_binding(c, args, r, OP_LET_CHECK, OP_LET);
+    break;
+  case FORM_SET:
+    compile_binding(c, args, r, OP_SET_CHECK, OP_SET);
+    break;
+  default:
+    compile_loop(c, args, r);
+    break;
+  }
+}
+
+static void compile_expr(compiler_t *c, akx_cell_t *expr, uint32_t r,
+                         int tail) {
+  uint32_t op = OP_EVAL;
+  switch (expr->type) {
+  case AKX_TYPE_INTEGER_LITERAL:
+  case AKX_TYPE_REAL_LITERAL:
+  case AKX_TYPE_STRING_LITERAL:
+    op = OP_CONST;
+    break;
+  case AKX_TYPE_SYMBOL:
+    op = OP_SYMBOL;
+    break;
+  case AKX_TYPE_QUOTED:
+    op = OP_QUOTE;
+    break;
+  default:
+    break;
+  }
+  akx_cell_t *head = is_list_cell(expr) ? expr->value.list_head : NULL;
+  if (is_list_cell(expr) && !head) {
+    emit(c, OP_NIL);
+    emit(c, r);
+    return;
+  }
+  // Calls through a computed head are rare; the tree walker takes them
+  if (!head || head->type != AKX_TYPE_SYMBOL) {
+    emit(c, op);
+    emit(c, r);
+    emit(c, constant(c, expr));
+    return;
+  }
+
+  akx_builtin_info_t *info =
+      akx_rt_resolve_builtin(c->vm->rt, expr, head->value.symbol);
+  if (!info) {
+    compile_call(c, expr, r, tail);
+    return;
+  }
+
+  // The lowered form runs while the call still names the same builtin,
+  // which is called as written once it has been reloaded
+  int form = builtin_form(c, info, head->next);
+  size_t end = 0;
+  if (form != FORM_NONE) {
+    emit(c, OP_GUARD);
+    emit(c, constant(c, expr));
+    emit(c, constant(c, info));
+    emit(c, constant(c, info->signature));
+    size_t fallback = emit(c, 0);
+    compile_form(c, form, info, head->next, r, tail);
+    emit(c, OP_JUMP);
+    end = emit(c, 0);
+    patch(c, fallback);
+  }
+  emit(c, OP_BUILTIN);
+  emit(c, r);
+  emit(c, constant(c, expr));
+  emit(c, (uint32_t)tail);
+  if (form != FORM_NONE) {
+    patch(c, end);
+  }
+}
+
+static akx_rt_code_t *compile(akx_rt_vm_t *vm, akx_cell_t *body,
+                              int lambda) {
+  compiler_t c = {0};
+  c.vm = vm;
+  c.lambda = lambda;
+  c.next_reg = 1;
+  c.reg_count = 1;
+  if (!body) {
+    emit(&c, OP_NIL);
+    emit(&c, 0);
+  } else if (lambda) {
+    compile_seq(&c, body, 0, 1, OP_DROP);
+  } else {
+    compile_expr(&c, body, 0, 0);
+  }
+  emit(&c, OP_RETURN);
+  emit(&c, 0);
+
+  akx_rt_code_t *code = NULL;
+  if (!c.failed) {
+    code = AK24_ALLOC(sizeof(akx_rt_code_t) + sizeof(void *) * c.const_count +
+                      sizeof(uint32_t) * c.op_count);
+  }
+  if (code) {
+    code->consts = (void **)(code + 1);
+    code->ops = (uint32_t *)(code->consts + c.const_count);
+    memcpy(code->consts, c.consts, sizeof(void *) * c.const_count);
+    memcpy(code->ops, c.ops, sizeof(uint32_t) * c.op_count);
+    code->op_count = (uint32_t)c.op_count;
+    code->const_count = (uint32_t)c.const_count;
+    code->reg_count = c.reg_count;
+  } else {
+    akx_rt_error(vm->rt, "vm: memory allocation failed");
+  }
+  if (c.ops) {
+    AK24_FREE(c.ops);
+  }
+  if (c.consts) {
+    AK24_FREE(c.consts);
+  }
+  return code;
+}
+
+void akx_rt_code_free(akx_rt_code_t *code) {
+  if (code) {
+    AK24_FREE(code);
+  }
+}
+
+static akx_rt_code_t *lambda_code(akx_rt_vm_t *vm,
+                                  akx_lambda_context_t *lambda_ctx) {
+  if (!lambda_ctx->code) {
+    lambda_ctx->code = compile(vm, lambda_ctx->body, 1);
+  }
+  return lambda_ctx->code;
+}
+
+static vm_frame_t *push_frame(akx_rt_vm_t *vm, const akx_rt_code_t *code) {
+  size_t size = sizeof(vm_frame_t) + sizeof(akx_cell_t *) * code->reg_count;
+  size = (size + 15) & ~(size_t)15;
+  vm_chunk_t *chunk = vm->chunk;
+  char *top = vm->top;
+  if (!chunk || top + size > chunk->end) {
+    vm_chunk_t *next = chunk ? chunk->next : NULL;
+    if (next && (size_t)(next->end - (char *)next) <
+                    AKX_RT_VM_CHUNK_HEADER + size) {
+      // Too small for this frame; chunks past it are dropped with it
+      next->prev->next = NULL;
+      while (next) {
+        vm_chunk_t *after = next->next;
+        AK24_FREE(next);
+        next = after;
+      }
+    }
+    if (!next) {
+      size_t bytes = AKX_RT_VM_CHUNK_HEADER + size;
+      if (bytes < AKX_RT_VM_CHUNK_SIZE) {
+        bytes = AKX_RT_VM_CHUNK_SIZE;
+      }
+      next = AK24_ALLOC(bytes);
+      if (!next) {
+        return NULL;
+      }
+      next->prev = chunk;
+      next->next = NULL;
+      next->end = (char *)next + bytes;
+      if (chunk) {
+        chunk->next = next;
+      }
+    }
+    vm->chunk = next;
+    vm->top = (char *)next + AKX_RT_VM_CHUNK_HEADER;
+  }
+
+  vm_frame_t *frame = (vm_frame_t *)vm->top;
+  vm->top += size;
+  memset(frame, 0, size);
+  frame->caller = vm->frame;
+  frame->code = code;
+  frame->pc = code->ops;
+  frame->capacity = code->reg_count;
+  frame->chunk = chunk;
+  frame->top = top;
+  return frame;
+}
+
+static void pop_frame(akx_rt_vm_t *vm, vm_frame_t *frame) {
+  vm->chunk = frame->chunk;
+  vm->top = frame->top;
+}
+
+static void release(akx_rt_vm_t *vm, vm_frame_t *frame, uint32_t from) {
+  for (uint32_t i = from; i < frame->code->reg_count; i++) {
+    akx_cell_t *value = frame->regs[i];
+    if (value && value->type != AKX_TYPE_LAMBDA) {
+      akx_rt_free_cell(vm->rt, value);
+    }
+    frame->regs[i] = NULL;
+  }
+}
+
+static int push_handler(akx_rt_vm_t *vm, vm_frame_t *frame,
+                        const uint32_t *resume, uint32_t dst,
+                        uint32_t mark) {
+  if (vm->handler_count == vm->handler_capacity &&
+      grow((void **)&vm->handlers, &vm->handler_capacity, vm->handler_count,
+           sizeof(vm_handler_t)) != 0) {
+    return -1;
+  }
+  vm_handler_t *handler = &vm->handlers[vm->handler_count++];
+  handler->frame = frame;
+  handler->scope = akx_rt_current_scope(vm->rt);
+  handler->resume = resume;
+  handler->dst = dst;
+  handler->mark = mark;
+  return 0;
+}
+
+static akx_lambda_context_t *lambda_context(akx_cell_t *lambda_cell) {
+  return lambda_cell->value.lambda
+             ? (akx_lambda_context_t *)ak_lambda_get_context(
+                   lambda_cell->value.lambda)
+             : NULL;
+}
+
+#define A(i) pc[i]
+#define REG(i) regs[pc[i]]
+#define CONST(i) consts[pc[i]]
+
+#ifdef AKX_RT_VM_THREADED
+#define DISPATCH() goto *labels[*pc]
+#define CASE(op) label_##op:
+#else
+#define DISPATCH() goto dispatch
+#define CASE(op) case op:
+#endif
+
+// Switches to frame and carries on where it left off
+#define RESUME(next)                                                           \
+  do {                                                                         \
+    frame = (next);                                                            \
+    vm->frame = frame;                                                         \
+    regs = frame->regs;                                                        \
+    consts = frame->code->consts;                                              \
+    ops = frame->code->ops;                                                    \
+    pc = frame->pc;                                                            \
+  } while (0)
+
+// Runs vm->frame, and every frame it calls, until it returns
+static akx_cell_t *run(akx_rt_vm_t *vm) {
+  akx_runtime_ctx_t *rt = vm->rt;
+  vm_frame_t *frame = NULL;
+  akx_cell_t **regs = NULL;
+  void **consts = NULL;
+  const uint32_t *ops = NULL;
+  const uint32_t *pc = NULL;
+  akx_cell_t *value = NULL;
+  akx_cell_t *lambda_cell = NULL;
+  akx_lambda_context_t *lambda_ctx = NULL;
+  uint32_t dst = 0;
+  int saved = 0;
+
+#ifdef AKX_RT_VM_THREADED
+  static void *const labels[] = {
+      [OP_CONST] = &&label_OP_CONST,
+      [OP_QUOTE] = &&label_OP_QUOTE,
+      [OP_NIL] = &&label_OP_NIL,
+      [OP_SYMBOL] = &&label_OP_SYMBOL,
+      [OP_EVAL] = &&label_OP_EVAL,
+      [OP_FREE] = &&label_OP_FREE,
+      [OP_DROP] = &&label_OP_DROP,
+      [OP_NIL_IF_EMPTY] = &&label_OP_NIL_IF_EMPTY,
+      [OP_JUMP] = &&label_OP_JUMP,
+      [OP_BRANCH] = &&label_OP_BRANCH,
+      [OP_GUARD] = &&label_OP_GUARD,
+      [OP_CHECK] = &&label_OP_CHECK,
+      [OP_STRICT] = &&label_OP_STRICT,
+      [OP_BUILTIN] = &&label_OP_BUILTIN,
+      [OP_CALL] = &&label_OP_CALL,
+      [OP_BIND] = &&label_OP_BIND,
+      [OP_ENTER] = &&label_OP_ENTER,
+      [OP_RETURN] = &&label_OP_RETURN,
+      [OP_LET_CHECK] = &&label_OP_LET_CHECK,
+      [OP_LET] = &&label_OP_LET,
+      [OP_SET_CHECK] = &&label_OP_SET_CHECK,
+      [OP_SET] = &&label_OP_SET,
+      [OP_PUSH_SCOPE] = &&label_OP_PUSH_SCOPE,
+      [OP_POP_SCOPE] = &&label_OP_POP_SCOPE,
+      [OP_SAFEPOINT] = &&label_OP_SAFEPOINT,
+  };
+#endif
+
+  RESUME(vm->frame);
+  DISPATCH();
+
+#ifndef AKX_RT_VM_THREADED
+dispatch:
+  switch (*pc) {
+#endif
+
+  CASE(OP_CONST) {
+    REG(1) = akx_rt_copy(rt, CONST(2));
+    pc += 3;
+    DISPATCH();
+  }
+
+  CASE(OP_QUOTE) {
+    value = akx_cell_unwrap_quoted(CONST(2));
+    if (!value) {
+      goto fail;
+    }
+    REG(1) = value;
+    pc += 3;
+    DISPATCH();
+  }
+
+  CASE(OP_NIL) {
+    REG(1) = akx_rt_nil(rt);
+    pc += 2;
+    DISPATCH();
+  }
+
+  CASE(OP_SYMBOL) {
+    akx_cell_t *symbol = CONST(2);
+    value = akx_rt_lookup_symbol(rt, symbol);
+    if (!value) {
+      char error_msg[256];
+      snprintf(error_msg, sizeof(error_msg), "undefined symbol: %s",
+               symbol->value.symbol);
+      akx_rt_error_at(rt, symbol, error_msg);
+      goto fail;
+    }
+    REG(1) = value->type == AKX_TYPE_LAMBDA ? value : akx_rt_copy(rt, value);
+    pc += 3;
+    DISPATCH();
+  }
+
+  CASE(OP_EVAL) {
+    value = akx_rt_eval(rt, CONST(2));
+    if (!value) {
+      goto fail;
+    }
+    REG(1) = value;
+    pc += 3;
+    DISPATCH();
+  }
+
+  CASE(OP_FREE) {
+    value = REG(1);
+    if (value && value->type != AKX_TYPE_LAMBDA) {
+      akx_rt_free_cell(rt, value);
+    }
+    REG(1) = NULL;
+    pc += 2;
+    DISPATCH();
+  }
+
+  CASE(OP_DROP) {
+    if (REG(1)) {
+      akx_cell_free(REG(1));
+    }
+    REG(1) = NULL;
+    pc += 2;
+    DISPATCH();
+  }
+
+  CASE(OP_NIL_IF_EMPTY) {
+    if (!REG(1)) {
+      REG(1) = akx_rt_nil(rt);
+    }
+    pc += 2;
+    DISPATCH();
+  }
+
+  CASE(OP_JUMP) {
+    pc = ops + A(1);
+    DISPATCH();
+  }
+
+  CASE(OP_BRANCH) {
+    value = REG(1);
+    REG(1) = NULL;
+    int is_true = value->type == AKX_TYPE_INTEGER_LITERAL &&
+                  akx_rt_cell_as_int(value) == 1;
+    if (value->type != AKX_TYPE_LAMBDA) {
+      akx_rt_free_cell(rt, value);
+    }
+    pc = is_true ? pc + 3 : ops + A(2);
+    DISPATCH();
+  }
+
+  CASE(OP_GUARD) {
+    akx_cell_t *call = CONST(1);
+    akx_builtin_info_t *info = CONST(2);
+    if (akx_rt_resolve_builtin(rt, call, call->value.list_head->value.symbol) ==
+            info &&
+        !info->unit && info->signature == CONST(3)) {
+      pc += 5;
+    } else {
+      pc = ops + A(4);
+    }
+    DISPATCH();
+  }
+
+  CASE(OP_CHECK) {
+    const akx_builtin_signature_t *signature =
+        ((akx_builtin_info_t *)CONST(2))->signature;
+    if (!(signature->accepts & AKX_ARG(REG(1)->type))) {
+      akx_rt_signature_error(rt, signature, A(3));
+      goto fail;
+    }
+    pc += 4;
+    DISPATCH();
+  }
+
+  CASE(OP_STRICT) {
+    uint32_t first = A(2);
+    uint32_t argc = A(3);
+    value = akx_rt_call_strict(rt, CONST(4), &regs[first], argc);
+    memset(&regs[first], 0, sizeof(akx_cell_t *) * argc);
+    if (!value) {
+      goto fail;
+    }
+    REG(1) = value;
+    pc += 5;
+    DISPATCH();
+  }
+
+  CASE(OP_BUILTIN) {
+    akx_cell_t *call = CONST(2);
+    akx_cell_t *head = call->value.list_head;
+    akx_builtin_info_t *info =
+        akx_rt_resolve_builtin(rt, call, head->value.symbol);
+    dst = A(1);
+    value = info ? akx_rt_call_builtin(rt, info, head->next, (int)A(3))
+                 : akx_rt_eval(rt, call);
+    pc += 4;
+    goto builtin_result;
+  }
+
+  CASE(OP_CALL) {
+    akx_cell_t *call = CONST(3);
+    akx_cell_t *head = call->value.list_head;
+    akx_builtin_info_t *info =
+        akx_rt_resolve_builtin(rt, call, head->value.symbol);
+    // Something registered a builtin under the name since compiling
+    if (info) {
+      dst = A(1);
+      value = akx_rt_call_builtin(rt, info, head->next, (int)A(5));
+      pc = ops + A(6);
+      goto builtin_result;
+    }
+    value = akx_rt_lookup_symbol(rt, head);
+    if (!value || value->type != AKX_TYPE_LAMBDA) {
+      char error_msg[256];
+      snprintf(error_msg, sizeof(error_msg), "undefined function: %s",
+               head->value.symbol);
+      akx_rt_error_at(rt, head, error_msg);
+      goto fail;
+    }
+    akx_rt_gc_safepoint(rt);
+    lambda_ctx = lambda_context(value);
+    if (!lambda_ctx) {
+      akx_rt_error(rt, "failed to allocate a lambda frame");
+      goto fail;
+    }
+    if (A(4) != lambda_ctx->param_count) {
+      akx_rt_error_fmt(rt, "lambda: expected %zu arguments, got %zu",
+                       lambda_ctx->param_count, (size_t)A(4));
+      REG(1) = akx_rt_nil(rt);
+      pc = ops + A(6);
+      DISPATCH();
+    }
+    if (push_handler(vm, frame, ops + A(6), A(1), A(2)) != 0) {
+      akx_rt_error(rt, "vm: memory allocation failed");
+      goto fail;
+    }
+    if (akx_rt_push_call(rt, lambda_ctx) != 0) {
+      goto fail;
+    }
+    REG(2) = value;
+    pc += 7;
+    DISPATCH();
+  }
+
+  CASE(OP_BIND) {
+    lambda_ctx = lambda_context(REG(1));
+    if (akx_rt_bind(rt, lambda_ctx->param_names[A(2)], REG(3)) != 0) {
+      goto fail;
+    }
+    REG(3) = NULL;
+    pc += 4;
+    DISPATCH();
+  }
+
+  CASE(OP_ENTER) {
+    lambda_cell = REG(2);
+    lambda_ctx = lambda_context(lambda_cell);
+    if (!lambda_code(vm, lambda_ctx)) {
+      goto fail;
+    }
+    if (A(3)) {
+      REG(2) = NULL;
+      vm->handler_count--;
+      saved = 0;
+      goto tail_call;
+    }
+    frame->pc = pc + 4;
+    vm_frame_t *callee = push_frame(vm, lambda_ctx->code);
+    if (!callee) {
+      akx_rt_error(rt, "vm: memory allocation failed");
+      goto fail;
+    }
+    REG(2) = NULL;
+    vm_handler_t *handler = &vm->handlers[--vm->handler_count];
+    callee->outer = handler->scope;
+    callee->dst = A(1);
+    callee->lambda = lambda_cell;
+    RESUME(callee);
+    DISPATCH();
+  }
+
+  CASE(OP_RETURN) {
+    value = REG(1);
+    REG(1) = NULL;
+    goto return_value;
+  }
+
+  CASE(OP_LET_CHECK) {
+    akx_cell_t *symbol = CONST(1);
+    if (akx_rt_binds_locally(rt, symbol->value.symbol)) {
+      akx_rt_error_fmt(rt, "let: symbol '%s' already defined in current scope",
+                       symbol->value.symbol);
+      goto fail;
+    }
+    pc += 2;
+    DISPATCH();
+  }
+
+  CASE(OP_LET) {
+    akx_cell_t *symbol = CONST(2);
+    akx_rt_bind(rt, symbol->value.symbol, REG(1));
+    REG(1) = akx_rt_copy(rt, REG(1));
+    pc += 3;
+    DISPATCH();
+  }
+
+  CASE(OP_SET_CHECK) {
+    akx_cell_t *symbol = CONST(1);
+    if (!akx_rt_scope_find(rt, symbol)) {
+      akx_rt_error_fmt(rt, "set: symbol '%s' is not defined",
+                       symbol->value.symbol);
+      goto fail;
+    }
+    pc += 2;
+    DISPATCH();
+  }
+
+  CASE(OP_SET) {
+    akx_cell_t *symbol = CONST(2);
+    akx_rt_scope_t *scope = akx_rt_scope_find(rt, symbol);
+    void *old_value = NULL;
+    if (!scope) {
+      akx_rt_error_fmt(rt, "set: symbol '%s' is not defined",
+                       symbol->value.symbol);
+      goto fail;
+    }
+    akx_rt_scope_assign(rt, scope, symbol->value.symbol, REG(1), &old_value);
+    if (old_value) {
+      akx_cell_free((akx_cell_t *)old_value);
+    }
+    REG(1) = akx_rt_copy(rt, REG(1));
+    pc += 3;
+    DISPATCH();
+  }
+
+  CASE(OP_PUSH_SCOPE) {
+    if (akx_rt_enter_scope(rt, A(1)) != 0) {
+      goto fail;
+    }
+    pc += 2;
+    DISPATCH();
+  }
+
+  CASE(OP_POP_SCOPE) {
+    akx_rt_pop_scope(rt);
+    pc += 1;
+    DISPATCH();
+  }
+
+  CASE(OP_SAFEPOINT) {
+    akx_rt_gc_safepoint(rt);
+    pc += 1;
+    DISPATCH();
+  }
+
+#ifndef AKX_RT_VM_THREADED
+  default:
+    akx_rt_error(rt, "vm: unknown instruction");
+    goto fail;
+  }
+#endif
+
+builtin_result:
+  // A builtin called in tail position may hand back a tail call, as it
+  // would to the trampoline
+  if (!value) {
+    goto fail;
+  }
+  if (value->type != AKX_TYPE_CONTINUATION) {
+    regs[dst] = value;
+    DISPATCH();
+  }
+  {
+    akx_continuation_t *cont = value->value.continuation;
+    akx_cell_t *args = cont ? cont->args : NULL;
+    int immediate = (value->flags & AKX_CELL_FLAG_IMMEDIATE) != 0;
+    lambda_cell = cont ? cont->lambda_cell : NULL;
+    if (cont) {
+      cont->lambda_cell = NULL;
+      cont->args = NULL;
+    }
+    akx_cell_free(value);
+    if (!lambda_cell) {
+      akx_rt_error(rt, "invalid continuation - no data");
+      goto fail;
+    }
+    // One from akx_rt_alloc_continuation still has its argument expressions
+    if (!immediate) {
+      value = akx_rt_invoke_lambda(rt, lambda_cell, args);
+      if (!value) {
+        goto fail;
+      }
+      regs[dst] = value;
+      DISPATCH();
+    }
+    lambda_ctx = lambda_context(lambda_cell);
+    if (!lambda_ctx || !lambda_code(vm, lambda_ctx)) {
+      goto fail;
+    }
+    saved = 1;
+  }
+
+tail_call:
+  // The callee's call replaces this frame's, and its code this frame's
+  if (akx_rt_replace_call(rt, lambda_ctx, saved) != 0) {
+    goto fail;
+  }
+  release(vm, frame, 0);
+  frame->lambda = lambda_cell;
+  akx_rt_gc_safepoint(rt);
+  if (lambda_ctx->code->reg_count > frame->capacity) {
+    vm_frame_t *replaced = frame;
+    pop_frame(vm, replaced);
+    vm->frame = replaced->caller;
+    frame = push_frame(vm, lambda_ctx->code);
+    if (!frame) {
+      akx_rt_error(rt, "vm: memory allocation failed");
+      frame = replaced;
+      goto fail_frame;
+    }
+    frame->outer = replaced->outer;
+    frame->dst = replaced->dst;
+    frame->base = replaced->base;
+    frame->lambda = lambda_cell;
+  } else {
+    frame->code = lambda_ctx->code;
+    frame->pc = lambda_ctx->code->ops;
+  }
+  RESUME(frame);
+  DISPATCH();
+
+return_value:
+  if (frame->lambda) {
+    akx_rt_pop_call(rt);
+  }
+leave:
+  // The popped frame's fields stay readable until the next push
+  pop_frame(vm, frame);
+  vm->frame = frame->caller;
+  if (frame->base) {
+    return value;
+  }
+  dst = frame->dst;
+  RESUME(frame->caller);
+  regs[dst] = value;
+  DISPATCH();
+
+fail:
+  // A failure while a call's arguments are bound makes that call nil, and
+  // one anywhere else in a lambda body makes the lambda's call nil; only a
+  // failure outside every call fails the run
+  if (vm->handler_count && vm->handlers[vm->handler_count - 1].frame == frame) {
+    vm_handler_t *handler = &vm->handlers[--vm->handler_count];
+    akx_rt_unwind_scope(rt, handler->scope);
+    release(vm, frame, handler->mark);
+    regs[handler->dst] = akx_rt_nil(rt);
+    pc = handler->resume;
+    DISPATCH();
+  }
+fail_frame:
+  akx_rt_unwind_scope(rt, frame->outer);
+  release(vm, frame, 0);
+  value = frame->lambda ? akx_rt_nil(rt) : NULL;
+  goto leave;
+}
+
+akx_rt_vm_t *akx_rt_vm_new(akx_runtime_ctx_t *rt) {
+  akx_rt_vm_t *vm = AK24_ALLOC(sizeof(akx_rt_vm_t));
+  if (!vm) {
+    return NULL;
+  }
+  memset(vm, 0, sizeof(akx_rt_vm_t));
+  vm->rt = rt;
+  vm->if_name = ak_intern("if");
+  vm->begin_name = ak_intern("begin");
+  vm->let_name = ak_intern("let");
+  vm->set_name = ak_intern("set");
+  vm->loop_name = ak_intern("loop");
+  return vm;
+}
+
+void akx_rt_vm_free(akx_rt_vm_t *vm) {
+  if (!vm) {
+    return;
+  }
+  while (vm->chunk && vm->chunk->next) {
+    vm->chunk = vm->chunk->next;
+  }
+  while (vm->chunk) {
+    vm_chunk_t *prev = vm->chunk->prev;
+    AK24_FREE(vm->chunk);
+    vm->chunk = prev;
+  }
+  if (vm->handlers) {
+    AK24_FREE(vm->handlers);
+  }
+  AK24_FREE(vm);
+}
+
+static akx_cell_t *start(akx_rt_vm_t *vm, const akx_rt_code_t *code,
+                         akx_cell_t *lambda_cell, akx_rt_scope_t *outer) {
+  vm_frame_t *frame = push_frame(vm, code);
+  if (!frame) {
+    akx_rt_error(vm->rt, "vm: memory allocation failed");
+    return NULL;
+  }
+  frame->outer = outer;
+  frame->base = 1;
+  frame->lambda = lambda_cell;
+  vm->frame = frame;
+  return run(vm);
+}
+
+akx_cell_t *akx_rt_vm_eval(akx_rt_vm_t *vm, akx_cell_t *expr) {
+  if (!vm || !expr) {
+    return NULL;
+  }
+  if (!is_list_cell(expr)) {
+    return akx_rt_eval(vm->rt, expr);
+  }
+  akx_rt_code_t *code = compile(vm, expr, 0);
+  if (!code) {
+    return NULL;
+  }
+  akx_cell_t *result =
+      start(vm, code, NULL, akx_rt_current_scope(vm->rt));
+  akx_rt_code_free(code);
+  return result;
+}
+
+akx_cell_t *akx_rt_vm_invoke(akx_rt_vm_t *vm, akx_cell_t *lambda_cell,
+                             akx_cell_t *args) {
+  akx_runtime_ctx_t *rt = vm->rt;
+  akx_rt_gc_safepoint(rt);
+
+  akx_lambda_context_t *lambda_ctx = lambda_context(lambda_cell);
+  if (!lambda_ctx) {
+    akx_rt_error(rt, "invalid lambda cell - no lambda data");
+    return NULL;
+  }
+  akx_rt_scope_t *outer = akx_rt_current_scope(rt);
+  if (akx_rt_push_call(rt, lambda_ctx) != 0) {
+    return NULL;
+  }
+  if (akx_rt_bind_args(rt, lambda_ctx, args) != 0) {
+    akx_rt_pop_call(rt);
+    return akx_rt_nil(rt);
+  }
+  if (!lambda_code(vm, lambda_ctx)) {
+    akx_rt_pop_call(rt);
+    return NULL;
+  }
+  akx_cell_t *result = start(vm, lambda_ctx->code, lambda_cell, outer);
+  if (!result) {
+    akx_rt_unwind_scope(rt, outer);
+  }
+  return result;
+}
+
+void akx_rt_vm_mark(akx_rt_vm_t *vm, akx_rt_gc_t *gc) {
+  if (!vm) {
+    return;
+  }
+  for (vm_frame_t *frame = vm->frame; frame; frame = frame->caller) {
+    akx_rt_gc_mark(gc, frame->lambda);
+    for (uint32_t i = 0; i < frame->code->reg_count; i++) {
+      akx_rt_gc_mark(gc, frame->regs[i]);
+    }
+  }
+}
@@ -0,0 +1,63 @@
+#ifndef AKX_RT_VM_H
+#define AKX_RT_VM_H
+
+#include "akx_rt.h"
+#include "akx_rt_builtins.h"
+#include "akx_rt_gc.h"
+
+// Register VM behind --engine=vm. Top-level forms and lambda bodies are
+// compiled to bytecode the first time they run; if, begin, let, set, loop,
+// strict builtin calls and lambda calls become instructions, and any other
+// builtin is called with its argument list as it stands.
+typedef struct akx_rt_vm_t akx_rt_vm_t;
+
+akx_rt_vm_t *akx_rt_vm_new(akx_runtime_ctx_t *rt);
+void akx_rt_vm_free(akx_rt_vm_t *vm);
+
+// Compiles a top-level form, runs it and drops the code
+akx_cell_t *akx_rt_vm_eval(akx_rt_vm_t *vm, akx_cell_t *expr);
+
+// akx_rt_invoke_lambda() for the VM: binds the argument expressions and
+// runs the body
+akx_cell_t *akx_rt_vm_invoke(akx_rt_vm_t *vm, akx_cell_t *lambda_cell,
+                             akx_cell_t *args);
+
+void akx_rt_vm_mark(akx_rt_vm_t *vm, akx_rt_gc_t *gc);
+
+// The parts of the evaluator in akx_rt.c the VM shares, so both engines
+// resolve, bind and call the same way
+akx_builtin_info_t *akx_rt_resolve_builtin(akx_runtime_ctx_t *rt,
+                                           akx_cell_t *call,
+                                           const char *name);
+void *akx_rt_lookup_symbol(akx_runtime_ctx_t *rt, akx_cell_t *symbol);
+akx_cell_t *akx_rt_call_builtin(akx_runtime_ctx_t *rt,
+                                akx_builtin_info_t *info, akx_cell_t *args,
+                                int tail);
+void akx_rt_signature_error(akx_runtime_ctx_t *rt,
+                            const akx_builtin_signature_t *signature,
+                            size_t argc);
+// Checks evaluated arguments against info's signature and calls it; the
+// arguments are freed either way
+akx_cell_t *akx_rt_call_strict(akx_runtime_ctx_t *rt,
+                               akx_builtin_info_t *info, akx_cell_t **args,
+                               size_t argc);
+
+akx_rt_scope_t *akx_rt_current_scope(akx_runtime_ctx_t *rt);
+// Pops scopes and lambda frames until scope is the current one again
+void akx_rt_unwind_scope(akx_runtime_ctx_t *rt, akx_rt_scope_t *scope);
+int akx_rt_enter_scope(akx_runtime_ctx_t *rt, size_t slots);
+// Names are interned, as symbol cells hold them
+int akx_rt_bind(akx_runtime_ctx_t *rt, const char *name, void *value);
+int akx_rt_binds_locally(akx_runtime_ctx_t *rt, const char *name);
+
+int akx_rt_push_call(akx_runtime_ctx_t *rt, akx_lambda_context_t *lambda_ctx);
+void akx_rt_pop_call(akx_runtime_ctx_t *rt);
+int akx_rt_bind_args(akx_runtime_ctx_t *rt, akx_lambda_context_t *lambda_ctx,
+                     akx_cell_t *args);
+// Replaces the innermost call with a tail call to lambda_ctx. The callee's
+// frame, already bound, is on top unless a builtin made the tail call and
+// its bindings wait in the runtime (saved).
+int akx_rt_replace_call(akx_runtime_ctx_t *rt,
+                        akx_lambda_context_t *lambda_ctx, int saved);
+
+#endif
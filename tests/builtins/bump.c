@@ -0,0 +1,8 @@
+akx_cell_t *bump(akx_runtime_ctx_t *rt, akx_cell_t *args) {
+  akx_cell_t *value = akx_rt_eval(rt, args);
+  if (!value) {
+    return NULL;
+  }
+  akx_rt_set_int(rt, value, akx_rt_cell_as_int(value) + 1);
+  return value;
+}
@@ -0,0 +1,9 @@
+akx_cell_t *bump_unshared(akx_runtime_ctx_t *rt, akx_cell_t *args) {
+  akx_cell_t *value = akx_rt_eval(rt, args);
+  if (!value) {
+    return NULL;
+  }
+  value = akx_rt_unshare(rt, value);
+  akx_rt_set_int(rt, value, akx_rt_cell_as_int(value) + 1);
+  return value;
+}
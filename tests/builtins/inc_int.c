@@ -0,0 +1,14 @@
+const akx_builtin_signature_t inc_int_signature = {
+    .name = "inc",
+    .min_args = 1,
+    .max_args = 1,
+    .accepts = AKX_ARG(AKX_TYPE_INTEGER_LITERAL),
+};
+
+int inc_int(akx_runtime_ctx_t *rt, akx_value_t *argv, size_t argc,
+            akx_value_t *result) {
+  (void)rt;
+  (void)argc;
+  *result = AKX_VALUE_INT(argv[0].as.integer + 1);
+  return 0;
+}
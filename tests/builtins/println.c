@@ -9,7 +9,11 @@ akx_cell_t *println(akx_runtime_ctx_t *rt, akx_cell_t *args) {
     if (akx_rt_cell_is_type(evaled, AKX_TYPE_STRING_LITERAL)) {
       printf("%s", akx_rt_cell_as_string(evaled));
     } else if (akx_rt_cell_is_type(evaled, AKX_TYPE_INTEGER_LITERAL)) {
-      printf("%d", akx_rt_cell_as_int(evaled));
+      ak_buffer_t *digits = akx_rt_int_to_buffer(evaled);
+      if (digits) {
+        printf("%s", (const char *)ak_buffer_data(digits));
+        ak_buffer_free(digits);
+      }
     } else if (akx_rt_cell_is_type(evaled, AKX_TYPE_REAL_LITERAL)) {
       printf("%f", akx_rt_cell_as_real(evaled));
     } else if (akx_rt_cell_is_type(evaled, AKX_TYPE_SYMBOL)) {
@@ -5,6 +5,9 @@ set -e
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 PROJECT_ROOT="$(cd "$SCRIPT_DIR/.." && pwd)"
 AKX_BINARY="$PROJECT_ROOT/build/bin/akx"
+# aot builds each test with akx compile and runs the binary
+ENGINES="${AKX_TEST_ENGINES:-tree stack vm aot}"
+AKX_HOME="${AKX_HOME:-$HOME/.akx}"
 
 RED='\033[0;31m'
 GREEN='\033[0;32m'
@@ -25,19 +28,35 @@ TESTS_SKIPPED=0
 echo -e "${BLUE}=== AKX Core Test Suite ===${NC}"
 echo "Binary: $AKX_BINARY"
 echo "Tests directory: $SCRIPT_DIR"
+echo "Engines: $ENGINES"
 echo ""
 
+# akx compile needs a C compiler and the headers make install puts under
+# AKX_HOME
+aot_missing=""
+if ! command -v "${CC:-cc}" > /dev/null 2>&1; then
+    aot_missing="no C compiler (${CC:-cc})"
+elif [ ! -f "$AKX_HOME/include/akx_rt_aot.h" ]; then
+    aot_missing="no installed headers in $AKX_HOME/include"
+fi
+
+for engine in $ENGINES; do
+if [ "$engine" = "aot" ] && [ -n "$aot_missing" ]; then
+    echo -e "${YELLOW}⊘ SKIP${NC} [aot] engine: $aot_missing"
+    TESTS_SKIPPED=$((TESTS_SKIPPED + 1))
+    continue
+fi
 for test_file in "$SCRIPT_DIR"/*.akx; do
     if [ ! -f "$test_file" ]; then
         continue
     fi
     
-    test_name=$(basename "$test_file" .akx)
+    test_name="$(basename "$test_file" .akx) [$engine]"
     expect_file="${test_file%.akx}.expect"
     
     if [ ! -f "$expect_file" ]; then
         echo -e "${YELLOW}⊘ SKIP${NC} $test_name (no .expect file)"
-        ((TESTS_SKIPPED++))
+        TESTS_SKIPPED=$((TESTS_SKIPPED + 1))
         continue
     fi
     
@@ -47,7 +66,15 @@ for test_file in "$SCRIPT_DIR"/*.akx; do
     expected_output=$(mktemp)
     raw_output=$(mktemp)
     
-    if (cd "$PROJECT_ROOT" && "$AKX_BINARY" "$test_file") > "$raw_output" 2>&1; then
+    if [ "$engine" = "aot" ]; then
+        aot_binary=$(mktemp)
+        if (cd "$PROJECT_ROOT" && "$AKX_BINARY" compile "$test_file" -o "$aot_binary" && "$aot_binary") > "$raw_output" 2>&1; then
+            exit_code=0
+        else
+            exit_code=$?
+        fi
+        rm -f "$aot_binary"
+    elif (cd "$PROJECT_ROOT" && "$AKX_BINARY" --engine="$engine" "$test_file") > "$raw_output" 2>&1; then
         exit_code=0
     else
         exit_code=$?
@@ -78,7 +105,7 @@ for test_file in "$SCRIPT_DIR"/*.akx; do
     
     if [ "$match" = "true" ]; then
         echo -e "${GREEN}✓ PASS${NC}"
-        ((TESTS_PASSED++))
+        TESTS_PASSED=$((TESTS_PASSED + 1))
     else
         echo -e "${RED}✗ FAIL${NC}"
         echo ""
@@ -91,11 +118,12 @@ for test_file in "$SCRIPT_DIR"/*.akx; do
         echo -e "${YELLOW}Diff:${NC}"
         diff -u "$expected_output" "$actual_output" || true
         echo ""
-        ((TESTS_FAILED++))
+        TESTS_FAILED=$((TESTS_FAILED + 1))
     fi
     
     rm -f "$actual_output" "$expected_output"
 done
+done
 
 echo ""
 echo -e "${BLUE}=== Test Summary ===${NC}"